@@ -25,6 +25,8 @@
  */
 
 #include "svn_client.h"
+#include "svn_pools.h"
+#include "private/svn_client_private.h"
 #include "private/svn_wc_private.h"
 
 #include "ClientContext.h"
@@ -39,7 +41,10 @@
 #include "svn_private_config.h"
 
 ClientContext::ClientContext(jobject jsvnclient, SVN::Pool &pool)
-    : OperationContext(pool)
+    : OperationContext(pool),
+      m_monitoredWcCtx(NULL),
+      m_monitorPool(NULL),
+      m_monitorConfig(NULL)
 {
     static jfieldID ctxFieldID = 0;
     attachJavaObject(jsvnclient, JAVAHL_ARG("/SVNClient$ClientContext;"), "clientContext", &ctxFieldID);
@@ -159,9 +164,43 @@ ClientContext::getContext(CommitMessage *message, SVN::Pool &in_pool)
     ctx->log_msg_baton3 = message;
     resetCancelRequest();
 
-    SVN_JNI_ERR(svn_wc_context_create(&ctx->wc_ctx, NULL,
-                                      in_pool.getPool(), in_pool.getPool()),
-                NULL);
+    /* The status monitor only pays off if it outlives a single operation,
+       so keep the working copy context that it is attached to. */
+    if (ctx->config != m_monitorConfig)
+      {
+        apr_pool_t *monitor_pool = svn_pool_create(m_pool->getPool());
+        svn_wc_context_t *wc_ctx;
+        svn_boolean_t started;
+
+        if (m_monitorPool)
+          svn_pool_destroy(m_monitorPool);
+        m_monitorPool = NULL;
+        m_monitoredWcCtx = NULL;
+        m_monitorConfig = ctx->config;
+
+        SVN_JNI_ERR(svn_wc_context_create(&wc_ctx, NULL, monitor_pool,
+                                          monitor_pool),
+                    NULL);
+        SVN_JNI_ERR(svn_client__start_status_monitor(&started, wc_ctx,
+                                                     ctx->config,
+                                                     monitor_pool),
+                    NULL);
+
+        if (started)
+          {
+            m_monitorPool = monitor_pool;
+            m_monitoredWcCtx = wc_ctx;
+          }
+        else
+          svn_pool_destroy(monitor_pool);
+      }
+
+    if (m_monitoredWcCtx)
+      ctx->wc_ctx = m_monitoredWcCtx;
+    else
+      SVN_JNI_ERR(svn_wc_context_create(&ctx->wc_ctx, NULL,
+                                        in_pool.getPool(), in_pool.getPool()),
+                  NULL);
 
     return ctx;
 }
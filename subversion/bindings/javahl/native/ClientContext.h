@@ -50,6 +50,13 @@ class ClientContext : public OperationContext
  private:
   svn_client_ctx_t *m_context;
 
+  /* The working copy context kept for all operations while the status
+     monitor is enabled, the pool it lives in and the configuration it
+     has been set up for. */
+  svn_wc_context_t *m_monitoredWcCtx;
+  apr_pool_t *m_monitorPool;
+  apr_hash_t *m_monitorConfig;
+
  protected:
   static void notify(void *baton, const svn_wc_notify_t *notify,
                      apr_pool_t *pool);
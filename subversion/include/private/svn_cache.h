@@ -179,6 +179,24 @@ typedef struct svn_cache__info_t
    * highest array index.
    */
   apr_uint64_t histogram[32];
+
+  /** Number of getter calls that missed the cache and have been forwarded
+   * to a second-level (disk) cache.  0 if there is no second level.
+   */
+  apr_uint64_t l2_gets;
+
+  /** Number of @a l2_gets that returned data.
+   */
+  apr_uint64_t l2_hits;
+
+  /** Size of the data currently stored in the second-level cache.
+   * 0 if there is no second level.
+   */
+  apr_uint64_t l2_used_size;
+
+  /** Capacity of the second-level cache.  0 if there is no second level.
+   */
+  apr_uint64_t l2_total_size;
 } svn_cache__info_t;
 
 /**
@@ -270,6 +288,26 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
                                      apr_pool_t *result_pool,
                                      apr_pool_t *scratch_pool);
 
+/**
+ * Replacement policies supported by membuffer caches.
+ */
+typedef enum svn_cache__membuffer_policy_t
+{
+  /** Randomized LFU based on per-entry hit counters.  Simple and cheap
+   * but a long sequence of items being read only once (e.g. an export
+   * of a large tree) may still push out frequently used data.
+   */
+  svn_cache__membuffer_policy_lfu,
+
+  /** Scan-resistant variant of the above.  A compact sketch estimates
+   * how often each key has been requested recently, including requests
+   * for items that were not in the cache.  Only items that are requested
+   * more often than the ones they would replace will be kept beyond the
+   * first cache level.  Requires about 4 extra bytes per index entry.
+   */
+  svn_cache__membuffer_policy_tinylfu
+} svn_cache__membuffer_policy_t;
+
 /**
  * Creates a new membuffer cache object in @a *cache. It will contain
  * up to @a total_size bytes of data, using @a directory_size bytes
@@ -288,6 +326,9 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
  * specific upper limit and the setting will be capped there automatically.
  * If the number is 0, a default will be derived from @a total_size.
  *
+ * @a policy selects the strategy that decides which items to evict
+ * when the cache is full.
+ *
  * If access to the resulting cache object is guaranteed to be serialized,
  * @a thread_safe may be set to @c FALSE for maximum performance.
  *
@@ -299,6 +340,14 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
  * (no data being written to the cache) if some reader or another writer
  * currently holds the segment lock.
  *
+ * If @a process_shared is set, the cache contents will be placed in
+ * anonymous shared memory and be guarded by process-shared locks.  All
+ * processes forked after this call will then share the same cache, once
+ * they called svn_cache__membuffer_child_init().  In that case,
+ * @a thread_safe and @a allow_blocking_writes are ignored and writes will
+ * always wait for the lock.  If the platform does not support this,
+ * #SVN_ERR_UNSUPPORTED_FEATURE will be returned.
+ *
  * Allocations will be made in @a result_pool, in particular the data buffers.
  */
 svn_error_t *
@@ -306,10 +355,24 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t total_size,
                                   apr_size_t directory_size,
                                   apr_size_t segment_count,
+                                  svn_cache__membuffer_policy_t policy,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t allow_blocking_writes,
+                                  svn_boolean_t process_shared,
                                   apr_pool_t *result_pool);
 
+/**
+ * Re-initialize the process-shared locks of @a cache in a process that
+ * has been forked after @a cache had been created with @a process_shared
+ * set.  This must be called once in every such child process before it
+ * accesses @a cache.  It is a no-op for caches that are not shared.
+ * Use @a pool for allocations that must live as long as the child process
+ * uses @a cache.
+ */
+svn_error_t *
+svn_cache__membuffer_child_init(svn_membuffer_t *cache,
+                                apr_pool_t *pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -378,6 +441,65 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool);
 
+/**
+ * An opaque structure representing a persistent, size-bounded on-disk
+ * store that can be used as a second-level cache for multiple
+ * first-level caches.
+ */
+typedef struct svn_cache__disk_t svn_cache__disk_t;
+
+/**
+ * Open the on-disk store at @a path in @a *store, creating it if
+ * necessary.  The file will be @a size bytes large (rounded to sensible
+ * limits).  Existing contents will be kept unless they have been
+ * written by a different Subversion version or with a different @a size.
+ *
+ * Stores are never closed and opening the same @a path again within the
+ * same process will return the same object.  Only one process at a time
+ * may use the store.  If the store is in use by another process or can't
+ * be locked for other reasons, @a *store will be set to @c NULL, i.e. the
+ * caller shall run without a second-level cache.  The @a store is
+ * thread-safe.  Use @a scratch_pool for temporary allocations.
+ *
+ * If the platform does not support memory-mapped files, this returns
+ * #SVN_ERR_UNSUPPORTED_FEATURE.
+ */
+svn_error_t *
+svn_cache__open_disk_store(svn_cache__disk_t **store,
+                           const char *path,
+                           apr_uint64_t size,
+                           apr_pool_t *scratch_pool);
+
+/**
+ * Creates a new cache in @a *cache_p, allocated in @a result_pool, that
+ * uses @a memory as its first level and @a store as its second level.
+ *
+ * Lookups that miss @a memory will be tried in @a store and found items
+ * be put back into @a memory.  All setter calls write through to both
+ * levels, i.e. @a store will retain the data across @a memory evictions
+ * and process restarts.  Keys must be of length @a klen, may be
+ * APR_HASH_KEY_STRING and will be prefixed with @a prefix in @a store.
+ * Hence, @a prefix must identify the contents sufficiently to be unique
+ * across all users of @a store and over time.
+ *
+ * @a serialize_func and @a deserialize_func must be the functions that
+ * @a memory has been created with; @c NULL means svn_stringbuf_t, as for
+ * the other cache types.
+ *
+ * svn_cache__get_info() will report the usage and size of @a memory plus
+ * the second-level statistics.  These caches do not support
+ * svn_cache__iter.
+ */
+svn_error_t *
+svn_cache__create_disk_tier(svn_cache__t **cache_p,
+                            svn_cache__t *memory,
+                            svn_cache__disk_t *store,
+                            svn_cache__serialize_func_t serialize_func,
+                            svn_cache__deserialize_func_t deserialize_func,
+                            apr_ssize_t klen,
+                            const char *prefix,
+                            apr_pool_t *result_pool);
+
 /**
  * Creates a null-cache instance in @a *cache_p, allocated from
  * @a result_pool.  The given @c id is the only data stored in it and can
@@ -341,6 +341,39 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool);
 
+/* Set whether the status callbacks that CTX's users pass to
+ * svn_client_status6() are READ_ONLY, i.e. never modify the working copy,
+ * neither directly nor through other contexts.
+ *
+ * If that is the case and the @c status-threads option in the
+ * [working-copy] section of CTX->config is larger than 1, the local
+ * status walk reads directories ahead of time, which would not see such
+ * modifications.  By default, the walk is sequential.
+ */
+void
+svn_client__set_read_only_status(svn_client_ctx_t *ctx,
+                                 svn_boolean_t read_only);
+
+/* If the @c status-monitor option in the [working-copy] section of CONFIG
+ * is enabled, start monitoring the directories that status walks through
+ * WC_CTX read, until RESULT_POOL, which must not outlive WC_CTX, gets
+ * cleared or destroyed.  See svn_wc__status_monitor_start().
+ *
+ * Set *STARTED to whether the monitor runs now.  It won't if the option
+ * is disabled or the platform does not support monitoring.  CONFIG is a
+ * configuration hash as in svn_client_ctx_t and may be NULL.
+ *
+ * svn_client_create_context2() calls this for the context it creates.
+ * Clients that use a different working copy context for each operation
+ * need to keep one around and call this for it, to benefit from the
+ * monitor.
+ */
+svn_error_t *
+svn_client__start_status_monitor(svn_boolean_t *started,
+                                 svn_wc_context_t *wc_ctx,
+                                 apr_hash_t *config,
+                                 apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -108,6 +108,31 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
                                  svn_stream_t *stream,
                                  apr_pool_t *pool);
 
+/** Return a writable generic stream in @a *stream which will produce
+ * svndiff data for the delta from @a source to the data written to
+ * @a *stream, and write it to @a output.  This is equivalent to
+ * svn_txdelta_target_push() feeding svn_txdelta_to_svndiff3() with
+ * @a svndiff_version and @a compression_level.
+ *
+ * However, computing the delta windows and compressing them will be done
+ * concurrently for up to @a max_pending windows.  @a source will be read
+ * and @a output be written strictly sequentially and only from within
+ * the calling thread, i.e. neither needs to be thread-safe.  The output
+ * is byte-identical to the one of the sequential code path.
+ *
+ * Closing @a *stream will close @a output.  Allocate the stream and all
+ * window buffers in @a pool.  Memory usage is proportional to
+ * @a max_pending.
+ */
+svn_error_t *
+svn_txdelta__target_push_svndiff(svn_stream_t **stream,
+                                 svn_stream_t *output,
+                                 int svndiff_version,
+                                 int compression_level,
+                                 svn_stream_t *source,
+                                 int max_pending,
+                                 apr_pool_t *pool);
+
 /* Return a debug editor that wraps @a wrapped_editor.
  *
  * The debug editor simply prints an indication of what callbacks are being
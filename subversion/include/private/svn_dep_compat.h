@@ -95,6 +95,23 @@ extern "C" {
 #endif
 #endif
 
+/**
+ * Defined if the compiler targets a CPU that supports SSE2 and provides
+ * the respective intrinsics in <emmintrin.h>.  This is always the case
+ * for x86-64 and for 32 bit x86 builds that explicitly enabled SSE2.
+ *
+ * Code using this must provide a portable fallback.
+ *
+ * @since New in 1.11.
+ */
+#ifndef SVN_HAVE_SSE2
+#if    defined(__SSE2__) \
+    || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define SVN_HAVE_SSE2
+#endif
+#endif
+
 /**
  * APR keeps a few interesting defines hidden away in its private
  * headers apr_arch_file_io.h, so we redefined them here.
@@ -85,6 +85,34 @@ svn_io__file_lock_autocreate(const char *lock_file,
                              apr_pool_t *pool);
 
 
+/** Try to copy the contents of @a from_file to the empty @a to_file
+ * without moving the data through userspace.  On Linux, this uses
+ * FICLONE to share the data blocks of both files on copy-on-write file
+ * systems such as Btrfs and XFS and copy_file_range() otherwise.
+ *
+ * Set @a *copied to TRUE if the contents have been copied.  If this is
+ * not supported for these files or on this platform, set it to FALSE and
+ * leave @a to_file untouched; the caller should then copy the data itself.
+ * The positions of both files will not be changed.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_copy_in_kernel(svn_boolean_t *copied,
+                            apr_file_t *from_file,
+                            apr_file_t *to_file,
+                            apr_pool_t *scratch_pool);
+
+/** Create @a new_path as a hard link to the existing file
+ * @a existing_path.  Fail if @a new_path already exists, if both paths
+ * are on different file systems or if the platform or file system does
+ * not support hard links.  Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_link(const char *existing_path,
+                  const char *new_path,
+                  apr_pool_t *scratch_pool);
+
 /** Return the underlying file, if any, associated with the stream, or
  * NULL if not available.  Accessing the file bypasses the stream.
  */
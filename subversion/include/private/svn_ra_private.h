@@ -32,6 +32,7 @@
 #include "svn_error.h"
 #include "svn_ra.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_editor.h"
 #include "svn_io.h"
 
@@ -83,6 +84,62 @@ svn_ra__assert_capable_server(svn_ra_session_t *ra_session,
                               const char *path_or_url,
                               apr_pool_t *pool);
 
+
+/*** Server-side Blame ***/
+
+/** The capability of a server to compute blame information itself,
+ * see svn_ra__blame().
+ *
+ * @since New in 1.11.
+ */
+#define SVN_RA__CAPABILITY_BLAME "blame"
+
+/** One run of consecutive lines that share the same origin, as reported
+ * by svn_ra__blame().
+ *
+ * @since New in 1.11.
+ */
+typedef struct svn_ra__blame_chunk_t
+{
+  /** Zero-based number of the first line of this run. */
+  apr_int64_t start;
+
+  /** The revision that last changed these lines, or #SVN_INVALID_REVNUM
+   * if that happened before the start of the requested range. */
+  svn_revnum_t revision;
+} svn_ra__blame_chunk_t;
+
+/** Let the server compute the blame information of the file at @a path
+ * (relative to the @a session's URL) as of revision @a end, ignoring
+ * changes made before @a start.  Compare lines according to
+ * @a diff_options, which may be @c NULL for defaults.
+ *
+ * Set @a *chunks to an array of #svn_ra__blame_chunk_t, ordered by line
+ * number and with the first chunk starting at line 0.  Set @a *rev_props
+ * to a hash mapping (svn_revnum_t *) keys to the revision property hashes
+ * of all revisions referenced by @a *chunks.
+ *
+ * This is the server-side counterpart of driving svn_ra_get_file_revs2()
+ * without merged revisions.  @a start must not be younger than @a end.
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if the server does not have the
+ * #SVN_RA__CAPABILITY_BLAME capability.
+ *
+ * Allocate the results in @a result_pool and use @a scratch_pool for
+ * temporaries.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra__blame(svn_ra_session_t *session,
+              const char *path,
+              svn_revnum_t start,
+              svn_revnum_t end,
+              const svn_diff_file_options_t *diff_options,
+              apr_array_header_t **chunks,
+              apr_hash_t **rev_props,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool);
+
 
 /*** Operational Locks ***/
 
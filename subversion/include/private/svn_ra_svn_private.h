@@ -132,6 +132,25 @@ svn_ra_svn__set_capabilities(svn_ra_svn_conn_t *conn,
 int
 svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn);
 
+/** Compress all further data sent and received over @a conn.  Flush
+ * @a conn before switching, then wrap the underlying stream into a
+ * zlib codec using @a conn's compression level.  Data that has already
+ * been received but not yet parsed is assumed to be compressed.
+ *
+ * Both sides of the connection must switch at the same point in the
+ * data stream.  For svn:// connections, that is right after the client's
+ * reply to the server's greeting, if both sides announced the
+ * #SVN_RA_SVN_CAP_COMPRESSED_TRANSPORT capability.  Use @a scratch_pool
+ * for temporary allocations.
+ *
+ * Calling this function again on the same @a conn has no effect.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn,
+                               apr_pool_t *scratch_pool);
+
 
 /**
  * Set the shim callbacks to be used by @a conn to @a shim_callbacks.
@@ -33,6 +33,7 @@
 #include "svn_repos.h"
 #include "svn_editor.h"
 #include "svn_config.h"
+#include "svn_diff.h"
 
 #include "private/svn_object_pool.h"
 #include "private/svn_string_private.h"
@@ -349,6 +350,67 @@ svn_repos__dump_node_record(svn_stream_t *dump_stream,
                             svn_boolean_t content_length_always,
                             apr_pool_t *scratch_pool);
 
+/** One run of consecutive lines that share the same origin, as reported
+ * by svn_repos__blame().
+ *
+ * @since New in 1.11.
+ */
+typedef struct svn_repos__blame_chunk_t
+{
+  /** Zero-based number of the first line of this run. */
+  apr_int64_t start;
+
+  /** The revision that last changed these lines, or #SVN_INVALID_REVNUM
+   * if that happened before the start of the requested range. */
+  svn_revnum_t revision;
+} svn_repos__blame_chunk_t;
+
+/** Compute the line-origin map of the file @a path in @a repos as of
+ * revision @a end, attributing each line to the revision that last
+ * changed it.  Changes older than @a start are not attributed.
+ *
+ * Set @a *chunks_p to an array of #svn_repos__blame_chunk_t, ordered by
+ * line number.  The first chunk always starts at line 0 and each chunk
+ * extends up to the start of the next one, resp. the end of the file.
+ * Set @a *rev_props_p to a hash mapping (svn_revnum_t *) keys to the
+ * revision property hashes of all revisions referenced by the chunks.
+ *
+ * Invalid @a start or @a end default to HEAD.  @a start must not be
+ * younger than @a end.  Lines are compared according to @a diff_options,
+ * which may be @c NULL for defaults.
+ *
+ * If @a authz_read_func is not @c NULL, use it with @a authz_read_baton
+ * to check read access to every location in the file's history; the
+ * history is truncated at the first unreadable one, i.e. older changes
+ * are attributed to the oldest readable location.  If @a path is not
+ * readable in @a end, return #SVN_ERR_AUTHZ_UNREADABLE.  The revision
+ * properties are filtered the same way.
+ *
+ * Completed maps are kept in the global membuffer cache, keyed by node
+ * revision, so later requests for newer revisions only need to process
+ * the changes made since then.  The cached maps cover the full history
+ * and are shared by all users; authz only gets applied to the result.
+ *
+ * Allocate the results in @a result_pool and use @a scratch_pool for
+ * temporaries.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos__blame(apr_array_header_t **chunks_p,
+                 apr_hash_t **rev_props_p,
+                 svn_repos_t *repos,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 const svn_diff_file_options_t *diff_options,
+                 svn_repos_authz_func_t authz_read_func,
+                 void *authz_read_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,152 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_task.h
+ * @brief Ordered execution of independent tasks on worker threads.
+ */
+
+#ifndef SVN_TASK_H
+#define SVN_TASK_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * A task queue executes the "process" part of each task on a shared,
+ * process-wide set of worker threads and then calls the "output" part of
+ * the respective task in the thread that owns the queue.  The outputs are
+ * always delivered in the order in which the tasks got pushed, no matter
+ * in which order they complete.
+ *
+ * The number of tasks in flight is bounded by the @c max_pending value
+ * given to svn_task__queue_create().  Pushing more tasks than that will
+ * block until the oldest task has completed and its output been delivered.
+ *
+ * If APR has no thread support or @c max_pending is 1, all tasks are
+ * executed synchronously within svn_task__queue_push().  Callers will
+ * observe the exact same sequence of calls either way.
+ */
+typedef struct svn_task__queue_t svn_task__queue_t;
+
+/**
+ * Callback executing the potentially expensive part of a task, typically
+ * in some worker thread.  @a process_baton is the value passed to
+ * svn_task__queue_push().  Return the task's result in @a *result,
+ * allocated in @a result_pool.  @a scratch_pool is for temporaries.
+ *
+ * Both pools are private to this task and may be used safely in the
+ * worker thread.  However, the implementation must not access any other
+ * object that is being used concurrently by other tasks or by the thread
+ * owning the queue without proper synchronization.
+ */
+typedef svn_error_t *
+(*svn_task__process_func_t)(void **result,
+                            void *process_baton,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/**
+ * Callback processing the @a result of a task, as returned by the
+ * respective #svn_task__process_func_t.  @a output_baton is the value
+ * passed to svn_task__queue_push().  This will always be called from the
+ * thread owning the queue.  Use @a scratch_pool for temporaries.
+ */
+typedef svn_error_t *
+(*svn_task__output_func_t)(void *result,
+                           void *output_baton,
+                           apr_pool_t *scratch_pool);
+
+/**
+ * Create a new task queue in @a *queue, allocated in @a result_pool,
+ * that will have at most @a max_pending tasks in flight at any time.
+ * Values smaller than 1 will be treated as 1, i.e. no concurrency.
+ *
+ * The queue must only be used by the thread that created it.  Destroying
+ * @a result_pool will wait for all outstanding tasks to complete but
+ * will not deliver their output.
+ */
+svn_error_t *
+svn_task__queue_create(svn_task__queue_t **queue,
+                       int max_pending,
+                       apr_pool_t *result_pool);
+
+/**
+ * Add a new task to @a queue.  Its @a process function will be called
+ * with @a process_baton, followed by @a output being called with
+ * @a output_baton once all earlier tasks have been output.  @a output may
+ * be @c NULL.  Both batons must remain valid until the output has been
+ * delivered or the @a queue got destroyed.
+ *
+ * If the queue is full, this will block until the oldest task has
+ * completed and output its result, using @a scratch_pool for temporaries.
+ *
+ * Errors returned by any task or output function will be returned by this
+ * or a later call to svn_task__queue_push() or svn_task__queue_finish().
+ * After an error, outputs of pending tasks will not be delivered anymore.
+ */
+svn_error_t *
+svn_task__queue_push(svn_task__queue_t *queue,
+                     svn_task__process_func_t process,
+                     void *process_baton,
+                     svn_task__output_func_t output,
+                     void *output_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Wait for the oldest task in @a queue to complete and deliver its output.
+ * Do nothing if @a queue is empty.  Use @a scratch_pool for temporaries.
+ *
+ * This allows the queue owner to wait for a specific result without
+ * draining the whole queue.  Errors are reported as for
+ * svn_task__queue_push().
+ */
+svn_error_t *
+svn_task__queue_deliver_next(svn_task__queue_t *queue,
+                             apr_pool_t *scratch_pool);
+
+/**
+ * Wait for all tasks in @a queue to complete and deliver their outputs.
+ * Use @a scratch_pool for temporaries.  The queue may be reused
+ * afterwards.
+ */
+svn_error_t *
+svn_task__queue_finish(svn_task__queue_t *queue,
+                       apr_pool_t *scratch_pool);
+
+/**
+ * Return a default value for @c max_pending for parallel work that is
+ * mainly CPU bound.  Without thread support, this will be 1.
+ */
+int
+svn_task__default_concurrency(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TASK_H */
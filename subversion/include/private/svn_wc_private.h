@@ -1379,6 +1379,34 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
                           apr_pool_t *scratch_pool);
 
 
+/**
+ * Like svn_wc_walk_status(), but the caller promises that @a status_func
+ * does not modify the working copy, neither directly nor through other
+ * contexts, while the walk is in progress.
+ *
+ * That allows reading directories and their metadata ahead of time on up
+ * to as many threads as configured by the @c status-threads option in the
+ * [working-copy] section of the client configuration.  Modifications made
+ * during the walk may not be seen by the walk.  The sequence of
+ * @a status_func calls is the same as for svn_wc_walk_status().
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_wc__walk_status_read_only(svn_wc_context_t *wc_ctx,
+                              const char *local_abspath,
+                              svn_depth_t depth,
+                              svn_boolean_t get_all,
+                              svn_boolean_t no_ignore,
+                              svn_boolean_t ignore_text_mods,
+                              const apr_array_header_t *ignore_patterns,
+                              svn_wc_status_func4_t status_func,
+                              void *status_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool);
+
+
 /**
  * Set @a *editor and @a *edit_baton to an editor and baton for updating a
  * working copy.
@@ -2102,6 +2130,31 @@ svn_wc__translated_stream(svn_stream_t **stream,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool);
 
+/** Watches working copy directories for changes on disk. */
+typedef struct svn_wc__status_monitor_t svn_wc__status_monitor_t;
+
+/**
+ * Start monitoring the directories that status walks through @a wc_ctx
+ * read, until @a result_pool, which must not outlive @a wc_ctx, gets
+ * cleared or destroyed.  Subsequent walks
+ * will not read directories again that have not changed since, i.e. they
+ * won't need to readdir() them and lstat() their children.
+ *
+ * This is meant for long-running clients such as IDE integrations that
+ * repeatedly ask for the status of the same, large working copies.  Each
+ * monitored directory takes a watch from the per-user limit of the
+ * operating system; directories beyond that limit are simply read every
+ * time.  Changes made through memory mappings may go unnoticed.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if the platform cannot report
+ * changes to directories.  Currently, only Linux' inotify is supported.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_wc__status_monitor_start(svn_wc_context_t *wc_ctx,
+                             apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
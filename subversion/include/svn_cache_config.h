@@ -83,6 +83,58 @@ svn_cache_config_get(void);
 void
 svn_cache_config_set(const svn_cache_config_t *settings);
 
+/** Select the replacement @a policy of the process-global cache.  With
+   "lfu", the default, the cache evicts the least frequently used data.
+   With "tinylfu", it also tracks how often uncached data gets requested
+   and only keeps data that is requested more often than what it would
+   replace.  That prevents one-off reads of many items from pushing out
+   frequently used data, at the expense of about 2% of the cache memory.
+
+   Like svn_cache_config_set(), this has no effect once the cache has been
+   created and is not thread-safe.  Return #SVN_ERR_INCORRECT_PARAMS if
+   @a policy is not one of the above.
+
+   @since New in 1.11.
+ */
+svn_error_t *
+svn_cache_config_set_replacement_policy(const char *policy);
+
+/** Create the process-global cache right away, using the current cache
+   configuration, and place it in memory that will be shared with all
+   child processes forked after this call.  All of these processes will
+   then see the same cache contents and the configured cache size will
+   apply to all of them combined rather than to each one individually.
+
+   This is meant for pre-fork servers and must be called in the parent
+   process after svn_cache_config_set() but before forking the workers.
+   Like svn_cache_config_set(), this function is not thread-safe.
+
+   If the cache has already been created or the configured cache size is
+   0, this will be a no-op.  If the platform does not support shared
+   memory or fork(), return #SVN_ERR_UNSUPPORTED_FEATURE.
+
+   @since New in 1.11.
+ */
+svn_error_t *
+svn_cache_config_create_shared_cache(void);
+
+/** Prepare the process-global cache created by
+   svn_cache_config_create_shared_cache() for use in the current process.
+   This must be called once in every child process forked after that
+   call, before the child uses any Subversion API that may access the
+   cache.  Depending on the platform, the locks guarding the shared cache
+   may otherwise not be valid in the child process.
+
+   Use @a pool for allocations that must live as long as the child process
+   uses the cache, e.g. the child's process pool.
+
+   If no shared cache has been created, this will be a no-op.
+
+   @since New in 1.11.
+ */
+svn_error_t *
+svn_cache_config_child_init(apr_pool_t *pool);
+
 /** @} */
 
 /** @} */
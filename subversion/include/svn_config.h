@@ -117,6 +117,8 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SERF_LOG_COMPONENTS       "serf-log-components"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SERF_LOG_LEVEL            "serf-log-level"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_SVN_COMPRESSED_TRANSPORT  "svn-compressed-transport"
 
 
 #define SVN_CONFIG_CATEGORY_CONFIG          "config"
@@ -171,6 +173,14 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE_CLIENTS  "exclusive-locking-clients"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_STATUS_THREADS            "status-threads"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_INSTALL_THREADS           "install-threads"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE     "shared-pristine-store"
+/** @since New in 1.11. */
+#define SVN_CONFIG_OPTION_STATUS_MONITOR            "status-monitor"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
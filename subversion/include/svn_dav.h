@@ -404,6 +404,15 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_LIST\
             SVN_DAV_PROP_NS_DAV "svn/list"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) knows how to handle
+ * 'blame-report' requests.
+ *
+ * @since New in 1.11.
+ */
+#define SVN_DAV_NS_DAV_SVN_BLAME\
+            SVN_DAV_PROP_NS_DAV "svn/blame"
+
 /** Presence of this in a DAV header in an OPTIONS response indicates
  * that the transmitter (in this case, the server) knows how to handle
  * svndiff2 format encoding.
@@ -455,6 +455,23 @@ typedef enum svn_diff_file_ignore_space_t
   svn_diff_file_ignore_space_all
 } svn_diff_file_ignore_space_t;
 
+/** The algorithm used to find the common lines of two files.
+ *
+ * @since New in 1.11.
+ */
+typedef enum svn_diff_file_algorithm_t
+{
+  /** Find a longest common subsequence, using the O(NP) algorithm by
+   * Wu, Manber, Myers and Miller. */
+  svn_diff_file_algorithm_default,
+
+  /** Use the histogram algorithm known from Git, which anchors the diff
+   * on the least frequent common lines.  This is much faster on large
+   * files with many repeated lines and often produces more readable
+   * diffs, but the result is not necessarily minimal. */
+  svn_diff_file_algorithm_histogram
+} svn_diff_file_algorithm_t;
+
 /** Options to control the behaviour of the file diff routines.
  *
  * @since New in 1.4.
@@ -487,6 +504,12 @@ typedef struct svn_diff_file_options_t
    *
    * @since New in 1.9 */
   int context_size;
+
+  /** The algorithm to use for two-way diffs.  The default is
+   * @c svn_diff_file_algorithm_default.
+   *
+   * @since New in 1.11 */
+  svn_diff_file_algorithm_t algorithm;
 } svn_diff_file_options_t;
 
 /** Allocate a @c svn_diff_file_options_t structure in @a pool, initializing
@@ -510,6 +533,7 @@ svn_diff_file_options_create(apr_pool_t *pool);
  * - --ignore-eol-style
  * - --show-c-function, -p @since New in 1.5.
  * - --context, -U ARG @since New in 1.9.
+ * - --histogram @since New in 1.11.
  * - --unified, -u (for compatibility, does nothing).
  */
 svn_error_t *
@@ -71,6 +71,10 @@ extern "C" {
 #define SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE "file-revs-reverse"
 /* maps to SVN_RA_CAPABILITY_LIST */
 #define SVN_RA_SVN_CAP_LIST "list"
+/* maps to SVN_RA__CAPABILITY_BLAME */
+#define SVN_RA_SVN_CAP_BLAME "blame"
+/* compress the whole connection after the greeting exchange */
+#define SVN_RA_SVN_CAP_COMPRESSED_TRANSPORT "compressed-transport"
 
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
@@ -250,7 +250,15 @@ typedef enum svn_repos_notify_action_t
   svn_repos_notify_pack_noop,
 
   /** The revision properties got set. @since New in 1.10. */
-  svn_repos_notify_load_revprop_set
+  svn_repos_notify_load_revprop_set,
+
+  /** The mergeinfo changes of a revision got added to the mergeinfo
+   * index. @since New in 1.11. */
+  svn_repos_notify_mergeinfo_indexed,
+
+  /** The changed paths of a revision got added to the changed-paths
+   * index. @since New in 1.11. */
+  svn_repos_notify_changes_indexed
 } svn_repos_notify_action_t;
 
 /** The type of warning occurring.
@@ -756,6 +764,65 @@ svn_repos_fs_pack(svn_repos_t *repos,
                   void *cancel_baton,
                   apr_pool_t *pool);
 
+/**
+ * Create the mergeinfo index of @a repos, if it does not exist yet, and
+ * add all revisions up to the youngest one to it.
+ *
+ * The index records the mergeinfo changes of every revision, allowing
+ * svn_repos_get_logs5() to find merged revisions without examining the
+ * changed paths and mergeinfo properties of every revision in the log
+ * range.  Once created, the index will be kept up-to-date by
+ * svn_repos_fs_commit_txn() and by loading dump streams.  If it falls
+ * behind, e.g. because revisions were committed by other means, it will
+ * only be used for the revisions it covers and calling this function
+ * again will catch up on the missing revisions.
+ *
+ * If @a notify_func is not @c NULL, call it with @a notify_baton for
+ * every revision added to the index, using the action
+ * #svn_repos_notify_mergeinfo_indexed.  Call @a cancel_func with
+ * @a cancel_baton, if not @c NULL, to check for cancellation.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_build_mergeinfo_index(svn_repos_t *repos,
+                                svn_repos_notify_func_t notify_func,
+                                void *notify_baton,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *scratch_pool);
+
+/**
+ * Create the changed-paths index of @a repos, if it does not exist yet,
+ * and add all revisions up to the youngest one to it.
+ *
+ * For every path, the index records the revisions that changed it or
+ * anything below it, together with all copies.  This allows
+ * svn_repos_get_logs5() to find the revisions affecting a path without
+ * following the history of its node one predecessor at a time, which
+ * makes the log of rarely changed paths in large repositories much
+ * cheaper.  Once created, the index will be kept up-to-date just like
+ * the mergeinfo index, see svn_repos_build_mergeinfo_index().
+ *
+ * If @a notify_func is not @c NULL, call it with @a notify_baton for
+ * every revision added to the index, using the action
+ * #svn_repos_notify_changes_indexed.  Call @a cancel_func with
+ * @a cancel_baton, if not @c NULL, to check for cancellation.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_build_changes_index(svn_repos_t *repos,
+                              svn_repos_notify_func_t notify_func,
+                              void *notify_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool);
+
 /**
  * Run database recovery procedures on the repository at @a path,
  * returning the database to a consistent state.  Use @a pool for all
@@ -2488,6 +2555,12 @@ svn_repos_get_file_revs(svn_repos_t *repos,
  * SVN_ERR_REPOS_POST_COMMIT_HOOK_FAILED wrapped error is the child
  * error.
  *
+ * After the post-commit hook, the optional log indexes of @a repos get
+ * extended by the new revision, see svn_repos_build_mergeinfo_index().
+ * This never fails the commit.  If an index is locked by another process
+ * for more than a moment, broken or too far behind, it will not be
+ * updated and log will fall back to the live data for newer revisions.
+ *
  * @a conflict_p, @a new_rev, and @a txn are as in svn_fs_commit_txn().
  */
 svn_error_t *
@@ -3131,10 +3204,10 @@ enum svn_repos_load_uuid
   svn_repos_load_uuid_force
 };
 
-/** Callback type for use with svn_repos_verify_fs3().  @a revision
+/** Callback type for use with svn_repos_verify_fs4().  @a revision
  * and @a verify_err are the details of a single verification failure
- * that occurred during the svn_repos_verify_fs3() call.  @a baton is
- * the same baton given to svn_repos_verify_fs3().  @a scratch_pool is
+ * that occurred during the svn_repos_verify_fs4() call.  @a baton is
+ * the same baton given to svn_repos_verify_fs4().  @a scratch_pool is
  * provided for the convenience of the implementor, who should not
  * expect it to live longer than a single callback call.
  *
@@ -3144,7 +3217,7 @@ enum svn_repos_load_uuid
  * should also call svn_error_dup() for @a verify_err.  Implementors of this
  * callback are forbidden to call svn_error_clear() for @a verify_err.
  *
- * @see svn_repos_verify_fs3
+ * @see svn_repos_verify_fs4
  *
  * @since New in 1.9.
  */
@@ -3189,6 +3262,11 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  * from continuing, such as #SVN_ERR_CANCELLED, are returned immediately
  * and do not trigger an invocation of @a verify_callback.
  *
+ * If @a keep_going is @c FALSE, don't verify any further revisions once
+ * a revision failed verification and has been reported to
+ * @a verify_callback.  Otherwise, let @a verify_callback decide whether
+ * to continue.
+ *
  * If @a notify_func is not null, then call it with @a notify_baton and
  * with a notification structure in which the fields are set as follows.
  * (For a warning that does not apply to a specific revision, the revision
@@ -3217,12 +3295,45 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  * cancel_baton as argument to see if the caller wishes to cancel the
  * verification.
  *
+ * If @a jobs is larger than 1, verify up to @a jobs revision ranges
+ * concurrently, each using its own file system instance.  Notifications
+ * and @a verify_callback invocations will still be made from the calling
+ * thread and in the same order as for @a jobs being 1.  However,
+ * @a cancel_func may be called from other threads.  The global metadata
+ * check performed by svn_fs_verify() is not affected by this parameter.
+ * The caller should make sure that the caches have been configured for
+ * multi-threaded access, see svn_cache_config_set().
+ *
  * Use @a scratch_pool for temporary allocation.
  *
  * @see svn_repos_verify_callback_t
  *
+ * @since New in 1.11.
+ */
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     int jobs,
+                     svn_boolean_t keep_going,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_verify_fs4(), but with @a jobs set to 1 and
+ * @a keep_going set to @c TRUE.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.10 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -3280,7 +3391,7 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * Dump the contents of the filesystem within already-open @a repos into
  * writable @a dumpstream.  If @a dumpstream is
  * @c NULL, this is effectively a primitive verify.  It is not complete,
- * however; see instead svn_repos_verify_fs3().
+ * however; see instead svn_repos_verify_fs4().
  *
  * Begin at revision @a start_rev, and dump every revision up through
  * @a end_rev.  If @a start_rev is #SVN_INVALID_REVNUM, start at revision
@@ -38,6 +38,7 @@
 #include "svn_sorts.h"
 
 #include "private/svn_wc_private.h"
+#include "private/svn_ra_private.h"
 
 #include "svn_private_config.h"
 
@@ -655,6 +656,67 @@ normalize_blames(struct blame_chain *chain,
     }
 }
 
+/* Let the server behind RA_SESSION compute the blame information for
+   FRB->start_rev:FRB->end_rev and turn it into FRB->chain, then fetch the
+   file as of FRB->end_rev into FRB->last_filename.  Return an error with
+   code SVN_ERR_UNSUPPORTED_FEATURE if the server can't do that. */
+static svn_error_t *
+get_blame_from_server(struct file_rev_baton *frb,
+                      svn_ra_session_t *ra_session,
+                      apr_pool_t *pool)
+{
+  apr_array_header_t *chunks;
+  apr_hash_t *rev_props;
+  apr_hash_t *revs = apr_hash_make(pool);
+  struct blame *last = NULL;
+  svn_stream_t *stream;
+  const char *filename;
+  int i;
+
+  SVN_ERR(svn_ra__blame(ra_session, "", frb->start_rev, frb->end_rev,
+                        frb->diff_options, &chunks, &rev_props,
+                        frb->mainpool, pool));
+
+  for (i = 0; i < chunks->nelts; ++i)
+    {
+      const svn_ra__blame_chunk_t *chunk
+        = &APR_ARRAY_IDX(chunks, i, svn_ra__blame_chunk_t);
+      struct rev *rev = apr_hash_get(revs, &chunk->revision,
+                                     sizeof(chunk->revision));
+      struct blame *blame;
+
+      /* Lines from before start_rev share a rev without properties,
+         just like the first file revision in file_rev_handler(). */
+      if (!rev)
+        {
+          rev = apr_pcalloc(frb->mainpool, sizeof(*rev));
+          rev->revision = chunk->revision;
+          if (SVN_IS_VALID_REVNUM(chunk->revision))
+            rev->rev_props = apr_hash_get(rev_props, &chunk->revision,
+                                          sizeof(chunk->revision));
+          apr_hash_set(revs, &rev->revision, sizeof(rev->revision), rev);
+        }
+
+      blame = blame_create(frb->chain, rev, (apr_off_t)chunk->start);
+      if (last)
+        last->next = blame;
+      else
+        frb->chain->blame = blame;
+      last = blame;
+    }
+
+  /* The blame information applies to the file as of end_rev. */
+  SVN_ERR(svn_stream_open_unique(&stream, &filename, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 frb->mainpool, pool));
+  SVN_ERR(svn_ra_get_file(ra_session, "", frb->end_rev, stream, NULL, NULL,
+                          pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  frb->last_filename = filename;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client_blame5(const char *target,
                   const svn_opt_revision_t *peg_revision,
@@ -806,16 +868,33 @@ svn_client_blame5(const char *target,
       frb.prevfilepool = svn_pool_create(pool);
     }
 
+  /* Servers that can compute the blame information themselves save us
+     from transferring and diffing every revision of the file.  Merged
+     revisions and backward blames still need the file revisions.  So do
+     non-default diff algorithms, because the blame protocol does not
+     transmit them and the server would silently use the default one. */
+  if (!include_merged_revisions && !frb.backwards
+      && diff_options->algorithm == svn_diff_file_algorithm_default)
+    {
+      svn_error_t *err = get_blame_from_server(&frb, ra_session, pool);
+
+      if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+        svn_error_clear(err);
+      else
+        SVN_ERR(err);
+    }
+
   /* Collect all blame information.
      We need to ensure that we get one revision before the start_rev,
      if available so that we can know what was actually changed in the start
      revision. */
-  SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
-                                frb.backwards ? start_revnum
-                                              : MAX(0, start_revnum-1),
-                                end_revnum,
-                                include_merged_revisions,
-                                file_rev_handler, &frb, pool));
+  if (!frb.last_filename)
+    SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
+                                  frb.backwards ? start_revnum
+                                                : MAX(0, start_revnum-1),
+                                  end_revnum,
+                                  include_merged_revisions,
+                                  file_rev_handler, &frb, pool));
 
   if (end->kind == svn_opt_revision_working)
     {
@@ -31,8 +31,10 @@
 #include <apr_pools.h>
 #include "svn_hash.h"
 #include "svn_client.h"
+#include "svn_config.h"
 #include "svn_error.h"
 
+#include "private/svn_client_private.h"
 #include "private/svn_wc_private.h"
 
 #include "client.h"
@@ -122,11 +124,50 @@ svn_client_create_context2(svn_client_ctx_t **ctx,
 
   SVN_ERR(svn_wc_context_create(&public_ctx->wc_ctx, cfg_config,
                                 pool, pool));
+  SVN_ERR(svn_client__start_status_monitor(NULL, public_ctx->wc_ctx,
+                                           cfg_hash, pool));
   *ctx = public_ctx;
 
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_client__start_status_monitor(svn_boolean_t *started,
+                                 svn_wc_context_t *wc_ctx,
+                                 apr_hash_t *config,
+                                 apr_pool_t *result_pool)
+{
+  svn_config_t *cfg_config = NULL;
+  svn_boolean_t enabled;
+  svn_error_t *err;
+
+  if (started)
+    *started = FALSE;
+
+  if (config)
+    cfg_config = svn_hash_gets(config, SVN_CONFIG_CATEGORY_CONFIG);
+
+  SVN_ERR(svn_config_get_bool(cfg_config, &enabled,
+                              SVN_CONFIG_SECTION_WORKING_COPY,
+                              SVN_CONFIG_OPTION_STATUS_MONITOR, FALSE));
+  if (! enabled)
+    return SVN_NO_ERROR;
+
+  /* The option may be shared with platforms that can't support it. */
+  err = svn_wc__status_monitor_start(wc_ctx, result_pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  if (started)
+    *started = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client_create_context(svn_client_ctx_t **ctx,
                           apr_pool_t *pool)
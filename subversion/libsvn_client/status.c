@@ -333,6 +333,13 @@ do_external_status(svn_client_ctx_t *ctx,
 /*** Public Interface. ***/
 
 
+void
+svn_client__set_read_only_status(svn_client_ctx_t *ctx,
+                                 svn_boolean_t read_only)
+{
+  svn_client__get_private_ctx(ctx)->read_only_status = read_only;
+}
+
 svn_error_t *
 svn_client_status6(svn_revnum_t *result_rev,
                    svn_client_ctx_t *ctx,
@@ -586,11 +593,21 @@ svn_client_status6(svn_revnum_t *result_rev,
     }
   else
     {
-      err = svn_wc_walk_status(ctx->wc_ctx, target_abspath,
-                               depth, get_all, no_ignore, FALSE, ignores,
-                               tweak_status, &sb,
-                               ctx->cancel_func, ctx->cancel_baton,
-                               pool);
+      /* Only read directories ahead of time if our caller promised
+         that STATUS_FUNC won't change the working copy. */
+      if (svn_client__get_private_ctx(ctx)->read_only_status)
+        err = svn_wc__walk_status_read_only(ctx->wc_ctx, target_abspath,
+                                            depth, get_all, no_ignore, FALSE,
+                                            ignores, tweak_status, &sb,
+                                            ctx->cancel_func,
+                                            ctx->cancel_baton,
+                                            pool);
+      else
+        err = svn_wc_walk_status(ctx->wc_ctx, target_abspath,
+                                 depth, get_all, no_ignore, FALSE, ignores,
+                                 tweak_status, &sb,
+                                 ctx->cancel_func, ctx->cancel_baton,
+                                 pool);
 
       if (err && err->apr_err == SVN_ERR_WC_MISSING)
         {
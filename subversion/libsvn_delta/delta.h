@@ -81,6 +81,18 @@ svn_txdelta__make_window(const svn_txdelta__ops_baton_t *build_baton,
                          apr_pool_t *pool);
 
 
+/* Compute and return a delta window using the xdelta algorithm on
+   DATA, which contains SOURCE_LEN bytes of source data and TARGET_LEN
+   bytes of target data.  SOURCE_OFFSET gives the offset of the source
+   data, and is simply copied into the window's sview_offset field.
+   Allocate the result and temporaries in POOL. */
+svn_txdelta_window_t *
+svn_txdelta__compute_window(const char *data,
+                            apr_size_t source_len,
+                            apr_size_t target_len,
+                            svn_filesize_t source_offset,
+                            apr_pool_t *pool);
+
 /* Create xdelta window data. Allocate temporary data from POOL. */
 void svn_txdelta__xdelta(svn_txdelta__ops_baton_t *build_baton,
                          const char *start,
@@ -35,6 +35,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_task.h"
 
 static const char SVNDIFF_V0[] = { 'S', 'V', 'N', 0 };
 static const char SVNDIFF_V1[] = { 'S', 'V', 'N', 1 };
@@ -344,6 +345,268 @@ svn_txdelta_to_svndiff(svn_stream_t *output,
                           SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, pool);
 }
 
+
+/* ----- Concurrent text delta to svndiff ----- */
+
+/* Baton for the stream returned by svn_txdelta__target_push_svndiff(). */
+struct pipelined_baton
+{
+  /* These are copied from the parameters passed to
+     svn_txdelta__target_push_svndiff(). */
+  svn_stream_t *source;
+  svn_stream_t *output;
+  int version;
+  int compression_level;
+
+  /* Computes and encodes the windows, emitting them in order. */
+  svn_task__queue_t *queue;
+
+  /* Source and target data for the next window. */
+  struct pipelined_window_t *current;
+
+  /* Offset of the next source view. */
+  svn_filesize_t source_offset;
+
+  /* All source data has been read. */
+  svn_boolean_t source_done;
+
+  /* The svndiff stream header has been written. */
+  svn_boolean_t header_done;
+
+  /* Pool to allocate the windows from. */
+  apr_pool_t *pool;
+};
+
+/* Input data for a single window, i.e. one task in the queue. */
+typedef struct pipelined_window_t
+{
+  /* The owning stream. */
+  struct pipelined_baton *pb;
+
+  /* Source view followed by target view data.  Allocated with this
+     struct in POOL, a sub-pool of PB->POOL owned by the stream's thread.
+     Once the window has been pushed, it will only be read from. */
+  char *buf;
+  apr_size_t source_len;
+  apr_size_t target_len;
+  svn_filesize_t source_offset;
+  apr_pool_t *pool;
+} pipelined_window_t;
+
+/* The svndiff representation of a window, as produced by encode_window(). */
+typedef struct encoded_window_t
+{
+  svn_stringbuf_t *header;
+  svn_stringbuf_t *instructions;
+  const svn_string_t *newdata;
+} encoded_window_t;
+
+/* Return a new, empty window to be filled with data for PB. */
+static pipelined_window_t *
+create_pipelined_window(struct pipelined_baton *pb)
+{
+  apr_pool_t *pool = svn_pool_create(pb->pool);
+  pipelined_window_t *w = apr_pcalloc(pool, sizeof(*w));
+
+  w->pb = pb;
+  w->pool = pool;
+  w->buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+  w->source_offset = pb->source_offset;
+
+  return w;
+}
+
+/* Implements svn_task__process_func_t.  Compute the delta for the
+   pipelined_window_t given as PROCESS_BATON and return its encoded
+   form as encoded_window_t in *RESULT. */
+static svn_error_t *
+encode_pipelined_window(void **result,
+                        void *process_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  pipelined_window_t *w = process_baton;
+  encoded_window_t *encoded = apr_palloc(result_pool, sizeof(*encoded));
+  svn_txdelta_window_t *window;
+
+  window = svn_txdelta__compute_window(w->buf, w->source_len, w->target_len,
+                                       w->source_offset, result_pool);
+  SVN_ERR(encode_window(&encoded->instructions, &encoded->header,
+                        &encoded->newdata, window, w->pb->version,
+                        w->pb->compression_level, result_pool));
+
+  *result = encoded;
+  return SVN_NO_ERROR;
+}
+
+/* Write the svndiff header to PB's output stream, if that has not
+   been done yet. */
+static svn_error_t *
+write_pipelined_header(struct pipelined_baton *pb)
+{
+  if (!pb->header_done)
+    {
+      apr_size_t len = SVNDIFF_HEADER_SIZE;
+      SVN_ERR(svn_stream_write(pb->output, get_svndiff_header(pb->version),
+                               &len));
+      pb->header_done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Write the encoded_window_t in
+   RESULT for the pipelined_window_t given as OUTPUT_BATON to the output
+   stream and release the window's memory. */
+static svn_error_t *
+write_pipelined_window(void *result,
+                       void *output_baton,
+                       apr_pool_t *scratch_pool)
+{
+  encoded_window_t *encoded = result;
+  pipelined_window_t *w = output_baton;
+  svn_stream_t *output = w->pb->output;
+  apr_size_t len;
+
+  SVN_ERR(write_pipelined_header(w->pb));
+
+  len = encoded->header->len;
+  SVN_ERR(svn_stream_write(output, encoded->header->data, &len));
+  if (encoded->instructions->len > 0)
+    {
+      len = encoded->instructions->len;
+      SVN_ERR(svn_stream_write(output, encoded->instructions->data, &len));
+    }
+  if (encoded->newdata->len > 0)
+    {
+      len = encoded->newdata->len;
+      SVN_ERR(svn_stream_write(output, encoded->newdata->data, &len));
+    }
+
+  svn_pool_destroy(w->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Hand the current window of PB over to the task queue and start a new
+   one.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+push_pipelined_window(struct pipelined_baton *pb,
+                      apr_pool_t *scratch_pool)
+{
+  pipelined_window_t *w = pb->current;
+
+  pb->source_offset += w->source_len;
+  pb->current = create_pipelined_window(pb);
+
+  return svn_error_trace(svn_task__queue_push(pb->queue,
+                                              encode_pipelined_window, w,
+                                              write_pipelined_window, w,
+                                              scratch_pool));
+}
+
+/* Implements svn_write_fn_t.  Same as tpush_write_handler() in
+   text_delta.c but queues the windows for concurrent processing. */
+static svn_error_t *
+pipelined_write_handler(void *baton,
+                        const char *data,
+                        apr_size_t *len)
+{
+  struct pipelined_baton *pb = baton;
+  apr_size_t chunk_len, data_len = *len;
+  apr_pool_t *scratch_pool = svn_pool_create(pb->pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (data_len > 0 && !err)
+    {
+      pipelined_window_t *w = pb->current;
+
+      /* Make sure we're all full up on source data, if possible. */
+      if (w->source_len == 0 && w->target_len == 0 && !pb->source_done)
+        {
+          w->source_len = SVN_DELTA_WINDOW_SIZE;
+          err = svn_stream_read_full(pb->source, w->buf, &w->source_len);
+          if (err)
+            break;
+          if (w->source_len < SVN_DELTA_WINDOW_SIZE)
+            pb->source_done = TRUE;
+        }
+
+      /* Copy in the target data, up to SVN_DELTA_WINDOW_SIZE. */
+      chunk_len = SVN_DELTA_WINDOW_SIZE - w->target_len;
+      if (chunk_len > data_len)
+        chunk_len = data_len;
+      memcpy(w->buf + w->source_len + w->target_len, data, chunk_len);
+      data += chunk_len;
+      data_len -= chunk_len;
+      w->target_len += chunk_len;
+
+      /* If we're full of target data, queue the window. */
+      if (w->target_len == SVN_DELTA_WINDOW_SIZE)
+        {
+          svn_pool_clear(scratch_pool);
+          err = push_pipelined_window(pb, scratch_pool);
+        }
+    }
+
+  svn_pool_destroy(scratch_pool);
+  return svn_error_trace(err);
+}
+
+/* Implements svn_close_fn_t.  Flush the last window, wait for all windows
+   to be written and close the output stream. */
+static svn_error_t *
+pipelined_close_handler(void *baton)
+{
+  struct pipelined_baton *pb = baton;
+  apr_pool_t *scratch_pool = svn_pool_create(pb->pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* Send a final window if we have any residual target data. */
+  if (pb->current->target_len > 0)
+    err = push_pipelined_window(pb, scratch_pool);
+
+  if (!err)
+    err = svn_task__queue_finish(pb->queue, scratch_pool);
+
+  /* Even an empty delta has the svndiff header. */
+  if (!err)
+    err = write_pipelined_header(pb);
+  if (!err)
+    err = svn_stream_close(pb->output);
+
+  svn_pool_destroy(scratch_pool);
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_txdelta__target_push_svndiff(svn_stream_t **stream,
+                                 svn_stream_t *output,
+                                 int svndiff_version,
+                                 int compression_level,
+                                 svn_stream_t *source,
+                                 int max_pending,
+                                 apr_pool_t *pool)
+{
+  struct pipelined_baton *pb = apr_pcalloc(pool, sizeof(*pb));
+
+  pb->source = source;
+  pb->output = output;
+  pb->version = svndiff_version;
+  pb->compression_level = compression_level;
+  pb->pool = pool;
+
+  SVN_ERR(svn_task__queue_create(&pb->queue, max_pending, pool));
+  pb->current = create_pipelined_window(pb);
+
+  *stream = svn_stream_create(pb, pool);
+  svn_stream_set_write(*stream, pipelined_write_handler);
+  svn_stream_set_close(*stream, pipelined_close_handler);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* ----- svndiff to text delta ----- */
 
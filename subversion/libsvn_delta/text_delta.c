@@ -33,8 +33,14 @@
 #include "svn_pools.h"
 #include "svn_checksum.h"
 
+#include "private/svn_dep_compat.h"
+
 #include "delta.h"
 
+#ifdef SVN_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
 
 /* Text delta stream descriptor. */
 
@@ -139,13 +145,12 @@ svn_txdelta__make_window(const svn_txdelta__ops_baton_t *build_baton,
 }
 
 
-/* Compute and return a delta window using the xdelta algorithm on
-   DATA, which contains SOURCE_LEN bytes of source data and TARGET_LEN
-   bytes of target data.  SOURCE_OFFSET gives the offset of the source
-   data, and is simply copied into the window's sview_offset field. */
-static svn_txdelta_window_t *
-compute_window(const char *data, apr_size_t source_len, apr_size_t target_len,
-               svn_filesize_t source_offset, apr_pool_t *pool)
+svn_txdelta_window_t *
+svn_txdelta__compute_window(const char *data,
+                            apr_size_t source_len,
+                            apr_size_t target_len,
+                            svn_filesize_t source_offset,
+                            apr_pool_t *pool)
 {
   svn_txdelta__ops_baton_t build_baton = { 0 };
   svn_txdelta_window_t *window;
@@ -388,8 +393,8 @@ txdelta_next_window(svn_txdelta_window_t **window,
   else if (b->context != NULL)
     SVN_ERR(svn_checksum_update(b->context, b->buf + source_len, target_len));
 
-  *window = compute_window(b->buf, source_len, target_len,
-                           b->pos - source_len, pool);
+  *window = svn_txdelta__compute_window(b->buf, source_len, target_len,
+                                        b->pos - source_len, pool);
 
   /* That's it. */
   return SVN_NO_ERROR;
@@ -538,8 +543,9 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       /* If we're full of target data, compute and fire off a window. */
       if (tb->target_len == SVN_DELTA_WINDOW_SIZE)
         {
-          window = compute_window(tb->buf, tb->source_len, tb->target_len,
-                                  tb->source_offset, pool);
+          window = svn_txdelta__compute_window(tb->buf, tb->source_len,
+                                               tb->target_len,
+                                               tb->source_offset, pool);
           SVN_ERR(tb->wh(window, tb->whb));
           tb->source_offset += tb->source_len;
           tb->source_len = 0;
@@ -564,8 +570,9 @@ tpush_close_handler(void *baton)
   /* Send a final window if we have any residual target data. */
   if (tb->target_len > 0)
     {
-      window = compute_window(tb->buf, tb->source_len, tb->target_len,
-                              tb->source_offset, tb->pool);
+      window = svn_txdelta__compute_window(tb->buf, tb->source_len,
+                                           tb->target_len,
+                                           tb->source_offset, tb->pool);
       SVN_ERR(tb->wh(window, tb->whb));
     }
 
@@ -628,17 +635,31 @@ size_buffer(char **buf, apr_size_t *buf_size,
 static APR_INLINE char *
 patterning_copy(char *target, const char *source, apr_size_t len)
 {
+  apr_size_t overlap = target - source;
+
+  /* Runs of a single byte, e.g. zero padding, are common enough to
+     deserve their own shortcut. */
+  if (overlap == 1 && len > 1)
+    {
+      memset(target, *source, len);
+      return target + len;
+    }
+
   /* If the source and target overlap, repeat the overlapping pattern
      in the target buffer. Always copy from the source buffer because
      presumably it will be in the L1 cache after the first iteration
      and doing this should avoid pipeline stalls due to write/read
-     dependencies. */
-  const apr_size_t overlap = target - source;
+     dependencies.
+
+     Each copy extends the repeated pattern that starts at SOURCE, so
+     we can copy twice as much in the next iteration.  Short patterns
+     thus take a few large memcpy() calls instead of many tiny ones. */
   while (len > overlap)
     {
       memcpy(target, source, overlap);
       target += overlap;
       len -= overlap;
+      overlap = target - source;
     }
 
   /* Copy any remaining source pattern. */
@@ -651,6 +672,24 @@ patterning_copy(char *target, const char *source, apr_size_t len)
   return target;
 }
 
+#ifdef SVN_HAVE_SSE2
+
+/* Most delta ops are short, and the function call overhead of memcpy()
+ * dominates the copying itself.  Ops of up to SHORT_COPY_SIZE bytes get
+ * copied using a single unaligned SSE2 load and store instead.  */
+#define SHORT_COPY_SIZE sizeof(__m128i)
+
+/* Copy SHORT_COPY_SIZE bytes from SOURCE to TARGET.  The ranges must not
+ * overlap.  */
+static APR_INLINE void
+short_copy(char *target, const char *source)
+{
+  _mm_storeu_si128((__m128i *)target,
+                   _mm_loadu_si128((const __m128i *)source));
+}
+
+#endif
+
 void
 svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
                                const char *sbuf, char *tbuf,
@@ -659,6 +698,15 @@ svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
   const svn_txdelta_op_t *op;
   apr_size_t tpos = 0;
 
+#ifdef SVN_HAVE_SSE2
+  /* Short copies may write up to SHORT_COPY_SIZE bytes, i.e. beyond the
+     end of the op.  That is fine as long as we stay within the part of
+     TBUF that later ops will overwrite anyway. */
+  const apr_size_t tlimit = *tlen < window->tview_len
+                          ? *tlen
+                          : window->tview_len;
+#endif
+
   /* Nothing to do for empty buffers.
    * This check allows for NULL TBUF in that case. */
   if (*tlen == 0)
@@ -678,7 +726,14 @@ svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
           /* Copy from source area.  */
           assert(sbuf);
           assert(op->offset + op->length <= window->sview_len);
-          memcpy(tbuf + tpos, sbuf + op->offset, buf_len);
+#ifdef SVN_HAVE_SSE2
+          if (   buf_len <= SHORT_COPY_SIZE
+              && tpos + SHORT_COPY_SIZE <= tlimit
+              && op->offset + SHORT_COPY_SIZE <= window->sview_len)
+            short_copy(tbuf + tpos, sbuf + op->offset);
+          else
+#endif
+            memcpy(tbuf + tpos, sbuf + op->offset, buf_len);
           break;
 
         case svn_txdelta_target:
@@ -689,15 +744,29 @@ svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
            * target ranges (they are just a result of self-compressed
            * data) but a small percentage will.  */
           assert(op->offset < tpos);
-          patterning_copy(tbuf + tpos, tbuf + op->offset, buf_len);
+#ifdef SVN_HAVE_SSE2
+          if (   buf_len <= SHORT_COPY_SIZE
+              && tpos + SHORT_COPY_SIZE <= tlimit
+              && op->offset + SHORT_COPY_SIZE <= tpos)
+            short_copy(tbuf + tpos, tbuf + op->offset);
+          else
+#endif
+            patterning_copy(tbuf + tpos, tbuf + op->offset, buf_len);
           break;
 
         case svn_txdelta_new:
           /* Copy from window new area.  */
           assert(op->offset + op->length <= window->new_data->len);
-          memcpy(tbuf + tpos,
-                 window->new_data->data + op->offset,
-                 buf_len);
+#ifdef SVN_HAVE_SSE2
+          if (   buf_len <= SHORT_COPY_SIZE
+              && tpos + SHORT_COPY_SIZE <= tlimit
+              && op->offset + SHORT_COPY_SIZE <= window->new_data->len)
+            short_copy(tbuf + tpos, window->new_data->data + op->offset);
+          else
+#endif
+            memcpy(tbuf + tpos,
+                   window->new_data->data + op->offset,
+                   buf_len);
           break;
 
         default:
@@ -26,6 +26,9 @@
 #include <apr_pools.h>
 #include <apr_general.h>
 
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
 #include "diff.h"
 
 
@@ -228,6 +231,36 @@ prepend_lcs(svn_diff__lcs_t *lcs, apr_off_t lines,
 }
 
 
+/* Since EOF is always a sync point, every lcs chain ends with an EOF link
+ * with sentinel positions.  Return that link for POSITION_LIST1 and
+ * POSITION_LIST2, either of which may be NULL, and the given number of
+ * PREFIX_LINES and SUFFIX_LINES. */
+static svn_diff__lcs_t *
+create_eof_lcs(svn_diff__position_t *position_list1,
+               svn_diff__position_t *position_list2,
+               apr_off_t prefix_lines,
+               apr_off_t suffix_lines,
+               apr_pool_t *pool)
+{
+  svn_diff__lcs_t *lcs;
+
+  lcs = apr_palloc(pool, sizeof(*lcs));
+  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
+  lcs->position[0]->offset = position_list1
+                             ? position_list1->offset + suffix_lines + 1
+                             : prefix_lines + suffix_lines + 1;
+  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
+  lcs->position[1]->offset = position_list2
+                             ? position_list2->offset + suffix_lines + 1
+                             : prefix_lines + suffix_lines + 1;
+  lcs->length = 0;
+  lcs->refcount = 1;
+  lcs->next = NULL;
+
+  return lcs;
+}
+
+
 svn_diff__lcs_t *
 svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               svn_diff__position_t *position_list2, /* pointer to tail (ring) */
@@ -250,21 +283,8 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
 
   svn_diff__position_t sentinel_position[2];
 
-  /* Since EOF is always a sync point we tack on an EOF link
-   * with sentinel positions
-   */
-  lcs = apr_palloc(pool, sizeof(*lcs));
-  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
-  lcs->position[0]->offset = position_list1
-                             ? position_list1->offset + suffix_lines + 1
-                             : prefix_lines + suffix_lines + 1;
-  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
-  lcs->position[1]->offset = position_list2
-                             ? position_list2->offset + suffix_lines + 1
-                             : prefix_lines + suffix_lines + 1;
-  lcs->length = 0;
-  lcs->refcount = 1;
-  lcs->next = NULL;
+  lcs = create_eof_lcs(position_list1, position_list2,
+                       prefix_lines, suffix_lines, pool);
 
   if (position_list1 == NULL || position_list2 == NULL)
     {
@@ -373,3 +393,379 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
   else
     return lcs;
 }
+
+
+/*
+ * Histogram diff.
+ *
+ * This is the algorithm used by JGit and "git diff --histogram", a
+ * variation of Bram Cohen's patience diff.  Within a region of both
+ * sources, count how often each token occurs in the original source.
+ * Then find the longest common run of tokens that contains the fewest
+ * occurrences of its rarest token, i.e. the run that is least likely to
+ * be a coincidental match of frequent lines like blank lines or closing
+ * braces.  That run is part of the result, and the regions before and
+ * after it get processed the same way.
+ *
+ * The result is not guaranteed to be a longest common subsequence, but
+ * on large files with many repeated lines it is found much faster and
+ * usually aligns better with how humans read the changes.  If a region
+ * has common tokens but all of them are too frequent to serve as an
+ * anchor, it is handed to the O(NP) algorithm above.
+ */
+
+/* Tokens occurring more often than this in the original region are not
+ * used as anchors. */
+#define SVN_DIFF__HISTOGRAM_MAX_CHAIN 64
+
+/* A region of both sources, given as [START, END) indexes into the
+ * position arrays.  A region with MATCH_LENGTH > 0 stands for a common
+ * run of that length at START, which is to be reported once all regions
+ * before it have been processed. */
+typedef struct histogram_region_t
+{
+  apr_off_t start[2];
+  apr_off_t end[2];
+  apr_off_t match_length;
+} histogram_region_t;
+
+typedef struct histogram_baton_t
+{
+  /* All positions of both sources, in order. */
+  svn_diff__position_t **positions[2];
+
+  /* Per token index: the generation in which COUNT and HEAD were last
+   * initialized.  Incrementing GENERATION invalidates all of them at
+   * once. */
+  apr_uint32_t *stamp;
+  apr_uint32_t generation;
+
+  /* Per token index: number of occurrences in the original region and
+   * index of the first one. */
+  apr_off_t *count;
+  apr_off_t *head;
+
+  /* Per original position: index of the next occurrence of the same
+   * token in the original region, or -1. */
+  apr_off_t *next;
+
+  /* The common runs found so far, in reverse order. */
+  svn_diff__lcs_t *lcs;
+} histogram_baton_t;
+
+/* Return the token index at INDEX in source IDX of HB. */
+#define HISTOGRAM_TOKEN(hb, idx, index) \
+  ((hb)->positions[idx][index]->token_index)
+
+/* Append a common run of LENGTH tokens at START0 and START1 to HB,
+ * allocated in POOL. */
+static void
+histogram_add_match(histogram_baton_t *hb,
+                    apr_off_t start0,
+                    apr_off_t start1,
+                    apr_off_t length,
+                    apr_pool_t *pool)
+{
+  svn_diff__lcs_t *last = hb->lcs;
+
+  /* Merge adjacent runs. */
+  if (last
+      && last->position[0]->offset + last->length
+         == hb->positions[0][start0]->offset
+      && last->position[1]->offset + last->length
+         == hb->positions[1][start1]->offset)
+    {
+      last->length += length;
+      return;
+    }
+
+  last = apr_palloc(pool, sizeof(*last));
+  last->position[0] = hb->positions[0][start0];
+  last->position[1] = hb->positions[1][start1];
+  last->length = length;
+  last->refcount = 1;
+  last->next = hb->lcs;
+  hb->lcs = last;
+}
+
+/* Find the best anchor in REGION of HB as described above and return it
+ * in *MATCH, with MATCH->MATCH_LENGTH set to 0 if there is none.  Set
+ * *HAS_COMMON to whether the region has any tokens in common at all. */
+static void
+histogram_find_match(histogram_region_t *match,
+                     svn_boolean_t *has_common,
+                     histogram_baton_t *hb,
+                     const histogram_region_t *region)
+{
+  apr_uint32_t generation = ++hb->generation;
+  apr_off_t best_count = SVN_DIFF__HISTOGRAM_MAX_CHAIN;
+  apr_off_t a, b, b_next;
+
+  match->match_length = 0;
+  *has_common = FALSE;
+
+  /* Index the original region.  Walk it backwards, so the chains end up
+   * in ascending order. */
+  for (a = region->end[0] - 1; a >= region->start[0]; a--)
+    {
+      svn_diff__token_index_t token = HISTOGRAM_TOKEN(hb, 0, a);
+
+      if (hb->stamp[token] != generation)
+        {
+          hb->stamp[token] = generation;
+          hb->count[token] = 0;
+          hb->head[token] = -1;
+        }
+
+      hb->next[a] = hb->head[token];
+      hb->head[token] = a;
+      hb->count[token]++;
+    }
+
+  for (b = region->start[1]; b < region->end[1]; b = b_next)
+    {
+      svn_diff__token_index_t token = HISTOGRAM_TOKEN(hb, 1, b);
+
+      b_next = b + 1;
+      if (hb->stamp[token] != generation)
+        continue;
+
+      *has_common = TRUE;
+      if (hb->count[token] > best_count)
+        continue;
+
+      a = hb->head[token];
+      while (a >= 0)
+        {
+          apr_off_t start0 = a, start1 = b, end0 = a + 1, end1 = b + 1;
+          apr_off_t rarest = hb->count[token];
+
+          /* Extend the common run in both directions. */
+          while (start0 > region->start[0] && start1 > region->start[1]
+                 && HISTOGRAM_TOKEN(hb, 0, start0 - 1)
+                    == HISTOGRAM_TOKEN(hb, 1, start1 - 1))
+            {
+              start0--;
+              start1--;
+              rarest = MIN(rarest,
+                           hb->count[HISTOGRAM_TOKEN(hb, 0, start0)]);
+            }
+
+          while (end0 < region->end[0] && end1 < region->end[1]
+                 && HISTOGRAM_TOKEN(hb, 0, end0)
+                    == HISTOGRAM_TOKEN(hb, 1, end1))
+            {
+              rarest = MIN(rarest,
+                           hb->count[HISTOGRAM_TOKEN(hb, 0, end0)]);
+              end0++;
+              end1++;
+            }
+
+          /* No other anchor within this run can do any better. */
+          if (b_next < end1)
+            b_next = end1;
+
+          if (match->match_length < end0 - start0 || rarest < best_count)
+            {
+              match->start[0] = start0;
+              match->start[1] = start1;
+              match->match_length = end0 - start0;
+              best_count = rarest;
+            }
+
+          /* Skip the occurrences covered by this run. */
+          do
+            a = hb->next[a];
+          while (a >= 0 && a < end0);
+        }
+    }
+}
+
+/* Add the common runs in REGION of HB, as found by the O(NP) algorithm,
+ * allocated in RESULT_POOL.  Use SCRATCH_POOL for temporary allocations. */
+static void
+histogram_fallback(histogram_baton_t *hb,
+                   const histogram_region_t *region,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  apr_uint32_t generation = ++hb->generation;
+  svn_diff__position_t *list[2];
+  svn_diff__token_index_t *token_counts[2];
+  svn_diff__token_index_t num_tokens = 0;
+  svn_diff__lcs_t *lcs;
+  int idx;
+
+  /* Number the tokens in this region densely, so the O(NP) algorithm
+   * does not need to deal with the token counts of whole files. */
+  for (idx = 0; idx < 2; idx++)
+    {
+      apr_off_t i;
+      for (i = region->start[idx]; i < region->end[idx]; i++)
+        {
+          svn_diff__token_index_t token = HISTOGRAM_TOKEN(hb, idx, i);
+          if (hb->stamp[token] != generation)
+            {
+              hb->stamp[token] = generation;
+              hb->head[token] = num_tokens++;
+            }
+        }
+    }
+
+  /* Build the rings of positions and count the tokens. */
+  for (idx = 0; idx < 2; idx++)
+    {
+      apr_off_t length = region->end[idx] - region->start[idx];
+      svn_diff__position_t *copies
+        = apr_palloc(scratch_pool, length * sizeof(*copies));
+      apr_off_t i;
+
+      token_counts[idx] = apr_pcalloc(scratch_pool,
+                                      num_tokens * sizeof(*token_counts[idx]));
+      for (i = 0; i < length; i++)
+        {
+          const svn_diff__position_t *original
+            = hb->positions[idx][region->start[idx] + i];
+
+          copies[i].token_index = hb->head[original->token_index];
+          copies[i].offset = original->offset;
+          copies[i].next = &copies[(i + 1) % length];
+          token_counts[idx][copies[i].token_index]++;
+        }
+
+      list[idx] = &copies[length - 1];
+    }
+
+  lcs = svn_diff__lcs(list[0], list[1], token_counts[0], token_counts[1],
+                      num_tokens, 0, 0, scratch_pool);
+  for (; lcs->length; lcs = lcs->next)
+    histogram_add_match(hb,
+                        region->start[0] + lcs->position[0]->offset
+                        - list[0]->next->offset,
+                        region->start[1] + lcs->position[1]->offset
+                        - list[1]->next->offset,
+                        lcs->length, result_pool);
+}
+
+svn_diff__lcs_t *
+svn_diff__lcs_histogram(svn_diff__position_t *position_list1,
+                        svn_diff__position_t *position_list2,
+                        svn_diff__token_index_t num_tokens,
+                        apr_off_t prefix_lines,
+                        apr_off_t suffix_lines,
+                        apr_pool_t *pool)
+{
+  svn_diff__position_t *lists[2];
+  histogram_baton_t hb = { { 0 } };
+  apr_array_header_t *stack;
+  apr_pool_t *scratch_pool;
+  svn_diff__lcs_t *lcs;
+  histogram_region_t *region;
+  int idx;
+
+  lcs = create_eof_lcs(position_list1, position_list2,
+                       prefix_lines, suffix_lines, pool);
+
+  if (suffix_lines)
+    lcs = prepend_lcs(lcs, suffix_lines,
+                      lcs->position[0]->offset - suffix_lines,
+                      lcs->position[1]->offset - suffix_lines,
+                      pool);
+
+  if (position_list1 == NULL || position_list2 == NULL)
+    return prefix_lines ? prepend_lcs(lcs, prefix_lines, 1, 1, pool) : lcs;
+
+  scratch_pool = svn_pool_create(pool);
+  stack = apr_array_make(scratch_pool, 16, sizeof(histogram_region_t));
+  region = apr_array_push(stack);
+
+  lists[0] = position_list1;
+  lists[1] = position_list2;
+  for (idx = 0; idx < 2; idx++)
+    {
+      svn_diff__position_t *position = lists[idx]->next;
+      apr_off_t length = lists[idx]->offset - position->offset + 1;
+      apr_off_t i;
+
+      hb.positions[idx] = apr_palloc(scratch_pool,
+                                     length * sizeof(*hb.positions[idx]));
+      for (i = 0; i < length; i++, position = position->next)
+        hb.positions[idx][i] = position;
+
+      region->start[idx] = 0;
+      region->end[idx] = length;
+    }
+  region->match_length = 0;
+
+  hb.stamp = apr_pcalloc(scratch_pool, num_tokens * sizeof(*hb.stamp));
+  hb.count = apr_palloc(scratch_pool, num_tokens * sizeof(*hb.count));
+  hb.head = apr_palloc(scratch_pool, num_tokens * sizeof(*hb.head));
+  hb.next = apr_palloc(scratch_pool, region->end[0] * sizeof(*hb.next));
+
+  /* Process the regions depth-first, left to right, so the common runs
+   * get found in order. */
+  while (stack->nelts)
+    {
+      histogram_region_t current = *(histogram_region_t *)apr_array_pop(stack);
+      histogram_region_t match;
+      svn_boolean_t has_common;
+
+      if (current.match_length)
+        {
+          histogram_add_match(&hb, current.start[0], current.start[1],
+                              current.match_length, pool);
+          continue;
+        }
+
+      if (current.start[0] == current.end[0]
+          || current.start[1] == current.end[1])
+        continue;
+
+      histogram_find_match(&match, &has_common, &hb, &current);
+      if (match.match_length)
+        {
+          /* Right side, the match itself, left side.  In reverse order,
+           * because this is a stack. */
+          region = apr_array_push(stack);
+          region->start[0] = match.start[0] + match.match_length;
+          region->start[1] = match.start[1] + match.match_length;
+          region->end[0] = current.end[0];
+          region->end[1] = current.end[1];
+          region->match_length = 0;
+
+          region = apr_array_push(stack);
+          *region = match;
+
+          region = apr_array_push(stack);
+          region->start[0] = current.start[0];
+          region->start[1] = current.start[1];
+          region->end[0] = match.start[0];
+          region->end[1] = match.start[1];
+          region->match_length = 0;
+        }
+      else if (has_common)
+        {
+          apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+          histogram_fallback(&hb, &current, pool, iterpool);
+          svn_pool_destroy(iterpool);
+        }
+    }
+
+  /* HB.LCS is in reverse order, so prepending each link restores the
+   * original one. */
+  while (hb.lcs)
+    {
+      svn_diff__lcs_t *next = hb.lcs->next;
+
+      hb.lcs->next = lcs;
+      lcs = hb.lcs;
+      hb.lcs = next;
+    }
+
+  svn_pool_destroy(scratch_pool);
+
+  if (prefix_lines)
+    return prepend_lcs(lcs, prefix_lines, 1, 1, pool);
+  else
+    return lcs;
+}
@@ -34,16 +34,25 @@
 
 
 /*
- * Prime number to use as the size of the hash table.  This number was
- * not selected by testing of any kind and may need tweaking.
+ * Initial number of buckets in the token hash table.  Must be a power
+ * of two.  The table doubles whenever it holds more tokens than buckets.
  */
-#define SVN_DIFF__HASH_SIZE 127
+#define SVN_DIFF__HASH_SIZE 256
+
+/*
+ * Nodes and positions get allocated in blocks, starting with the
+ * minimum block size and doubling up to the maximum one.  Large files
+ * easily contain millions of lines, so allocating them one by one would
+ * spend most of the time in the pool allocator, while small files should
+ * not pay for large blocks.
+ */
+#define SVN_DIFF__MIN_BLOCK_SIZE 32
+#define SVN_DIFF__MAX_BLOCK_SIZE 4096
 
 struct svn_diff__node_t
 {
-  svn_diff__node_t       *parent;
-  svn_diff__node_t       *left;
-  svn_diff__node_t       *right;
+  /* Next node in the same hash bucket. */
+  svn_diff__node_t       *next;
 
   apr_uint32_t            hash;
   svn_diff__token_index_t index;
@@ -52,7 +61,15 @@ struct svn_diff__node_t
 
 struct svn_diff__tree_t
 {
-  svn_diff__node_t       *root[SVN_DIFF__HASH_SIZE];
+  /* BUCKET_MASK + 1 chains of nodes. */
+  svn_diff__node_t      **buckets;
+  apr_uint32_t            bucket_mask;
+
+  /* Unused nodes of the most recently allocated node block. */
+  svn_diff__node_t       *free_nodes;
+  apr_size_t              free_count;
+  apr_size_t              block_size;
+
   apr_pool_t             *pool;
   svn_diff__token_index_t node_count;
 };
@@ -75,68 +92,115 @@ void
 svn_diff__tree_create(svn_diff__tree_t **tree, apr_pool_t *pool)
 {
   *tree = apr_pcalloc(pool, sizeof(**tree));
+  (*tree)->buckets = apr_pcalloc(pool, SVN_DIFF__HASH_SIZE
+                                       * sizeof(*(*tree)->buckets));
+  (*tree)->bucket_mask = SVN_DIFF__HASH_SIZE - 1;
+  (*tree)->block_size = SVN_DIFF__MIN_BLOCK_SIZE;
   (*tree)->pool = pool;
   (*tree)->node_count = 0;
 }
 
+/* Return the bucket in TREE for HASH.  The hashes provided by the
+ * datasources tend to have poorly distributed low bits (e.g. Adler-32),
+ * so mix all bits into the bucket index.
+ */
+static APR_INLINE svn_diff__node_t **
+get_bucket(svn_diff__tree_t *tree, apr_uint32_t hash)
+{
+  apr_uint32_t mixed = hash * 0x9e3779b1;
+
+  return &tree->buckets[(mixed ^ (mixed >> 16)) & tree->bucket_mask];
+}
+
+/* Double the number of buckets in TREE and redistribute all nodes. */
+static void
+grow_hash_table(svn_diff__tree_t *tree)
+{
+  svn_diff__node_t **old_buckets = tree->buckets;
+  apr_uint32_t old_count = tree->bucket_mask + 1;
+  apr_uint32_t i;
+
+  tree->buckets = apr_pcalloc(tree->pool,
+                              2 * old_count * sizeof(*tree->buckets));
+  tree->bucket_mask = 2 * old_count - 1;
+
+  for (i = 0; i < old_count; i++)
+    {
+      svn_diff__node_t *node = old_buckets[i];
+      while (node)
+        {
+          svn_diff__node_t *next = node->next;
+          svn_diff__node_t **bucket = get_bucket(tree, node->hash);
+
+          node->next = *bucket;
+          *bucket = node;
+          node = next;
+        }
+    }
+}
 
+/* Find the node for TOKEN with HASH in TREE, creating a new one if this
+ * is the first time such a token is seen, and return it in *NODE.
+ */
 static svn_error_t *
-tree_insert_token(svn_diff__node_t **node, svn_diff__tree_t *tree,
-                  void *diff_baton,
-                  const svn_diff_fns2_t *vtable,
-                  apr_uint32_t hash, void *token)
+intern_token(svn_diff__node_t **node, svn_diff__tree_t *tree,
+             void *diff_baton,
+             const svn_diff_fns2_t *vtable,
+             apr_uint32_t hash, void *token)
 {
   svn_diff__node_t *new_node;
-  svn_diff__node_t **node_ref;
-  svn_diff__node_t *parent;
+  svn_diff__node_t **bucket;
+  svn_diff__node_t *candidate;
   int rv;
 
   SVN_ERR_ASSERT(token);
 
-  parent = NULL;
-  node_ref = &tree->root[hash % SVN_DIFF__HASH_SIZE];
-
-  while (*node_ref != NULL)
+  bucket = get_bucket(tree, hash);
+  for (candidate = *bucket; candidate != NULL; candidate = candidate->next)
     {
-      parent = *node_ref;
-
-      rv = hash - parent->hash;
-      if (!rv)
-        SVN_ERR(vtable->token_compare(diff_baton, parent->token, token, &rv));
+      if (candidate->hash != hash)
+        continue;
 
+      SVN_ERR(vtable->token_compare(diff_baton, candidate->token, token,
+                                    &rv));
       if (rv == 0)
         {
           /* Discard the previous token.  This helps in cases where
            * only recently read tokens are still in memory.
            */
           if (vtable->token_discard != NULL)
-            vtable->token_discard(diff_baton, parent->token);
+            vtable->token_discard(diff_baton, candidate->token);
 
-          parent->token = token;
-          *node = parent;
+          candidate->token = token;
+          *node = candidate;
 
           return SVN_NO_ERROR;
         }
-      else if (rv > 0)
-        {
-          node_ref = &parent->left;
-        }
-      else
-        {
-          node_ref = &parent->right;
-        }
     }
 
   /* Create a new node */
-  new_node = apr_palloc(tree->pool, sizeof(*new_node));
-  new_node->parent = parent;
-  new_node->left = NULL;
-  new_node->right = NULL;
+  if (tree->free_count == 0)
+    {
+      tree->free_nodes = apr_palloc(tree->pool, tree->block_size
+                                                * sizeof(*tree->free_nodes));
+      tree->free_count = tree->block_size;
+      if (tree->block_size < SVN_DIFF__MAX_BLOCK_SIZE)
+        tree->block_size *= 2;
+    }
+
+  new_node = tree->free_nodes++;
+  tree->free_count--;
+
+  new_node->next = *bucket;
   new_node->hash = hash;
   new_node->token = token;
   new_node->index = tree->node_count++;
 
-  *node = *node_ref = new_node;
+  *node = *bucket = new_node;
+
+  /* Keep the chains short. */
+  if ((apr_uint32_t)tree->node_count > tree->bucket_mask)
+    grow_hash_table(tree);
 
   return SVN_NO_ERROR;
 }
@@ -158,6 +222,9 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
   svn_diff__position_t *start_position;
   svn_diff__position_t *position = NULL;
   svn_diff__position_t **position_ref;
+  svn_diff__position_t *free_positions = NULL;
+  apr_size_t free_count = 0;
+  apr_size_t block_size = SVN_DIFF__MIN_BLOCK_SIZE;
   svn_diff__node_t *node;
   void *token;
   apr_off_t offset;
@@ -176,10 +243,20 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
         break;
 
       offset++;
-      SVN_ERR(tree_insert_token(&node, tree, diff_baton, vtable, hash, token));
+      SVN_ERR(intern_token(&node, tree, diff_baton, vtable, hash, token));
+
+      /* Create a new position, allocating them in blocks as well */
+      if (free_count == 0)
+        {
+          free_positions = apr_palloc(pool, block_size
+                                            * sizeof(*free_positions));
+          free_count = block_size;
+          if (block_size < SVN_DIFF__MAX_BLOCK_SIZE)
+            block_size *= 2;
+        }
 
-      /* Create a new position */
-      position = apr_palloc(pool, sizeof(*position));
+      position = free_positions++;
+      free_count--;
       position->next = NULL;
       position->token_index = node->index;
       position->offset = offset;
@@ -3511,16 +3511,37 @@ read_item(svn_stream_t **stream,
   svn_checksum_t *expected, *actual;
   apr_uint32_t plain_digest;
 
-  /* Read item into string buffer. */
-  svn_stringbuf_t *text = svn_stringbuf_create_ensure(entry->size, pool);
-  text->len = entry->size;
-  text->data[text->len] = 0;
-  SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
-                                 NULL, NULL, pool));
+  if (rev_file->mapped_data)
+    {
+      /* Parse the item directly from the mapped file. */
+      svn_string_t *text = apr_palloc(pool, sizeof(*text));
+      if (   entry->offset < 0
+          || entry->size > rev_file->mapped_size - entry->offset)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Item at offset %s in revision %ld "
+                                   "exceeds the pack file"),
+                                 apr_off_t_toa(pool, entry->offset),
+                                 entry->item.revision);
 
-  /* Return (construct, calculate) stream and checksum. */
-  *stream = svn_stream_from_stringbuf(text, pool);
-  digest = svn__fnv1a_32x4(text->data, text->len);
+      text->data = rev_file->mapped_data + entry->offset;
+      text->len = (apr_size_t)entry->size;
+
+      *stream = svn_stream_from_string(text, pool);
+      digest = svn__fnv1a_32x4(text->data, text->len);
+    }
+  else
+    {
+      /* Read item into string buffer. */
+      svn_stringbuf_t *text = svn_stringbuf_create_ensure(entry->size, pool);
+      text->len = entry->size;
+      text->data[text->len] = 0;
+      SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
+                                     NULL, NULL, pool));
+
+      /* Return (construct, calculate) stream and checksum. */
+      *stream = svn_stream_from_stringbuf(text, pool);
+      digest = svn__fnv1a_32x4(text->data, text->len);
+    }
 
   /* Checksums will match most of the time. */
   if (entry->fnv1_checksum == digest)
@@ -3718,8 +3739,10 @@ block_read(void **result,
                                           ffd->block_size, scratch_pool,
                                           scratch_pool));
 
-      SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, offset,
-                           iterpool));
+      /* Prefetch the block unless we can access it directly. */
+      if (!revision_file->mapped_data)
+        SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, offset,
+                             iterpool));
 
       /* read all items from the block */
       for (i = 0; i < entries->nelts; ++i)
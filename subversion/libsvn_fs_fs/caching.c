@@ -346,6 +346,52 @@ create_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+/* If FS has been configured to use a persistent second-level cache, put
+ * it behind the membuffer-based *CACHE_P and replace *CACHE_P with the
+ * combined cache.  SERIALIZER, DESERIALIZER and KLEN must be the ones
+ * that *CACHE_P has been created with.  NAME identifies the type of data
+ * within FS.  Short-lived caches as indicated by HAS_NAMESPACE and
+ * memcached-based caches will not be touched.
+ *
+ * Unless NO_HANDLER is true, register the usual error handler for the
+ * new cache object.  Allocate it in RESULT_POOL.
+ */
+static svn_error_t *
+add_disk_tier(svn_cache__t **cache_p,
+              svn_cache__serialize_func_t serializer,
+              svn_cache__deserialize_func_t deserializer,
+              apr_ssize_t klen,
+              const char *name,
+              svn_boolean_t has_namespace,
+              svn_fs_t *fs,
+              svn_boolean_t no_handler,
+              apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *prefix;
+
+  if (   *cache_p == NULL
+      || ffd->disk_cache == NULL
+      || ffd->memcache != NULL
+      || has_namespace
+      || svn_cache__get_global_membuffer_cache() == NULL)
+    return SVN_NO_ERROR;
+
+  /* Since the store survives restarts, make sure that the keys become
+   * invalid once the repository gets replaced. */
+  prefix = apr_pstrcat(result_pool, "fsfs:", fs->uuid, ":",
+                       ffd->instance_id, ":", name, SVN_VA_NULL);
+  SVN_ERR(svn_cache__create_disk_tier(cache_p, *cache_p, ffd->disk_cache,
+                                      serializer, deserializer, klen,
+                                      prefix, result_pool));
+
+  SVN_ERR(init_callbacks(*cache_p, fs,
+                         no_handler ? NULL : warn_and_fail_on_cache_errors,
+                         result_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__initialize_caches(svn_fs_t *fs,
                              apr_pool_t *pool)
@@ -546,6 +592,14 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(add_disk_tier(&(ffd->fulltext_cache),
+                            NULL, NULL,
+                            sizeof(pair_cache_key_t),
+                            "TEXT",
+                            has_namespace,
+                            fs,
+                            no_handler,
+                            fs->pool));
 
       SVN_ERR(create_cache(&(ffd->mergeinfo_cache),
                            NULL,
@@ -639,6 +693,15 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(add_disk_tier(&(ffd->txdelta_window_cache),
+                            svn_fs_fs__serialize_txdelta_window,
+                            svn_fs_fs__deserialize_txdelta_window,
+                            sizeof(window_cache_key_t),
+                            "TXDELTA_WINDOW",
+                            has_namespace,
+                            fs,
+                            no_handler,
+                            fs->pool));
 
       SVN_ERR(create_cache(&(ffd->combined_window_cache),
                            NULL,
@@ -654,6 +717,14 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(add_disk_tier(&(ffd->combined_window_cache),
+                            NULL, NULL,
+                            sizeof(window_cache_key_t),
+                            "COMBINED_WINDOW",
+                            has_namespace,
+                            fs,
+                            no_handler,
+                            fs->pool));
     }
   else
     {
@@ -32,6 +32,7 @@
 #include "svn_delta.h"
 #include "svn_version.h"
 #include "svn_pools.h"
+#include "batch_fsync.h"
 #include "fs.h"
 #include "fs_fs.h"
 #include "tree.h"
@@ -119,6 +120,14 @@ fs_serialized_init(svn_fs_t *fs, apr_pool_t *common_pool, apr_pool_t *pool)
       SVN_ERR(svn_mutex__init(&ffsd->txn_current_lock,
                               SVN_FS_FS__USE_LOCK_MUTEX, common_pool));
 
+      /* We also need a mutex for synchronizing access to the shared
+         memory mapped pack files. */
+      SVN_ERR(svn_mutex__init(&ffsd->mapped_files_lock, TRUE, common_pool));
+
+      /* ... and to the filter for rep-cache lookups. */
+      SVN_ERR(svn_mutex__init(&ffsd->rep_cache_filter_lock, TRUE,
+                              common_pool));
+
       /* We also need a mutex for synchronizing access to the active
          transaction list and free transaction pointer. */
       SVN_ERR(svn_mutex__init(&ffsd->txn_list_lock, TRUE, common_pool));
@@ -293,6 +302,7 @@ initialize_fs_struct(svn_fs_t *fs)
   ffd->use_log_addressing = FALSE;
   ffd->revprop_prefix = 0;
   ffd->flush_to_disk = TRUE;
+  svn_fs_fs__id_txn_reset(&ffd->rep_cache_filter_txn_id);
 
   fs->vtable = &fs_vtable;
   fs->fsap_data = ffd;
@@ -367,6 +377,35 @@ fs_open(svn_fs_t *fs,
 
 
 
+svn_error_t *
+svn_fs_fs__open_instance(svn_fs_t **instance_p,
+                         svn_fs_t *fs,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_data_t *instance_ffd;
+  svn_fs_t *instance = apr_pcalloc(result_pool, sizeof(*instance));
+
+  instance->pool = result_pool;
+  instance->warning = fs->warning;
+  instance->warning_baton = fs->warning_baton;
+  instance->config = fs->config;
+
+  SVN_ERR(initialize_fs_struct(instance));
+  SVN_ERR(svn_fs_fs__open(instance, fs->path, scratch_pool));
+  SVN_ERR(svn_fs_fs__initialize_caches(instance, scratch_pool));
+
+  /* This is what fs_serialized_init() would find for this repository. */
+  instance_ffd = instance->fsap_data;
+  instance_ffd->shared = ffd->shared;
+  instance_ffd->svn_fs_open_ = ffd->svn_fs_open_;
+
+  *instance_p = instance;
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements the fs_library_vtable_t.open_for_recovery() API. */
 static svn_error_t *
 fs_open_for_recovery(svn_fs_t *fs,
@@ -624,6 +663,7 @@ svn_fs_fs__init(const svn_version_t *loader_version,
                              _("Unsupported FS loader version (%d) for fsfs"),
                              loader_version->major);
   SVN_ERR(svn_ver_check_list2(fs_version(), checklist, svn_ver_equal));
+  SVN_ERR(svn_fs_fs__batch_fsync_init(common_pool));
 
   *vtable = &library_vtable;
   return SVN_NO_ERROR;
@@ -78,6 +78,8 @@ extern "C" {
                                                     to-log index */
 /* If you change this, look at tests/svn_test_fs.c(maybe_install_fsfs_conf) */
 #define PATH_CONFIG           "fsfs.conf"        /* Configuration */
+#define PATH_DISK_CACHE       "disk-cache"       /* Persistent second-level
+                                                    cache file */
 
 /* Names of special files and file extensions for transactions */
 #define PATH_CHANGES       "changes"       /* Records changes made so far */
@@ -100,6 +102,7 @@ extern "C" {
 /* Names of sections and options in fsfs.conf. */
 #define CONFIG_SECTION_CACHES            "caches"
 #define CONFIG_OPTION_FAIL_STOP          "fail-stop"
+#define CONFIG_OPTION_DISK_CACHE_SIZE    "disk-cache-size"
 #define CONFIG_SECTION_REP_SHARING       "rep-sharing"
 #define CONFIG_OPTION_ENABLE_REP_SHARING "enable-rep-sharing"
 #define CONFIG_SECTION_DELTIFICATION     "deltification"
@@ -115,10 +118,14 @@ extern "C" {
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_OPTION_MMAP_PACKED_FILES  "mmap-packed-files"
+#define CONFIG_SECTION_PACK              "pack"
+#define CONFIG_OPTION_PACK_THREADS       "pack-threads"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 #define CONFIG_OPTION_VERIFY_BEFORE_COMMIT "verify-before-commit"
 #define CONFIG_OPTION_COMPRESSION        "compression"
+#define CONFIG_OPTION_DELTA_THREADS      "delta-threads"
 
 /* The format number of this filesystem.
    This is independent of the repository format number, and
@@ -275,6 +282,27 @@ typedef struct fs_fs_shared_data_t
      txn-current file. */
   svn_mutex__t *txn_current_lock;
 
+  /* A lock for intra-process synchronization when accessing MAPPED_FILES.
+     No other lock will be acquired while holding this one. */
+  svn_mutex__t *mapped_files_lock;
+
+  /* Memory mapped pack files, shared between all filesystem objects of
+     this repository.  Maps the shard number to a mapped_file_t (see rev_file.c).
+     Created upon first use in MAPPED_FILES_POOL, a subpool of COMMON_POOL.
+     All access is synchronised under MAPPED_FILES_LOCK. */
+  apr_hash_t *mapped_files;
+  apr_pool_t *mapped_files_pool;
+
+  /* A lock for intra-process synchronization when accessing
+     REP_CACHE_FILTER.  No other lock will be acquired while holding
+     this one. */
+  svn_mutex__t *rep_cache_filter_lock;
+
+  /* In-memory filter telling us which representations are definitely not
+     in rep-cache.db.  Created upon first use in COMMON_POOL.  All access
+     is synchronised under REP_CACHE_FILTER_LOCK. */
+  struct rep_cache_filter_t *rep_cache_filter;
+
   /* The common pool, under which this object is allocated, subpools
      of which are used to allocate the transaction objects. */
   apr_pool_t *common_pool;
@@ -343,6 +371,10 @@ typedef struct fs_fs_data_t
    * index page. */
   apr_int64_t p2l_page_size;
 
+  /* Map pack files into memory and read index and meta data directly
+   * from the mapped region. */
+  svn_boolean_t mmap_packed_files;
+
   /* If set, parse and cache *all* data of each block that we read
    * (not just the one bit that we need, atm). */
   svn_boolean_t use_block_read;
@@ -360,6 +392,10 @@ typedef struct fs_fs_data_t
      e.g. memcached may be ignored as caching is an optional feature. */
   svn_boolean_t fail_stop;
 
+  /* Persistent second-level cache for fulltexts and delta windows.
+     NULL if disabled. */
+  svn_cache__disk_t *disk_cache;
+
   /* A cache of revision root IDs, mapping from (svn_revnum_t *) to
      (svn_fs_id_t *).  (Not threadsafe.) */
   svn_cache__t *rev_root_id_cache;
@@ -465,6 +501,10 @@ typedef struct fs_fs_data_t
   /* Thread-safe boolean */
   svn_atomic_t rep_cache_db_opened;
 
+  /* The transaction for which we last checked whether the shared
+     rep-cache filter is up to date.  See rep-cache.c. */
+  svn_fs_fs__id_part_t rep_cache_filter_txn_id;
+
   /* The oldest revision not in a pack file.  It also applies to revprops
    * if revprop packing has been enabled by the FSFS format version. */
   svn_revnum_t min_unpacked_rev;
@@ -499,6 +539,14 @@ typedef struct fs_fs_data_t
   /* Compression level (currently, only used with compression_type_zlib). */
   int delta_compression_level;
 
+  /* Maximum number of delta windows of a file representation to compute
+   * and compress concurrently.  1 means fully sequential processing. */
+  apr_int64_t delta_threads;
+
+  /* Maximum number of shards to pack concurrently.  1 means fully
+   * sequential processing. */
+  apr_int64_t pack_threads;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
@@ -65,6 +65,12 @@
    Values < 2 will result in standard skip-delta behavior. */
 #define SVN_FS_FS_MAX_LINEAR_DELTIFICATION 16
 
+/* Upper limit for the [deltification] delta-threads setting. */
+#define SVN_FS_FS_MAX_DELTA_THREADS 64
+
+/* Upper limit for the number of shards being packed concurrently. */
+#define SVN_FS_FS_MAX_PACK_THREADS 64
+
 /* Finding a deltification base takes operations proportional to the
    number of changes being skipped. To prevent exploding runtime
    during commits, limit the deltification range to this value.
@@ -747,6 +753,7 @@ read_config(fs_fs_data_t *ffd,
             apr_pool_t *scratch_pool)
 {
   svn_config_t *config;
+  apr_int64_t disk_cache_size;
 
   SVN_ERR(svn_config_read3(&config,
                            svn_dirent_join(fs_path, PATH_CONFIG, scratch_pool),
@@ -824,6 +831,10 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_IO,
                                    CONFIG_OPTION_P2L_PAGE_SIZE,
                                    0x400));
+      SVN_ERR(svn_config_get_bool(config, &ffd->mmap_packed_files,
+                                  CONFIG_SECTION_IO,
+                                  CONFIG_OPTION_MMAP_PACKED_FILES,
+                                  FALSE));
 
       /* Don't accept unreasonable or illegal values.
        * Block size and P2L page size are in kbytes;
@@ -846,6 +857,7 @@ read_config(fs_fs_data_t *ffd,
       ffd->block_size = 0x1000; /* Matches default APR file buffer size. */
       ffd->l2p_page_size = 0x2000;    /* Matches above default. */
       ffd->p2l_page_size = 0x100000;  /* Matches above default in bytes. */
+      ffd->mmap_packed_files = FALSE;
     }
 
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
@@ -925,6 +937,18 @@ read_config(fs_fs_data_t *ffd,
       ffd->delta_compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
     }
 
+  SVN_ERR(svn_config_get_int64(config, &ffd->delta_threads,
+                               CONFIG_SECTION_DELTIFICATION,
+                               CONFIG_OPTION_DELTA_THREADS, 1));
+  ffd->delta_threads = MIN(MAX(1, ffd->delta_threads),
+                           SVN_FS_FS_MAX_DELTA_THREADS);
+
+  SVN_ERR(svn_config_get_int64(config, &ffd->pack_threads,
+                               CONFIG_SECTION_PACK,
+                               CONFIG_OPTION_PACK_THREADS, 1));
+  ffd->pack_threads = MIN(MAX(1, ffd->pack_threads),
+                          SVN_FS_FS_MAX_PACK_THREADS);
+
 #ifdef SVN_DEBUG
   SVN_ERR(svn_config_get_bool(config, &ffd->verify_before_commit,
                               CONFIG_SECTION_DEBUG,
@@ -945,6 +969,32 @@ read_config(fs_fs_data_t *ffd,
                               CONFIG_SECTION_CACHES, CONFIG_OPTION_FAIL_STOP,
                               FALSE));
 
+  /* Persistent second-level cache.  Like all caches, it is optional
+   * unless we have been told to fail on cache errors. */
+  SVN_ERR(svn_config_get_int64(config, &disk_cache_size,
+                               CONFIG_SECTION_CACHES,
+                               CONFIG_OPTION_DISK_CACHE_SIZE, 0));
+  ffd->disk_cache = NULL;
+  if (disk_cache_size > 0)
+    {
+      svn_error_t *err
+        = svn_cache__open_disk_store(&ffd->disk_cache,
+                                     svn_dirent_join(fs_path,
+                                                     PATH_DISK_CACHE,
+                                                     scratch_pool),
+                                     (apr_uint64_t)disk_cache_size * 0x100000,
+                                     scratch_pool);
+      if (err && !ffd->fail_stop)
+        {
+          svn_error_clear(err);
+          ffd->disk_cache = NULL;
+        }
+      else
+        {
+          SVN_ERR(err);
+        }
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -977,6 +1027,13 @@ write_config(svn_fs_t *fs,
 "### configured (and ignoring it with file:// access).  To make"             NL
 "### Subversion never ignore cache errors, uncomment this line."             NL
 "# " CONFIG_OPTION_FAIL_STOP " = true"                                       NL
+"### Fulltexts and delta windows may additionally be kept in a persistent"   NL
+"### cache file inside the db/ directory.  It will be consulted whenever"    NL
+"### the in-memory cache misses and retains its contents across server"      NL
+"### restarts.  Only one process at a time can use that file, so this is"    NL
+"### mainly useful for threaded servers.  The size is given in MB; the"      NL
+"### default of 0 disables the persistent cache."                            NL
+"# " CONFIG_OPTION_DISK_CACHE_SIZE " = 0"                                    NL
 ""                                                                           NL
 "[" CONFIG_SECTION_REP_SHARING "]"                                           NL
 "### To conserve space, the filesystem can optionally avoid storing"         NL
@@ -1079,6 +1136,15 @@ write_config(svn_fs_t *fs,
 "### still be used (and it will result in zlib compression with the"         NL
 "### corresponding compression level)."                                      NL
 "###   " CONFIG_OPTION_COMPRESSION_LEVEL " = 0 ... 9 (default is 5)"         NL
+"###"                                                                        NL
+"### Large files are being deltified and compressed in windows of 100 kB."   NL
+"### This option allows for up to the given number of windows to be"         NL
+"### processed concurrently, speeding up commits of large files on multi-"   NL
+"### core machines.  The data written is the same as with sequential"        NL
+"### processing.  Memory usage is about 300 kB per window in flight."        NL
+"### Versions prior to Subversion 1.11 will ignore this option."             NL
+"### The default is 1, i.e. sequential processing."                          NL
+"# " CONFIG_OPTION_DELTA_THREADS " = 1"                                      NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -1147,6 +1213,28 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+"###"                                                                        NL
+"### Pack files may be mapped into memory such that indexes and meta data"   NL
+"### get parsed directly from the mapped region instead of being read into"  NL
+"### buffers first.  The mappings are kept alive and shared by all users"    NL
+"### within the same process, i.e. across requests in server processes."     NL
+"### This is best suited for read-mostly servers on 64 bit systems with"     NL
+"### enough RAM to keep the frequently used pack files in the OS cache."     NL
+"### On any mapping failure, the regular file access will be used."          NL
+"### Versions prior to Subversion 1.11 will ignore this option."             NL
+"### Memory mapping is disabled by default."                                 NL
+"# " CONFIG_OPTION_MMAP_PACKED_FILES " = false"                              NL
+""                                                                           NL
+"[" CONFIG_SECTION_PACK "]"                                                  NL
+"### 'svnadmin pack' can pack up to this many shards concurrently.  The"     NL
+"### shards are still being switched over to their packed form one at a"     NL
+"### time and in order, so concurrent readers and committers are not"        NL
+"### affected.  Each shard being packed may use its own full reordering"     NL
+"### memory budget (64 MB by default).  This only takes effect if the"       NL
+"### process uses thread-safe caches."                                       NL
+"### Versions prior to Subversion 1.11 will ignore this option."             NL
+"### The default is 1, i.e. sequential processing."                          NL
+"# " CONFIG_OPTION_PACK_THREADS " = 1"                                       NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DEBUG "]"                                                 NL
 "###"                                                                        NL
@@ -23,6 +23,7 @@
 #include "svn_path.h"
 #include "svn_dirent_uri.h"
 
+#include "batch_fsync.h"
 #include "fs_fs.h"
 #include "hotcopy.h"
 #include "util.h"
@@ -34,16 +35,22 @@
 
 #include "svn_private_config.h"
 
+/* Flush the files copied so far to disk after this many revisions even
+ * if we don't checkpoint the hotcopy.  This limits the number of file
+ * handles held open by the fsync batch. */
+#define FSYNC_INTERVAL 64
+
 /* Like svn_io_dir_file_copy(), but doesn't copy files that exist at
  * the destination and do not differ in terms of kind, size, and mtime.
  * Set *SKIPPED_P to FALSE only if the file was copied, do not change
  * the value in *SKIPPED_P otherwise. SKIPPED_P may be NULL if not
- * required. */
+ * required.  Schedule the copy for fsync in BATCH unless that is NULL. */
 static svn_error_t *
 hotcopy_io_dir_file_copy(svn_boolean_t *skipped_p,
                          const char *src_path,
                          const char *dst_path,
                          const char *file,
+                         svn_fs_fs__batch_fsync_t *batch,
                          apr_pool_t *scratch_pool)
 {
   const svn_io_dirent2_t *src_dirent;
@@ -72,8 +79,16 @@ hotcopy_io_dir_file_copy(svn_boolean_t *skipped_p,
   if (skipped_p)
     *skipped_p = FALSE;
 
-  return svn_error_trace(svn_io_dir_file_copy(src_path, dst_path, file,
+  SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, file, scratch_pool));
+  if (batch)
+    {
+      SVN_ERR(svn_fs_fs__batch_fsync_add_file(batch, dst_target,
                                               scratch_pool));
+      SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, dst_target,
+                                              scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
 }
 
 /* Set *NAME_P to the UTF-8 representation of directory entry NAME.
@@ -115,13 +130,15 @@ entry_name_to_utf8(const char **name_p,
  * exist in the destination and do not differ from the source in terms of
  * kind, size, and mtime. Set *SKIPPED_P to FALSE only if at least one
  * file was copied, do not change the value in *SKIPPED_P otherwise.
- * SKIPPED_P may be NULL if not required. */
+ * SKIPPED_P may be NULL if not required.  Schedule all copies for fsync
+ * in BATCH unless that is NULL. */
 static svn_error_t *
 hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
                                 const char *src,
                                 const char *dst_parent,
                                 const char *dst_basename,
                                 svn_boolean_t copy_perms,
+                                svn_fs_fs__batch_fsync_t *batch,
                                 svn_cancel_func_t cancel_func,
                                 void *cancel_baton,
                                 apr_pool_t *pool)
@@ -158,6 +175,8 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
   /* Create the new directory. */
   /* ### TODO: copy permissions (needs apr_file_attrs_get()) */
   SVN_ERR(svn_io_make_dir_recursively(dst_path, pool));
+  if (batch && kind == svn_node_none)
+    SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, dst_path, pool));
 
   /* Loop over the dirents in SRC.  ('.' and '..' are auto-excluded) */
   SVN_ERR(svn_io_dir_open(&this_dir, src, subpool));
@@ -185,7 +204,8 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
           if (this_entry.filetype == APR_REG) /* regular file */
             {
               SVN_ERR(hotcopy_io_dir_file_copy(skipped_p, src, dst_path,
-                                               entryname_utf8, subpool));
+                                               entryname_utf8, batch,
+                                               subpool));
             }
           else if (this_entry.filetype == APR_LNK) /* symlink */
             {
@@ -213,6 +233,7 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
                                                       dst_path,
                                                       entryname_utf8,
                                                       copy_perms,
+                                                      batch,
                                                       cancel_func,
                                                       cancel_baton,
                                                       subpool));
@@ -241,6 +262,7 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
  * to DST_SUBDIR. Assume a sharding layout based on MAX_FILES_PER_DIR.
  * Set *SKIPPED_P to FALSE only if the file was copied, do not change the
  * value in *SKIPPED_P otherwise. SKIPPED_P may be NULL if not required.
+ * Schedule the necessary fsyncs in BATCH.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
@@ -248,6 +270,7 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
                         const char *dst_subdir,
                         svn_revnum_t rev,
                         int max_files_per_dir,
+                        svn_fs_fs__batch_fsync_t *batch,
                         apr_pool_t *scratch_pool)
 {
   const char *src_subdir_shard = src_subdir,
@@ -265,13 +288,15 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
           SVN_ERR(svn_io_make_dir_recursively(dst_subdir_shard, scratch_pool));
           SVN_ERR(svn_io_copy_perms(dst_subdir, dst_subdir_shard,
                                     scratch_pool));
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, dst_subdir_shard,
+                                                  scratch_pool));
         }
     }
 
   SVN_ERR(hotcopy_io_dir_file_copy(skipped_p,
                                    src_subdir_shard, dst_subdir_shard,
                                    apr_psprintf(scratch_pool, "%ld", rev),
-                                   scratch_pool));
+                                   batch, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -283,7 +308,8 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
  * Do not re-copy data which already exists in DST_FS.
  * Set *SKIPPED_P to FALSE only if at least one part of the shard
  * was copied, do not change the value in *SKIPPED_P otherwise.
- * SKIPPED_P may be NULL if not required.
+ * SKIPPED_P may be NULL if not required.  Flush all copied data to disk
+ * using BATCH before returning.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
@@ -292,6 +318,7 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                           svn_fs_t *dst_fs,
                           svn_revnum_t rev,
                           int max_files_per_dir,
+                          svn_fs_fs__batch_fsync_t *batch,
                           apr_pool_t *scratch_pool)
 {
   const char *src_subdir;
@@ -311,7 +338,7 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                                             scratch_pool);
   SVN_ERR(hotcopy_io_copy_dir_recursively(skipped_p, src_subdir_packed_shard,
                                           dst_subdir, packed_shard,
-                                          TRUE /* copy_perms */,
+                                          TRUE /* copy_perms */, batch,
                                           NULL /* cancel_func */, NULL,
                                           scratch_pool));
 
@@ -332,7 +359,9 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
 
           SVN_ERR(hotcopy_copy_shard_file(skipped_p, src_subdir, dst_subdir,
                                           revprop_rev, max_files_per_dir,
-                                          iterpool));
+                                          batch, iterpool));
+          if (revprop_rev % FSYNC_INTERVAL == 0)
+            SVN_ERR(svn_fs_fs__batch_fsync_run(batch, iterpool));
         }
       svn_pool_destroy(iterpool);
     }
@@ -341,7 +370,7 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
       /* revprop for revision 0 will never be packed */
       if (rev == 0)
         SVN_ERR(hotcopy_copy_shard_file(skipped_p, src_subdir, dst_subdir,
-                                        0, max_files_per_dir,
+                                        0, max_files_per_dir, batch,
                                         scratch_pool));
 
       /* packed revprops folder */
@@ -352,11 +381,14 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
       SVN_ERR(hotcopy_io_copy_dir_recursively(skipped_p,
                                               src_subdir_packed_shard,
                                               dst_subdir, packed_shard,
-                                              TRUE /* copy_perms */,
+                                              TRUE /* copy_perms */, batch,
                                               NULL /* cancel_func */, NULL,
                                               scratch_pool));
     }
 
+  /* The shard must be complete on disk before we declare it packed. */
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, scratch_pool));
+
   /* If necessary, update the min-unpacked rev file in the hotcopy. */
   if (*dst_min_unpacked_rev < rev + max_files_per_dir)
     {
@@ -562,6 +594,7 @@ hotcopy_revisions(svn_fs_t *src_fs,
   svn_revnum_t src_min_unpacked_rev;
   svn_revnum_t dst_min_unpacked_rev;
   svn_revnum_t rev;
+  svn_fs_fs__batch_fsync_t *batch;
   apr_pool_t *iterpool;
 
   /* Copy the min unpacked rev, and read its value. */
@@ -597,9 +630,12 @@ hotcopy_revisions(svn_fs_t *src_fs,
     SVN_ERR(cancel_func(cancel_baton));
 
   /*
-   * Copy the necessary rev files.
+   * Copy the necessary rev files.  Copied files get flushed to disk
+   * concurrently before we checkpoint our progress.
    */
 
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, dst_ffd->flush_to_disk,
+                                        pool));
   iterpool = svn_pool_create(pool);
   /* First, copy packed shards. */
   for (rev = 0; rev < src_min_unpacked_rev; rev += max_files_per_dir)
@@ -615,7 +651,7 @@ hotcopy_revisions(svn_fs_t *src_fs,
       /* Copy the packed shard. */
       SVN_ERR(hotcopy_copy_packed_shard(&skipped, &dst_min_unpacked_rev,
                                         src_fs, dst_fs,
-                                        rev, max_files_per_dir,
+                                        rev, max_files_per_dir, batch,
                                         iterpool));
 
       pack_end_rev = rev + max_files_per_dir - 1;
@@ -693,24 +729,27 @@ hotcopy_revisions(svn_fs_t *src_fs,
       /* Copy the rev file. */
       SVN_ERR(hotcopy_copy_shard_file(&skipped,
                                       src_revs_dir, dst_revs_dir, rev,
-                                      max_files_per_dir,
+                                      max_files_per_dir, batch,
                                       iterpool));
       /* Copy the revprop file. */
       SVN_ERR(hotcopy_copy_shard_file(&skipped,
                                       src_revprops_dir, dst_revprops_dir,
-                                      rev, max_files_per_dir,
+                                      rev, max_files_per_dir, batch,
                                       iterpool));
 
       /* Whenever this revision did not previously exist in the destination,
        * checkpoint the progress via 'current' (do that once per full shard
-       * in order not to slow things down). */
-      if (rev > dst_youngest)
+       * in order not to slow things down).  The copied data must be on
+       * disk before that. */
+      if (rev > dst_youngest
+          && max_files_per_dir && (rev % max_files_per_dir == 0))
         {
-          if (max_files_per_dir && (rev % max_files_per_dir == 0))
-            {
-              SVN_ERR(svn_fs_fs__write_current(dst_fs, rev, 0, 0,
-                                               iterpool));
-            }
+          SVN_ERR(svn_fs_fs__batch_fsync_run(batch, iterpool));
+          SVN_ERR(svn_fs_fs__write_current(dst_fs, rev, 0, 0, iterpool));
+        }
+      else if (rev % FSYNC_INTERVAL == 0)
+        {
+          SVN_ERR(svn_fs_fs__batch_fsync_run(batch, iterpool));
         }
 
       if (notify_func && !skipped)
@@ -722,6 +761,9 @@ hotcopy_revisions(svn_fs_t *src_fs,
    * above loop early. 'rev' was last incremented during exit of the loop. */
   SVN_ERR_ASSERT(rev == src_youngest + 1);
 
+  /* Our caller will bump 'current' to the youngest revision. */
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -747,9 +789,13 @@ hotcopy_revisions_old(svn_fs_t *src_fs,
                       void* cancel_baton,
                       apr_pool_t *pool)
 {
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_fs__batch_fsync_t *batch;
   svn_revnum_t rev;
 
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, dst_ffd->flush_to_disk,
+                                        pool));
   for (rev = 0; rev <= src_youngest; rev++)
     {
       svn_boolean_t skipped = TRUE;
@@ -761,17 +807,22 @@ hotcopy_revisions_old(svn_fs_t *src_fs,
 
       SVN_ERR(hotcopy_io_dir_file_copy(&skipped, src_revs_dir, dst_revs_dir,
                                        apr_psprintf(iterpool, "%ld", rev),
-                                       iterpool));
+                                       batch, iterpool));
       SVN_ERR(hotcopy_io_dir_file_copy(&skipped, src_revprops_dir,
                                        dst_revprops_dir,
                                        apr_psprintf(iterpool, "%ld", rev),
-                                       iterpool));
+                                       batch, iterpool));
+      if (rev % FSYNC_INTERVAL == 0)
+        SVN_ERR(svn_fs_fs__batch_fsync_run(batch, iterpool));
 
       if (notify_func && !skipped)
         notify_func(notify_baton, rev, rev, iterpool);
     }
     svn_pool_destroy(iterpool);
 
+    /* Our caller will update 'current'. */
+    SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
+
     return SVN_NO_ERROR;
 }
 
@@ -964,7 +1015,7 @@ hotcopy_body(void *baton, apr_pool_t *pool)
   SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
   if (kind == svn_node_dir)
     SVN_ERR(hotcopy_io_copy_dir_recursively(NULL, src_subdir, dst_fs->path,
-                                            PATH_NODE_ORIGINS_DIR, TRUE,
+                                            PATH_NODE_ORIGINS_DIR, TRUE, NULL,
                                             cancel_func, cancel_baton, pool));
 
   /*
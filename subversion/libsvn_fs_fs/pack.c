@@ -25,12 +25,15 @@
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "svn_sorts.h"
+#include "svn_cache_config.h"
 #include "private/svn_temp_serializer.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_io_private.h"
+#include "private/svn_task.h"
 
+#include "batch_fsync.h"
 #include "fs_fs.h"
 #include "pack.h"
 #include "util.h"
@@ -180,6 +183,9 @@ typedef struct pack_context_t
   /* the pack file to ultimately write all data to */
   apr_file_t *pack_file;
 
+  /* collects the fsyncs to run once the pack file is complete */
+  svn_fs_fs__batch_fsync_t *batch;
+
   /* array of svn_fs_fs__p2l_entry_t *, all referring to change lists.
    * Will be filled in phase 2 and be cleared after each revision range. */
   apr_array_header_t *changes;
@@ -233,9 +239,6 @@ typedef struct pack_context_t
   /* pool used for temporary data structures that will be cleaned up when
    * the next range of revisions is being processed */
   apr_pool_t *info_pool;
-
-  /* ensure that all filesystem changes are written to disk. */
-  svn_boolean_t flush_to_disk;
 } pack_context_t;
 
 /* Create and initialize a new pack context for packing shard SHARD_REV in
@@ -243,7 +246,8 @@ typedef struct pack_context_t
  * and return the structure in *CONTEXT.
  *
  * Limit the number of items being copied per iteration to MAX_ITEMS.
- * Set FLUSH_TO_DISK, CANCEL_FUNC and CANCEL_BATON as well.
+ * Schedule the pack file's fsync in BATCH.  Set CANCEL_FUNC and
+ * CANCEL_BATON as well.
  */
 static svn_error_t *
 initialize_pack_context(pack_context_t *context,
@@ -252,7 +256,7 @@ initialize_pack_context(pack_context_t *context,
                         const char *shard_dir,
                         svn_revnum_t shard_rev,
                         int max_items,
-                        svn_boolean_t flush_to_disk,
+                        svn_fs_fs__batch_fsync_t *batch,
                         svn_cancel_func_t cancel_func,
                         void *cancel_baton,
                         apr_pool_t *pool)
@@ -281,13 +285,12 @@ initialize_pack_context(pack_context_t *context,
   context->info_pool = svn_pool_create(pool);
   context->paths = svn_prefix_tree__create(context->info_pool);
 
-  context->flush_to_disk = flush_to_disk;
-
   /* Create the new directory and pack file. */
   context->shard_dir = shard_dir;
   context->pack_file_dir = pack_file_dir;
   context->pack_file_path
     = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
+  context->batch = batch;
   SVN_ERR(svn_io_file_open(&context->pack_file, context->pack_file_path,
                            APR_WRITE | APR_BUFFERED | APR_BINARY | APR_EXCL
                              | APR_CREATE, APR_OS_DEFAULT, pool));
@@ -413,9 +416,9 @@ close_pack_context(pack_context_t *context,
   SVN_ERR(svn_io_remove_file2(proto_p2l_index_path, FALSE, pool));
 
   /* Ensure that packed file is written to disk.*/
-  if (context->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(context->pack_file, pool));
   SVN_ERR(svn_io_file_close(context->pack_file, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_add_file(context->batch,
+                                          context->pack_file_path, pool));
 
   return SVN_NO_ERROR;
 }
@@ -1538,9 +1541,9 @@ append_revision(pack_context_t *context,
  *
  * Pack the revision shard starting at SHARD_REV in filesystem FS from
  * SHARD_DIR into the PACK_FILE_DIR, using POOL for allocations.  Limit
- * the extra memory consumption to MAX_MEM bytes.  If FLUSH_TO_DISK is
- * non-zero, do not return until the data has actually been written on
- * the disk.  CANCEL_FUNC and CANCEL_BATON are what you think they are.
+ * the extra memory consumption to MAX_MEM bytes.  Schedule the necessary
+ * fsyncs in BATCH.  CANCEL_FUNC and CANCEL_BATON are what you think they
+ * are.
  */
 static svn_error_t *
 pack_log_addressed(svn_fs_t *fs,
@@ -1548,7 +1551,7 @@ pack_log_addressed(svn_fs_t *fs,
                    const char *shard_dir,
                    svn_revnum_t shard_rev,
                    apr_size_t max_mem,
-                   svn_boolean_t flush_to_disk,
+                   svn_fs_fs__batch_fsync_t *batch,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *pool)
@@ -1581,7 +1584,7 @@ pack_log_addressed(svn_fs_t *fs,
 
   /* set up a pack context */
   SVN_ERR(initialize_pack_context(&context, fs, pack_file_dir, shard_dir,
-                                  shard_rev, max_items, flush_to_disk,
+                                  shard_rev, max_items, batch,
                                   cancel_func, cancel_baton, pool));
 
   /* phase 1: determine the size of the revisions to pack */
@@ -1706,8 +1709,7 @@ svn_fs_fs__get_packed_offset(apr_off_t *rev_offset,
  *
  * Pack the revision shard starting at SHARD_REV containing exactly
  * MAX_FILES_PER_DIR revisions from SHARD_PATH into the PACK_FILE_DIR,
- * using POOL for allocations.  If FLUSH_TO_DISK is non-zero, do not
- * return until the data has actually been written on the disk.
+ * using POOL for allocations.  Schedule the necessary fsyncs in BATCH.
  * CANCEL_FUNC and CANCEL_BATON are what you think they are.
  */
 static svn_error_t *
@@ -1715,7 +1717,7 @@ pack_phys_addressed(const char *pack_file_dir,
                     const char *shard_path,
                     svn_revnum_t start_rev,
                     int max_files_per_dir,
-                    svn_boolean_t flush_to_disk,
+                    svn_fs_fs__batch_fsync_t *batch,
                     svn_cancel_func_t cancel_func,
                     void *cancel_baton,
                     apr_pool_t *pool)
@@ -1782,18 +1784,16 @@ pack_phys_addressed(const char *pack_file_dir,
   /* Close stream over APR file. */
   SVN_ERR(svn_stream_close(manifest_stream));
 
-  /* Ensure that pack file is written to disk. */
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(manifest_file, pool));
+  /* Ensure that the manifest file is written to disk. */
   SVN_ERR(svn_io_file_close(manifest_file, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_add_file(batch, manifest_file_path, pool));
 
   /* disallow write access to the manifest file */
   SVN_ERR(svn_io_set_file_read_only(manifest_file_path, FALSE, iterpool));
 
   /* Ensure that pack file is written to disk. */
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(pack_file, pool));
   SVN_ERR(svn_io_file_close(pack_file, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_add_file(batch, pack_file_path, pool));
 
   svn_pool_destroy(iterpool);
 
@@ -1805,6 +1805,7 @@ pack_phys_addressed(const char *pack_file_dir,
  * using POOL for allocations.  Try to limit the amount of temporary
  * memory needed to MAX_MEM bytes.  If FLUSH_TO_DISK is non-zero, do
  * not return until the data has actually been written on the disk.
+ * All files will be flushed concurrently at the end.
  * CANCEL_FUNC and CANCEL_BATON are what you think they are.
  *
  * If for some reason we detect a partial packing already performed, we
@@ -1825,6 +1826,7 @@ pack_rev_shard(svn_fs_t *fs,
                apr_pool_t *pool)
 {
   const char *pack_file_path;
+  svn_fs_fs__batch_fsync_t *batch;
   svn_revnum_t shard_rev = (svn_revnum_t) (shard * max_files_per_dir);
 
   /* Some useful paths. */
@@ -1836,17 +1838,23 @@ pack_rev_shard(svn_fs_t *fs,
 
   /* Create the new directory and pack file. */
   SVN_ERR(svn_io_dir_make(pack_file_dir, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, flush_to_disk, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, pack_file_dir, pool));
 
   /* Index information files */
   if (svn_fs_fs__use_log_addressing(fs))
     SVN_ERR(pack_log_addressed(fs, pack_file_dir, shard_path,
-                               shard_rev, max_mem, flush_to_disk,
+                               shard_rev, max_mem, batch,
                                cancel_func, cancel_baton, pool));
   else
     SVN_ERR(pack_phys_addressed(pack_file_dir, shard_path, shard_rev,
-                                max_files_per_dir, flush_to_disk,
+                                max_files_per_dir, batch,
                                 cancel_func, cancel_baton, pool));
 
+  /* Ensure that the pack data is written to disk before the caller
+   * switches over to it. */
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
+
   SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, pool));
   SVN_ERR(svn_io_set_file_read_only(pack_file_path, FALSE, pool));
 
@@ -1957,6 +1965,27 @@ synced_pack_shard(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Switch the shard described by BATON over to its packed form, which has
+ * already been written to disk.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+switch_to_packed_shard(struct pack_baton *baton,
+                       apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+
+  /* For newer repo formats, we only acquired the pack lock so far.
+     Before modifying the repo state by switching over to the packed
+     data, we need to acquire the global (write) lock. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
+                                       pool));
+  else
+    SVN_ERR(synced_pack_shard(baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Pack the shard described by BATON.
  *
  * If for some reason we detect a partial packing already performed,
@@ -1992,14 +2021,7 @@ pack_shard(struct pack_baton *baton,
                          baton->max_mem, ffd->flush_to_disk,
                          baton->cancel_func, baton->cancel_baton, pool));
 
-  /* For newer repo formats, we only acquired the pack lock so far.
-     Before modifying the repo state by switching over to the packed
-     data, we need to acquire the global (write) lock. */
-  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
-    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
-                                       pool));
-  else
-    SVN_ERR(synced_pack_shard(baton, pool));
+  SVN_ERR(switch_to_packed_shard(baton, pool));
 
   /* Notify caller we're starting to pack this shard. */
   if (baton->notify_func)
@@ -2009,6 +2031,147 @@ pack_shard(struct pack_baton *baton,
   return SVN_NO_ERROR;
 }
 
+/* A shard being packed by pack_shards_concurrently(). */
+typedef struct shard_task_t
+{
+  /* The pack operation that this task is part of.  Worker threads only
+     read the members that remain constant throughout the operation. */
+  struct pack_baton *pb;
+
+  /* The shard to pack and its directories. */
+  apr_int64_t shard;
+  const char *rev_pack_file_dir;
+  const char *rev_shard_path;
+
+  /* The first shard not to be packed by this operation. */
+  apr_int64_t end_shard;
+} shard_task_t;
+
+/* Implements svn_task__process_func_t.  Pack the revision contents of the
+ * shard described by the shard_task_t in BATON.  This does not modify the
+ * repository state; the result will only be used by pack_shard_output().
+ * Set *RESULT to NULL.
+ */
+static svn_error_t *
+pack_shard_process(void **result,
+                   void *baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  shard_task_t *task = baton;
+  struct pack_baton *pb = task->pb;
+  svn_fs_t *fs = pb->fs;
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Reading the revision contents requires a filesystem instance that
+     is private to this thread. */
+  if (svn_fs_fs__use_log_addressing(fs))
+    SVN_ERR(svn_fs_fs__open_instance(&fs, pb->fs, scratch_pool,
+                                     scratch_pool));
+
+  SVN_ERR(pack_rev_shard(fs, task->rev_pack_file_dir, task->rev_shard_path,
+                         task->shard, ffd->max_files_per_dir, pb->max_mem,
+                         ffd->flush_to_disk, pb->cancel_func,
+                         pb->cancel_baton, scratch_pool));
+
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Switch the shard described by the
+ * shard_task_t in BATON over to the packed data created by
+ * pack_shard_process() and notify the caller that it is done.
+ *
+ * The start notification for this shard has been sent when the previous
+ * shard was done, i.e. as early as possible while still keeping the
+ * notifications in the same order as pack_shard() does.  So, send the
+ * start notification for the next shard here.
+ */
+static svn_error_t *
+pack_shard_output(void *result,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  shard_task_t *task = baton;
+  struct pack_baton *pb = task->pb;
+
+  pb->shard = task->shard;
+  pb->rev_shard_path = task->rev_shard_path;
+
+  SVN_ERR(switch_to_packed_shard(pb, scratch_pool));
+
+  if (pb->notify_func)
+    {
+      SVN_ERR(pb->notify_func(pb->notify_baton, pb->shard,
+                              svn_fs_pack_notify_end, scratch_pool));
+      if (pb->shard + 1 < task->end_shard)
+        SVN_ERR(pb->notify_func(pb->notify_baton, pb->shard + 1,
+                                svn_fs_pack_notify_start, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Pack the shards of PB->FS from FIRST_SHARD up to but not including
+ * END_SHARD, processing up to THREADS of them concurrently.  The shards
+ * will still be switched over to their packed form one at a time, in
+ * order and from within the calling thread.  Hence, the repository goes
+ * through the same sequence of states as with pack_shard() and an error
+ * or cancellation leaves all later shards untouched.  Use POOL for
+ * allocations.
+ */
+static svn_error_t *
+pack_shards_concurrently(struct pack_baton *pb,
+                         apr_int64_t first_shard,
+                         apr_int64_t end_shard,
+                         int threads,
+                         apr_pool_t *pool)
+{
+  svn_task__queue_t *queue;
+  apr_int64_t shard;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_task__queue_create(&queue, threads, pool));
+
+  /* Notify caller we're starting to pack the first shard.  The others
+     will follow as their predecessors are done. */
+  if (pb->notify_func && first_shard < end_shard)
+    SVN_ERR(pb->notify_func(pb->notify_baton, first_shard,
+                            svn_fs_pack_notify_start, pool));
+
+  for (shard = first_shard; shard < end_shard; shard++)
+    {
+      shard_task_t *task = apr_pcalloc(pool, sizeof(*task));
+
+      svn_pool_clear(iterpool);
+
+      if (pb->cancel_func)
+        SVN_ERR(pb->cancel_func(pb->cancel_baton));
+
+      task->pb = pb;
+      task->shard = shard;
+      task->rev_pack_file_dir = svn_dirent_join(pb->revs_dir,
+                  apr_psprintf(pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               shard),
+                  pool);
+      task->rev_shard_path = svn_dirent_join(pb->revs_dir,
+                                             apr_psprintf(pool,
+                                                          "%" APR_INT64_T_FMT,
+                                                          shard),
+                                             pool);
+      task->end_shard = end_shard;
+
+      SVN_ERR(svn_task__queue_push(queue, pack_shard_process, task,
+                                   pack_shard_output, task, iterpool));
+    }
+
+  SVN_ERR(svn_task__queue_finish(queue, iterpool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the youngest rev and the first non-packed rev info for FS from disk.
    Set *FULLY_PACKED when there is no completed unpacked shard.
    Use SCRATCH_POOL for temporary allocations.
@@ -2080,6 +2243,16 @@ pack_body(void *baton,
     pb->revsprops_dir = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
                                         pool);
 
+  /* Pack shards concurrently if so configured.  The worker threads will
+     access the global caches, so those must be thread-safe. */
+  if (ffd->pack_threads > 1 && !svn_cache_config_get()->single_threaded)
+    return svn_error_trace(
+             pack_shards_concurrently(pb,
+                                      ffd->min_unpacked_rev
+                                        / ffd->max_files_per_dir,
+                                      completed_shards,
+                                      (int)ffd->pack_threads, pool));
+
   iterpool = svn_pool_create(pool);
   for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
        pb->shard < completed_shards;
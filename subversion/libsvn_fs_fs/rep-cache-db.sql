@@ -60,10 +60,33 @@ FROM rep_cache
 WHERE hash = ?1
 
 -- STMT_SET_REP
-/* Works for both V1 and V2 schemas. */
-INSERT OR FAIL INTO rep_cache (hash, revision, offset, size, expanded_size)
+/* Works for both V1 and V2 schemas.  Existing entries are left untouched;
+   the caller can tell by the number of affected rows. */
+INSERT OR IGNORE INTO rep_cache (hash, revision, offset, size, expanded_size)
 VALUES (?1, ?2, ?3, ?4, ?5)
 
+-- STMT_SET_REP_BATCH
+/* Same as STMT_SET_REP but for 16 entries at once, i.e. with 5 parameters
+   per entry.  This saves most of the per-statement overhead when adding
+   the reps of large commits.  Works for both V1 and V2 schemas. */
+INSERT OR IGNORE INTO rep_cache (hash, revision, offset, size, expanded_size)
+VALUES (?1, ?2, ?3, ?4, ?5),
+       (?6, ?7, ?8, ?9, ?10),
+       (?11, ?12, ?13, ?14, ?15),
+       (?16, ?17, ?18, ?19, ?20),
+       (?21, ?22, ?23, ?24, ?25),
+       (?26, ?27, ?28, ?29, ?30),
+       (?31, ?32, ?33, ?34, ?35),
+       (?36, ?37, ?38, ?39, ?40),
+       (?41, ?42, ?43, ?44, ?45),
+       (?46, ?47, ?48, ?49, ?50),
+       (?51, ?52, ?53, ?54, ?55),
+       (?56, ?57, ?58, ?59, ?60),
+       (?61, ?62, ?63, ?64, ?65),
+       (?66, ?67, ?68, ?69, ?70),
+       (?71, ?72, ?73, ?74, ?75),
+       (?76, ?77, ?78, ?79, ?80)
+
 -- STMT_GET_REPS_FOR_RANGE
 /* Works for both V1 and V2 schemas. */
 SELECT hash, revision, offset, size, expanded_size
@@ -75,6 +98,11 @@ WHERE revision >= ?1 AND revision <= ?2
 SELECT MAX(revision)
 FROM rep_cache
 
+-- STMT_GET_ALL_HASHES
+/* Works for both V1 and V2 schemas. */
+SELECT hash
+FROM rep_cache
+
 -- STMT_DEL_REPS_YOUNGER_THAN_REV
 /* Works for both V1 and V2 schemas. */
 DELETE FROM rep_cache
@@ -27,10 +27,12 @@
 #include "cached_data.h"
 #include "fs_fs.h"
 #include "fs.h"
+#include "id.h"
 #include "rep-cache.h"
 #include "../libsvn_fs/fs-loader.h"
 
 #include "svn_path.h"
+#include "svn_sorts.h"
 
 #include "private/svn_sqlite.h"
 
@@ -48,7 +50,457 @@ path_rep_cache_db(const char *fs_path,
   return svn_dirent_join(fs_path, REP_CACHE_DB_NAME, result_pool);
 }
 
-
+
+/** The rep-cache filter. **/
+
+/* Most rep-cache lookups are for representations that are not in the
+   cache.  To answer these without querying the database, we keep a Bloom
+   filter of all SHA1 keys in rep-cache.db.  There is one filter per
+   repository and process, shared by all svn_fs_t of that repository.
+
+   Other processes may add entries at any time.  SQLite increments the
+   file change counter in the header of rep-cache.db whenever it commits
+   a modification, no matter which connection made it.  The filter
+   remembers the counter value it reflects, and commits made through the
+   filter's process update both.  Once per transaction, we compare that
+   value with the file.  If they differ, we query the database directly
+   until enough lookups have accumulated to justify rebuilding the
+   filter.  Entries added by others while a transaction is running may
+   be missed for the rest of it, which merely means that some rep does
+   not get shared.
+
+   We only build the first filter after a similar number of lookups, so
+   short-lived processes and small commits never pay for scanning the
+   whole table. */
+
+/* Number of filter bits per entry we aim for and the number of bits we
+   set per entry.  Together, they give a false positive rate of about 1%. */
+#define FILTER_BITS_PER_ENTRY 10
+#define FILTER_HASH_COUNT     6
+
+/* Lower limit to the number of entries the filter is sized for. */
+#define FILTER_MIN_ENTRIES 1024
+
+/* (Re-)build the filter after the number of database lookups exceeded
+   1/FILTER_REBUILD_RATIO of the number of entries in the database. */
+#define FILTER_REBUILD_RATIO 16
+
+/* A lower limit to the average size of a rep-cache.db entry in bytes.
+   We use it to estimate the number of entries from the file size. */
+#define FILTER_BYTES_PER_ENTRY 64
+
+/* Offset and size of the file change counter in rep-cache.db. */
+#define CHANGE_COUNTER_OFFSET 24
+#define CHANGE_COUNTER_SIZE    4
+
+typedef struct rep_cache_filter_t
+{
+  /* The filter bits.  NULL if the filter has not been built, yet. */
+  apr_uint32_t *bits;
+
+  /* Number of filter bits - 1.  The number of bits is a power of 2. */
+  apr_uint32_t mask;
+
+  /* Number of entries added to BITS and the number of entries after
+     which the false positive rate becomes too large. */
+  apr_int64_t entries;
+  apr_int64_t capacity;
+
+  /* The file change counter of rep-cache.db that BITS reflect. */
+  apr_uint32_t change_counter;
+
+  /* If set, BITS may be missing entries and must not be used.  This is
+     always set if there are no BITS. */
+  svn_boolean_t stale;
+
+  /* Number of lookups since the filter became stale. */
+  apr_int64_t stale_lookups;
+
+  /* Upper estimate of the number of entries in rep-cache.db. */
+  apr_int64_t estimated_entries;
+
+  /* Set while some thread is building new BITS. */
+  svn_boolean_t building;
+
+  /* Pool containing BITS or NULL. */
+  apr_pool_t *pool;
+} rep_cache_filter_t;
+
+/* Set *H1 and *H2 to the hash values used to probe the filter bits for
+   the SHA1 DIGEST.  SHA1 sums are uniformly distributed, so we simply
+   take them from DIGEST itself. */
+static void
+filter_hashes(apr_uint32_t *h1,
+              apr_uint32_t *h2,
+              const unsigned char *digest)
+{
+  *h1 = (apr_uint32_t)digest[0]
+      | (apr_uint32_t)digest[1] << 8
+      | (apr_uint32_t)digest[2] << 16
+      | (apr_uint32_t)digest[3] << 24;
+
+  /* Make sure subsequent probes actually differ. */
+  *h2 = (apr_uint32_t)digest[4]
+      | (apr_uint32_t)digest[5] << 8
+      | (apr_uint32_t)digest[6] << 16
+      | (apr_uint32_t)digest[7] << 24
+      | 1;
+}
+
+/* Add the SHA1 DIGEST to FILTER. */
+static void
+filter_add(rep_cache_filter_t *filter,
+           const unsigned char *digest)
+{
+  apr_uint32_t h1, h2;
+  int i;
+
+  if (filter->bits == NULL)
+    return;
+
+  filter_hashes(&h1, &h2, digest);
+  for (i = 0; i < FILTER_HASH_COUNT; ++i, h1 += h2)
+    filter->bits[(h1 & filter->mask) / 32] |= 1u << (h1 % 32);
+
+  /* An overfull filter becomes useless.  Replace it eventually. */
+  if (++filter->entries > filter->capacity)
+    filter->stale = TRUE;
+}
+
+/* Return TRUE if the SHA1 DIGEST may have been added to FILTER. */
+static svn_boolean_t
+filter_test(rep_cache_filter_t *filter,
+            const unsigned char *digest)
+{
+  apr_uint32_t h1, h2;
+  int i;
+
+  filter_hashes(&h1, &h2, digest);
+  for (i = 0; i < FILTER_HASH_COUNT; ++i, h1 += h2)
+    if ((filter->bits[(h1 & filter->mask) / 32] & (1u << (h1 % 32))) == 0)
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Set *CHANGE_COUNTER to the file change counter of the rep-cache.db of
+   FS.  If ESTIMATED_ENTRIES is not NULL, set *ESTIMATED_ENTRIES to an
+   upper estimate of the number of entries in that database.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_db_state(apr_uint32_t *change_counter,
+              apr_int64_t *estimated_entries,
+              svn_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  unsigned char header[CHANGE_COUNTER_OFFSET + CHANGE_COUNTER_SIZE];
+  apr_size_t len;
+  svn_boolean_t eof;
+
+  SVN_ERR(svn_io_file_open(&file, path_rep_cache_db(fs->path, scratch_pool),
+                           APR_READ, APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(file, header, sizeof(header), &len, &eof,
+                                 scratch_pool));
+
+  /* A database that has not been initialized yet has no header. */
+  if (len < sizeof(header))
+    *change_counter = 0;
+  else
+    *change_counter = (apr_uint32_t)header[CHANGE_COUNTER_OFFSET] << 24
+                    | (apr_uint32_t)header[CHANGE_COUNTER_OFFSET + 1] << 16
+                    | (apr_uint32_t)header[CHANGE_COUNTER_OFFSET + 2] << 8
+                    | (apr_uint32_t)header[CHANGE_COUNTER_OFFSET + 3];
+
+  if (estimated_entries)
+    {
+      apr_off_t size;
+
+      SVN_ERR(svn_io_file_size_get(&size, file, scratch_pool));
+      *estimated_entries = size / FILTER_BYTES_PER_ENTRY;
+    }
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+/* Add all keys in rep-cache.db of FS to FILTER and set FILTER's change
+   counter accordingly.  This must be run within an SQLite transaction or
+   savepoint, so that no modification can be committed in the meantime.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+fill_filter(rep_cache_filter_t *filter,
+            svn_fs_t *fs,
+            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int iterations = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_ALL_HASHES));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  /* We now hold a read lock, so the file change counter stays put. */
+  SVN_ERR(read_db_state(&filter->change_counter, NULL, fs, scratch_pool));
+
+  while (have_row)
+    {
+      svn_checksum_t *checksum;
+      svn_error_t *err;
+
+      /* Clear ITERPOOL occasionally. */
+      if (iterations++ % 256 == 0)
+        svn_pool_clear(iterpool);
+
+      /* Keys that are not SHA1 sums, like the dummy entry created by
+         lock_rep_cache(), will never be looked up. */
+      err = svn_checksum_parse_hex(&checksum, svn_checksum_sha1,
+                                   svn_sqlite__column_text(stmt, 0, NULL),
+                                   iterpool);
+      if (err)
+        svn_error_clear(err);
+      else if (checksum)
+        filter_add(filter, checksum->digest);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Start building a new filter for FFSD.  Set *FILTER to a new filter of
+   suitable size, allocated in a new sub-pool of the common pool.  The
+   caller must hold the REP_CACHE_FILTER_LOCK of FFSD. */
+static svn_error_t *
+start_building_filter(rep_cache_filter_t **filter,
+                      fs_fs_shared_data_t *ffsd)
+{
+  apr_pool_t *pool = svn_pool_create(ffsd->common_pool);
+  apr_int64_t count = ffsd->rep_cache_filter->estimated_entries;
+  apr_uint64_t bit_count = 32;
+
+  /* Leave room for growth. */
+  count += count / 2;
+  if (count < FILTER_MIN_ENTRIES)
+    count = FILTER_MIN_ENTRIES;
+
+  while (bit_count < (apr_uint64_t)count * FILTER_BITS_PER_ENTRY
+         && bit_count <= APR_UINT32_MAX / 2)
+    bit_count *= 2;
+
+  *filter = apr_pcalloc(pool, sizeof(**filter));
+  (*filter)->pool = pool;
+  (*filter)->bits = apr_pcalloc(pool, bit_count / 8);
+  (*filter)->mask = (apr_uint32_t)(bit_count - 1);
+  (*filter)->capacity = bit_count / (FILTER_BITS_PER_ENTRY - 2);
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the bits of the filter in FFSD with those of NEW_FILTER, which
+   may be NULL if building it failed.  The caller must hold the
+   REP_CACHE_FILTER_LOCK of FFSD. */
+static svn_error_t *
+finish_building_filter(fs_fs_shared_data_t *ffsd,
+                       rep_cache_filter_t *new_filter)
+{
+  rep_cache_filter_t *filter = ffsd->rep_cache_filter;
+
+  if (filter->pool)
+    svn_pool_destroy(filter->pool);
+
+  if (new_filter)
+    {
+      filter->bits = new_filter->bits;
+      filter->mask = new_filter->mask;
+      filter->entries = new_filter->entries;
+      filter->capacity = new_filter->capacity;
+      filter->change_counter = new_filter->change_counter;
+      filter->stale = new_filter->entries > new_filter->capacity;
+      filter->pool = new_filter->pool;
+    }
+  else
+    {
+      filter->bits = NULL;
+      filter->stale = TRUE;
+      filter->pool = NULL;
+    }
+
+  filter->stale_lookups = 0;
+  filter->building = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the rep-cache filter of FS with a new one that reflects the
+   current contents of rep-cache.db.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+build_filter(svn_fs_t *fs,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  rep_cache_filter_t *filter;
+  svn_sqlite__db_t *sdb = ffd->rep_cache_db;
+  svn_error_t *err;
+
+  SVN_MUTEX__WITH_LOCK(ffsd->rep_cache_filter_lock,
+                       start_building_filter(&filter, ffsd));
+
+  /* Scan the table without holding the lock, so other threads can keep
+     using the old filter or the database in the meantime. */
+  err = svn_sqlite__begin_savepoint(sdb);
+  if (!err)
+    err = svn_sqlite__finish_savepoint(sdb, fill_filter(filter, fs,
+                                                        scratch_pool));
+
+  if (err)
+    {
+      svn_pool_destroy(filter->pool);
+      filter = NULL;
+    }
+
+  SVN_MUTEX__WITH_LOCK(ffsd->rep_cache_filter_lock,
+                       finish_building_filter(ffsd, filter));
+
+  return svn_error_trace(err);
+}
+
+/* Set *MAYBE_PRESENT to FALSE if the filter in FFSD tells that rep-cache.db
+   does not contain the SHA1 DIGEST.  Otherwise, set it to TRUE.  Set
+   *BUILD if the caller shall build a new filter.
+
+   If CHECK_COUNTER is set, CHANGE_COUNTER and ESTIMATED_ENTRIES describe
+   the current state of rep-cache.db as returned by read_db_state().
+
+   The caller must hold the REP_CACHE_FILTER_LOCK of FFSD. */
+static svn_error_t *
+test_filter(svn_boolean_t *maybe_present,
+            svn_boolean_t *build,
+            fs_fs_shared_data_t *ffsd,
+            const unsigned char *digest,
+            svn_boolean_t check_counter,
+            apr_uint32_t change_counter,
+            apr_int64_t estimated_entries)
+{
+  rep_cache_filter_t *filter = ffsd->rep_cache_filter;
+
+  *maybe_present = TRUE;
+  *build = FALSE;
+
+  if (!filter)
+    {
+      filter = apr_pcalloc(ffsd->common_pool, sizeof(*filter));
+      filter->stale = TRUE;
+      ffsd->rep_cache_filter = filter;
+    }
+
+  if (check_counter)
+    {
+      filter->estimated_entries = estimated_entries;
+      if (filter->change_counter != change_counter)
+        filter->stale = TRUE;
+    }
+
+  if (!filter->stale)
+    {
+      *maybe_present = filter_test(filter, digest);
+      return SVN_NO_ERROR;
+    }
+
+  /* (Re-)build the filter once it pays off. */
+  filter->stale_lookups++;
+  if (   !filter->building
+      && filter->stale_lookups * FILTER_REBUILD_RATIO
+           >= MAX(filter->estimated_entries, FILTER_MIN_ENTRIES))
+    {
+      filter->building = TRUE;
+      *build = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MAYBE_PRESENT to FALSE if rep-cache.db of FS definitely does not
+   contain the SHA1 DIGEST.  Otherwise, set it to TRUE.  TXN_ID is the
+   transaction on whose behalf we look up DIGEST.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+check_filter(svn_boolean_t *maybe_present,
+             svn_fs_t *fs,
+             const unsigned char *digest,
+             const svn_fs_fs__id_part_t *txn_id,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t check_counter = FALSE;
+  apr_uint32_t change_counter = 0;
+  apr_int64_t estimated_entries = 0;
+  svn_boolean_t build;
+
+  /* Look for changes made by others only once per transaction. */
+  if (!svn_fs_fs__id_part_eq(&ffd->rep_cache_filter_txn_id, txn_id))
+    {
+      SVN_ERR(read_db_state(&change_counter, &estimated_entries, fs,
+                            scratch_pool));
+      ffd->rep_cache_filter_txn_id = *txn_id;
+      check_counter = TRUE;
+    }
+
+  SVN_MUTEX__WITH_LOCK(ffd->shared->rep_cache_filter_lock,
+                       test_filter(maybe_present, &build, ffd->shared,
+                                   digest, check_counter, change_counter,
+                                   estimated_entries));
+
+  /* The next lookup will use the new filter. */
+  if (build)
+    SVN_ERR(build_filter(fs, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the keys of all representations in REPS (an array of
+   representation_t *) to the filter in FFSD.  CHANGE_COUNTER is the file
+   change counter of rep-cache.db before the caller's SQLite transaction
+   that added them.  MODIFIED tells whether that transaction actually
+   modified the database.  The caller must hold the REP_CACHE_FILTER_LOCK
+   of FFSD. */
+static svn_error_t *
+add_to_filter(fs_fs_shared_data_t *ffsd,
+              const apr_array_header_t *reps,
+              apr_uint32_t change_counter,
+              svn_boolean_t modified)
+{
+  rep_cache_filter_t *filter = ffsd->rep_cache_filter;
+  int i;
+
+  if (!filter || filter->stale)
+    return SVN_NO_ERROR;
+
+  /* Someone else modified the database and the filter doesn't know. */
+  if (filter->change_counter != change_counter)
+    {
+      filter->stale = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  for (i = 0; i < reps->nelts; ++i)
+    filter_add(filter, APR_ARRAY_IDX(reps, i, representation_t *)
+                         ->sha1_digest);
+
+  /* SQLite increments the counter once when committing the transaction. */
+  if (modified)
+    filter->change_counter++;
+
+  return SVN_NO_ERROR;
+}
+
+
 /** Library-private API's. **/
 
 /* Body of svn_fs_fs__open_rep_cache().
@@ -264,6 +716,7 @@ svn_error_t *
 svn_fs_fs__get_rep_reference(representation_t **rep_p,
                              svn_fs_t *fs,
                              svn_checksum_t *checksum,
+                             const svn_fs_fs__id_part_t *txn_id,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
@@ -281,6 +734,20 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
+  /* Don't bother the database if it can't have a matching entry. */
+  if (txn_id)
+    {
+      svn_boolean_t maybe_present;
+
+      SVN_ERR(check_filter(&maybe_present, fs, checksum->digest, txn_id,
+                           pool));
+      if (!maybe_present)
+        {
+          *rep_p = NULL;
+          return SVN_NO_ERROR;
+        }
+    }
+
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "s",
                             svn_checksum_to_cstring(checksum, pool)));
@@ -321,59 +788,205 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__set_rep_reference(svn_fs_t *fs,
-                             representation_t *rep,
-                             apr_pool_t *pool)
+/* Number of entries added by a single STMT_SET_REP_BATCH statement. */
+#define REP_BATCH_SIZE 16
+
+/* Return an error if REP cannot be used as rep-cache entry. */
+static svn_error_t *
+check_rep_key(representation_t *rep)
+{
+  /* We only allow SHA1 checksums in this table. */
+  if (! rep->has_sha1)
+    return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL,
+                            _("Only SHA1 checksums can be used as keys in the "
+                              "rep_cache table.\n"));
+
+  return SVN_NO_ERROR;
+}
+
+/* The rep-cache.db of FS already contains an entry for the SHA1 checksum
+   of REP.  Verify that it is valid.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+check_existing_rep(svn_fs_t *fs,
+                   representation_t *rep,
+                   apr_pool_t *scratch_pool)
+{
+  representation_t *old_rep;
+  svn_checksum_t checksum;
+  checksum.kind = svn_checksum_sha1;
+  checksum.digest = rep->sha1_digest;
+
+  /* The mapping for SHA1_CHECKSUM->REP already exists.  If it is
+     valid, that's cool -- just do nothing.  */
+  SVN_ERR(svn_fs_fs__get_rep_reference(&old_rep, fs, &checksum, NULL,
+                                       scratch_pool));
+
+  if (!old_rep)
+    {
+      /* Something really odd at this point, we failed to insert the
+         checksum AND failed to read an existing checksum.  Do we need
+         to flag this? */
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add REP to the rep-cache.db of FS, unless there already is an entry
+   for its SHA1 checksum.  Set *INSERTED to TRUE if a new entry has been
+   added and to FALSE otherwise.  The database must already be open.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+insert_rep_reference(svn_boolean_t *inserted,
+                     svn_fs_t *fs,
+                     representation_t *rep,
+                     apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_sqlite__stmt_t *stmt;
-  svn_error_t *err;
+  int affected_rows;
   svn_checksum_t checksum;
   checksum.kind = svn_checksum_sha1;
   checksum.digest = rep->sha1_digest;
 
-  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
-  if (! ffd->rep_cache_db)
-    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
-
-  /* We only allow SHA1 checksums in this table. */
-  if (! rep->has_sha1)
-    return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL,
-                            _("Only SHA1 checksums can be used as keys in the "
-                              "rep_cache table.\n"));
+  SVN_ERR(check_rep_key(rep));
 
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_SET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "siiii",
-                            svn_checksum_to_cstring(&checksum, pool),
+                            svn_checksum_to_cstring(&checksum, scratch_pool),
                             (apr_int64_t) rep->revision,
                             (apr_int64_t) rep->item_index,
                             (apr_int64_t) rep->size,
                             (apr_int64_t) rep->expanded_size));
 
-  err = svn_sqlite__insert(NULL, stmt);
-  if (err)
+  SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
+  if (affected_rows == 0)
+    SVN_ERR(check_existing_rep(fs, rep, scratch_pool));
+
+  *inserted = affected_rows > 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like insert_rep_reference() but for the REP_BATCH_SIZE elements of REPS
+   (an array of representation_t *) starting at index FIRST, using a
+   single statement.  Set *INSERTED to TRUE if any new entry has been
+   added. */
+static svn_error_t *
+insert_rep_batch(svn_boolean_t *inserted,
+                 svn_fs_t *fs,
+                 const apr_array_header_t *reps,
+                 int first,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  int affected_rows;
+  int i;
+
+  for (i = first; i < first + REP_BATCH_SIZE; ++i)
+    SVN_ERR(check_rep_key(APR_ARRAY_IDX(reps, i, representation_t *)));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_SET_REP_BATCH));
+  for (i = 0; i < REP_BATCH_SIZE; ++i)
     {
-      representation_t *old_rep;
+      representation_t *rep = APR_ARRAY_IDX(reps, first + i,
+                                            representation_t *);
+      int slot = i * 5 + 1;
+      svn_checksum_t checksum;
+      checksum.kind = svn_checksum_sha1;
+      checksum.digest = rep->sha1_digest;
+
+      SVN_ERR(svn_sqlite__bind_text(stmt, slot,
+                                    svn_checksum_to_cstring(&checksum,
+                                                            scratch_pool)));
+      SVN_ERR(svn_sqlite__bind_int64(stmt, slot + 1, rep->revision));
+      SVN_ERR(svn_sqlite__bind_int64(stmt, slot + 2, rep->item_index));
+      SVN_ERR(svn_sqlite__bind_int64(stmt, slot + 3, rep->size));
+      SVN_ERR(svn_sqlite__bind_int64(stmt, slot + 4, rep->expanded_size));
+    }
+
+  SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
+
+  /* We can't tell which entries existed before.  Check all of them. */
+  if (affected_rows < REP_BATCH_SIZE)
+    for (i = first; i < first + REP_BATCH_SIZE; ++i)
+      SVN_ERR(check_existing_rep(fs, APR_ARRAY_IDX(reps, i,
+                                                   representation_t *),
+                                 scratch_pool));
 
-      if (err->apr_err != SVN_ERR_SQLITE_CONSTRAINT)
-        return svn_error_trace(err);
+  *inserted = affected_rows > 0;
 
-      svn_error_clear(err);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__set_rep_reference(svn_fs_t *fs,
+                             representation_t *rep,
+                             apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t inserted;
+
+  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
-      /* Constraint failed so the mapping for SHA1_CHECKSUM->REP
-         should exist.  If so that's cool -- just do nothing.  If not,
-         that's a red flag!  */
-      SVN_ERR(svn_fs_fs__get_rep_reference(&old_rep, fs, &checksum, pool));
+  /* Not updating the filter here simply makes it stale. */
+  return svn_error_trace(insert_rep_reference(&inserted, fs, rep, pool));
+}
 
-      if (!old_rep)
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool;
+  svn_boolean_t modified = FALSE;
+  apr_uint32_t change_counter;
+  int i;
+
+  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+
+  if (reps->nelts == 0)
+    return SVN_NO_ERROR;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < reps->nelts; )
+    {
+      svn_boolean_t inserted;
+
+      svn_pool_clear(iterpool);
+      if (reps->nelts - i >= REP_BATCH_SIZE)
         {
-          /* Something really odd at this point, we failed to insert the
-             checksum AND failed to read an existing checksum.  Do we need
-             to flag this? */
+          SVN_ERR(insert_rep_batch(&inserted, fs, reps, i, iterpool));
+          i += REP_BATCH_SIZE;
         }
+      else
+        {
+          SVN_ERR(insert_rep_reference(&inserted, fs,
+                                       APR_ARRAY_IDX(reps, i,
+                                                     representation_t *),
+                                       iterpool));
+          ++i;
+        }
+
+      modified |= inserted;
     }
 
+  svn_pool_destroy(iterpool);
+
+  /* The caller's transaction holds a write lock by now, so nobody else
+     can have committed changes since it started.  Tell the filter. */
+  SVN_ERR(read_db_state(&change_counter, NULL, fs, scratch_pool));
+  SVN_MUTEX__WITH_LOCK(ffd->shared->rep_cache_filter_lock,
+                       add_to_filter(ffd->shared, reps, change_counter,
+                                     modified));
+
   return SVN_NO_ERROR;
 }
 
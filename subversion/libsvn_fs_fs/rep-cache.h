@@ -66,11 +66,17 @@ svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
 /* Return the representation REP in FS which has fulltext CHECKSUM.
    *REP_P is allocated in POOL.  If the rep cache database has not been
    opened, just set *REP_P to NULL.  Returns SVN_ERR_FS_CORRUPT if
-   a reference beyond HEAD is detected. */
+   a reference beyond HEAD is detected.
+
+   If TXN_ID is not NULL, the lookup is made on behalf of that transaction
+   and may be answered by an in-memory filter instead of the database.
+   Entries added by other processes while the transaction is running may
+   then not be found. */
 svn_error_t *
 svn_fs_fs__get_rep_reference(representation_t **rep_p,
                              svn_fs_t *fs,
                              svn_checksum_t *checksum,
+                             const svn_fs_fs__id_part_t *txn_id,
                              apr_pool_t *pool);
 
 /* Set the representation REP in FS, using REP->CHECKSUM.
@@ -83,6 +89,21 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              representation_t *rep,
                              apr_pool_t *pool);
 
+/* Set all representations in REPS (an array of representation_t *) in FS,
+   using their respective CHECKSUMs.  This is equivalent to calling
+   svn_fs_fs__set_rep_reference() for each of them but cheaper for large
+   numbers of REPS.  The caller should wrap this in an SQLite transaction;
+   otherwise, the in-memory filter used by svn_fs_fs__get_rep_reference()
+   needs to be rebuilt afterwards.
+   Use SCRATCH_POOL for temporary allocations.  Returns SVN_ERR_FS_CORRUPT
+   if an existing reference beyond HEAD is detected.
+
+   If the rep cache database has not been opened, this may be a no op. */
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool);
+
 /* Delete from the cache all reps corresponding to revisions younger
    than YOUNGEST. */
 svn_error_t *
@@ -20,6 +20,8 @@
  * ====================================================================
  */
 
+#include <apr_mmap.h>
+
 #include "rev_file.h"
 #include "fs_fs.h"
 #include "index.h"
@@ -28,9 +30,29 @@
 
 #include "../libsvn_fs/fs-loader.h"
 
+#include "svn_pools.h"
 #include "private/svn_io_private.h"
 #include "svn_private_config.h"
 
+/* Upper limit for the number of pack files per repository that we keep
+ * mapped into memory.  Beyond that, we use the regular file access. */
+#define MAX_MAPPED_FILES 4096
+
+/* A memory mapped pack file as being stored in the FS' shared data. */
+typedef struct mapped_file_t
+{
+  /* The mapped file contents. */
+  const char *data;
+
+  /* Number of bytes in DATA. */
+  apr_off_t size;
+
+  /* File identity at the time it got mapped.  If any of these changes,
+   * the pack file has been replaced and needs to be mapped again. */
+  apr_ino_t inode;
+  apr_time_t mtime;
+} mapped_file_t;
+
 /* Initialize the *FILE structure for REVISION in filesystem FS.  Set its
  * pool member to the provided POOL. */
 static void
@@ -54,9 +76,115 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   file->p2l_offset = -1;
   file->p2l_checksum = NULL;
   file->footer_offset = -1;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
   file->pool = pool;
 }
 
+#if APR_HAS_MMAP
+
+/* Set *MAPPED to the mapping of the pack file starting at START_REVISION
+ * in FFSD.  If there is no mapping for APR_FILE with the identity given
+ * by FINFO, yet, create one.  Set *MAPPED to NULL if the file can't be
+ * mapped.  The caller must hold FFSD->MAPPED_FILES_LOCK.
+ */
+static svn_error_t *
+get_mapped_file(mapped_file_t **mapped,
+                fs_fs_shared_data_t *ffsd,
+                svn_revnum_t start_revision,
+                apr_file_t *apr_file,
+                const apr_finfo_t *finfo)
+{
+  mapped_file_t *result;
+  apr_mmap_t *mmap;
+  apr_status_t status;
+
+  if (!ffsd->mapped_files)
+    {
+      ffsd->mapped_files_pool = svn_pool_create(ffsd->common_pool);
+      ffsd->mapped_files = apr_hash_make(ffsd->mapped_files_pool);
+    }
+
+  result = apr_hash_get(ffsd->mapped_files, &start_revision,
+                        sizeof(start_revision));
+  if (   result
+      && result->size == finfo->size
+      && result->inode == finfo->inode
+      && result->mtime == finfo->mtime)
+    {
+      *mapped = result;
+      return SVN_NO_ERROR;
+    }
+
+  /* Don't exhaust the address space. */
+  *mapped = NULL;
+  if (!result && apr_hash_count(ffsd->mapped_files) >= MAX_MAPPED_FILES)
+    return SVN_NO_ERROR;
+
+  /* Mapping is only an optimization.  Upon failure, simply use the file.
+   * Outdated mappings may still be in use by other threads and will only
+   * be released together with the shared data. */
+  status = apr_mmap_create(&mmap, apr_file, 0, (apr_size_t)finfo->size,
+                           APR_MMAP_READ, ffsd->mapped_files_pool);
+  if (status)
+    return SVN_NO_ERROR;
+
+  result = apr_palloc(ffsd->mapped_files_pool, sizeof(*result));
+  result->data = mmap->mm;
+  result->size = finfo->size;
+  result->inode = finfo->inode;
+  result->mtime = finfo->mtime;
+
+  apr_hash_set(ffsd->mapped_files,
+               apr_pmemdup(ffsd->mapped_files_pool, &start_revision,
+                           sizeof(start_revision)),
+               sizeof(start_revision), result);
+  *mapped = result;
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
+/* If enabled in FS, attach the memory mapping of the pack file to FILE,
+ * creating it if necessary. */
+static svn_error_t *
+auto_map_pack_file(svn_fs_fs__revision_file_t *file,
+                   svn_fs_t *fs)
+{
+#if APR_HAS_MMAP
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_int32_t wanted = APR_FINFO_SIZE | APR_FINFO_INODE | APR_FINFO_MTIME;
+  apr_finfo_t finfo;
+  apr_status_t status;
+  mapped_file_t *mapped;
+
+  if (!ffd->mmap_packed_files || !ffd->shared || !file->is_packed)
+    return SVN_NO_ERROR;
+
+  /* Without a file size or if we could not address the whole file,
+   * don't map it. */
+  status = apr_file_info_get(&finfo, wanted, file->file);
+  if (   (status && status != APR_INCOMPLETE)
+      || (finfo.valid & wanted) != wanted
+      || finfo.size <= 0
+      || (apr_uint64_t)finfo.size > APR_SIZE_MAX)
+    return SVN_NO_ERROR;
+
+  SVN_MUTEX__WITH_LOCK(ffd->shared->mapped_files_lock,
+                       get_mapped_file(&mapped, ffd->shared,
+                                       file->start_revision, file->file,
+                                       &finfo));
+  if (mapped)
+    {
+      file->mapped_data = mapped->data;
+      file->mapped_size = mapped->size;
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton type for set_read_only() */
 typedef struct set_read_only_baton_t
 {
@@ -160,6 +288,11 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
                                                   result_pool);
           file->is_packed = svn_fs_fs__is_packed_rev(fs, rev);
 
+          /* Pack files won't change, so it's safe to read them from
+           * a long-lived mapping. */
+          if (!writable)
+            SVN_ERR(auto_map_pack_file(file, fs));
+
           return SVN_NO_ERROR;
         }
 
@@ -236,24 +369,46 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
       unsigned char footer_length;
       svn_stringbuf_t *footer;
 
-      /* Determine file size. */
-      SVN_ERR(svn_io_file_seek(file->file, APR_END, &filesize, file->pool));
-
-      /* Read last byte (containing the length of the footer). */
-      SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size, NULL,
-                                       filesize - 1, file->pool));
-      SVN_ERR(svn_io_file_read_full2(file->file, &footer_length,
-                                     sizeof(footer_length), NULL, NULL,
-                                     file->pool));
-
-      /* Read footer. */
-      footer = svn_stringbuf_create_ensure(footer_length, file->pool);
-      SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size, NULL,
-                                       filesize - 1 - footer_length,
-                                       file->pool));
-      SVN_ERR(svn_io_file_read_full2(file->file, footer->data, footer_length,
-                                     &footer->len, NULL, file->pool));
-      footer->data[footer->len] = '\0';
+      if (file->mapped_data)
+        {
+          /* Read the footer directly from the mapped file. */
+          filesize = file->mapped_size;
+          footer_length = (unsigned char)file->mapped_data[filesize - 1];
+          if (footer_length >= filesize)
+            return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                     _("Invalid footer length %d in pack "
+                                       "file for revision %ld"),
+                                     (int)footer_length,
+                                     file->start_revision);
+
+          footer = svn_stringbuf_ncreate(file->mapped_data + filesize - 1
+                                           - footer_length,
+                                         footer_length, file->pool);
+        }
+      else
+        {
+          /* Determine file size. */
+          SVN_ERR(svn_io_file_seek(file->file, APR_END, &filesize,
+                                   file->pool));
+
+          /* Read last byte (containing the length of the footer). */
+          SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size,
+                                           NULL, filesize - 1, file->pool));
+          SVN_ERR(svn_io_file_read_full2(file->file, &footer_length,
+                                         sizeof(footer_length), NULL, NULL,
+                                         file->pool));
+
+          /* Read footer. */
+          footer = svn_stringbuf_create_ensure(footer_length, file->pool);
+          SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size,
+                                           NULL,
+                                           filesize - 1 - footer_length,
+                                           file->pool));
+          SVN_ERR(svn_io_file_read_full2(file->file, footer->data,
+                                         footer_length, &footer->len, NULL,
+                                         file->pool));
+          footer->data[footer->len] = '\0';
+        }
 
       /* Extract index locations. */
       SVN_ERR(svn_fs_fs__parse_footer(&file->l2p_offset, &file->l2p_checksum,
@@ -302,6 +457,8 @@ svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file)
   file->stream = NULL;
   file->l2p_stream = NULL;
   file->p2l_stream = NULL;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
 
   return SVN_NO_ERROR;
 }
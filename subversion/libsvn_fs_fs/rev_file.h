@@ -90,6 +90,15 @@ typedef struct svn_fs_fs__revision_file_t
    * been called, yet. */
   apr_off_t footer_offset;
 
+  /* If not NULL, the whole contents of FILE mapped into memory.  This is
+   * shared with all other users of the same pack file and remains valid
+   * for as long as the filesystem's shared data exists.  Only used for
+   * read-only access to pack files. */
+  const char *mapped_data;
+
+  /* Number of bytes in MAPPED_DATA.  0 if MAPPED_DATA is NULL. */
+  apr_off_t mapped_size;
+
   /* pool containing this object */
   apr_pool_t *pool;
 } svn_fs_fs__revision_file_t;
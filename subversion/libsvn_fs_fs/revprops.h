@@ -22,6 +22,8 @@
 
 #include "svn_fs.h"
 
+#include "batch_fsync.h"
+
 /* In the filesystem FS, pack all revprop shards up to min_unpacked_rev.
  *
  * NOTE: Keep the old non-packed shards around until after the format bump.
@@ -111,9 +113,9 @@ svn_fs_fs__packed_revprop_available(svn_boolean_t *missing,
  * a hint on which initial buffer size we should use to hold the pack file
  * content.
  *
- * If FLUSH_TO_DISK is non-zero, do not return until the data has actually
- * been written on the disk.  CANCEL_FUNC and CANCEL_BATON are used as usual.
- * Temporary allocations are done in SCRATCH_POOL.
+ * The pack file will be opened through BATCH, i.e. BATCH is responsible
+ * for flushing and closing it.  CANCEL_FUNC and CANCEL_BATON are used as
+ * usual.  Temporary allocations are done in SCRATCH_POOL.
  */
 svn_error_t *
 svn_fs_fs__copy_revprops(const char *pack_file_dir,
@@ -124,7 +126,7 @@ svn_fs_fs__copy_revprops(const char *pack_file_dir,
                          apr_array_header_t *sizes,
                          apr_size_t total_size,
                          int compression_level,
-                         svn_boolean_t flush_to_disk,
+                         svn_fs_fs__batch_fsync_t *batch,
                          svn_cancel_func_t cancel_func,
                          void *cancel_baton,
                          apr_pool_t *scratch_pool);
@@ -32,6 +32,7 @@
 #include "svn_time.h"
 #include "svn_dirent_uri.h"
 
+#include "batch_fsync.h"
 #include "fs_fs.h"
 #include "index.h"
 #include "tree.h"
@@ -43,6 +44,7 @@
 #include "lock.h"
 #include "rep-cache.h"
 
+#include "private/svn_delta_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
@@ -2159,32 +2161,37 @@ rep_write_cleanup(void *data)
   return APR_SUCCESS;
 }
 
-static void
-txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
-                   void **handler_baton,
-                   svn_stream_t *output,
-                   svn_fs_t *fs,
-                   apr_pool_t *pool)
+/* Return the svndiff version to use for new representations in FS. */
+static int
+get_svndiff_version(svn_fs_t *fs)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  int svndiff_version;
 
   if (ffd->delta_compression_type == compression_type_lz4)
     {
       SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT);
-      svndiff_version = 2;
+      return 2;
     }
   else if (ffd->delta_compression_type == compression_type_zlib)
     {
       SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF1_FORMAT);
-      svndiff_version = 1;
-    }
-  else
-    {
-      svndiff_version = 0;
+      return 1;
     }
 
-  svn_txdelta_to_svndiff3(handler, handler_baton, output, svndiff_version,
+  return 0;
+}
+
+static void
+txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
+                   void **handler_baton,
+                   svn_stream_t *output,
+                   svn_fs_t *fs,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  svn_txdelta_to_svndiff3(handler, handler_baton, output,
+                          get_svndiff_version(fs),
                           ffd->delta_compression_level, pool);
 }
 
@@ -2198,6 +2205,7 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
                     node_revision_t *noderev,
                     apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   struct rep_write_baton *b;
   apr_file_t *file;
   representation_t *base_rep;
@@ -2258,11 +2266,24 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   apr_pool_cleanup_register(b->scratch_pool, b, rep_write_cleanup,
                             apr_pool_cleanup_null);
 
-  /* Prepare to write the svndiff data. */
-  txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
-
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->scratch_pool);
+  /* Prepare to write the svndiff data.  Large files may be processed
+     in multiple threads. */
+  if (ffd->delta_threads > 1)
+    {
+      SVN_ERR(svn_txdelta__target_push_svndiff(&b->delta_stream,
+                                               b->rep_stream,
+                                               get_svndiff_version(fs),
+                                               ffd->delta_compression_level,
+                                               source,
+                                               (int)ffd->delta_threads,
+                                               b->scratch_pool));
+    }
+  else
+    {
+      txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
+      b->delta_stream = svn_txdelta_target_push(wh, whb, source,
+                                                b->scratch_pool);
+    }
 
   *wb_p = b;
 
@@ -2320,7 +2341,11 @@ get_shared_rep(representation_t **old_rep,
   /* If we haven't found anything yet, try harder and consult our DB. */
   if (*old_rep == NULL)
     {
-      err = svn_fs_fs__get_rep_reference(old_rep, fs, &checksum, result_pool);
+      err = svn_fs_fs__get_rep_reference(old_rep, fs, &checksum,
+                                         svn_fs_fs__id_txn_used(&rep->txn_id)
+                                           ? &rep->txn_id
+                                           : NULL,
+                                         result_pool);
       /* ### Other error codes that we shouldn't mask out? */
       if (err == SVN_NO_ERROR)
         {
@@ -3593,13 +3618,14 @@ verify_locks(svn_fs_t *fs,
 }
 
 /* Writes final revision properties to file PATH applying permissions
-   from file PERMS_REFERENCE. This involves setting svn:date and
-   removing any temporary properties associated with the commit flags. */
+   from file PERMS_REFERENCE and schedules the necessary fsyncs in BATCH.
+   This involves setting svn:date and removing any temporary properties
+   associated with the commit flags. */
 static svn_error_t *
 write_final_revprop(const char *path,
                     const char *perms_reference,
                     svn_fs_txn_t *txn,
-                    svn_boolean_t flush_to_disk,
+                    svn_fs_fs__batch_fsync_t *batch,
                     apr_pool_t *pool)
 {
   apr_hash_t *txnprops;
@@ -3629,19 +3655,19 @@ write_final_revprop(const char *path,
       svn_hash_sets(txnprops, SVN_PROP_REVISION_DATE, &date);
     }
 
-  /* Create new revprops file. Tell OS to truncate existing file,
-     since  file may already exists from failed transaction. */
-  SVN_ERR(svn_io_file_open(&revprop_file, path,
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  /* Create new revprops file. Truncate existing file, since file may
+     already exist from failed transaction.  BATCH owns the handle and
+     will fsync and close it. */
+  SVN_ERR(svn_fs_fs__batch_fsync_open_file(&revprop_file, batch, path,
+                                           pool));
+  SVN_ERR(svn_io_file_trunc(revprop_file, 0, pool));
 
   stream = svn_stream_from_aprfile2(revprop_file, TRUE, pool);
   SVN_ERR(svn_hash_write2(txnprops, stream, SVN_HASH_TERMINATOR, pool));
   SVN_ERR(svn_stream_close(stream));
 
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(revprop_file, pool));
-  SVN_ERR(svn_io_file_close(revprop_file, pool));
+  /* Make the contents visible to readers, e.g. the paranoia checks. */
+  SVN_ERR(svn_io_file_flush(revprop_file, pool));
 
   SVN_ERR(svn_io_copy_perms(perms_reference, path, pool));
 
@@ -3750,6 +3776,7 @@ commit_body(void *baton, apr_pool_t *pool)
   svn_revnum_t old_rev, new_rev;
   apr_file_t *proto_file;
   void *proto_file_lockcookie;
+  svn_fs_fs__batch_fsync_t *batch;
   apr_off_t initial_offset, changed_path_offset;
   const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
   apr_hash_t *changed_paths;
@@ -3837,8 +3864,6 @@ commit_body(void *baton, apr_pool_t *pool)
                                      NULL, pool));
     }
 
-  if (ffd->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
   SVN_ERR(svn_io_file_close(proto_file, pool));
 
   /* We don't unlock the prototype revision file immediately to avoid a
@@ -3847,7 +3872,11 @@ commit_body(void *baton, apr_pool_t *pool)
 
   /* Create the shard for the rev and revprop file, if we're sharding and
      this is the first revision of a new shard.  We don't care if this
-     fails because the shard already existed for some reason. */
+     fails because the shard already existed for some reason.
+
+     All fsyncs required for the new revision get collected in BATCH
+     and will be run concurrently before we bump 'current'. */
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, ffd->flush_to_disk, pool));
   if (ffd->max_files_per_dir && new_rev % ffd->max_files_per_dir == 0)
     {
       /* Create the revs shard. */
@@ -3863,6 +3892,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_dir, pool));
         }
 
       /* Create the revprops shard. */
@@ -3879,6 +3909,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVPROPS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_dir, pool));
         }
     }
 
@@ -3891,8 +3922,9 @@ commit_body(void *baton, apr_pool_t *pool)
   rev_filename = svn_fs_fs__path_rev(cb->fs, new_rev, pool);
   proto_filename = svn_fs_fs__path_txn_proto_rev(cb->fs, txn_id, pool);
   SVN_ERR(svn_fs_fs__move_into_place(proto_filename, rev_filename,
-                                     old_rev_filename, ffd->flush_to_disk,
-                                     pool));
+                                     old_rev_filename, FALSE, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_add_file(batch, rev_filename, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, rev_filename, pool));
 
   /* Now that we've moved the prototype revision file out of the way,
      we can unlock it (since further attempts to write to the file
@@ -3904,7 +3936,7 @@ commit_body(void *baton, apr_pool_t *pool)
   SVN_ERR_ASSERT(! svn_fs_fs__is_packed_revprop(cb->fs, new_rev));
   revprop_filename = svn_fs_fs__path_revprops(cb->fs, new_rev, pool);
   SVN_ERR(write_final_revprop(revprop_filename, old_rev_filename,
-                              cb->txn, ffd->flush_to_disk, pool));
+                              cb->txn, batch, pool));
 
   /* Run paranoia checks. */
   if (ffd->verify_before_commit)
@@ -3912,6 +3944,11 @@ commit_body(void *baton, apr_pool_t *pool)
       SVN_ERR(verify_before_commit(cb->fs, new_rev, pool));
     }
 
+  /* Make sure all data of the new revision is on disk before we make it
+     visible.  Otherwise, 'current' might point to a revision that got
+     lost in a system crash. */
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
+
   /* Update the 'current' file. */
   SVN_ERR(write_final_current(cb->fs, txn_id, new_rev, start_node_id,
                               start_copy_id, pool));
@@ -3935,25 +3972,6 @@ commit_body(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
-/* Add the representations in REPS_TO_CACHE (an array of representation_t *)
- * to the rep-cache database of FS. */
-static svn_error_t *
-write_reps_to_cache(svn_fs_t *fs,
-                    const apr_array_header_t *reps_to_cache,
-                    apr_pool_t *scratch_pool)
-{
-  int i;
-
-  for (i = 0; i < reps_to_cache->nelts; i++)
-    {
-      representation_t *rep = APR_ARRAY_IDX(reps_to_cache, i, representation_t *);
-
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, rep, scratch_pool));
-    }
-
-  return SVN_NO_ERROR;
-}
-
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
@@ -4000,7 +4018,7 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
              (reader/writer) commits for the duration of the below call.
              Maybe write in batches? */
       SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = write_reps_to_cache(fs, cb.reps_to_cache, pool);
+      err = svn_fs_fs__set_rep_references(fs, cb.reps_to_cache, pool);
       err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
 
       if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
@@ -668,6 +668,31 @@ svn_ra_list(svn_ra_session_t *session,
                                scratch_pool);
 }
 
+svn_error_t *
+svn_ra__blame(svn_ra_session_t *session,
+              const char *path,
+              svn_revnum_t start,
+              svn_revnum_t end,
+              const svn_diff_file_options_t *diff_options,
+              apr_array_header_t **chunks,
+              apr_hash_t **rev_props,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(start) && SVN_IS_VALID_REVNUM(end));
+  SVN_ERR_ASSERT(start <= end);
+  if (!session->vtable->blame)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL, NULL);
+
+  SVN_ERR(svn_ra__assert_capable_server(session, SVN_RA__CAPABILITY_BLAME,
+                                        NULL, scratch_pool));
+
+  return session->vtable->blame(session, path, start, end, diff_options,
+                                chunks, rev_props, result_pool,
+                                scratch_pool);
+}
+
 svn_error_t *svn_ra_get_mergeinfo(svn_ra_session_t *session,
                                   svn_mergeinfo_catalog_t *catalog,
                                   const apr_array_header_t *paths,
@@ -1673,6 +1673,7 @@ svn_ra_local__has_capability(svn_ra_session_t *session,
       || strcmp(capability, SVN_RA_CAPABILITY_EPHEMERAL_TXNPROPS) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_LIST) == 0
+      || strcmp(capability, SVN_RA__CAPABILITY_BLAME) == 0
       )
     {
       *has = TRUE;
@@ -1863,6 +1864,45 @@ svn_ra_local__list(svn_ra_session_t *session,
                                         sess->callback_baton, pool));
 }
 
+static svn_error_t *
+svn_ra_local__blame(svn_ra_session_t *session,
+                    const char *path,
+                    svn_revnum_t start,
+                    svn_revnum_t end,
+                    const svn_diff_file_options_t *diff_options,
+                    apr_array_header_t **chunks,
+                    apr_hash_t **rev_props,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  apr_array_header_t *repos_chunks;
+  int i;
+
+  path = svn_fspath__join(sess->fs_path->data, path, scratch_pool);
+  SVN_ERR(svn_repos__blame(&repos_chunks, rev_props, sess->repos, path,
+                           start, end, diff_options, NULL, NULL,
+                           sess->callbacks
+                             ? sess->callbacks->cancel_func
+                             : NULL,
+                           sess->callback_baton,
+                           result_pool, scratch_pool));
+
+  *chunks = apr_array_make(result_pool, repos_chunks->nelts,
+                           sizeof(svn_ra__blame_chunk_t));
+  for (i = 0; i < repos_chunks->nelts; ++i)
+    {
+      const svn_repos__blame_chunk_t *repos_chunk
+        = &APR_ARRAY_IDX(repos_chunks, i, svn_repos__blame_chunk_t);
+      svn_ra__blame_chunk_t *chunk = apr_array_push(*chunks);
+
+      chunk->start = repos_chunk->start;
+      chunk->revision = repos_chunk->revision;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /*----------------------------------------------------------------*/
 
 static const svn_version_t *
@@ -1914,6 +1954,7 @@ static const svn_ra__vtable_t ra_local_vtable =
   svn_ra_local__get_inherited_props,
   NULL /* set_svn_ra_open */,
   svn_ra_local__list ,
+  svn_ra_local__blame,
   svn_ra_local__register_editor_shim_callbacks,
   svn_ra_local__get_commit_ev2,
   NULL /* replay_range_ev2 */
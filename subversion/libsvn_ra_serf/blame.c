@@ -397,3 +397,218 @@ svn_ra_serf__get_file_revs(svn_ra_session_t *ra_session,
 
   return SVN_NO_ERROR;
 }
+
+
+/*
+ * The server-side blame REPORT, see svn_ra__blame().
+ */
+typedef enum blame_report_state_e {
+  BLAME_INITIAL = XML_STATE_INITIAL,
+  BLAME_REPORT,
+  BLAME_CHUNK,
+  BLAME_REVISION,
+  BLAME_REV_PROP
+} blame_report_state_e;
+
+typedef struct blame_report_context_t {
+  /* parameters set by our caller */
+  const char *path;
+  svn_revnum_t start;
+  svn_revnum_t end;
+  const svn_diff_file_options_t *diff_options;
+
+  /* The results, allocated in RESULT_POOL. */
+  apr_array_header_t *chunks;
+  apr_hash_t *rev_props;
+  apr_pool_t *result_pool;
+
+  /* The revision properties of the REVISION being parsed. */
+  apr_hash_t *props;
+} blame_report_context_t;
+
+static const svn_ra_serf__xml_transition_t blame_report_ttable[] = {
+  { BLAME_INITIAL, S_, "blame-report", BLAME_REPORT,
+    FALSE, { NULL }, FALSE },
+
+  { BLAME_REPORT, S_, "chunk", BLAME_CHUNK,
+    FALSE, { "start", "?rev", NULL }, TRUE },
+
+  { BLAME_REPORT, S_, "revision", BLAME_REVISION,
+    FALSE, { "rev", NULL }, TRUE },
+
+  { BLAME_REVISION, S_, "rev-prop", BLAME_REV_PROP,
+    TRUE, { "name", "?encoding", NULL }, TRUE },
+
+  { 0 }
+};
+
+/* Conforms to svn_ra_serf__xml_opened_t  */
+static svn_error_t *
+blame_report_opened(svn_ra_serf__xml_estate_t *xes,
+                    void *baton,
+                    int entered_state,
+                    const svn_ra_serf__dav_props_t *tag,
+                    apr_pool_t *scratch_pool)
+{
+  blame_report_context_t *ctx = baton;
+
+  if (entered_state == BLAME_REVISION)
+    ctx->props = apr_hash_make(ctx->result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Conforms to svn_ra_serf__xml_closed_t  */
+static svn_error_t *
+blame_report_closed(svn_ra_serf__xml_estate_t *xes,
+                    void *baton,
+                    int leaving_state,
+                    const svn_string_t *cdata,
+                    apr_hash_t *attrs,
+                    apr_pool_t *scratch_pool)
+{
+  blame_report_context_t *ctx = baton;
+
+  if (leaving_state == BLAME_CHUNK)
+    {
+      const char *rev_str = svn_hash_gets(attrs, "rev");
+      svn_ra__blame_chunk_t *chunk = apr_array_push(ctx->chunks);
+
+      SVN_ERR(svn_cstring_atoi64(&chunk->start,
+                                 svn_hash_gets(attrs, "start")));
+      chunk->revision = rev_str ? SVN_STR_TO_REV(rev_str)
+                                : SVN_INVALID_REVNUM;
+    }
+  else if (leaving_state == BLAME_REVISION)
+    {
+      svn_revnum_t revision = SVN_STR_TO_REV(svn_hash_gets(attrs, "rev"));
+
+      apr_hash_set(ctx->rev_props,
+                   apr_pmemdup(ctx->result_pool, &revision, sizeof(revision)),
+                   sizeof(revision), ctx->props);
+    }
+  else
+    {
+      const char *encoding = svn_hash_gets(attrs, "encoding");
+      const char *name;
+      const svn_string_t *value;
+
+      SVN_ERR_ASSERT(leaving_state == BLAME_REV_PROP);
+
+      name = apr_pstrdup(ctx->result_pool, svn_hash_gets(attrs, "name"));
+      if (encoding && strcmp(encoding, "base64") == 0)
+        value = svn_base64_decode_string(cdata, ctx->result_pool);
+      else
+        value = svn_string_dup(cdata, ctx->result_pool);
+
+      svn_hash_sets(ctx->props, name, value);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__request_body_delegate_t */
+static svn_error_t *
+create_blame_body(serf_bucket_t **body_bkt,
+                  void *baton,
+                  serf_bucket_alloc_t *alloc,
+                  apr_pool_t *pool /* request pool */,
+                  apr_pool_t *scratch_pool)
+{
+  serf_bucket_t *buckets;
+  blame_report_context_t *ctx = baton;
+
+  buckets = serf_bucket_aggregate_create(alloc);
+
+  svn_ra_serf__add_open_tag_buckets(buckets, alloc,
+                                    "S:blame-report",
+                                    "xmlns:S", SVN_XML_NAMESPACE,
+                                    SVN_VA_NULL);
+
+  svn_ra_serf__add_tag_buckets(buckets,
+                               "S:start-revision",
+                               apr_ltoa(pool, ctx->start), alloc);
+
+  svn_ra_serf__add_tag_buckets(buckets,
+                               "S:end-revision",
+                               apr_ltoa(pool, ctx->end), alloc);
+
+  if (ctx->diff_options)
+    {
+      if (ctx->diff_options->ignore_space == svn_diff_file_ignore_space_change)
+        svn_ra_serf__add_tag_buckets(buckets, "S:ignore-space", "change",
+                                     alloc);
+      else if (ctx->diff_options->ignore_space
+                 == svn_diff_file_ignore_space_all)
+        svn_ra_serf__add_tag_buckets(buckets, "S:ignore-space", "all",
+                                     alloc);
+
+      if (ctx->diff_options->ignore_eol_style)
+        svn_ra_serf__add_empty_tag_buckets(buckets, alloc,
+                                           "S:ignore-eol-style", SVN_VA_NULL);
+    }
+
+  svn_ra_serf__add_tag_buckets(buckets, "S:path", ctx->path, alloc);
+
+  svn_ra_serf__add_close_tag_buckets(buckets, alloc, "S:blame-report");
+
+  *body_bkt = buckets;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__blame(svn_ra_session_t *ra_session,
+                   const char *path,
+                   svn_revnum_t start,
+                   svn_revnum_t end,
+                   const svn_diff_file_options_t *diff_options,
+                   apr_array_header_t **chunks,
+                   apr_hash_t **rev_props,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  blame_report_context_t *ctx;
+  svn_ra_serf__session_t *session = ra_session->priv;
+  svn_ra_serf__handler_t *handler;
+  svn_ra_serf__xml_context_t *xmlctx;
+  const char *req_url;
+
+  ctx = apr_pcalloc(scratch_pool, sizeof(*ctx));
+  ctx->path = path;
+  ctx->start = start;
+  ctx->end = end;
+  ctx->diff_options = diff_options;
+  ctx->chunks = apr_array_make(result_pool, 16, sizeof(svn_ra__blame_chunk_t));
+  ctx->rev_props = apr_hash_make(result_pool);
+  ctx->result_pool = result_pool;
+
+  SVN_ERR(svn_ra_serf__get_stable_url(&req_url, NULL /* latest_revnum */,
+                                      session,
+                                      NULL /* url */, end,
+                                      scratch_pool, scratch_pool));
+
+  xmlctx = svn_ra_serf__xml_context_create(blame_report_ttable,
+                                           blame_report_opened,
+                                           blame_report_closed,
+                                           NULL,
+                                           ctx,
+                                           scratch_pool);
+  handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
+                                              scratch_pool);
+
+  handler->method = "REPORT";
+  handler->path = req_url;
+  handler->body_type = "text/xml";
+  handler->body_delegate = create_blame_body;
+  handler->body_delegate_baton = ctx;
+
+  SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+
+  if (handler->sline.code != 200)
+    return svn_error_trace(svn_ra_serf__unexpected_status(handler));
+
+  *chunks = ctx->chunks;
+  *rev_props = ctx->rev_props;
+
+  return SVN_NO_ERROR;
+}
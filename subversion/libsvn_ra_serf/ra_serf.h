@@ -33,6 +33,7 @@
 #include "svn_pools.h"
 #include "svn_ra.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_version.h"
 #include "svn_dav.h"
 #include "svn_dirent_uri.h"
@@ -1321,6 +1322,18 @@ svn_ra_serf__get_file_revs(svn_ra_session_t *session,
                            void *handler_baton,
                            apr_pool_t *pool);
 
+/* Implements svn_ra__vtable_t.blame(). */
+svn_error_t *
+svn_ra_serf__blame(svn_ra_session_t *ra_session,
+                   const char *path,
+                   svn_revnum_t start,
+                   svn_revnum_t end,
+                   const svn_diff_file_options_t *diff_options,
+                   apr_array_header_t **chunks,
+                   apr_hash_t **rev_props,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool);
+
 /* Implements svn_ra__vtable_t.get_dated_revision(). */
 svn_error_t *
 svn_ra_serf__get_dated_revision(svn_ra_session_t *session,
@@ -604,6 +604,31 @@ static apr_status_t close_tunnel_cleanup(void *baton)
   return APR_SUCCESS; /* ignored */
 }
 
+/* Set *COMPRESSED to TRUE if the servers section of CONFIG enables
+   the compressed-transport capability for HOSTNAME.  It defaults to
+   FALSE.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_compressed_transport(svn_boolean_t *compressed,
+                         apr_hash_t *config,
+                         const char *hostname,
+                         apr_pool_t *scratch_pool)
+{
+  svn_config_t *cfg = config
+                    ? svn_hash_gets(config, SVN_CONFIG_CATEGORY_SERVERS)
+                    : NULL;
+  const char *server_group = NULL;
+
+  if (cfg)
+    server_group = svn_config_find_group(cfg, hostname,
+                                         SVN_CONFIG_SECTION_GROUPS,
+                                         scratch_pool);
+
+  return svn_error_trace(svn_config_get_server_setting_bool(
+                           cfg, compressed, server_group,
+                           SVN_CONFIG_OPTION_SVN_COMPRESSED_TRANSPORT,
+                           FALSE));
+}
+
 /* Open a session to URL, returning it in *SESS_P, allocating it in POOL.
    URI is a parsed version of URL.  CALLBACKS and CALLBACKS_BATON
    are provided by the caller of ra_svn_open. If TUNNEL_NAME is not NULL,
@@ -629,6 +654,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   apr_uint64_t minver, maxver;
   svn_ra_svn__list_t *mechlist, *server_caplist, *repos_caplist;
   const char *client_string = NULL;
+  svn_boolean_t compress;
   apr_pool_t *pool = result_pool;
   svn_ra_svn__parent_t *parent;
 
@@ -743,11 +769,19 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
     return svn_error_create(SVN_ERR_RA_SVN_BAD_VERSION, NULL,
                             _("Server does not support edit pipelining"));
 
+  /* Compress the whole connection only if configured to do so and the
+   * server offers it.  Otherwise, we keep the svndiff1/2 deltas. */
+  SVN_ERR(get_compressed_transport(&compress, config, uri->hostname, pool));
+  compress = compress
+          && svn_ra_svn_compression_level(conn) > 0
+          && svn_ra_svn_has_capability(conn,
+                                       SVN_RA_SVN_CAP_COMPRESSED_TRANSPORT);
+
   /* In protocol version 2, we send back our protocol version, our
    * capability list, and the URL, and subsequently there is an auth
    * request. */
   /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww)cc(?c)",
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww!",
                                   (apr_uint64_t) 2,
                                   SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                   SVN_RA_SVN_CAP_SVNDIFF1,
@@ -755,10 +789,19 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                   SVN_RA_SVN_CAP_ABSENT_ENTRIES,
                                   SVN_RA_SVN_CAP_DEPTH,
                                   SVN_RA_SVN_CAP_MERGEINFO,
-                                  SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  SVN_RA_SVN_CAP_LOG_REVPROPS));
+  if (compress)
+    SVN_ERR(svn_ra_svn__write_word(conn, pool,
+                                   SVN_RA_SVN_CAP_COMPRESSED_TRANSPORT));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)cc(?c)",
                                   url,
                                   SVN_RA_SVN__DEFAULT_USERAGENT,
                                   client_string));
+
+  /* Everything after our reply to the greeting will be compressed. */
+  if (compress)
+    SVN_ERR(svn_ra_svn__enable_compression(conn, pool));
+
   SVN_ERR(handle_auth_request(sess, pool));
 
   /* This is where the security layer would go into effect if we
@@ -3073,6 +3116,7 @@ ra_svn_has_capability(svn_ra_session_t *session,
       {SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE,
                                        SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE},
       {SVN_RA_CAPABILITY_LIST, SVN_RA_SVN_CAP_LIST},
+      {SVN_RA__CAPABILITY_BLAME, SVN_RA_SVN_CAP_BLAME},
 
       {NULL, NULL} /* End of list marker */
   };
@@ -3242,6 +3286,87 @@ ra_svn_list(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+ra_svn_blame(svn_ra_session_t *session,
+             const char *path,
+             svn_revnum_t start,
+             svn_revnum_t end,
+             const svn_diff_file_options_t *diff_options,
+             apr_array_header_t **chunks,
+             apr_hash_t **rev_props,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn__list_t *chunk_list, *rev_list;
+  const char *ignore_space = "none";
+  svn_boolean_t ignore_eol_style = FALSE;
+  int i;
+
+  path = reparent_path(session, path, scratch_pool);
+
+  if (diff_options)
+    {
+      if (diff_options->ignore_space == svn_diff_file_ignore_space_change)
+        ignore_space = "change";
+      else if (diff_options->ignore_space == svn_diff_file_ignore_space_all)
+        ignore_space = "all";
+
+      ignore_eol_style = diff_options->ignore_eol_style;
+    }
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(crrwb)", "blame",
+                                  path, start, end, ignore_space,
+                                  ignore_eol_style));
+
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, "ll",
+                                        &chunk_list, &rev_list));
+
+  *chunks = apr_array_make(result_pool, chunk_list->nelts,
+                           sizeof(svn_ra__blame_chunk_t));
+  for (i = 0; i < chunk_list->nelts; ++i)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(chunk_list, i);
+      svn_ra__blame_chunk_t *chunk;
+      apr_uint64_t start_line;
+      svn_revnum_t revision;
+
+      if (elt->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Blame chunk not a list"));
+      SVN_ERR(svn_ra_svn__parse_tuple(&elt->u.list, "n(?r)",
+                                      &start_line, &revision));
+
+      chunk = apr_array_push(*chunks);
+      chunk->start = (apr_int64_t)start_line;
+      chunk->revision = revision;
+    }
+
+  *rev_props = apr_hash_make(result_pool);
+  for (i = 0; i < rev_list->nelts; ++i)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(rev_list, i);
+      svn_ra_svn__list_t *proplist;
+      apr_hash_t *props;
+      svn_revnum_t revision;
+
+      if (elt->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Blame revision entry not a list"));
+      SVN_ERR(svn_ra_svn__parse_tuple(&elt->u.list, "rl",
+                                      &revision, &proplist));
+      SVN_ERR(svn_ra_svn__parse_proplist(proplist, result_pool, &props));
+
+      apr_hash_set(*rev_props,
+                   apr_pmemdup(result_pool, &revision, sizeof(revision)),
+                   sizeof(revision), props);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static const svn_ra__vtable_t ra_svn_vtable = {
   svn_ra_svn_version,
   ra_svn_get_description,
@@ -3282,6 +3407,7 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_get_inherited_props,
   NULL /* ra_set_svn_ra_open */,
   ra_svn_list,
+  ra_svn_blame,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
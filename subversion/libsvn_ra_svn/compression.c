@@ -0,0 +1,365 @@
+/*
+ * compression.c :  transport-level compression for ra_svn connections
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <string.h>
+#include <zlib.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_ra_svn.h"
+#include "svn_private_config.h"
+
+#include "private/svn_error_private.h"
+
+#include "ra_svn.h"
+
+/* Size of the buffers for compressed input and decompressed output. */
+#define COMPRESSION_BUFFER_SIZE SVN_RA_SVN__READBUF_SIZE
+
+/* Baton for a compressed svn_ra_svn__stream_t.
+ *
+ * Both directions are a single, never-ending zlib stream each.  Every
+ * write gets flushed with Z_SYNC_FLUSH, so the receiver can decode all
+ * data sent so far without having to wait for more.  The compression
+ * dictionary is kept across writes, so even short command tuples will
+ * compress well.
+ */
+typedef struct compression_baton_t
+{
+  /* Inherited stream. */
+  svn_ra_svn__stream_t *stream;
+
+  /* Decompression state.  NEXT_IN points into IN_BUF. */
+  z_stream in;
+  char *in_buf;
+
+  /* Decompressed data not yet returned to the reader. */
+  char *decoded_buf;
+  char *decoded_ptr;
+  char *decoded_end;
+
+  /* Compression state. */
+  z_stream out;
+
+  /* Compressed data not yet written to STREAM.  Its capacity is
+     WRITE_BUF_SIZE.  WRITE_PTR and WRITE_LEN describe the unsent part. */
+  char *write_buf;
+  apr_size_t write_buf_size;
+  const char *write_ptr;
+  apr_size_t write_len;
+
+  /* For all allocations incl. those of zlib. */
+  apr_pool_t *pool;
+} compression_baton_t;
+
+/* zlib alloc function.  OPAQUE is the pool to allocate from. */
+static voidpf
+zalloc(voidpf opaque, uInt items, uInt size)
+{
+  apr_pool_t *pool = opaque;
+
+  return apr_palloc(pool, items * size);
+}
+
+/* zlib free function */
+static void
+zfree(voidpf opaque, voidpf address)
+{
+  /* Empty, since we allocate on the pool */
+}
+
+/* Decompress as much of the pending input in BATON as fits into its
+   decoded data buffer - unless there is still unread decoded data.
+   This never reads from the inherited stream. */
+static svn_error_t *
+decode_pending(compression_baton_t *baton)
+{
+  int zerr;
+
+  if (baton->decoded_ptr != baton->decoded_end || baton->in.avail_in == 0)
+    return SVN_NO_ERROR;
+
+  baton->in.next_out = (Bytef *)baton->decoded_buf;
+  baton->in.avail_out = COMPRESSION_BUFFER_SIZE;
+
+  zerr = inflate(&baton->in, Z_SYNC_FLUSH);
+
+  /* Z_BUF_ERROR simply means that we need more input. */
+  if (zerr == Z_STREAM_END)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Unexpected end of compressed network data"));
+  if (zerr != Z_BUF_ERROR)
+    SVN_ERR(svn_error__wrap_zlib(zerr, "inflate", baton->in.msg));
+
+  baton->decoded_ptr = baton->decoded_buf;
+  baton->decoded_end = (char *)baton->in.next_out;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next chunk of compressed data from the inherited stream in
+   BATON, unless there is still unprocessed input.  If the stream has been
+   closed, set *EOF to TRUE. */
+static svn_error_t *
+read_input(compression_baton_t *baton,
+           svn_boolean_t *eof)
+{
+  apr_size_t len = COMPRESSION_BUFFER_SIZE;
+
+  *eof = FALSE;
+  if (baton->in.avail_in)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_ra_svn__stream_read(baton->stream, baton->in_buf, &len));
+  baton->in.next_in = (Bytef *)baton->in_buf;
+  baton->in.avail_in = (uInt)len;
+  *eof = len == 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Functions to implement a compressed svn_ra_svn__stream_t. */
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+compression_read_cb(void *baton, char *buffer, apr_size_t *len)
+{
+  compression_baton_t *compression_baton = baton;
+  apr_size_t available;
+
+  /* A single compressed chunk may not produce any output.  Keep reading
+     until it does. */
+  while (compression_baton->decoded_ptr == compression_baton->decoded_end)
+    {
+      svn_boolean_t eof;
+      SVN_ERR(read_input(compression_baton, &eof));
+      if (eof)
+        {
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(decode_pending(compression_baton));
+    }
+
+  available = compression_baton->decoded_end - compression_baton->decoded_ptr;
+  if (*len > available)
+    *len = available;
+
+  memcpy(buffer, compression_baton->decoded_ptr, *len);
+  compression_baton->decoded_ptr += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+compression_write_cb(void *baton, const char *buffer, apr_size_t *len)
+{
+  compression_baton_t *compression_baton = baton;
+  z_stream *out = &compression_baton->out;
+  int zerr;
+
+  /* Compress BUFFER, unless a previous call with the same arguments
+     could not send all of its output. */
+  if (compression_baton->write_len == 0)
+    {
+      apr_size_t produced = 0;
+
+      out->next_in = (Bytef *)buffer;  /* Casting away const! */
+      out->avail_in = (uInt)*len;
+
+      do
+        {
+          /* deflate() may need more output space than the bound suggests
+             when flushing.  Grow the buffer as needed. */
+          if (compression_baton->write_buf_size - produced
+              < deflateBound(out, out->avail_in) + 16)
+            {
+              apr_size_t new_size = 2 * compression_baton->write_buf_size
+                                  + deflateBound(out, out->avail_in) + 16;
+              char *new_buf = apr_palloc(compression_baton->pool, new_size);
+
+              if (produced)
+                memcpy(new_buf, compression_baton->write_buf, produced);
+              compression_baton->write_buf = new_buf;
+              compression_baton->write_buf_size = new_size;
+            }
+
+          out->next_out = (Bytef *)compression_baton->write_buf + produced;
+          out->avail_out = (uInt)(compression_baton->write_buf_size
+                                  - produced);
+
+          zerr = deflate(out, Z_SYNC_FLUSH);
+          if (zerr != Z_BUF_ERROR)
+            SVN_ERR(svn_error__wrap_zlib(zerr, "deflate", out->msg));
+
+          produced = (char *)out->next_out - compression_baton->write_buf;
+        }
+      while (out->avail_out == 0);
+
+      compression_baton->write_ptr = compression_baton->write_buf;
+      compression_baton->write_len = produced;
+    }
+
+  while (compression_baton->write_len > 0)
+    {
+      apr_size_t tmplen = compression_baton->write_len;
+      SVN_ERR(svn_ra_svn__stream_write(compression_baton->stream,
+                                       compression_baton->write_ptr,
+                                       &tmplen));
+      if (tmplen == 0)
+        {
+          /* The remaining output will be written during the next call to
+             this function (which will have the same arguments). */
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+
+      compression_baton->write_len -= tmplen;
+      compression_baton->write_ptr += tmplen;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements ra_svn_timeout_fn_t. */
+static void
+compression_timeout_cb(void *baton, apr_interval_time_t interval)
+{
+  compression_baton_t *compression_baton = baton;
+  svn_ra_svn__stream_timeout(compression_baton->stream, interval);
+}
+
+/* Implements svn_stream_data_available_fn_t. */
+static svn_error_t *
+compression_data_available_cb(void *baton, svn_boolean_t *data_available)
+{
+  compression_baton_t *compression_baton = baton;
+
+  /* Compressed data may or may not contain actual payload, e.g. when we
+     received only the tail of a flushed chunk.  Consume whatever has
+     arrived but never block while looking for actual payload. */
+  SVN_ERR(decode_pending(compression_baton));
+  while (compression_baton->decoded_ptr == compression_baton->decoded_end)
+    {
+      svn_boolean_t eof;
+
+      SVN_ERR(svn_ra_svn__stream_data_available(compression_baton->stream,
+                                                data_available));
+      if (!*data_available)
+        return SVN_NO_ERROR;
+
+      /* Let the reader detect the end of the stream. */
+      SVN_ERR(read_input(compression_baton, &eof));
+      if (eof)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(decode_pending(compression_baton));
+    }
+
+  *data_available = TRUE;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__enable_compression(svn_ra_svn_conn_t *conn,
+                               apr_pool_t *scratch_pool)
+{
+  compression_baton_t *compression_baton;
+  int zerr;
+
+  if (conn->compressed)
+    return SVN_NO_ERROR;
+
+  /* Flush the connection, as we're about to replace its stream. */
+  SVN_ERR(svn_ra_svn__flush(conn, scratch_pool));
+
+  /* Create and initialize the stream baton. */
+  compression_baton = apr_pcalloc(conn->pool, sizeof(*compression_baton));
+  compression_baton->pool = conn->pool;
+  compression_baton->in_buf = apr_palloc(conn->pool,
+                                         COMPRESSION_BUFFER_SIZE);
+  compression_baton->decoded_buf = apr_palloc(conn->pool,
+                                              COMPRESSION_BUFFER_SIZE);
+  compression_baton->decoded_ptr = compression_baton->decoded_buf;
+  compression_baton->decoded_end = compression_baton->decoded_buf;
+
+  compression_baton->in.zalloc = zalloc;
+  compression_baton->in.zfree = zfree;
+  compression_baton->in.opaque = conn->pool;
+  zerr = inflateInit(&compression_baton->in);
+  SVN_ERR(svn_error__wrap_zlib(zerr, "inflateInit",
+                               compression_baton->in.msg));
+
+  compression_baton->out.zalloc = zalloc;
+  compression_baton->out.zfree = zfree;
+  compression_baton->out.opaque = conn->pool;
+  zerr = deflateInit(&compression_baton->out,
+                     conn->compression_level > 0
+                       ? conn->compression_level
+                       : Z_DEFAULT_COMPRESSION);
+  SVN_ERR(svn_error__wrap_zlib(zerr, "deflateInit",
+                               compression_baton->out.msg));
+
+  /* If there is any data left in the read buffer at this point,
+     it has already been compressed by the other side. */
+  if (conn->read_end > conn->read_ptr)
+    {
+      apr_size_t len = conn->read_end - conn->read_ptr;
+
+      memcpy(compression_baton->in_buf, conn->read_ptr, len);
+      compression_baton->in.next_in = (Bytef *)compression_baton->in_buf;
+      compression_baton->in.avail_in = (uInt)len;
+      conn->read_end = conn->read_ptr;
+    }
+
+  /* Wrap the existing stream. */
+  compression_baton->stream = conn->stream;
+
+  {
+    svn_stream_t *compressed_in = svn_stream_create(compression_baton,
+                                                    conn->pool);
+    svn_stream_t *compressed_out = svn_stream_create(compression_baton,
+                                                     conn->pool);
+
+    svn_stream_set_read2(compressed_in, compression_read_cb,
+                         NULL /* use default */);
+    svn_stream_set_data_available(compressed_in,
+                                  compression_data_available_cb);
+    svn_stream_set_write(compressed_out, compression_write_cb);
+
+    conn->stream = svn_ra_svn__stream_create(compressed_in, compressed_out,
+                                             compression_baton,
+                                             compression_timeout_cb,
+                                             conn->pool);
+  }
+
+  conn->compressed = TRUE;
+
+  return SVN_NO_ERROR;
+}
@@ -215,6 +215,7 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->capabilities = apr_hash_make(result_pool);
   conn->compression_level = compression_level;
   conn->zero_copy_limit = zero_copy_limit;
+  conn->compressed = FALSE;
   conn->pool = result_pool;
 
   if (sock != NULL)
@@ -273,6 +274,11 @@ svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn)
   if (svn_ra_svn_compression_level(conn) <= 0)
     return 0;
 
+  /* Compressing the windows again would only cost CPU if the whole
+   * connection is being compressed already. */
+  if (conn->compressed)
+    return 0;
+
   /* Prefer SVNDIFF2 over SVNDIFF1. */
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED))
     return 2;
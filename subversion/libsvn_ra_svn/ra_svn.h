@@ -115,6 +115,9 @@ struct svn_ra_svn_conn_st {
   int compression_level;
   apr_size_t zero_copy_limit;
 
+  /* Whether STREAM has been wrapped by svn_ra_svn__enable_compression. */
+  svn_boolean_t compressed;
+
   /* who's on the other side of the connection? */
   char *remote_ip;
 
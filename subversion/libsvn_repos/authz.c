@@ -967,6 +967,23 @@ create_user_authz(authz_full_t *authz,
 
 /*** Lookup. ***/
 
+/* The lookup state for one of the directories along the PARENT_PATH of
+ * a lookup_state_t. */
+typedef struct lookup_frame_t
+{
+  /* Length of the PARENT_PATH prefix that denotes this directory. */
+  apr_size_t path_len;
+
+  /* Copy of the CURRENT node list at this directory. */
+  apr_array_header_t *nodes;
+
+  /* Copies of the RIGHTS and PARENT_RIGHTS at this directory.  They only
+   * differ for the root. */
+  limited_rights_t rights;
+  limited_rights_t parent_rights;
+
+} lookup_frame_t;
+
 /* Reusable lookup state object. It is easy to pass to functions and
  * recycling it between lookups saves significant setup costs. */
 typedef struct lookup_state_t
@@ -992,6 +1009,17 @@ typedef struct lookup_state_t
   /* Rights that apply at PARENT_PATH, if PARENT_PATH is not empty. */
   limited_rights_t parent_rights;
 
+  /* Cursor into the rule tree: The lookup_frame_t of the root and of every
+   * directory along PARENT_PATH, outermost first.  Only the first DEPTH
+   * entries are valid; the others are kept for recycling.  This allows
+   * us to continue any lookup at the deepest directory that it has in
+   * common with the previous lookup, e.g. when walking a tree. */
+  apr_array_header_t *frames;
+  int depth;
+
+  /* For allocating FRAMES. */
+  apr_pool_t *pool;
+
 } lookup_state_t;
 
 /* Constructor for lookup_state_t. */
@@ -1015,31 +1043,76 @@ create_lookup_state(apr_pool_t *result_pool)
    * above applies. */
   state->parent_path = svn_stringbuf_create_ensure(200, result_pool);
 
+  /* Paths are rarely nested deeper than this. */
+  state->frames = apr_array_make(result_pool, 16, sizeof(lookup_frame_t));
+  state->pool = result_pool;
+
   return state;
 }
 
+/* Record the CURRENT nodes and the rights in STATE as the frame for the
+ * directory at PARENT_PATH. */
+static void
+push_frame(lookup_state_t *state)
+{
+  lookup_frame_t *frame;
+
+  if (state->depth == state->frames->nelts)
+    {
+      frame = apr_array_push(state->frames);
+      frame->nodes = apr_array_make(state->pool, state->current->nelts,
+                                    sizeof(node_t *));
+    }
+  else
+    {
+      frame = &APR_ARRAY_IDX(state->frames, state->depth, lookup_frame_t);
+      apr_array_clear(frame->nodes);
+    }
+
+  frame->path_len = state->parent_path->len;
+  frame->rights = state->rights;
+  frame->parent_rights = state->parent_rights;
+  apr_array_cat(frame->nodes, state->current);
+
+  ++state->depth;
+}
+
 /* Clear the current contents of STATE and re-initialize it for ROOT.
- * Check whether we can reuse a previous parent path lookup to shorten
- * the current PATH walk.  Return the full or remaining portion of
- * PATH, respectively.  PATH must not be NULL. */
+ * Check whether we can reuse a previous lookup of some parent path to
+ * shorten the current PATH walk.  Return the full or remaining portion
+ * of PATH, respectively.  PATH must not be NULL. */
 static const char *
 init_lockup_state(lookup_state_t *state,
                   node_t *root,
                   const char *path)
 {
   apr_size_t len = strlen(path);
-  if (   (len > state->parent_path->len)
-      && state->parent_path->len
-      && (path[state->parent_path->len] == '/')
-      && !memcmp(path, state->parent_path->data, state->parent_path->len))
-    {
-      /* The PARENT_PATH of the previous lookup is actually a parent path
-       * of PATH.  The CURRENT node list already matches the parent path
-       * and we only have to set the correct rights info. */
-      state->rights = state->parent_rights;
+  int i;
 
-      /* Tell the caller where to proceed. */
-      return path + state->parent_path->len;
+  /* Find the deepest directory that PATH shares with the previous lookup.
+   * The root frame matches all absolute paths. */
+  for (i = state->depth - 1; i >= 0; --i)
+    {
+      lookup_frame_t *frame = &APR_ARRAY_IDX(state->frames, i,
+                                             lookup_frame_t);
+      if (   (len > frame->path_len)
+          && (path[frame->path_len] == '/')
+          && !memcmp(path, state->parent_path->data, frame->path_len))
+        {
+          /* Continue from this frame.  Anything deeper does not apply
+           * to PATH. */
+          state->depth = i + 1;
+          svn_stringbuf_chop(state->parent_path,
+                             state->parent_path->len - frame->path_len);
+
+          apr_array_clear(state->current);
+          apr_array_cat(state->current, frame->nodes);
+          state->rights = frame->rights;
+          state->parent_rights = frame->parent_rights;
+
+          /* Tell the caller where to proceed. */
+          return path + frame->path_len;
+        }
     }
 
   /* Start lookup at ROOT for the full PATH. */
@@ -1064,6 +1137,10 @@ init_lockup_state(lookup_state_t *state,
   svn_stringbuf_setempty(state->parent_path);
   svn_stringbuf_setempty(state->scratch_pad);
 
+  /* Remember the root for future lookups. */
+  state->depth = 0;
+  push_frame(state);
+
   return path;
 }
 
@@ -1359,6 +1436,7 @@ lookup(lookup_state_t *state,
 
           /* In STATE, PARENT_PATH, PARENT_RIGHTS and CURRENT are now in sync. */
           state->parent_rights = state->rights;
+          push_frame(state);
         }
     }
 
@@ -1377,6 +1455,25 @@ lookup(lookup_state_t *state,
 
 /*** The authz data structure. ***/
 
+/* Number of entries in authz_user_rules_t's result memo.  Must be a power
+ * of two. */
+#define AUTHZ_MEMO_SIZE 1024
+
+/* An entry in authz_user_rules_t's result memo. */
+typedef struct authz_memo_t
+{
+  /* The path that got checked.  NULL for unused entries. */
+  svn_stringbuf_t *path;
+
+  /* The access rights that were required and whether the check was
+   * recursive. */
+  authz_access_t required;
+  svn_boolean_t recursive;
+
+  /* Result of the check. */
+  svn_boolean_t granted;
+} authz_memo_t;
+
 /* An entry in svn_authz_t's USER_RULES cache.  All members must be
  * allocated in the POOL and the latter has to be cleared / destroyed
  * before overwriting the entries' contents.
@@ -1401,6 +1498,10 @@ struct authz_user_rules_t
   /* Reusable lookup state instance. */
   lookup_state_t *lookup_state;
 
+  /* Direct-mapped cache of recent lookup results with AUTHZ_MEMO_SIZE
+   * entries.  Will remain NULL until the first tree lookup. */
+  authz_memo_t *memo;
+
   /* Pool from which all data within this struct got allocated.
    * Can be destroyed or cleaned up with no further side-effects. */
   apr_pool_t *pool;
@@ -1460,6 +1561,7 @@ get_user_rules(svn_authz_t *authz,
   authz->filtered->user = user ? apr_pstrdup(pool, user) : NULL;
   authz->filtered->lookup_state = create_lookup_state(pool);
   authz->filtered->root = NULL;
+  authz->filtered->memo = NULL;
 
   svn_authz__get_global_rights(&authz->filtered->global_rights,
                                authz->full, user, repos_name);
@@ -1675,6 +1777,10 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
   const authz_access_t required =
     ((required_access & svn_authz_read ? authz_access_read_flag : 0)
      | (required_access & svn_authz_write ? authz_access_write_flag : 0));
+  const svn_boolean_t recursive = !!(required_access & svn_authz_recursive);
+  const char *remainder;
+  authz_memo_t *memo;
+  apr_size_t path_len;
 
   /* Pick or create the suitable pre-filtered path rule tree. */
   authz_user_rules_t *rules = get_user_rules(
@@ -1711,19 +1817,49 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
 
   /* Did we already filter the data model? */
   if (!rules->root)
-    SVN_ERR(filter_tree(authz, pool));
+    {
+      SVN_ERR(filter_tree(authz, pool));
+      rules->memo = apr_pcalloc(rules->pool,
+                                AUTHZ_MEMO_SIZE * sizeof(*rules->memo));
+    }
+
+  /* Paths tend to get checked repeatedly, e.g. for every revision in a
+   * log or once per operation and once per parent directory. */
+  path_len = strlen(path);
+  memo = &rules->memo[svn__fnv1a_32(path, path_len)
+                      & (AUTHZ_MEMO_SIZE - 1)];
+  if (   memo->path
+      && memo->required == required
+      && memo->recursive == recursive
+      && memo->path->len == path_len
+      && !memcmp(memo->path->data, path, path_len))
+    {
+      *access_granted = memo->granted;
+      return SVN_NO_ERROR;
+    }
 
   /* Re-use previous lookup results, if possible. */
-  path = init_lockup_state(authz->filtered->lookup_state,
-                           authz->filtered->root, path);
+  remainder = init_lockup_state(authz->filtered->lookup_state,
+                                authz->filtered->root, path);
 
   /* Sanity check. */
-  SVN_ERR_ASSERT(path[0] == '/');
+  SVN_ERR_ASSERT(remainder[0] == '/');
 
   /* Determine the granted access for the requested path.
    * PATH does not need to be normalized for lockup(). */
-  *access_granted = lookup(rules->lookup_state, path, required,
-                           !!(required_access & svn_authz_recursive), pool);
+  *access_granted = lookup(rules->lookup_state, remainder, required,
+                           recursive, pool);
+
+  /* Remember the result. */
+  if (memo->path)
+    svn_stringbuf_setempty(memo->path);
+  else
+    memo->path = svn_stringbuf_create_ensure(path_len, rules->pool);
+
+  svn_stringbuf_appendbytes(memo->path, path, path_len);
+  memo->required = required;
+  memo->recursive = recursive;
+  memo->granted = *access_granted;
 
   return SVN_NO_ERROR;
 }
@@ -0,0 +1,546 @@
+/* blame.c --- compute line-origin maps of files inside the repository.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "svn_diff.h"
+#include "svn_io.h"
+#include "svn_string.h"
+
+#include "private/svn_cache.h"
+#include "private/svn_repos_private.h"
+
+#include "svn_private_config.h"
+#include "repos.h"
+
+
+/* One location in the history of the blamed file. */
+typedef struct location_t
+{
+  const char *path;
+  svn_revnum_t revision;
+} location_t;
+
+/* Baton for the svn_diff_output_fns_t callbacks below.  They translate
+   the chunks of the older text into those of the newer one. */
+typedef struct blame_baton_t
+{
+  /* Line origins of the older text. */
+  const apr_array_header_t *old_chunks;
+
+  /* Index in OLD_CHUNKS of the chunk covering the next common line.
+     The diff output is ordered, so this only ever moves forward. */
+  int old_idx;
+
+  /* Line origins of the newer text, as being built. */
+  apr_array_header_t *new_chunks;
+
+  /* The revision that introduced the newer text. */
+  svn_revnum_t revision;
+} blame_baton_t;
+
+
+/* Append a chunk of lines starting at START and attributed to REVISION
+   to CHUNKS, unless it merely continues the last chunk in there. */
+static void
+append_chunk(apr_array_header_t *chunks,
+             apr_int64_t start,
+             svn_revnum_t revision)
+{
+  svn_repos__blame_chunk_t *chunk;
+
+  if (chunks->nelts
+      && APR_ARRAY_IDX(chunks, chunks->nelts - 1,
+                       svn_repos__blame_chunk_t).revision == revision)
+    return;
+
+  chunk = apr_array_push(chunks);
+  chunk->start = start;
+  chunk->revision = revision;
+}
+
+/* Implements svn_diff_output_fns_t.output_common.
+   Carry the origins of the unchanged lines over to the newer text. */
+static svn_error_t *
+output_common(void *baton,
+              apr_off_t original_start, apr_off_t original_length,
+              apr_off_t modified_start, apr_off_t modified_length,
+              apr_off_t latest_start, apr_off_t latest_length)
+{
+  blame_baton_t *bb = baton;
+  const apr_array_header_t *old_chunks = bb->old_chunks;
+  apr_off_t original_end = original_start + original_length;
+  apr_off_t line = original_start;
+
+  if (original_length == 0)
+    return SVN_NO_ERROR;
+
+  while (bb->old_idx + 1 < old_chunks->nelts
+         && APR_ARRAY_IDX(old_chunks, bb->old_idx + 1,
+                          svn_repos__blame_chunk_t).start <= original_start)
+    ++bb->old_idx;
+
+  while (TRUE)
+    {
+      const svn_repos__blame_chunk_t *chunk
+        = &APR_ARRAY_IDX(old_chunks, bb->old_idx, svn_repos__blame_chunk_t);
+      const svn_repos__blame_chunk_t *next;
+
+      append_chunk(bb->new_chunks, modified_start + (line - original_start),
+                   chunk->revision);
+
+      if (bb->old_idx + 1 == old_chunks->nelts)
+        break;
+
+      next = &APR_ARRAY_IDX(old_chunks, bb->old_idx + 1,
+                            svn_repos__blame_chunk_t);
+      if (next->start >= original_end)
+        break;
+
+      line = next->start;
+      ++bb->old_idx;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_diff_output_fns_t.output_diff_modified.
+   Attribute the new or changed lines to the current revision. */
+static svn_error_t *
+output_diff_modified(void *baton,
+                     apr_off_t original_start, apr_off_t original_length,
+                     apr_off_t modified_start, apr_off_t modified_length,
+                     apr_off_t latest_start, apr_off_t latest_length)
+{
+  blame_baton_t *bb = baton;
+
+  if (modified_length)
+    append_chunk(bb->new_chunks, modified_start, bb->revision);
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t blame_output_fns = {
+  output_common,
+  output_diff_modified
+};
+
+
+/* Implements svn_cache__serialize_func_t for chunk arrays. */
+static svn_error_t *
+serialize_chunks(void **data,
+                 apr_size_t *data_len,
+                 void *in,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *chunks = in;
+
+  *data_len = chunks->nelts * sizeof(svn_repos__blame_chunk_t);
+  *data = apr_pmemdup(pool, chunks->elts, *data_len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for chunk arrays. */
+static svn_error_t *
+deserialize_chunks(void **out,
+                   void *data,
+                   apr_size_t data_len,
+                   apr_pool_t *pool)
+{
+  apr_array_header_t *chunks
+    = apr_array_make(pool, 1, sizeof(svn_repos__blame_chunk_t));
+
+  chunks->nelts = (int) (data_len / sizeof(svn_repos__blame_chunk_t));
+  chunks->nalloc = chunks->nelts;
+  chunks->elts = data;
+
+  *out = chunks;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CACHE_P to the blame cache of REPOS, creating it on first use.
+   Set it to NULL if there is no membuffer cache to put it into. */
+static svn_error_t *
+get_blame_cache(svn_cache__t **cache_p,
+                svn_repos_t *repos,
+                apr_pool_t *scratch_pool)
+{
+  if (!repos->blame_cache)
+    {
+      svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+      const char *uuid;
+
+      if (!membuffer)
+        {
+          *cache_p = NULL;
+          return SVN_NO_ERROR;
+        }
+
+      /* Node revision IDs are only unique within a repository and
+         there may be copies of it around, hence the path. */
+      SVN_ERR(svn_fs_get_uuid(repos->fs, &uuid, scratch_pool));
+      SVN_ERR(svn_cache__create_membuffer_cache(
+                &repos->blame_cache, membuffer,
+                serialize_chunks, deserialize_chunks, APR_HASH_KEY_STRING,
+                apr_pstrcat(scratch_pool, "blame:", uuid, "/", repos->path,
+                            ":", SVN_VA_NULL),
+                SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                TRUE, FALSE, repos->pool, scratch_pool));
+    }
+
+  *cache_p = repos->blame_cache;
+  return SVN_NO_ERROR;
+}
+
+/* Set *KEY to the cache key for the line-origin map of the node at
+   LOCATION in REPOS, computed with DIFF_OPTIONS.  Allocate it in POOL. */
+static svn_error_t *
+get_cache_key(const char **key,
+              svn_repos_t *repos,
+              const location_t *location,
+              const svn_diff_file_options_t *diff_options,
+              apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  const svn_fs_id_t *id;
+
+  /* All revisions of a path that share the node revision share the
+     map, so keying by ID makes unchanged files hit in later revisions. */
+  SVN_ERR(svn_fs_revision_root(&root, repos->fs, location->revision, pool));
+  SVN_ERR(svn_fs_node_id(&id, root, location->path, pool));
+
+  *key = apr_psprintf(pool, "%s:%d:%d:%d",
+                      svn_fs_unparse_id(id, pool)->data,
+                      (int)diff_options->ignore_space,
+                      diff_options->ignore_eol_style,
+                      (int)diff_options->algorithm);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *TEXT to the contents of the file at LOCATION in REPOS and *ROOT
+   to the revision root it was read from, both allocated in POOL. */
+static svn_error_t *
+read_text(svn_string_t **text,
+          svn_fs_root_t **root,
+          svn_repos_t *repos,
+          const location_t *location,
+          apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  svn_filesize_t length;
+
+  SVN_ERR(svn_fs_revision_root(root, repos->fs, location->revision, pool));
+  SVN_ERR(svn_fs_file_length(&length, *root, location->path, pool));
+  SVN_ERR(svn_fs_file_contents(&stream, *root, location->path, pool));
+  SVN_ERR(svn_string_from_stream2(text, stream, (apr_size_t)length, pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__blame(apr_array_header_t **chunks_p,
+                 apr_hash_t **rev_props_p,
+                 svn_repos_t *repos,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 const svn_diff_file_options_t *diff_options,
+                 svn_repos_authz_func_t authz_read_func,
+                 void *authz_read_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  static const svn_diff_file_options_t default_options = { 0 };
+  apr_array_header_t *locations;
+  apr_array_header_t *chunks = NULL;
+  apr_array_header_t *result;
+  apr_hash_t *rev_props;
+  svn_cache__t *cache;
+  svn_fs_root_t *root;
+  svn_fs_history_t *history;
+  svn_node_kind_t kind;
+  svn_string_t *text;
+  const location_t *location;
+  svn_boolean_t complete = FALSE;
+  svn_boolean_t check_authz = authz_read_func != NULL;
+  svn_revnum_t last_rev = SVN_INVALID_REVNUM;
+  svn_revnum_t oldest_readable_rev = SVN_INVALID_REVNUM;
+  apr_pool_t *iterpool, *last_pool;
+  int i;
+
+  if (!diff_options)
+    diff_options = &default_options;
+
+  if (!SVN_IS_VALID_REVNUM(start) || !SVN_IS_VALID_REVNUM(end))
+    {
+      svn_revnum_t youngest_rev;
+      SVN_ERR(svn_fs_youngest_rev(&youngest_rev, repos->fs, scratch_pool));
+
+      if (!SVN_IS_VALID_REVNUM(start))
+        start = youngest_rev;
+      if (!SVN_IS_VALID_REVNUM(end))
+        end = youngest_rev;
+    }
+
+  if (start > end)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Start revision %ld is greater than end "
+                               "revision %ld"), start, end);
+
+  /* Don't reveal anything about paths the caller may not read. */
+  SVN_ERR(svn_fs_revision_root(&root, repos->fs, end, scratch_pool));
+  if (authz_read_func)
+    {
+      svn_boolean_t readable;
+
+      SVN_ERR(authz_read_func(&readable, root, path, authz_read_baton,
+                              scratch_pool));
+      if (!readable)
+        return svn_error_createf(SVN_ERR_AUTHZ_UNREADABLE, NULL,
+                                 _("Unable to read '%s' in revision %ld"),
+                                 path, end);
+    }
+
+  /* The path had better be a file in this revision. */
+  SVN_ERR(svn_fs_check_path(&kind, root, path, scratch_pool));
+  if (kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL, _("'%s' is not a file in revision %ld"),
+       path, end);
+
+  SVN_ERR(get_blame_cache(&cache, repos, scratch_pool));
+
+  /* Walk the history backwards until we either find a cached map to
+     extend, run past START or reach the beginning.  The map itself does
+     not depend on authz, so that it can be cached and shared by all
+     users.  Instead, remember the oldest readable location of the
+     history, i.e. the one before the first unreadable one, and attribute
+     everything older to it when returning the result.  The history may
+     have to be walked beyond a cache hit to find that location. */
+  locations = apr_array_make(scratch_pool, 16, sizeof(location_t));
+  iterpool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_fs_node_history2(&history, root, path, scratch_pool,
+                               scratch_pool));
+  while (TRUE)
+    {
+      location_t *new_location;
+      const char *tmp_path;
+      svn_revnum_t tmp_revnum;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, scratch_pool,
+                                   iterpool));
+      if (!history)
+        {
+          complete = TRUE;
+          break;
+        }
+
+      SVN_ERR(svn_fs_history_location(&tmp_path, &tmp_revnum, history,
+                                      iterpool));
+
+      if (check_authz)
+        {
+          svn_boolean_t readable;
+          svn_fs_root_t *tmp_root;
+
+          SVN_ERR(svn_fs_revision_root(&tmp_root, repos->fs, tmp_revnum,
+                                       iterpool));
+          SVN_ERR(authz_read_func(&readable, tmp_root, tmp_path,
+                                  authz_read_baton, iterpool));
+          if (!readable)
+            {
+              if (!SVN_IS_VALID_REVNUM(last_rev))
+                return svn_error_createf(SVN_ERR_AUTHZ_UNREADABLE, NULL,
+                                         _("Unable to read '%s' in "
+                                           "revision %ld"),
+                                         path, end);
+
+              oldest_readable_rev = last_rev;
+              check_authz = FALSE;
+            }
+        }
+
+      /* After a cache hit, we only look for the oldest readable location.
+         Anything older than START will not be attributed anyway. */
+      if (chunks && (!check_authz || tmp_revnum < start))
+        break;
+
+      last_rev = tmp_revnum;
+      if (chunks)
+        continue;
+
+      new_location = apr_array_push(locations);
+      new_location->path = apr_pstrdup(scratch_pool, tmp_path);
+      new_location->revision = tmp_revnum;
+
+      if (cache)
+        {
+          const char *key;
+          svn_boolean_t found;
+
+          SVN_ERR(get_cache_key(&key, repos, new_location, diff_options,
+                                iterpool));
+          SVN_ERR(svn_cache__get((void **)&chunks, &found, cache, key,
+                                 scratch_pool));
+          if (found)
+            {
+              complete = TRUE;
+              continue;
+            }
+        }
+
+      if (tmp_revnum < start)
+        break;
+    }
+
+  /* Starting from the oldest location, replay the changes up to END.
+     Everything not taken from the cache originates from that location. */
+  last_pool = svn_pool_create(scratch_pool);
+  location = &APR_ARRAY_IDX(locations, locations->nelts - 1, location_t);
+  SVN_ERR(read_text(&text, &root, repos, location, last_pool));
+  if (!chunks)
+    {
+      chunks = apr_array_make(last_pool, 16, sizeof(svn_repos__blame_chunk_t));
+      append_chunk(chunks, 0, location->revision);
+    }
+
+  for (i = locations->nelts - 2; i >= 0; --i)
+    {
+      const location_t *next_location
+        = &APR_ARRAY_IDX(locations, i, location_t);
+      svn_fs_root_t *next_root;
+      svn_boolean_t changed;
+      apr_pool_t *tmp_pool;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_revision_root(&next_root, repos->fs,
+                                   next_location->revision, iterpool));
+      SVN_ERR(svn_fs_contents_different(&changed, root, location->path,
+                                        next_root, next_location->path,
+                                        iterpool));
+
+      /* Property changes and copies leave the line origins alone.
+         LOCATION and TEXT keep referring to the last text change. */
+      if (changed)
+        {
+          svn_string_t *next_text;
+          svn_diff_t *diff;
+          blame_baton_t bb;
+
+          SVN_ERR(read_text(&next_text, &next_root, repos, next_location,
+                            iterpool));
+          SVN_ERR(svn_diff_mem_string_diff(&diff, text, next_text,
+                                           diff_options, iterpool));
+
+          bb.old_chunks = chunks;
+          bb.old_idx = 0;
+          bb.new_chunks = apr_array_make(iterpool, chunks->nelts + 1,
+                                         sizeof(svn_repos__blame_chunk_t));
+          bb.revision = next_location->revision;
+          SVN_ERR(svn_diff_output2(diff, &bb, &blame_output_fns,
+                                   cancel_func, cancel_baton));
+
+          /* An empty file still gets a chunk, as documented. */
+          if (bb.new_chunks->nelts == 0)
+            append_chunk(bb.new_chunks, 0, next_location->revision);
+
+          chunks = bb.new_chunks;
+          text = next_text;
+          root = next_root;
+          location = next_location;
+
+          tmp_pool = last_pool;
+          last_pool = iterpool;
+          iterpool = tmp_pool;
+        }
+    }
+
+  /* Remember complete maps, so the next request can start from here. */
+  if (cache && complete && locations->nelts > 1)
+    {
+      const char *key;
+
+      SVN_ERR(get_cache_key(&key, repos,
+                            &APR_ARRAY_IDX(locations, 0, location_t),
+                            diff_options, iterpool));
+      SVN_ERR(svn_cache__set(cache, key, chunks, iterpool));
+    }
+
+  /* Attribute changes in unreadable history to the oldest readable
+     location, hide anything before START and fetch the properties of
+     the rest. */
+  result = apr_array_make(result_pool, chunks->nelts,
+                          sizeof(svn_repos__blame_chunk_t));
+  rev_props = apr_hash_make(result_pool);
+  for (i = 0; i < chunks->nelts; ++i)
+    {
+      const svn_repos__blame_chunk_t *chunk
+        = &APR_ARRAY_IDX(chunks, i, svn_repos__blame_chunk_t);
+      svn_revnum_t revision = chunk->revision;
+
+      if (SVN_IS_VALID_REVNUM(oldest_readable_rev)
+          && revision < oldest_readable_rev)
+        revision = oldest_readable_rev;
+      if (revision < start)
+        revision = SVN_INVALID_REVNUM;
+
+      append_chunk(result, chunk->start, revision);
+
+      if (SVN_IS_VALID_REVNUM(revision)
+          && !apr_hash_get(rev_props, &revision, sizeof(revision)))
+        {
+          apr_hash_t *props;
+
+          SVN_ERR(svn_repos_fs_revision_proplist(&props, repos, revision,
+                                                 authz_read_func,
+                                                 authz_read_baton,
+                                                 result_pool));
+          apr_hash_set(rev_props,
+                       apr_pmemdup(result_pool, &revision, sizeof(revision)),
+                       sizeof(revision), props);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(last_pool);
+
+  *chunks_p = result;
+  *rev_props_p = rev_props;
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,94 @@
+/* changes-index-db.sql -- schema for use in the changed-paths index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* One row for every revision that changed PATH or anything below it.
+   PATH is an fspath.  This is the reverse of the changed-paths list,
+   expanded to all parent directories. */
+CREATE TABLE path_revisions (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  PRIMARY KEY (path, revision)
+  );
+
+/* One row for every node that got added or replaced, with or without
+   history.  COPYFROM_PATH and COPYFROM_REVISION are NULL for plain adds. */
+CREATE TABLE path_additions (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  copyfrom_path TEXT,
+  copyfrom_revision INTEGER,
+  PRIMARY KEY (path, revision)
+  );
+
+/* A single row containing the youngest revision covered by the index. */
+CREATE TABLE indexed_revision (
+  id INTEGER NOT NULL PRIMARY KEY,
+  revision INTEGER NOT NULL
+  );
+
+INSERT INTO indexed_revision (id, revision) VALUES (0, 0);
+
+PRAGMA USER_VERSION = 1;
+
+-- STMT_GET_INDEXED_REVISION
+SELECT revision
+FROM indexed_revision
+WHERE id = 0
+
+-- STMT_SET_INDEXED_REVISION
+UPDATE indexed_revision
+SET revision = ?1
+WHERE id = 0
+
+-- STMT_ADD_PATH_REVISION
+INSERT OR IGNORE INTO path_revisions (path, revision)
+VALUES (?1, ?2)
+
+-- STMT_ADD_PATH_ADDITION
+INSERT OR REPLACE INTO path_additions (path, revision, copyfrom_path,
+                                       copyfrom_revision)
+VALUES (?1, ?2, ?3, ?4)
+
+-- STMT_GET_LAST_PATH_REVISION
+SELECT revision
+FROM path_revisions
+WHERE path = ?1 AND revision <= ?2
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_GET_LAST_PATH_ADDITION
+SELECT revision
+FROM path_additions
+WHERE path = ?1 AND revision <= ?2
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_GET_PATH_ADDITION
+SELECT copyfrom_path, copyfrom_revision
+FROM path_additions
+WHERE path = ?1 AND revision = ?2
+
+-- STMT_DELETE_ALL_CHANGES
+DELETE FROM path_revisions;
+DELETE FROM path_additions;
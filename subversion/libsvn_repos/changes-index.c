@@ -0,0 +1,378 @@
+/* changes-index.c --- an on-disk index of the revisions changing a path
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
+#include "repos.h"
+#include "svn_private_config.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_sqlite.h"
+#include "private/svn_subr_private.h"
+
+#include "changes-index-db.h"
+
+CHANGES_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* The schema version that this code creates and understands. */
+#define CHANGES_INDEX_SCHEMA_VERSION 1
+
+struct svn_repos__changes_index_t
+{
+  /* The database connection. */
+  svn_sqlite__db_t *sdb;
+};
+
+
+/*** Helper functions ***/
+
+/* Record in SDB that REV changed PATH and all its parents.  PREFIXES
+   contains all paths already recorded for REV and will be updated.
+   Allocate new keys in PREFIXES in its pool. */
+static svn_error_t *
+add_path_revisions(svn_sqlite__db_t *sdb,
+                   apr_hash_t *prefixes,
+                   const char *path,
+                   svn_revnum_t rev)
+{
+  apr_pool_t *pool = apr_hash_pool_get(prefixes);
+  svn_sqlite__stmt_t *stmt;
+
+  /* Once we find a path that has been recorded already, all its parents
+     will have been recorded as well. */
+  while (!svn_hash_gets(prefixes, path))
+    {
+      path = apr_pstrdup(pool, path);
+      svn_hash_sets(prefixes, path, path);
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                        STMT_ADD_PATH_REVISION));
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, rev));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+
+      if (svn_fspath__is_root(path, strlen(path)))
+        break;
+
+      path = svn_fspath__dirname(path, pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos__log_index_add_func_t.  Read the changed paths of
+   REV in FS and store them in SDB. */
+static svn_error_t *
+index_revision(svn_sqlite__db_t *sdb,
+               svn_fs_t *fs,
+               svn_revnum_t rev,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_hash_t *prefixes = svn_hash__make(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, scratch_pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool,
+                                scratch_pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+
+  while (change)
+    {
+      const char *path = change->path.data;
+
+      svn_pool_clear(iterpool);
+
+      switch (change->change_kind)
+        {
+        case svn_fs_path_change_add:
+        case svn_fs_path_change_replace:
+          {
+            svn_sqlite__stmt_t *stmt;
+            svn_revnum_t copyfrom_rev = change->copyfrom_rev;
+            const char *copyfrom_path = change->copyfrom_path;
+
+            if (!change->copyfrom_known)
+              SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                         root, path, iterpool));
+
+            if (!SVN_IS_VALID_REVNUM(copyfrom_rev))
+              copyfrom_path = NULL;
+
+            SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                              STMT_ADD_PATH_ADDITION));
+            SVN_ERR(svn_sqlite__bindf(stmt, "srsr", path, rev,
+                                      copyfrom_path, copyfrom_rev));
+            SVN_ERR(svn_sqlite__insert(NULL, stmt));
+          }
+          /* Fall through. */
+
+        case svn_fs_path_change_modify:
+        case svn_fs_path_change_delete:
+          SVN_ERR(add_path_revisions(sdb, prefixes, path, rev));
+          break;
+
+        /* Not an actual change. */
+        case svn_fs_path_change_reset:
+        default:
+          break;
+        }
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *REV to the youngest revision not younger than MAX_REV that
+   INDEX lists in the table queried by statement STMT_IDX for PATH.
+   Set it to SVN_INVALID_REVNUM if there is no such revision. */
+static svn_error_t *
+get_last_revision(svn_revnum_t *rev,
+                  svn_repos__changes_index_t *index,
+                  int stmt_idx,
+                  const char *path,
+                  svn_revnum_t max_rev)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb, stmt_idx));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, max_rev));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *rev = have_row ? svn_sqlite__column_revnum(stmt, 0) : SVN_INVALID_REVNUM;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* If PATH or any of its parents got added in REV, set *FOUND to TRUE and
+   return in *COPYFROM_PATH and *COPYFROM_REV where PATH got copied from.
+   The latter will be NULL and SVN_INVALID_REVNUM, respectively, if PATH
+   has no history before REV.  If there was no such addition, set *FOUND to
+   FALSE.  Allocate *COPYFROM_PATH in RESULT_POOL. */
+static svn_error_t *
+get_addition(svn_boolean_t *found,
+             const char **copyfrom_path,
+             svn_revnum_t *copyfrom_rev,
+             svn_repos__changes_index_t *index,
+             const char *path,
+             svn_revnum_t rev,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  const char *parent = path;
+
+  *found = FALSE;
+
+  /* The deepest addition determines the node's history. */
+  while (TRUE)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb,
+                                        STMT_GET_PATH_ADDITION));
+      SVN_ERR(svn_sqlite__bindf(stmt, "sr", parent, rev));
+      SVN_ERR(svn_sqlite__step(found, stmt));
+
+      if (*found)
+        {
+          *copyfrom_path = NULL;
+          *copyfrom_rev = svn_sqlite__column_revnum(stmt, 1);
+
+          if (!svn_sqlite__column_is_null(stmt, 0))
+            *copyfrom_path
+              = svn_fspath__join(svn_sqlite__column_text(stmt, 0, NULL),
+                                 svn_fspath__skip_ancestor(parent, path),
+                                 result_pool);
+
+          return svn_error_trace(svn_sqlite__reset(stmt));
+        }
+
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      if (svn_fspath__is_root(parent, strlen(parent)))
+        break;
+
+      parent = svn_fspath__dirname(parent, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Describes the changed-paths index to the common log index code. */
+static const svn_repos__log_index_desc_t index_desc =
+{
+  SVN_REPOS__CHANGES_INDEX_DB,
+  N_("Changed-paths index"),
+  statements,
+  CHANGES_INDEX_SCHEMA_VERSION,
+  STMT_CREATE_SCHEMA,
+  STMT_GET_INDEXED_REVISION,
+  STMT_SET_INDEXED_REVISION,
+  STMT_DELETE_ALL_CHANGES,
+  svn_repos_notify_changes_indexed,
+  index_revision
+};
+
+
+/*** Library-private API ***/
+
+svn_error_t *
+svn_repos__changes_index_open(svn_repos__changes_index_t **index,
+                              svn_repos_t *repos,
+                              svn_boolean_t writable,
+                              svn_boolean_t create,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+
+  SVN_ERR(svn_repos__log_index_open(&sdb, &index_desc, repos, writable,
+                                    create, 0, result_pool, scratch_pool));
+  if (sdb)
+    {
+      *index = apr_pcalloc(result_pool, sizeof(**index));
+      (*index)->sdb = sdb;
+    }
+  else
+    {
+      *index = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__changes_index_get_revision(svn_revnum_t *rev,
+                                      svn_repos__changes_index_t *index)
+{
+  return svn_error_trace(svn_repos__log_index_get_revision(rev, index->sdb,
+                                                           &index_desc));
+}
+
+svn_error_t *
+svn_repos__changes_index_history_prev(const char **prev_path,
+                                      svn_revnum_t *prev_rev,
+                                      svn_repos__changes_index_t *index,
+                                      const char *path,
+                                      svn_revnum_t rev,
+                                      svn_boolean_t inclusive,
+                                      svn_boolean_t cross_copies,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool)
+{
+  svn_revnum_t last, added;
+  const char *parent;
+
+  *prev_path = NULL;
+  *prev_rev = SVN_INVALID_REVNUM;
+
+  if (!inclusive)
+    {
+      svn_boolean_t found;
+      const char *copyfrom_path;
+      svn_revnum_t copyfrom_rev;
+
+      /* If PATH@REV got created by an addition of itself or any of its
+         parents, its history either ends here or continues at the copy
+         source. */
+      SVN_ERR(get_addition(&found, &copyfrom_path, &copyfrom_rev, index,
+                           path, rev, scratch_pool, scratch_pool));
+      if (found && (!copyfrom_path || !cross_copies))
+        return SVN_NO_ERROR;
+
+      if (found)
+        {
+          path = copyfrom_path;
+          rev = copyfrom_rev;
+        }
+      else
+        {
+          rev--;
+        }
+    }
+
+  /* The youngest change to PATH or anything below it. */
+  SVN_ERR(get_last_revision(&last, index, STMT_GET_LAST_PATH_REVISION,
+                            path, rev));
+
+  /* Copying a parent creates PATH as well, without listing it as
+     changed. */
+  parent = path;
+  while (!svn_fspath__is_root(parent, strlen(parent)))
+    {
+      parent = svn_fspath__dirname(parent, scratch_pool);
+      SVN_ERR(get_last_revision(&added, index, STMT_GET_LAST_PATH_ADDITION,
+                                parent, rev));
+      if (added > last)
+        last = added;
+    }
+
+  /* The root directory exists since r0, without ever being added. */
+  if (!SVN_IS_VALID_REVNUM(last) && rev >= 0
+      && svn_fspath__is_root(path, strlen(path)))
+    last = 0;
+
+  if (SVN_IS_VALID_REVNUM(last))
+    {
+      *prev_path = apr_pstrdup(result_pool, path);
+      *prev_rev = last;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_repos__changes_index_post_commit(svn_repos_t *repos,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_repos__log_index_post_commit(&index_desc, repos, scratch_pool);
+}
+
+
+/*** Public API ***/
+
+svn_error_t *
+svn_repos_build_changes_index(svn_repos_t *repos,
+                              svn_repos_notify_func_t notify_func,
+                              void *notify_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+
+  SVN_ERR(svn_repos__log_index_open(&sdb, &index_desc, repos, TRUE, TRUE, 0,
+                                    scratch_pool, scratch_pool));
+  SVN_ERR(svn_repos__log_index_update(sdb, &index_desc, repos,
+                                      SVN_INVALID_REVNUM,
+                                      notify_func, notify_baton,
+                                      cancel_func, cancel_baton,
+                                      scratch_pool));
+
+  return svn_error_trace(svn_sqlite__close(sdb));
+}
@@ -44,6 +44,8 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
+#include "private/svn_task.h"
+#include "private/svn_atomic.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -2433,12 +2435,354 @@ report_error(svn_revnum_t revision,
     }
 }
 
+/* Number of revisions to verify within a single task when verifying
+ * concurrently.  Large enough to amortize the cost of opening a separate
+ * file system instance, small enough to keep notifications flowing and
+ * the workload evenly spread across the threads. */
+#define VERIFY_TASK_REVISIONS 32
+
+/* Result of the verification of a single revision by verify_range(). */
+typedef struct verify_rev_result_t
+{
+  /* The revision that got verified. */
+  svn_revnum_t revision;
+
+  /* Verification error or NULL.  Will be reset once reported. */
+  svn_error_t *err;
+
+  /* Notifications sent during verification, svn_repos_notify_t *. */
+  apr_array_header_t *notifications;
+} verify_rev_result_t;
+
+/* Process baton used by verify_range(). */
+typedef struct verify_range_baton_t
+{
+  /* File system to open and its configuration.  The latter is shared
+     between all tasks and must be treated as read-only. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+
+  /* Revisions to verify, inclusive. */
+  svn_revnum_t first;
+  svn_revnum_t last;
+
+  /* Parameters to pass through to verify_one_revision(). */
+  svn_revnum_t start_rev;
+  svn_boolean_t check_normalization;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Whether to record notifications at all. */
+  svn_boolean_t notify;
+
+  /* If set, stop verifying this range after the first error and record
+     the failure in *FIRST_FAILED_RANGE. */
+  svn_boolean_t stop_on_error;
+
+  /* Number of this range, counting from START_REV. */
+  svn_atomic_t range_no;
+
+  /* Lowest RANGE_NO of all ranges that failed so far.  Shared between
+     all tasks.  Ranges following it will not be reported anymore and
+     stop verifying. */
+  volatile svn_atomic_t *first_failed_range;
+} verify_range_baton_t;
+
+/* Output baton used by report_range(). */
+typedef struct report_range_baton_t
+{
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+  svn_repos_verify_callback_t verify_callback;
+  void *verify_baton;
+
+  /* Re-usable notification object for svn_repos_notify_verify_rev_end. */
+  svn_repos_notify_t *notify;
+
+  /* If not set, stop reporting after the first error. */
+  svn_boolean_t keep_going;
+
+  /* Set once an error has been reported and KEEP_GOING is not set. */
+  svn_boolean_t stopped;
+} report_range_baton_t;
+
+/* Baton for buffer_notification(). */
+typedef struct buffer_notification_baton_t
+{
+  /* Array of svn_repos_notify_t * to append to. */
+  apr_array_header_t *notifications;
+
+  /* Pool to allocate the copies in. */
+  apr_pool_t *pool;
+} buffer_notification_baton_t;
+
+/* Implements svn_repos_notify_func_t.  Append a deep copy of NOTIFY to
+ * the buffer_notification_baton_t BATON. */
+static void
+buffer_notification(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  buffer_notification_baton_t *b = baton;
+  svn_repos_notify_t *copy = apr_pmemdup(b->pool, notify, sizeof(*notify));
+
+  copy->warning_str = apr_pstrdup(b->pool, notify->warning_str);
+  copy->path = apr_pstrdup(b->pool, notify->path);
+  APR_ARRAY_PUSH(b->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* A warning handling function that does not abort on errors,
+   but just lets them be returned normally.  */
+static void
+verify_warning_func(void *baton, svn_error_t *err)
+{
+}
+
+/* Pool cleanup function clearing all unreported errors in the
+ * apr_array_header_t * of verify_rev_result_t * given as DATA. */
+static apr_status_t
+clear_verify_results(void *data)
+{
+  apr_array_header_t *results = data;
+  int i;
+
+  for (i = 0; i < results->nelts; ++i)
+    {
+      verify_rev_result_t *result
+        = APR_ARRAY_IDX(results, i, verify_rev_result_t *);
+      svn_error_clear(result->err);
+      result->err = NULL;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Lower *FIRST_FAILED_RANGE to RANGE_NO, if it isn't lower already. */
+static void
+record_failed_range(volatile svn_atomic_t *first_failed_range,
+                    svn_atomic_t range_no)
+{
+  svn_atomic_t current = svn_atomic_read(first_failed_range);
+
+  while (range_no < current)
+    {
+      svn_atomic_t previous = svn_atomic_cas(first_failed_range, range_no,
+                                             current);
+      if (previous == current)
+        break;
+
+      current = previous;
+    }
+}
+
+/* Implements svn_task__process_func_t.  Verify the revisions given by the
+ * verify_range_baton_t PROCESS_BATON in a private file system instance.
+ * Return the outcome as an array of verify_rev_result_t * in *RESULT.
+ *
+ * Verification errors are being recorded in RESULT while cancellation
+ * and errors in setting up the verification are being returned.
+ */
+static svn_error_t *
+verify_range(void **result,
+             void *process_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  verify_range_baton_t *b = process_baton;
+  apr_array_header_t *results;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+
+  results = apr_array_make(result_pool, (int)(b->last - b->first + 1),
+                           sizeof(verify_rev_result_t *));
+  apr_pool_cleanup_register(result_pool, results, clear_verify_results,
+                            apr_pool_cleanup_null);
+
+  SVN_ERR(svn_fs_open2(&fs, b->fs_path, b->fs_config, scratch_pool,
+                       scratch_pool));
+  svn_fs_set_warning_func(fs, verify_warning_func, NULL);
+
+  for (rev = b->first; rev <= b->last; ++rev)
+    {
+      verify_rev_result_t *rev_result;
+      buffer_notification_baton_t buffer_baton;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* An earlier range failed and we won't get reported anyway. */
+      if (   b->stop_on_error
+          && svn_atomic_read(b->first_failed_range) < b->range_no)
+        break;
+
+      rev_result = apr_pcalloc(result_pool, sizeof(*rev_result));
+      rev_result->revision = rev;
+      rev_result->notifications
+        = apr_array_make(result_pool, 0, sizeof(svn_repos_notify_t *));
+
+      buffer_baton.notifications = rev_result->notifications;
+      buffer_baton.pool = result_pool;
+
+      err = verify_one_revision(fs, rev,
+                                b->notify ? buffer_notification : NULL,
+                                &buffer_baton,
+                                b->start_rev, b->check_normalization,
+                                b->cancel_func, b->cancel_baton,
+                                iterpool);
+      if (err && err->apr_err == SVN_ERR_CANCELLED)
+        return svn_error_trace(err);
+
+      rev_result->err = err;
+      APR_ARRAY_PUSH(results, verify_rev_result_t *) = rev_result;
+
+      if (err && b->stop_on_error)
+        {
+          record_failed_range(b->first_failed_range, b->range_no);
+          break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *result = results;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Send the notifications and report
+ * the errors recorded by verify_range() in RESULT, as specified by the
+ * report_range_baton_t OUTPUT_BATON.  This produces the same sequence of
+ * calls as a sequential verification of the respective revisions. */
+static svn_error_t *
+report_range(void *result,
+             void *output_baton,
+             apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *results = result;
+  report_range_baton_t *b = output_baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i, k;
+
+  for (i = 0; i < results->nelts && !b->stopped; ++i)
+    {
+      verify_rev_result_t *rev_result
+        = APR_ARRAY_IDX(results, i, verify_rev_result_t *);
+
+      svn_pool_clear(iterpool);
+
+      if (b->notify_func)
+        for (k = 0; k < rev_result->notifications->nelts; ++k)
+          b->notify_func(b->notify_baton,
+                         APR_ARRAY_IDX(rev_result->notifications, k,
+                                       svn_repos_notify_t *),
+                         iterpool);
+
+      if (rev_result->err)
+        {
+          svn_error_t *err = rev_result->err;
+          rev_result->err = NULL;
+
+          SVN_ERR(report_error(rev_result->revision, err, b->verify_callback,
+                               b->verify_baton, iterpool));
+          b->stopped = !b->keep_going;
+        }
+      else if (b->notify_func)
+        {
+          /* Tell the caller that we're done with this revision. */
+          b->notify->revision = rev_result->revision;
+          b->notify_func(b->notify_baton, b->notify, iterpool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify revisions START_REV to END_REV in FS using up to JOBS concurrent
+ * tasks.  The remaining parameters are the same as for
+ * svn_repos_verify_fs4().  NOTIFY is the notification object to use for
+ * svn_repos_notify_verify_rev_end and may be NULL if NOTIFY_FUNC is.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+verify_revisions_concurrently(svn_fs_t *fs,
+                              svn_revnum_t start_rev,
+                              svn_revnum_t end_rev,
+                              svn_boolean_t check_normalization,
+                              int jobs,
+                              svn_boolean_t keep_going,
+                              svn_repos_notify_func_t notify_func,
+                              void *notify_baton,
+                              svn_repos_notify_t *notify,
+                              svn_repos_verify_callback_t verify_callback,
+                              void *verify_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool)
+{
+  svn_task__queue_t *queue;
+  report_range_baton_t *report_baton;
+  verify_range_baton_t *range_batons;
+  const char *fs_path = svn_fs_path(fs, scratch_pool);
+  apr_hash_t *fs_config = svn_fs_config(fs, scratch_pool);
+  volatile svn_atomic_t *first_failed_range;
+  svn_revnum_t first;
+  svn_atomic_t range_no;
+  int i;
+
+  first_failed_range = apr_palloc(scratch_pool, sizeof(*first_failed_range));
+  svn_atomic_set(first_failed_range, APR_UINT32_MAX);
+
+  report_baton = apr_pcalloc(scratch_pool, sizeof(*report_baton));
+  report_baton->notify_func = notify_func;
+  report_baton->notify_baton = notify_baton;
+  report_baton->verify_callback = verify_callback;
+  report_baton->verify_baton = verify_baton;
+  report_baton->notify = notify;
+  report_baton->keep_going = keep_going;
+
+  /* At most JOBS tasks will be in flight at any time.  So, by the time we
+     fill in the baton for the next task, the task that used the same baton
+     one round earlier has been completed and reported. */
+  range_batons = apr_pcalloc(scratch_pool, (jobs + 1) * sizeof(*range_batons));
+
+  SVN_ERR(svn_task__queue_create(&queue, jobs, scratch_pool));
+
+  for (first = start_rev, i = 0, range_no = 0;
+       first <= end_rev && !report_baton->stopped;
+       first += VERIFY_TASK_REVISIONS, i = (i + 1) % (jobs + 1), ++range_no)
+    {
+      verify_range_baton_t *range_baton = &range_batons[i];
+
+      range_baton->fs_path = fs_path;
+      range_baton->fs_config = fs_config;
+      range_baton->first = first;
+      range_baton->last = MIN(end_rev, first + VERIFY_TASK_REVISIONS - 1);
+      range_baton->start_rev = start_rev;
+      range_baton->check_normalization = check_normalization;
+      range_baton->cancel_func = cancel_func;
+      range_baton->cancel_baton = cancel_baton;
+      range_baton->notify = notify_func != NULL;
+      range_baton->stop_on_error = !keep_going || verify_callback == NULL;
+      range_baton->range_no = range_no;
+      range_baton->first_failed_range = first_failed_range;
+
+      SVN_ERR(svn_task__queue_push(queue, verify_range, range_baton,
+                                   report_range, report_baton,
+                                   scratch_pool));
+    }
+
+  return svn_error_trace(svn_task__queue_finish(queue, scratch_pool));
+}
+
 svn_error_t *
-svn_repos_verify_fs3(svn_repos_t *repos,
+svn_repos_verify_fs4(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      svn_boolean_t check_normalization,
                      svn_boolean_t metadata_only,
+                     int jobs,
+                     svn_boolean_t keep_going,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_repos_verify_callback_t verify_callback,
@@ -2451,7 +2795,7 @@ svn_repos_verify_fs3(svn_repos_t *repos,
   svn_revnum_t youngest;
   svn_revnum_t rev;
   apr_pool_t *iterpool = svn_pool_create(pool);
-  svn_repos_notify_t *notify;
+  svn_repos_notify_t *notify = NULL;
   svn_fs_progress_notify_func_t verify_notify = NULL;
   struct verify_fs_notify_func_baton_t *verify_notify_baton = NULL;
   svn_error_t *err;
@@ -2511,7 +2855,19 @@ svn_repos_verify_fs3(svn_repos_t *repos,
                            verify_baton, iterpool));
     }
 
-  if (!metadata_only)
+  /* Verify the revision contents, in parallel if requested and there
+     is enough work to distribute. */
+  if (   !metadata_only
+      && jobs > 1
+      && end_rev - start_rev >= VERIFY_TASK_REVISIONS)
+    SVN_ERR(verify_revisions_concurrently(fs, start_rev, end_rev,
+                                          check_normalization, jobs,
+                                          keep_going,
+                                          notify_func, notify_baton, notify,
+                                          verify_callback, verify_baton,
+                                          cancel_func, cancel_baton,
+                                          iterpool));
+  else if (!metadata_only)
     for (rev = start_rev; rev <= end_rev; rev++)
       {
         svn_pool_clear(iterpool);
@@ -2530,6 +2886,8 @@ svn_repos_verify_fs3(svn_repos_t *repos,
           {
             SVN_ERR(report_error(rev, err, verify_callback, verify_baton,
                                  iterpool));
+            if (!keep_going)
+              break;
           }
         else if (notify_func)
           {
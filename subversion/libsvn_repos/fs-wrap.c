@@ -120,6 +120,11 @@ svn_repos_fs_commit_txn(const char **conflict_p,
                 _("Commit succeeded, but post-commit hook failed"));
     }
 
+  /* Keep the optional indexes in sync with the new revision.  The commit
+     is complete at this point and these never fail. */
+  svn_repos__mergeinfo_index_post_commit(repos, pool);
+  svn_repos__changes_index_post_commit(repos, pool);
+
   return svn_error_compose_create(err, err2);
 }
 
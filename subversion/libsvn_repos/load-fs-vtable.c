@@ -1118,6 +1118,10 @@ close_revision(void *baton)
         return svn_error_trace(err);
     }
 
+  /* Keep the optional indexes in sync with the new revision. */
+  svn_repos__mergeinfo_index_post_commit(pb->repos, rb->pool);
+  svn_repos__changes_index_post_commit(pb->repos, rb->pool);
+
   /* Run post-commit hook, if so commanded.  */
   if (pb->use_post_commit_hook)
     {
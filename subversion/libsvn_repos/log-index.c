@@ -0,0 +1,298 @@
+/* log-index.c --- common parts of the optional per-revision log indexes
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_io.h"
+#include "svn_repos.h"
+#include "svn_sorts.h"
+#include "repos.h"
+#include "svn_private_config.h"
+
+#include "private/svn_sqlite.h"
+
+/* Number of revisions that svn_repos__log_index_update() adds within a
+   single SQLite transaction.  This keeps other writers from waiting too
+   long while a large range of revisions gets indexed. */
+#define REVISIONS_PER_TXN 100
+
+/* Number of revisions that a commit may catch up on.  Anything larger
+   is left to the respective svn_repos_build_*_index() function. */
+#define MAX_POST_COMMIT_REVISIONS 16
+
+/* SQLite busy timeout in msec for updates at commit time.  If some other
+   process keeps the index locked for longer, it will pick up our revision
+   as well or the next commit will. */
+#define POST_COMMIT_BUSY_TIMEOUT 100
+
+
+/*** Helper functions ***/
+
+/* Make REV the youngest revision covered by the index described by DESC
+   and opened in SDB. */
+static svn_error_t *
+set_indexed_revision(svn_sqlite__db_t *sdb,
+                     const svn_repos__log_index_desc_t *desc,
+                     svn_revnum_t rev)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    desc->stmt_set_indexed_revision));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, rev));
+
+  return svn_error_trace(svn_sqlite__update(NULL, stmt));
+}
+
+/* Baton for update_body(). */
+typedef struct update_baton_t
+{
+  const svn_repos__log_index_desc_t *desc;
+  svn_repos_t *repos;
+  svn_revnum_t max_revisions;
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Set to TRUE once the index covers the youngest revision. */
+  svn_boolean_t done;
+} update_baton_t;
+
+/* Implements svn_sqlite__transaction_callback_t.  Add up to
+   REVISIONS_PER_TXN revisions to the index in DB as described by the
+   update_baton_t given by BATON. */
+static svn_error_t *
+update_body(void *baton,
+            svn_sqlite__db_t *db,
+            apr_pool_t *scratch_pool)
+{
+  update_baton_t *ub = baton;
+  svn_revnum_t youngest, indexed, last, rev;
+  apr_pool_t *iterpool;
+
+  /* With the database locked, nobody else will update the index.  So,
+     both values remain consistent until we are done. */
+  SVN_ERR(svn_repos__log_index_get_revision(&indexed, db, ub->desc));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, ub->repos->fs, scratch_pool));
+
+  /* The repository has been replaced by some older copy of it and
+     the revisions following YOUNGEST may differ from what we indexed. */
+  if (indexed > youngest)
+    {
+      SVN_ERR(svn_sqlite__exec_statements(db, ub->desc->stmt_delete_all));
+      indexed = 0;
+    }
+
+  if (   ub->max_revisions != SVN_INVALID_REVNUM
+      && youngest - indexed > ub->max_revisions)
+    {
+      /* Too far behind, record the reset (if any) and leave it at that. */
+      ub->done = TRUE;
+      return svn_error_trace(set_indexed_revision(db, ub->desc, indexed));
+    }
+
+  last = MIN(youngest, indexed + REVISIONS_PER_TXN);
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = indexed + 1; rev <= last; ++rev)
+    {
+      svn_pool_clear(iterpool);
+
+      if (ub->cancel_func)
+        SVN_ERR(ub->cancel_func(ub->cancel_baton));
+
+      SVN_ERR(ub->desc->add_revision(db, ub->repos->fs, rev, iterpool));
+
+      if (ub->notify_func)
+        {
+          svn_repos_notify_t *notify
+            = svn_repos_notify_create(ub->desc->notify_action, iterpool);
+          notify->revision = rev;
+          ub->notify_func(ub->notify_baton, notify, iterpool);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  ub->done = last == youngest;
+
+  return svn_error_trace(set_indexed_revision(db, ub->desc, last));
+}
+
+
+/*** Library-private API ***/
+
+svn_error_t *
+svn_repos__log_index_open(svn_sqlite__db_t **sdb,
+                          const svn_repos__log_index_desc_t *desc,
+                          svn_repos_t *repos,
+                          svn_boolean_t writable,
+                          svn_boolean_t create,
+                          apr_int32_t timeout,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  const char *db_path = svn_dirent_join(repos->db_path, desc->db_name,
+                                        scratch_pool);
+  svn_sqlite__db_t *result;
+  svn_sqlite__mode_t mode;
+  svn_node_kind_t kind;
+  int version;
+
+  SVN_ERR(svn_io_check_path(db_path, &kind, scratch_pool));
+  if (kind == svn_node_none && !create)
+    {
+      *sdb = NULL;
+      return SVN_NO_ERROR;
+    }
+
+#ifndef WIN32
+  if (kind == svn_node_none)
+    {
+      /* Extend the permissions that apply to the repository as a whole
+         to the new index instead of simply using the umask. */
+      const char *format_path = svn_dirent_join(repos->path,
+                                                SVN_REPOS__FORMAT,
+                                                scratch_pool);
+      svn_error_t *err = svn_io_file_create_empty(db_path, scratch_pool);
+
+      if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
+        return svn_error_trace(err);
+      else if (err)
+        svn_error_clear(err);
+      else
+        SVN_ERR(svn_io_copy_perms(format_path, db_path, scratch_pool));
+    }
+#endif
+
+  if (create)
+    mode = svn_sqlite__mode_rwcreate;
+  else if (writable)
+    mode = svn_sqlite__mode_readwrite;
+  else
+    mode = svn_sqlite__mode_readonly;
+
+  SVN_ERR(svn_sqlite__open(&result, db_path, mode, desc->statements,
+                           0, NULL, timeout, result_pool, scratch_pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, result,
+                                                        scratch_pool),
+                        result);
+
+  /* An empty database file.  Initialize it, if we may. */
+  if (version <= 0 && create)
+    {
+      SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(
+                              result, desc->stmt_create_schema),
+                            result);
+      version = desc->schema_version;
+    }
+
+  if (version != desc->schema_version)
+    return svn_error_compose_create(
+             svn_error_createf(SVN_ERR_SQLITE_UNSUPPORTED_SCHEMA, NULL,
+                               _("%s '%s' has unsupported schema "
+                                 "version %d"),
+                               _(desc->description),
+                               svn_dirent_local_style(db_path, scratch_pool),
+                               version),
+             svn_sqlite__close(result));
+
+  *sdb = result;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__log_index_get_revision(svn_revnum_t *rev,
+                                  svn_sqlite__db_t *sdb,
+                                  const svn_repos__log_index_desc_t *desc)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    desc->stmt_get_indexed_revision));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  *rev = svn_sqlite__column_revnum(stmt, 0);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_repos__log_index_update(svn_sqlite__db_t *sdb,
+                            const svn_repos__log_index_desc_t *desc,
+                            svn_repos_t *repos,
+                            svn_revnum_t max_revisions,
+                            svn_repos_notify_func_t notify_func,
+                            void *notify_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool)
+{
+  update_baton_t ub = { 0 };
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  ub.desc = desc;
+  ub.repos = repos;
+  ub.max_revisions = max_revisions;
+  ub.notify_func = notify_func;
+  ub.notify_baton = notify_baton;
+  ub.cancel_func = cancel_func;
+  ub.cancel_baton = cancel_baton;
+
+  while (!ub.done)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_sqlite__with_immediate_transaction(sdb, update_body,
+                                                     &ub, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_repos__log_index_post_commit(const svn_repos__log_index_desc_t *desc,
+                                 svn_repos_t *repos,
+                                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  svn_sqlite__db_t *sdb;
+  svn_error_t *err;
+
+  /* Don't let the commit wait for other updaters of the index. */
+  err = svn_repos__log_index_open(&sdb, desc, repos, TRUE, FALSE,
+                                  POST_COMMIT_BUSY_TIMEOUT,
+                                  subpool, subpool);
+  if (!err && sdb)
+    err = svn_repos__log_index_update(sdb, desc, repos,
+                                      MAX_POST_COMMIT_REVISIONS,
+                                      NULL, NULL, NULL, NULL, subpool);
+
+  /* Readers only trust the index up to its youngest indexed revision.
+     So, failing to update it is harmless.  The SQLite transactions make
+     sure that we never leave a partially indexed revision behind. */
+  svn_error_clear(err);
+  svn_pool_destroy(subpool);
+}
@@ -56,6 +56,12 @@ typedef struct log_callbacks_t
   void *revision_receiver_baton;
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
+
+  /* The mergeinfo index of the repository, if available. */
+  svn_repos__mergeinfo_index_t *mergeinfo_index;
+
+  /* The changed-paths index of the repository, if available. */
+  svn_repos__changes_index_t *changes_index;
 } log_callbacks_t;
 
 
@@ -429,8 +435,73 @@ struct path_info
   svn_fs_history_t *hist;
   apr_pool_t *newpool;
   apr_pool_t *oldpool;
+
+  /* If not NULL, the changed-paths index to use instead of the FS history
+     for all revisions up to INDEXED_REV. */
+  svn_repos__changes_index_t *index;
+  svn_revnum_t indexed_rev;
 };
 
+/* Implement get_history() for INFO using its changed-paths index.
+ * INFO->HISTORY_REV must be covered by that index. */
+static svn_error_t *
+get_indexed_history(struct path_info *info,
+                    svn_fs_t *fs,
+                    svn_boolean_t strict,
+                    svn_repos_authz_func_t authz_read_func,
+                    void *authz_read_baton,
+                    svn_revnum_t start,
+                    apr_pool_t *scratch_pool)
+{
+  /* An open history object has already reported the current location. */
+  svn_boolean_t inclusive = info->first_time && ! info->hist;
+  const char *path;
+  svn_revnum_t rev;
+
+  /* We may have been following the FS history until here. */
+  if (info->hist)
+    {
+      svn_pool_destroy(info->newpool);
+      svn_pool_destroy(info->oldpool);
+      info->hist = NULL;
+      info->newpool = NULL;
+      info->oldpool = NULL;
+    }
+
+  SVN_ERR(svn_repos__changes_index_history_prev(&path, &rev, info->index,
+                                                info->path->data,
+                                                info->history_rev,
+                                                inclusive, ! strict,
+                                                scratch_pool, scratch_pool));
+  info->first_time = FALSE;
+
+  /* No more history or it predates our START revision? */
+  if (! path || rev < start)
+    {
+      info->done = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  svn_stringbuf_set(info->path, path);
+  info->history_rev = rev;
+
+  /* Is the history item readable?  If not, done with path. */
+  if (authz_read_func)
+    {
+      svn_boolean_t readable;
+      svn_fs_root_t *history_root;
+
+      SVN_ERR(svn_fs_revision_root(&history_root, fs, info->history_rev,
+                                   scratch_pool));
+      SVN_ERR(authz_read_func(&readable, history_root, info->path->data,
+                              authz_read_baton, scratch_pool));
+      if (! readable)
+        info->done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Advance to the next history for the path.
  *
  * If INFO->HIST is not NULL we do this using that existing history object,
@@ -446,6 +517,8 @@ struct path_info
  * If optional AUTHZ_READ_FUNC is non-NULL, then use it (with
  * AUTHZ_READ_BATON and FS) to check whether INFO->PATH is still readable if
  * we do indeed find more history for the path.
+ *
+ * If INFO->INDEX covers INFO->HISTORY_REV, use it instead of the FS history.
  */
 static svn_error_t *
 get_history(struct path_info *info,
@@ -462,6 +535,12 @@ get_history(struct path_info *info,
   apr_pool_t *subpool;
   const char *path;
 
+  if (info->index && info->history_rev <= info->indexed_rev)
+    return svn_error_trace(get_indexed_history(info, fs, strict,
+                                               authz_read_func,
+                                               authz_read_baton, start,
+                                               scratch_pool));
+
   if (info->hist)
     {
       subpool = info->newpool;
@@ -609,18 +688,15 @@ next_history_rev(const apr_array_header_t *histories)
   return next_rev;
 }
 
-/* Set *DELETED_MERGEINFO_CATALOG and *ADDED_MERGEINFO_CATALOG to
-   catalogs describing how mergeinfo values on paths (which are the
-   keys of those catalogs) were changed in REV. */
 /* ### TODO: This would make a *great*, useful public function,
    ### svn_repos_fs_mergeinfo_changed()!  -- cmpilato  */
-static svn_error_t *
-fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
-                     svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
-                     svn_fs_t *fs,
-                     svn_revnum_t rev,
-                     apr_pool_t *result_pool,
-                     apr_pool_t *scratch_pool)
+svn_error_t *
+svn_repos__mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+                             svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+                             svn_fs_t *fs,
+                             svn_revnum_t rev,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
 {
   svn_fs_root_t *root;
   apr_pool_t *iterpool, *iterator_pool;
@@ -877,11 +953,14 @@ fs_mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
 
 /* Determine what (if any) mergeinfo for PATHS was modified in
    revision REV, returning the differences for added mergeinfo in
-   *ADDED_MERGEINFO and deleted mergeinfo in *DELETED_MERGEINFO. */
+   *ADDED_MERGEINFO and deleted mergeinfo in *DELETED_MERGEINFO.
+   If not NULL, MERGEINFO_INDEX will be used to find the mergeinfo
+   changes in REV. */
 static svn_error_t *
 get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
                                svn_mergeinfo_t *deleted_mergeinfo,
                                svn_fs_t *fs,
+                               svn_repos__mergeinfo_index_t *mergeinfo_index,
                                const apr_array_header_t *paths,
                                svn_revnum_t rev,
                                apr_pool_t *result_pool,
@@ -892,7 +971,8 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
   svn_fs_root_t *root;
   apr_pool_t *iterpool;
   int i;
-  svn_error_t *err;
+  svn_boolean_t indexed = FALSE;
+  svn_error_t *err = SVN_NO_ERROR;
 
   /* Initialize return value. */
   *added_mergeinfo = svn_hash__make(result_pool);
@@ -906,11 +986,30 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
   if (! paths->nelts)
     return SVN_NO_ERROR;
 
-  /* Fetch the mergeinfo changes for REV. */
-  err = fs_mergeinfo_changed(&deleted_mergeinfo_catalog,
-                             &added_mergeinfo_catalog,
-                             fs, rev,
-                             scratch_pool, scratch_pool);
+  /* Fetch the mergeinfo changes for REV.  Reading them from the index
+     is much cheaper than reconstructing them from the changed paths.
+     The index is optional, so if reading it fails, e.g. because it is
+     corrupt or locked, simply reconstruct the changes as usual. */
+  if (mergeinfo_index)
+    {
+      err = svn_repos__mergeinfo_index_get(&indexed,
+                                           &deleted_mergeinfo_catalog,
+                                           &added_mergeinfo_catalog,
+                                           mergeinfo_index, rev,
+                                           scratch_pool, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          err = SVN_NO_ERROR;
+          indexed = FALSE;
+        }
+    }
+
+  if (!indexed)
+    err = svn_repos__mergeinfo_changed(&deleted_mergeinfo_catalog,
+                                       &added_mergeinfo_catalog,
+                                       fs, rev,
+                                       scratch_pool, scratch_pool);
   if (err)
     {
       if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
@@ -1401,11 +1500,13 @@ get_path_histories(apr_array_header_t **histories,
                    svn_boolean_t ignore_missing_locations,
                    svn_repos_authz_func_t authz_read_func,
                    void *authz_read_baton,
+                   svn_repos__changes_index_t *index,
                    apr_pool_t *pool)
 {
   svn_fs_root_t *root;
   apr_pool_t *iterpool;
   svn_error_t *err;
+  svn_revnum_t indexed_rev = SVN_INVALID_REVNUM;
   int i;
 
   /* Create a history object for each path so we can walk through
@@ -1421,6 +1522,12 @@ get_path_histories(apr_array_header_t **histories,
 
   SVN_ERR(svn_fs_revision_root(&root, fs, hist_end, pool));
 
+  /* Only use the index if it covers the range at least partially. */
+  if (index)
+    SVN_ERR(svn_repos__changes_index_get_revision(&indexed_rev, index));
+  if (indexed_rev < hist_start)
+    index = NULL;
+
   iterpool = svn_pool_create(pool);
   for (i = 0; i < paths->nelts; i++)
     {
@@ -1442,8 +1549,32 @@ get_path_histories(apr_array_header_t **histories,
       info->done = FALSE;
       info->history_rev = hist_end;
       info->first_time = TRUE;
+      info->index = index;
+      info->indexed_rev = indexed_rev;
 
-      if (i < MAX_OPEN_HISTORIES)
+      if (index && hist_end <= indexed_rev)
+        {
+          svn_node_kind_t kind;
+
+          /* The index won't tell us whether the path exists.  Fail the
+             same way svn_fs_node_history2() would. */
+          SVN_ERR(svn_fs_check_path(&kind, root, this_path, iterpool));
+          if (kind == svn_node_none)
+            {
+              if (ignore_missing_locations)
+                continue;
+
+              return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                                       _("File not found: revision %ld, "
+                                         "path '%s'"),
+                                       hist_end, this_path);
+            }
+
+          info->hist = NULL;
+          info->oldpool = NULL;
+          info->newpool = NULL;
+        }
+      else if (i < MAX_OPEN_HISTORIES)
         {
           err = svn_fs_node_history2(&info->hist, root, this_path, pool,
                                      iterpool);
@@ -2015,7 +2146,8 @@ do_logs(svn_fs_t *fs,
   SVN_ERR(get_path_histories(&histories, fs, paths, hist_start, hist_end,
                              strict_node_history, ignore_missing_locations,
                              callbacks->authz_read_func,
-                             callbacks->authz_read_baton, pool));
+                             callbacks->authz_read_baton,
+                             callbacks->changes_index, pool));
 
   /* Loop through all the revisions in the range and add any
      where a path was changed to the array, or if they wanted
@@ -2075,7 +2207,9 @@ do_logs(svn_fs_t *fs,
                 }
               SVN_ERR(get_combined_mergeinfo_changes(&added_mergeinfo,
                                                      &deleted_mergeinfo,
-                                                     fs, cur_paths,
+                                                     fs,
+                                                     callbacks->mergeinfo_index,
+                                                     cur_paths,
                                                      current,
                                                      iterpool, iterpool));
               has_children = (apr_hash_count(added_mergeinfo) > 0
@@ -2325,6 +2459,7 @@ svn_repos_get_logs5(svn_repos_t *repos,
   svn_boolean_t descending_order;
   svn_mergeinfo_t paths_history_mergeinfo = NULL;
   log_callbacks_t callbacks;
+  svn_error_t *err;
 
   callbacks.path_change_receiver = path_change_receiver;
   callbacks.path_change_receiver_baton = path_change_receiver_baton;
@@ -2332,6 +2467,8 @@ svn_repos_get_logs5(svn_repos_t *repos,
   callbacks.revision_receiver_baton = revision_receiver_baton;
   callbacks.authz_read_func = authz_read_func;
   callbacks.authz_read_baton = authz_read_baton;
+  callbacks.mergeinfo_index = NULL;
+  callbacks.changes_index = NULL;
 
   if (revprops)
     {
@@ -2452,6 +2589,16 @@ svn_repos_get_logs5(svn_repos_t *repos,
     {
       apr_pool_t *subpool = svn_pool_create(scratch_pool);
 
+      /* The index is optional.  If we can't use it, just do without. */
+      err = svn_repos__mergeinfo_index_open(&callbacks.mergeinfo_index,
+                                            repos, FALSE, FALSE,
+                                            scratch_pool, subpool);
+      if (err)
+        {
+          svn_error_clear(err);
+          callbacks.mergeinfo_index = NULL;
+        }
+
       SVN_ERR(get_paths_history_as_mergeinfo(&paths_history_mergeinfo,
                                              repos, paths, start, end,
                                              authz_read_func,
@@ -2460,6 +2607,16 @@ svn_repos_get_logs5(svn_repos_t *repos,
       svn_pool_destroy(subpool);
     }
 
+  /* The changed-paths index is optional as well. */
+  err = svn_repos__changes_index_open(&callbacks.changes_index, repos,
+                                      FALSE, FALSE, scratch_pool,
+                                      scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      callbacks.changes_index = NULL;
+    }
+
   return do_logs(repos->fs, paths, paths_history_mergeinfo, NULL, NULL,
                  start, end, limit, strict_node_history,
                  include_merged_revisions, FALSE, FALSE, FALSE,
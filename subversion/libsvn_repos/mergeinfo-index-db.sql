@@ -0,0 +1,67 @@
+/* mergeinfo-index-db.sql -- schema for use in the mergeinfo index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* The mergeinfo changes per revision and path, as determined by
+   svn_repos__mergeinfo_changed().  DELETED and ADDED are the respective
+   mergeinfo in its string representation.  Revisions without any
+   mergeinfo change have no rows. */
+CREATE TABLE mergeinfo_changes (
+  revision INTEGER NOT NULL,
+  path TEXT NOT NULL,
+  deleted TEXT NOT NULL,
+  added TEXT NOT NULL,
+  PRIMARY KEY (revision, path)
+  );
+
+/* A single row containing the youngest revision covered by the index. */
+CREATE TABLE indexed_revision (
+  id INTEGER NOT NULL PRIMARY KEY,
+  revision INTEGER NOT NULL
+  );
+
+INSERT INTO indexed_revision (id, revision) VALUES (0, 0);
+
+PRAGMA USER_VERSION = 1;
+
+-- STMT_GET_INDEXED_REVISION
+SELECT revision
+FROM indexed_revision
+WHERE id = 0
+
+-- STMT_SET_INDEXED_REVISION
+UPDATE indexed_revision
+SET revision = ?1
+WHERE id = 0
+
+-- STMT_GET_CHANGES
+SELECT path, deleted, added
+FROM mergeinfo_changes
+WHERE revision = ?1
+
+-- STMT_ADD_CHANGE
+INSERT OR REPLACE INTO mergeinfo_changes (revision, path, deleted, added)
+VALUES (?1, ?2, ?3, ?4)
+
+-- STMT_DELETE_ALL_CHANGES
+DELETE FROM mergeinfo_changes
@@ -0,0 +1,225 @@
+/* mergeinfo-index.c --- an on-disk index of mergeinfo changes
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_fs.h"
+#include "svn_mergeinfo.h"
+#include "svn_repos.h"
+#include "repos.h"
+#include "svn_private_config.h"
+
+#include "private/svn_sqlite.h"
+#include "private/svn_subr_private.h"
+
+#include "mergeinfo-index-db.h"
+
+MERGEINFO_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* The schema version that this code creates and understands. */
+#define MERGEINFO_INDEX_SCHEMA_VERSION 1
+
+struct svn_repos__mergeinfo_index_t
+{
+  /* The database connection. */
+  svn_sqlite__db_t *sdb;
+};
+
+
+/*** Helper functions ***/
+
+/* Implements svn_repos__log_index_add_func_t.  Determine the mergeinfo
+   changes of REV in FS and store them in SDB. */
+static svn_error_t *
+index_revision(svn_sqlite__db_t *sdb,
+               svn_fs_t *fs,
+               svn_revnum_t rev,
+               apr_pool_t *scratch_pool)
+{
+  svn_mergeinfo_catalog_t deleted_catalog, added_catalog;
+  svn_sqlite__stmt_t *stmt;
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+
+  err = svn_repos__mergeinfo_changed(&deleted_catalog, &added_catalog,
+                                     fs, rev, scratch_pool, scratch_pool);
+
+  /* Issue #3896: Invalid mergeinfo is treated as no change at all by
+     the log code.  Record it just the same way. */
+  if (err && err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Both catalogs always have the same keys. */
+  for (hi = apr_hash_first(scratch_pool, deleted_catalog);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      svn_mergeinfo_t deleted = apr_hash_this_val(hi);
+      svn_mergeinfo_t added = svn_hash_gets(added_catalog, path);
+      svn_string_t *deleted_str, *added_str;
+
+      SVN_ERR(svn_mergeinfo_to_string(&deleted_str, deleted, scratch_pool));
+      SVN_ERR(svn_mergeinfo_to_string(&added_str, added, scratch_pool));
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_ADD_CHANGE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "rsss", rev, path,
+                                deleted_str->data, added_str->data));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Describes the mergeinfo index to the common log index code. */
+static const svn_repos__log_index_desc_t index_desc =
+{
+  SVN_REPOS__MERGEINFO_INDEX_DB,
+  N_("Mergeinfo index"),
+  statements,
+  MERGEINFO_INDEX_SCHEMA_VERSION,
+  STMT_CREATE_SCHEMA,
+  STMT_GET_INDEXED_REVISION,
+  STMT_SET_INDEXED_REVISION,
+  STMT_DELETE_ALL_CHANGES,
+  svn_repos_notify_mergeinfo_indexed,
+  index_revision
+};
+
+
+/*** Library-private API ***/
+
+svn_error_t *
+svn_repos__mergeinfo_index_open(svn_repos__mergeinfo_index_t **index,
+                                svn_repos_t *repos,
+                                svn_boolean_t writable,
+                                svn_boolean_t create,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+
+  SVN_ERR(svn_repos__log_index_open(&sdb, &index_desc, repos, writable,
+                                    create, 0, result_pool, scratch_pool));
+  if (sdb)
+    {
+      *index = apr_pcalloc(result_pool, sizeof(**index));
+      (*index)->sdb = sdb;
+    }
+  else
+    {
+      *index = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__mergeinfo_index_get(svn_boolean_t *found,
+                               svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+                               svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+                               svn_repos__mergeinfo_index_t *index,
+                               svn_revnum_t rev,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_revnum_t indexed;
+  svn_boolean_t have_row;
+  svn_mergeinfo_catalog_t deleted_catalog, added_catalog;
+
+  SVN_ERR(svn_repos__log_index_get_revision(&indexed, index->sdb,
+                                            &index_desc));
+  *found = rev <= indexed;
+  if (!*found)
+    return SVN_NO_ERROR;
+
+  deleted_catalog = svn_hash__make(result_pool);
+  added_catalog = svn_hash__make(result_pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, index->sdb, STMT_GET_CHANGES));
+  SVN_ERR(svn_sqlite__bind_revnum(stmt, 1, rev));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *path = svn_sqlite__column_text(stmt, 0, result_pool);
+      svn_mergeinfo_t deleted, added;
+      svn_error_t *err;
+
+      err = svn_mergeinfo_parse(&deleted,
+                                svn_sqlite__column_text(stmt, 1, NULL),
+                                result_pool);
+      if (!err)
+        err = svn_mergeinfo_parse(&added,
+                                  svn_sqlite__column_text(stmt, 2, NULL),
+                                  result_pool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+      svn_hash_sets(deleted_catalog, path, deleted);
+      svn_hash_sets(added_catalog, path, added);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  *deleted_mergeinfo_catalog = deleted_catalog;
+  *added_mergeinfo_catalog = added_catalog;
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_repos__mergeinfo_index_post_commit(svn_repos_t *repos,
+                                       apr_pool_t *scratch_pool)
+{
+  svn_repos__log_index_post_commit(&index_desc, repos, scratch_pool);
+}
+
+
+/*** Public API ***/
+
+svn_error_t *
+svn_repos_build_mergeinfo_index(svn_repos_t *repos,
+                                svn_repos_notify_func_t notify_func,
+                                void *notify_baton,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+
+  SVN_ERR(svn_repos__log_index_open(&sdb, &index_desc, repos, TRUE, TRUE, 0,
+                                    scratch_pool, scratch_pool));
+  SVN_ERR(svn_repos__log_index_update(sdb, &index_desc, repos,
+                                      SVN_INVALID_REVNUM,
+                                      notify_func, notify_baton,
+                                      cancel_func, cancel_baton,
+                                      scratch_pool));
+
+  return svn_error_trace(svn_sqlite__close(sdb));
+}
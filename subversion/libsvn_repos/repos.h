@@ -29,6 +29,9 @@
 #include "svn_fs.h"
 #include "svn_config.h"
 
+#include "private/svn_cache.h"
+#include "private/svn_sqlite.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -153,6 +156,10 @@ struct svn_repos_t
      those constants' addresses, therefore). */
   apr_hash_t *repository_capabilities;
 
+  /* Cache of completed line-origin maps, see svn_repos__blame().
+     Created on first use; NULL until then or if caching is disabled. */
+  svn_cache__t *blame_cache;
+
   /* Pool from which this structure was allocated.  Also used for
      auxiliary repository-related data that requires a matching
      lifespan.  (As the svn_repos_t structure tends to be relatively
@@ -387,6 +394,220 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char *path,
                          apr_pool_t *pool);
 
+/* Set *DELETED_MERGEINFO_CATALOG and *ADDED_MERGEINFO_CATALOG to
+   catalogs describing how mergeinfo values on paths (which are the
+   keys of those catalogs) were changed in REV of FS.  Allocate the
+   catalogs in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__mergeinfo_changed(svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+                             svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+                             svn_fs_t *fs,
+                             svn_revnum_t rev,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+
+/*** Log Indexes ***/
+
+/* The mergeinfo and changed-paths indexes are optional SQLite databases
+   in the repository's db directory that hold per-revision data for all
+   revisions up to some youngest indexed revision.  Their common parts
+   are implemented in log-index.c; this describes an index type. */
+
+/* Add the data of revision REV in FS to the index database SDB.  Called
+   for every revision in ascending order from within an SQLite
+   transaction.  Use SCRATCH_POOL for temporaries. */
+typedef svn_error_t *(*svn_repos__log_index_add_func_t)(
+  svn_sqlite__db_t *sdb,
+  svn_fs_t *fs,
+  svn_revnum_t rev,
+  apr_pool_t *scratch_pool);
+
+typedef struct svn_repos__log_index_desc_t
+{
+  /* Name of the database file within the repository's db directory. */
+  const char *db_name;
+
+  /* Used in error messages, e.g. "Mergeinfo index". */
+  const char *description;
+
+  /* Statements of the database, their schema version and the indexes of
+     the statements that create the schema, get and set the youngest
+     indexed revision and remove all revisions from the index. */
+  const char * const *statements;
+  int schema_version;
+  int stmt_create_schema;
+  int stmt_get_indexed_revision;
+  int stmt_set_indexed_revision;
+  int stmt_delete_all;
+
+  /* Reported to the notification callback for every indexed revision. */
+  svn_repos_notify_action_t notify_action;
+
+  /* Adds the data of a single revision to the index. */
+  svn_repos__log_index_add_func_t add_revision;
+} svn_repos__log_index_desc_t;
+
+/* Open the index described by DESC of REPOS in *SDB.  If the index does
+   not exist, set *SDB to NULL unless CREATE is TRUE, in which case create
+   a new, empty index.  The index will be opened read-only unless WRITABLE
+   or CREATE are set.  TIMEOUT is the SQLite busy timeout as in
+   svn_sqlite__open().  Allocate *SDB in RESULT_POOL and close it when
+   that pool gets cleaned up.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__log_index_open(svn_sqlite__db_t **sdb,
+                          const svn_repos__log_index_desc_t *desc,
+                          svn_repos_t *repos,
+                          svn_boolean_t writable,
+                          svn_boolean_t create,
+                          apr_int32_t timeout,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/* Set *REV to the youngest revision covered by the index described by
+   DESC and opened in SDB. */
+svn_error_t *
+svn_repos__log_index_get_revision(svn_revnum_t *rev,
+                                  svn_sqlite__db_t *sdb,
+                                  const svn_repos__log_index_desc_t *desc);
+
+/* Add all revisions not covered by the index described by DESC and opened
+   in SDB yet up to the youngest revision of REPOS, but give up if that
+   would be more than MAX_REVISIONS (unless SVN_INVALID_REVNUM) revisions.
+   If the index covers revisions beyond the youngest revision, the
+   repository must have been replaced by an older version; reset the index
+   to empty in that case.  Call NOTIFY_FUNC with NOTIFY_BATON for every
+   revision added and CANCEL_FUNC with CANCEL_BATON in regular intervals,
+   if not NULL.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__log_index_update(svn_sqlite__db_t *sdb,
+                            const svn_repos__log_index_desc_t *desc,
+                            svn_repos_t *repos,
+                            svn_revnum_t max_revisions,
+                            svn_repos_notify_func_t notify_func,
+                            void *notify_baton,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool);
+
+/* If REPOS has the index described by DESC, bring it up-to-date after a
+   commit.  Errors are not being reported as the commit has already
+   succeeded; the index will simply fall behind and later updates will
+   catch up.  This only waits briefly for other processes to release the
+   index and gives up if the index is too far behind.  Use SCRATCH_POOL
+   for temporaries. */
+void
+svn_repos__log_index_post_commit(const svn_repos__log_index_desc_t *desc,
+                                 svn_repos_t *repos,
+                                 apr_pool_t *scratch_pool);
+
+
+/*** Mergeinfo Index ***/
+
+/* The optional mergeinfo index stores the results of
+   svn_repos__mergeinfo_changed() for all revisions up to some youngest
+   indexed revision.  It is being created by
+   svn_repos_build_mergeinfo_index() and kept up-to-date at commit time
+   from then on. */
+typedef struct svn_repos__mergeinfo_index_t svn_repos__mergeinfo_index_t;
+
+/* Name of the mergeinfo index database within the repository's db
+   directory. */
+#define SVN_REPOS__MERGEINFO_INDEX_DB "mergeinfo-index.db"
+
+/* Open the mergeinfo index of REPOS in *INDEX.  If the index does not
+   exist, set *INDEX to NULL unless CREATE is TRUE, in which case create a
+   new, empty index.  The index will be opened read-only unless WRITABLE
+   or CREATE are set.  Allocate *INDEX in RESULT_POOL and close it when
+   that pool gets cleaned up.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__mergeinfo_index_open(svn_repos__mergeinfo_index_t **index,
+                                svn_repos_t *repos,
+                                svn_boolean_t writable,
+                                svn_boolean_t create,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+/* If REV is covered by INDEX, set *FOUND to TRUE and return the mergeinfo
+   changes of REV just like svn_repos__mergeinfo_changed() does.  Otherwise,
+   set *FOUND to FALSE and leave the catalogs untouched.  Allocate the
+   catalogs in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__mergeinfo_index_get(svn_boolean_t *found,
+                               svn_mergeinfo_catalog_t *deleted_mergeinfo_catalog,
+                               svn_mergeinfo_catalog_t *added_mergeinfo_catalog,
+                               svn_repos__mergeinfo_index_t *index,
+                               svn_revnum_t rev,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+/* If REPOS has a mergeinfo index, bring it up-to-date after a commit.
+   See svn_repos__log_index_post_commit().  Use SCRATCH_POOL for
+   temporaries. */
+void
+svn_repos__mergeinfo_index_post_commit(svn_repos_t *repos,
+                                       apr_pool_t *scratch_pool);
+
+
+/*** Changed-paths Index ***/
+
+/* The changed-paths index is an optional SQLite database listing, for
+   every path, the revisions that changed it or anything below it as
+   well as all additions and copies, for all revisions up to some
+   youngest indexed revision.  It is being created by
+   svn_repos_build_changes_index() and kept up-to-date at commit time
+   from then on. */
+typedef struct svn_repos__changes_index_t svn_repos__changes_index_t;
+
+/* Name of the changed-paths index database within the repository's db
+   directory. */
+#define SVN_REPOS__CHANGES_INDEX_DB "changes-index.db"
+
+/* Open the changed-paths index of REPOS in *INDEX.  If the index does not
+   exist, set *INDEX to NULL unless CREATE is TRUE, in which case create a
+   new, empty index.  The index will be opened read-only unless WRITABLE
+   or CREATE are set.  Allocate *INDEX in RESULT_POOL and close it when
+   that pool gets cleaned up.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__changes_index_open(svn_repos__changes_index_t **index,
+                              svn_repos_t *repos,
+                              svn_boolean_t writable,
+                              svn_boolean_t create,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/* Set *REV to the youngest revision covered by INDEX. */
+svn_error_t *
+svn_repos__changes_index_get_revision(svn_revnum_t *rev,
+                                      svn_repos__changes_index_t *index);
+
+/* The equivalent of svn_fs_history_prev2() for the node at PATH@REV,
+   using INDEX instead of walking the node's predecessors.  REV must be
+   covered by INDEX.
+
+   Set *PREV_PATH and *PREV_REV to the youngest location in the node's
+   history that is older than REV or, if INCLUSIVE is set, not younger
+   than REV.  Follow the history across copies only if CROSS_COPIES is
+   set.  Set *PREV_PATH to NULL if there is no such location.  Allocate
+   *PREV_PATH in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_repos__changes_index_history_prev(const char **prev_path,
+                                      svn_revnum_t *prev_rev,
+                                      svn_repos__changes_index_t *index,
+                                      const char *path,
+                                      svn_revnum_t rev,
+                                      svn_boolean_t inclusive,
+                                      svn_boolean_t cross_copies,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool);
+
+/* If REPOS has a changed-paths index, bring it up-to-date after a commit.
+   See svn_repos__log_index_post_commit().  Use SCRATCH_POOL for
+   temporaries. */
+void
+svn_repos__changes_index_post_commit(svn_repos_t *repos,
+                                     apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
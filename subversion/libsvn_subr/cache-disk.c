@@ -0,0 +1,1097 @@
+/*
+ * cache-disk.c: persistent on-disk second-level cache
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_mmap.h>
+#include <apr_strings.h>
+
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+#include "svn_version.h"
+
+#include "svn_private_config.h"
+#include "private/svn_atomic.h"
+#include "private/svn_cache.h"
+#include "private/svn_mutex.h"
+
+#include "cache.h"
+#include "fnv1a.h"
+
+/* The on-disk store is a single, memory-mapped file of fixed size that is
+ * being used as a ring buffer of variable-sized records:
+ *
+ *   [file header] [record] [record] ... [record] [free / old records] ...
+ *
+ * New records are always appended at the current write position.  Once
+ * the end of the file has been reached, writing continues at the start
+ * of the file, overwriting the oldest records.  Records that are about
+ * to be overwritten get removed from the index first.  Hence, eviction
+ * is strictly FIFO which is good enough for a second-level cache that
+ * only sees the misses of a much faster first-level cache.
+ *
+ * Every record consists of a header, the full key and the serialized
+ * item data.  Records start at multiples of RECORD_ALIGNMENT bytes.
+ *
+ * The index that maps keys to records is only kept in memory.  When the
+ * store gets opened, the file will be scanned and the index rebuilt from
+ * the record headers.  The file header contains the write position and
+ * the next sequence number, so we know that the records in front of the
+ * write position follow each other without gaps.  Only behind it, where
+ * the oldest record may have been partially overwritten, we must check
+ * every slot that may contain a record header and verify its checksum
+ * until we find a valid record.  There is at most one live record per key
+ * in the file; superseded records get marked as dead in-place.  Dead
+ * records keep their size info, so we can still skip them as a whole.
+ *
+ * Because the scan trusts record headers without reading the item data,
+ * every record will be verified when it is being read.  Records that
+ * fail this check are simply dropped from the index.
+ *
+ * Index keys point into the mapped file itself, i.e. there is no extra
+ * memory needed to store them.
+ *
+ * Since the index is process-local, only one process at a time may use
+ * a given store.  This is enforced by an exclusive lock on the file.
+ * Other processes will not get to use the store and simply run without
+ * a second-level cache.  Within the process, access is serialized by a
+ * mutex.
+ */
+
+/* Record headers and records start at multiples of this. */
+#define RECORD_ALIGNMENT 64
+
+/* Marker for valid record headers. */
+#define RECORD_MAGIC 0x53564e44
+
+/* Marker for records that have been superseded or removed. */
+#define DEAD_RECORD_MAGIC 0x64656164
+
+/* Size of the file header.  The first record follows immediately. */
+#define FILE_HEADER_SIZE RECORD_ALIGNMENT
+
+/* Size of the part of the file header that identifies the store format. */
+#define FILE_ID_SIZE (FILE_HEADER_SIZE - 2 * sizeof(apr_uint64_t))
+
+/* Don't create stores smaller than this. */
+#define MIN_STORE_SIZE 0x100000
+
+/* Round VALUE up to the next multiple of RECORD_ALIGNMENT. */
+#define ALIGN_RECORD(value) \
+  (((value) + RECORD_ALIGNMENT - 1) & ~(apr_size_t)(RECORD_ALIGNMENT - 1))
+
+/* Header at the start of the file. */
+typedef struct file_header_t
+{
+  /* Identifies the Subversion version and store size that wrote the file,
+   * see format_file_header. */
+  char id[FILE_ID_SIZE];
+
+  /* Offset at which the next record will be written. */
+  apr_uint64_t write_pos;
+
+  /* Sequence number of the next record to write. */
+  apr_uint64_t next_sequence;
+} file_header_t;
+
+/* Header in front of every record in the file. */
+typedef struct record_header_t
+{
+  /* RECORD_MAGIC for live records, DEAD_RECORD_MAGIC for records that
+   * shall be ignored.  Anything else is not a record header. */
+  apr_uint32_t magic;
+
+  /* FNV-1a checksum over this header (with CHECKSUM being 0 and MAGIC
+   * being RECORD_MAGIC), the key and the data. */
+  apr_uint32_t checksum;
+
+  /* Length of the key that follows this header. */
+  apr_uint32_t key_len;
+
+  /* Length of the item data that follows the key. */
+  apr_uint32_t data_len;
+
+  /* Increasing number for all records written to the file.  Allows us
+   * to find the latest write position after re-opening the file. */
+  apr_uint64_t sequence;
+} record_header_t;
+
+/* In-memory index entry describing a valid record. */
+typedef struct index_entry_t
+{
+  /* Offset of the record header within the file. */
+  apr_size_t offset;
+
+  /* Number of bytes that the record occupies, see record_size. */
+  apr_size_t size;
+
+  /* Next entry in the store's free list.  Only valid for unused entries. */
+  struct index_entry_t *next;
+} index_entry_t;
+
+struct svn_cache__disk_t
+{
+  /* Path of the store's file. */
+  const char *path;
+
+  /* Start of the mapped file contents. */
+  char *base;
+
+  /* Size of the file in bytes. */
+  apr_size_t size;
+
+  /* Maps keys to index_entry_t *.  Keys point into the mapped file. */
+  apr_hash_t *index;
+
+  /* Recycled index entries. */
+  index_entry_t *free_entries;
+
+  /* Offset at which to write the next record. */
+  apr_size_t write_pos;
+
+  /* Records that start before this offset and at or after WRITE_POS have
+   * already been removed from the index.  Never smaller than WRITE_POS. */
+  apr_size_t evict_pos;
+
+  /* If set, EVICT_POS is known to be the start of a record (header). */
+  svn_boolean_t evict_synced;
+
+  /* Sequence number to give to the next record. */
+  apr_uint64_t next_sequence;
+
+  /* Number of bytes in valid records. */
+  apr_uint64_t used_size;
+
+  /* Serializes all access to this structure and the file contents. */
+  svn_mutex__t *mutex;
+
+  /* Pool containing the index and this structure. */
+  apr_pool_t *pool;
+};
+
+/* Return a pointer to the record header at OFFSET in STORE. */
+static APR_INLINE record_header_t *
+get_header(svn_cache__disk_t *store,
+           apr_size_t offset)
+{
+  return (record_header_t *)(store->base + offset);
+}
+
+/* Return the number of bytes that the record described by HEADER
+ * occupies in the file, including padding. */
+static APR_INLINE apr_size_t
+record_size(const record_header_t *header)
+{
+  return ALIGN_RECORD(sizeof(*header)
+                      + (apr_size_t)header->key_len
+                      + (apr_size_t)header->data_len);
+}
+
+/* Return the checksum to store in HEADER for the KEY_LEN bytes at KEY
+ * and the DATA_LEN bytes at DATA.  HEADER->CHECKSUM is ignored. */
+static apr_uint32_t
+record_checksum(const record_header_t *header,
+                const void *key,
+                const void *data,
+                apr_pool_t *scratch_pool)
+{
+  record_header_t copy = *header;
+  svn_fnv1a_32__context_t *context = svn_fnv1a_32__context_create(scratch_pool);
+
+  copy.magic = RECORD_MAGIC;
+  copy.checksum = 0;
+  svn_fnv1a_32__update(context, &copy, sizeof(copy));
+  svn_fnv1a_32__update(context, key, header->key_len);
+  svn_fnv1a_32__update(context, data, header->data_len);
+
+  return svn_fnv1a_32__finalize(context);
+}
+
+/* Return TRUE, if the data at OFFSET in STORE looks like a live or dead
+ * record that fits into the file.  Only if VERIFY is set, check that its
+ * checksum matches as well.  Use SCRATCH_POOL for temporaries. */
+static svn_boolean_t
+is_record(svn_cache__disk_t *store,
+          apr_size_t offset,
+          svn_boolean_t verify,
+          apr_pool_t *scratch_pool)
+{
+  const record_header_t *header = get_header(store, offset);
+  const char *key = (const char *)(header + 1);
+
+  if (   (header->magic != RECORD_MAGIC && header->magic != DEAD_RECORD_MAGIC)
+      || header->key_len > store->size
+      || header->data_len > store->size
+      || record_size(header) > store->size - offset)
+    return FALSE;
+
+  return !verify
+      || header->checksum == record_checksum(header, key,
+                                             key + header->key_len,
+                                             scratch_pool);
+}
+
+/* Remove the index entry for the record at OFFSET in STORE, if the index
+ * points to it.  Return TRUE if an entry has been removed. */
+static svn_boolean_t
+drop_index_entry(svn_cache__disk_t *store,
+                 apr_size_t offset)
+{
+  record_header_t *header = get_header(store, offset);
+  const char *key = (const char *)(header + 1);
+  index_entry_t *entry = apr_hash_get(store->index, key, header->key_len);
+
+  if (entry == NULL || entry->offset != offset)
+    return FALSE;
+
+  apr_hash_set(store->index, key, header->key_len, NULL);
+  store->used_size -= entry->size;
+
+  entry->next = store->free_entries;
+  store->free_entries = entry;
+
+  return TRUE;
+}
+
+/* Make the record at OFFSET in STORE the one that the index returns for
+ * its key.  Any other record with the same key will be invalidated. */
+static void
+set_index_entry(svn_cache__disk_t *store,
+                apr_size_t offset)
+{
+  record_header_t *header = get_header(store, offset);
+  const char *key = (const char *)(header + 1);
+  index_entry_t *entry = apr_hash_get(store->index, key, header->key_len);
+
+  if (entry)
+    {
+      /* Never let an old version of the item re-surface. */
+      record_header_t *old_header = get_header(store, entry->offset);
+      store->used_size -= entry->size;
+      old_header->magic = DEAD_RECORD_MAGIC;
+
+      /* The old key may get overwritten, so update the hash key as well. */
+      apr_hash_set(store->index, key, header->key_len, NULL);
+    }
+  else if (store->free_entries)
+    {
+      entry = store->free_entries;
+      store->free_entries = entry->next;
+    }
+  else
+    {
+      entry = apr_palloc(store->pool, sizeof(*entry));
+    }
+
+  entry->offset = offset;
+  entry->size = record_size(header);
+  apr_hash_set(store->index, key, header->key_len, entry);
+  store->used_size += entry->size;
+}
+
+/* Remove all records from the index of STORE that overlap with the
+ * section up to END, starting at the current eviction position.
+ * Use SCRATCH_POOL for temporaries. */
+static void
+evict_until(svn_cache__disk_t *store,
+            apr_size_t end,
+            apr_pool_t *scratch_pool)
+{
+  while (store->evict_pos < end)
+    {
+      /* Item data may contain anything.  So, verify the checksum unless
+       * we know that we are at a record boundary. */
+      if (is_record(store, store->evict_pos, !store->evict_synced,
+                    scratch_pool))
+        {
+          apr_size_t size = record_size(get_header(store, store->evict_pos));
+          drop_index_entry(store, store->evict_pos);
+          store->evict_pos += size;
+          store->evict_synced = TRUE;
+        }
+      else
+        {
+          store->evict_pos += RECORD_ALIGNMENT;
+          store->evict_synced = FALSE;
+        }
+    }
+}
+
+/* Store the write position and sequence number of STORE in its file
+ * header. */
+static void
+write_file_header(svn_cache__disk_t *store)
+{
+  file_header_t *file_header = (file_header_t *)store->base;
+
+  file_header->write_pos = store->write_pos;
+  file_header->next_sequence = store->next_sequence;
+}
+
+/* Scan the contents of STORE and fill its index with all valid records.
+ * Set the write position to behind the latest record.  Use SCRATCH_POOL
+ * for temporary allocations. */
+static void
+rebuild_index(svn_cache__disk_t *store,
+              apr_pool_t *scratch_pool)
+{
+  const file_header_t *file_header = (const file_header_t *)store->base;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_size_t offset = FILE_HEADER_SIZE;
+  apr_uint64_t latest = 0;
+
+  /* Only if the file header looks sane, we may rely on the records in
+   * front of the write position to form a gap-less chain. */
+  apr_size_t last_write_pos = (apr_size_t)file_header->write_pos;
+  svn_boolean_t trusted
+    =    file_header->next_sequence > 0
+      && file_header->write_pos >= FILE_HEADER_SIZE
+      && file_header->write_pos <= store->size
+      && ALIGN_RECORD(last_write_pos) == last_write_pos;
+  svn_boolean_t synced = trusted;
+
+  store->write_pos = FILE_HEADER_SIZE;
+  while (offset < store->size)
+    {
+      record_header_t *header = get_header(store, offset);
+
+      /* Behind the write position, we are in the middle of old data. */
+      if (offset == last_write_pos)
+        synced = FALSE;
+
+      svn_pool_clear(iterpool);
+      if (is_record(store, offset, !synced, iterpool))
+        {
+          const char *key = (const char *)(header + 1);
+          apr_size_t end = offset + record_size(header);
+          index_entry_t *entry = apr_hash_get(store->index, key,
+                                              header->key_len);
+
+          /* Only the latest version of any item is valid.  Dead records
+           * still count for determining the write position, though. */
+          if (header->magic == DEAD_RECORD_MAGIC)
+            ;
+          else if (entry && get_header(store, entry->offset)->sequence
+                            > header->sequence)
+            header->magic = DEAD_RECORD_MAGIC;
+          else
+            set_index_entry(store, offset);
+
+          if (header->sequence >= latest)
+            {
+              latest = header->sequence;
+              store->write_pos = end;
+            }
+
+          /* The next record follows immediately, unless this one crosses
+           * the write position. */
+          synced = trusted && !(offset < last_write_pos
+                                && end > last_write_pos);
+          offset = end;
+        }
+      else
+        {
+          offset += RECORD_ALIGNMENT;
+          synced = FALSE;
+        }
+    }
+
+  /* Records written after the file header has last been updated take
+   * precedence. */
+  if (trusted && file_header->next_sequence > latest)
+    {
+      store->write_pos = last_write_pos;
+      store->next_sequence = file_header->next_sequence;
+    }
+  else
+    {
+      store->next_sequence = latest + 1;
+    }
+
+  store->evict_pos = store->write_pos;
+  store->evict_synced = FALSE;
+  write_file_header(store);
+  svn_pool_destroy(iterpool);
+}
+
+/* Write the file header ID identifying a store of SIZE bytes that has
+ * been created by this version of Subversion into BUFFER. */
+static void
+format_file_header(char buffer[FILE_ID_SIZE],
+                   apr_size_t size)
+{
+  /* Serialized items depend on the struct layouts of this build. */
+  memset(buffer, 0, FILE_ID_SIZE);
+  apr_snprintf(buffer, FILE_ID_SIZE,
+               "SVN disk cache %s %d %" APR_SIZE_T_FMT "\n",
+               SVN_VER_NUMBER, (int)APR_SIZEOF_VOIDP, size);
+}
+
+/* Open the store file at PATH with SIZE bytes, lock it and map it into
+ * memory.  Discard any contents that were not written by us.  Return
+ * the new object in *STORE, allocated in RESULT_POOL.  If the file can't
+ * be locked, e.g. because another process uses it, set *STORE to NULL. */
+static svn_error_t *
+open_store(svn_cache__disk_t **store,
+           const char *path,
+           apr_size_t size,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+#if APR_HAS_MMAP
+  svn_cache__disk_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  char file_id[FILE_ID_SIZE];
+  apr_file_t *file;
+  apr_finfo_t finfo;
+  apr_mmap_t *mmap;
+  apr_status_t status;
+
+  SVN_ERR(svn_io_file_open(&file, path,
+                           APR_READ | APR_WRITE | APR_CREATE | APR_BINARY,
+                           APR_OS_DEFAULT, result_pool));
+
+  /* Keep other processes out.  They would not see our index updates.
+   * If some other process got here first, it owns the store until it
+   * terminates.  Being a cache, we will simply do without it. */
+  status = apr_file_lock(file, APR_FLOCK_EXCLUSIVE | APR_FLOCK_NONBLOCK);
+  if (status)
+    {
+      SVN_ERR(svn_io_file_close(file, scratch_pool));
+      *store = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Start from scratch if the file has been created with different
+   * parameters. */
+  format_file_header(file_id, size);
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, file, scratch_pool));
+  if (finfo.size != (apr_off_t)size)
+    {
+      SVN_ERR(svn_io_file_trunc(file, 0, scratch_pool));
+      SVN_ERR(svn_io_file_trunc(file, size, scratch_pool));
+    }
+
+  status = apr_mmap_create(&mmap, file, 0, size,
+                           APR_MMAP_READ | APR_MMAP_WRITE, result_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't map disk cache '%s'"),
+                              svn_dirent_local_style(path, scratch_pool));
+
+  result->path = apr_pstrdup(result_pool, path);
+  result->base = mmap->mm;
+  result->size = size;
+  result->index = svn_hash__make(result_pool);
+  result->pool = result_pool;
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, result_pool));
+
+  if (memcmp(result->base, file_id, FILE_ID_SIZE))
+    {
+      memset(result->base, 0, size);
+      memcpy(result->base, file_id, FILE_ID_SIZE);
+    }
+
+  rebuild_index(result, scratch_pool);
+
+  *store = result;
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Disk caches require memory-mapped files"));
+#endif
+}
+
+/* All stores opened by this process, mapping the absolute path to the
+ * svn_cache__disk_t *.  Only access under REGISTRY_MUTEX. */
+static apr_hash_t *registry = NULL;
+static svn_mutex__t *registry_mutex = NULL;
+static svn_atomic_t registry_initialized = 0;
+
+/* Implements svn_atomic__init_once's callback.  Create the REGISTRY. */
+static svn_error_t *
+initialize_registry(void *baton,
+                    apr_pool_t *unused_pool)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  registry = svn_hash__make(pool);
+  SVN_ERR(svn_mutex__init(&registry_mutex, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Lookup or create the store at ABSPATH, see svn_cache__open_disk_store.
+ * To be called with REGISTRY_MUTEX being held. */
+static svn_error_t *
+open_registered_store(svn_cache__disk_t **store,
+                      const char *abspath,
+                      apr_uint64_t size,
+                      apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool;
+  svn_error_t *err;
+
+  *store = svn_hash_gets(registry, abspath);
+  if (*store)
+    return SVN_NO_ERROR;
+
+  /* Limit the size to what we can map into memory. */
+  size = MIN(size, (apr_uint64_t)SVN_MAX_OBJECT_SIZE / 2);
+  size = MAX(size, MIN_STORE_SIZE);
+  size = ALIGN_RECORD((apr_size_t)size);
+
+  /* Stores are never closed.  Use a separate root pool for each store
+   * to not waste memory in case of failures. */
+  pool = svn_pool_create(NULL);
+  err = open_store(store, abspath, (apr_size_t)size, pool, scratch_pool);
+  if (err || *store == NULL)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  svn_hash_sets(registry, (*store)->path, *store);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__open_disk_store(svn_cache__disk_t **store,
+                           const char *path,
+                           apr_uint64_t size,
+                           apr_pool_t *scratch_pool)
+{
+  const char *abspath;
+
+  SVN_ERR(svn_dirent_get_absolute(&abspath, path, scratch_pool));
+  SVN_ERR(svn_atomic__init_once(&registry_initialized, initialize_registry,
+                                NULL, scratch_pool));
+  SVN_MUTEX__WITH_LOCK(registry_mutex,
+                       open_registered_store(store, abspath, size,
+                                             scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DATA to a copy of the item stored under the KEY_LEN bytes of KEY
+ * in STORE and *SIZE to its length.  Allocate it in RESULT_POOL.  Set
+ * *DATA to NULL if there is no such item.  To be called with the mutex
+ * of STORE being held. */
+static svn_error_t *
+store_get(void **data,
+          apr_size_t *size,
+          svn_cache__disk_t *store,
+          const void *key,
+          apr_size_t key_len,
+          apr_pool_t *result_pool)
+{
+  index_entry_t *entry = apr_hash_get(store->index, key, key_len);
+  record_header_t *header = entry ? get_header(store, entry->offset) : NULL;
+
+  /* The index has been built from unverified record headers.  Make sure
+   * the record is intact before handing out its contents. */
+  if (header
+      && (   header->magic != RECORD_MAGIC
+          || header->key_len != key_len
+          || record_size(header) != entry->size
+          || header->checksum != record_checksum(header, header + 1,
+                                                 (const char *)(header + 1)
+                                                   + key_len,
+                                                 result_pool)))
+    {
+      apr_hash_set(store->index, key, key_len, NULL);
+      store->used_size -= entry->size;
+
+      entry->next = store->free_entries;
+      store->free_entries = entry;
+      header = NULL;
+    }
+
+  if (header)
+    {
+      *size = header->data_len;
+      *data = apr_pmemdup(result_pool,
+                          (const char *)(header + 1) + header->key_len,
+                          header->data_len);
+    }
+  else
+    {
+      *data = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the DATA_LEN bytes of DATA under the KEY_LEN bytes of KEY in
+ * STORE, replacing any previous version.  Items larger than 1/8th of the
+ * store will be ignored.  To be called with the mutex of STORE being held.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+store_set(svn_cache__disk_t *store,
+          const void *key,
+          apr_size_t key_len,
+          const void *data,
+          apr_size_t data_len,
+          apr_pool_t *scratch_pool)
+{
+  record_header_t header;
+  record_header_t *target;
+  apr_size_t size = ALIGN_RECORD(sizeof(header) + key_len + data_len);
+
+  if (size > (store->size - FILE_HEADER_SIZE) / 8)
+    return SVN_NO_ERROR;
+
+  /* Wrap around at the end of the file.  The first record always starts
+   * right behind the file header. */
+  if (size > store->size - store->write_pos)
+    {
+      store->write_pos = FILE_HEADER_SIZE;
+      store->evict_pos = FILE_HEADER_SIZE;
+      store->evict_synced = TRUE;
+    }
+
+  evict_until(store, store->write_pos + size, scratch_pool);
+
+  header.magic = RECORD_MAGIC;
+  header.checksum = 0;
+  header.key_len = (apr_uint32_t)key_len;
+  header.data_len = (apr_uint32_t)data_len;
+  header.sequence = store->next_sequence++;
+  header.checksum = record_checksum(&header, key, data, scratch_pool);
+
+  /* Write the header last, such that a partially written record will not
+   * be considered valid. */
+  target = get_header(store, store->write_pos);
+  target->magic = 0;
+  memcpy(target + 1, key, key_len);
+  memcpy((char *)(target + 1) + key_len, data, data_len);
+  *target = header;
+
+  set_index_entry(store, store->write_pos);
+  store->write_pos += size;
+  write_file_header(store);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the item stored under the KEY_LEN bytes of KEY from STORE.
+ * To be called with the mutex of STORE being held. */
+static svn_error_t *
+store_remove(svn_cache__disk_t *store,
+             const void *key,
+             apr_size_t key_len)
+{
+  index_entry_t *entry = apr_hash_get(store->index, key, key_len);
+  if (entry)
+    {
+      apr_size_t offset = entry->offset;
+      drop_index_entry(store, offset);
+      get_header(store, offset)->magic = DEAD_RECORD_MAGIC;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FOUND to TRUE if the KEY_LEN bytes of KEY are in STORE.
+ * To be called with the mutex of STORE being held. */
+static svn_error_t *
+store_contains(svn_boolean_t *found,
+               svn_cache__disk_t *store,
+               const void *key,
+               apr_size_t key_len)
+{
+  *found = apr_hash_get(store->index, key, key_len) != NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Add the size info of STORE to INFO.
+ * To be called with the mutex of STORE being held. */
+static svn_error_t *
+store_get_info(svn_cache__info_t *info,
+               svn_cache__disk_t *store)
+{
+  info->l2_used_size = store->used_size;
+  info->l2_total_size = store->size;
+  return SVN_NO_ERROR;
+}
+
+
+/* The (internal) cache object of a first-level cache backed by a store. */
+typedef struct disk_tier_t
+{
+  /* The first level cache.  All requests go there first. */
+  svn_cache__t *memory;
+
+  /* The second level. */
+  svn_cache__disk_t *store;
+
+  /* Prefix to put in front of all keys in STORE. */
+  const char *prefix;
+  apr_size_t prefix_len;
+
+  /* The size of the key: either a fixed number of bytes or
+   * APR_HASH_KEY_STRING. */
+  apr_ssize_t klen;
+
+  /* Used to marshal values in and out of the store. */
+  svn_cache__serialize_func_t serialize_func;
+  svn_cache__deserialize_func_t deserialize_func;
+
+  /* Number of lookups that missed the first level.
+   * Purely statistical information; updates are not synchronized. */
+  apr_uint64_t l2_gets;
+
+  /* Number of those lookups that were found in the second level. */
+  apr_uint64_t l2_hits;
+} disk_tier_t;
+
+/* Return the key under which to store KEY of CACHE in its store.
+ * Allocate it in RESULT_POOL. */
+static svn_stringbuf_t *
+build_key(disk_tier_t *cache,
+          const void *key,
+          apr_pool_t *result_pool)
+{
+  apr_size_t key_len = cache->klen == APR_HASH_KEY_STRING
+                     ? strlen(key)
+                     : (apr_size_t)cache->klen;
+  svn_stringbuf_t *result
+    = svn_stringbuf_create_ensure(cache->prefix_len + key_len, result_pool);
+
+  svn_stringbuf_appendbytes(result, cache->prefix, cache->prefix_len);
+  svn_stringbuf_appendbytes(result, key, key_len);
+
+  return result;
+}
+
+/* Look up KEY of CACHE in its store.  Return the serialized item in
+ * *DATA and its size in *SIZE, both allocated in RESULT_POOL.  Set *DATA
+ * to NULL if it could not be found. */
+static svn_error_t *
+disk_get_raw(void **data,
+             apr_size_t *size,
+             disk_tier_t *cache,
+             const void *key,
+             apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *full_key = build_key(cache, key, result_pool);
+
+  cache->l2_gets++;
+  SVN_MUTEX__WITH_LOCK(cache->store->mutex,
+                       store_get(data, size, cache->store,
+                                 full_key->data, full_key->len,
+                                 result_pool));
+  if (*data)
+    cache->l2_hits++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Serialize VALUE and write it under KEY of CACHE to its store.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+disk_set(disk_tier_t *cache,
+         const void *key,
+         void *value,
+         apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *full_key = build_key(cache, key, scratch_pool);
+  void *data;
+  apr_size_t data_len;
+
+  if (cache->serialize_func)
+    {
+      SVN_ERR(cache->serialize_func(&data, &data_len, value, scratch_pool));
+    }
+  else
+    {
+      svn_stringbuf_t *value_str = value;
+      data = value_str->data;
+      data_len = value_str->len + 1; /* copy trailing NUL */
+    }
+
+  SVN_MUTEX__WITH_LOCK(cache->store->mutex,
+                       store_set(cache->store, full_key->data, full_key->len,
+                                 data, data_len, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Deserialize the SIZE bytes of DATA read from the store of CACHE into
+ * *VALUE_P, allocated in RESULT_POOL.  DATA may get modified. */
+static svn_error_t *
+deserialize(void **value_p,
+            disk_tier_t *cache,
+            void *data,
+            apr_size_t size,
+            apr_pool_t *result_pool)
+{
+  if (cache->deserialize_func)
+    return svn_error_trace(cache->deserialize_func(value_p, data, size,
+                                                   result_pool));
+
+  *value_p = svn_stringbuf_ncreate(data, size - 1, result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Put the SIZE bytes of serialized DATA found in the store of CACHE under
+ * KEY into the first level as well.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+promote(disk_tier_t *cache,
+        const void *key,
+        const void *data,
+        apr_size_t size,
+        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *subpool;
+  void *value;
+
+  if (!svn_cache__is_cachable(cache->memory, size))
+    return SVN_NO_ERROR;
+
+  /* The deserializers work in-place, so use a copy of DATA. */
+  subpool = svn_pool_create(scratch_pool);
+  SVN_ERR(deserialize(&value, cache, apr_pmemdup(subpool, data, size), size,
+                      subpool));
+  SVN_ERR(svn_cache__set(cache->memory, key, value, subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_tier_get(void **value_p,
+              svn_boolean_t *found,
+              void *cache_void,
+              const void *key,
+              apr_pool_t *result_pool)
+{
+  disk_tier_t *cache = cache_void;
+  void *data;
+  apr_size_t size;
+
+  SVN_ERR(svn_cache__get(value_p, found, cache->memory, key, result_pool));
+  if (*found || key == NULL)
+    return SVN_NO_ERROR;
+
+  /* Deserialized values reference DATA, so allocate it in RESULT_POOL. */
+  SVN_ERR(disk_get_raw(&data, &size, cache, key, result_pool));
+  if (data)
+    {
+      SVN_ERR(promote(cache, key, data, size, result_pool));
+      SVN_ERR(deserialize(value_p, cache, data, size, result_pool));
+      *found = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_tier_has_key(svn_boolean_t *found,
+                  void *cache_void,
+                  const void *key,
+                  apr_pool_t *scratch_pool)
+{
+  disk_tier_t *cache = cache_void;
+
+  SVN_ERR(svn_cache__has_key(found, cache->memory, key, scratch_pool));
+  if (!*found && key != NULL)
+    {
+      svn_stringbuf_t *full_key = build_key(cache, key, scratch_pool);
+
+      SVN_MUTEX__WITH_LOCK(cache->store->mutex,
+                           store_contains(found, cache->store,
+                                          full_key->data, full_key->len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_tier_set(void *cache_void,
+              const void *key,
+              void *value,
+              apr_pool_t *scratch_pool)
+{
+  disk_tier_t *cache = cache_void;
+  apr_pool_t *subpool;
+
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_cache__set(cache->memory, key, value, scratch_pool));
+
+  subpool = svn_pool_create(scratch_pool);
+  SVN_ERR(disk_set(cache, key, value, subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_tier_iter(svn_boolean_t *completed,
+               void *cache_void,
+               svn_iter_apr_hash_cb_t user_cb,
+               void *user_baton,
+               apr_pool_t *scratch_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Can't iterate a disk-backed cache"));
+}
+
+static svn_boolean_t
+disk_tier_is_cachable(void *cache_void,
+                      apr_size_t size)
+{
+  disk_tier_t *cache = cache_void;
+
+  /* Items too large for the first level will not be stored at all. */
+  return svn_cache__is_cachable(cache->memory, size);
+}
+
+static svn_error_t *
+disk_tier_get_partial(void **value_p,
+                      svn_boolean_t *found,
+                      void *cache_void,
+                      const void *key,
+                      svn_cache__partial_getter_func_t func,
+                      void *baton,
+                      apr_pool_t *result_pool)
+{
+  disk_tier_t *cache = cache_void;
+  apr_pool_t *scratch_pool;
+  void *data;
+  apr_size_t size;
+
+  SVN_ERR(svn_cache__get_partial(value_p, found, cache->memory, key, func,
+                                 baton, result_pool));
+  if (*found || key == NULL)
+    return SVN_NO_ERROR;
+
+  scratch_pool = svn_pool_create(result_pool);
+  SVN_ERR(disk_get_raw(&data, &size, cache, key, scratch_pool));
+  if (data)
+    {
+      SVN_ERR(func(value_p, data, size, baton, result_pool));
+      SVN_ERR(promote(cache, key, data, size, scratch_pool));
+      *found = TRUE;
+    }
+
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_tier_set_partial(void *cache_void,
+                      const void *key,
+                      svn_cache__partial_setter_func_t func,
+                      void *baton,
+                      apr_pool_t *scratch_pool)
+{
+  disk_tier_t *cache = cache_void;
+  svn_stringbuf_t *full_key;
+
+  if (key == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_cache__set_partial(cache->memory, key, func, baton,
+                                 scratch_pool));
+
+  /* The stored version is outdated now.  Drop it. */
+  full_key = build_key(cache, key, scratch_pool);
+  SVN_MUTEX__WITH_LOCK(cache->store->mutex,
+                       store_remove(cache->store, full_key->data,
+                                    full_key->len));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+disk_tier_get_info(void *cache_void,
+                   svn_cache__info_t *info,
+                   svn_boolean_t reset,
+                   apr_pool_t *result_pool)
+{
+  disk_tier_t *cache = cache_void;
+  svn_cache__t *memory = cache->memory;
+
+  /* Report the memory usage of the first level but keep our own
+   * access statistics. */
+  SVN_ERR(memory->vtable->get_info(memory->cache_internal, info, reset,
+                                   result_pool));
+
+  info->l2_gets = cache->l2_gets;
+  info->l2_hits = cache->l2_hits;
+  SVN_MUTEX__WITH_LOCK(cache->store->mutex,
+                       store_get_info(info, cache->store));
+
+  if (reset)
+    {
+      cache->l2_gets = 0;
+      cache->l2_hits = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_cache__vtable_t disk_tier_vtable = {
+  disk_tier_get,
+  disk_tier_has_key,
+  disk_tier_set,
+  disk_tier_iter,
+  disk_tier_is_cachable,
+  disk_tier_get_partial,
+  disk_tier_set_partial,
+  disk_tier_get_info
+};
+
+svn_error_t *
+svn_cache__create_disk_tier(svn_cache__t **cache_p,
+                            svn_cache__t *memory,
+                            svn_cache__disk_t *store,
+                            svn_cache__serialize_func_t serialize_func,
+                            svn_cache__deserialize_func_t deserialize_func,
+                            apr_ssize_t klen,
+                            const char *prefix,
+                            apr_pool_t *result_pool)
+{
+  svn_cache__t *wrapper = apr_pcalloc(result_pool, sizeof(*wrapper));
+  disk_tier_t *cache = apr_pcalloc(result_pool, sizeof(*cache));
+
+  cache->memory = memory;
+  cache->store = store;
+  cache->prefix = apr_pstrdup(result_pool, prefix);
+  cache->prefix_len = strlen(prefix);
+  cache->klen = klen;
+  cache->serialize_func = serialize_func;
+  cache->deserialize_func = deserialize_func;
+
+  wrapper->vtable = &disk_tier_vtable;
+  wrapper->cache_internal = cache;
+  wrapper->error_handler = 0;
+  wrapper->error_baton = 0;
+  wrapper->pretend_empty = !!getenv("SVN_X_DOES_NOT_MARK_THE_SPOT");
+
+  *cache_p = wrapper;
+  return SVN_NO_ERROR;
+}
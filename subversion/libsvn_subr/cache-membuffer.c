@@ -24,6 +24,8 @@
 #include <assert.h>
 #include <apr_md5.h>
 #include <apr_thread_rwlock.h>
+#include <apr_shm.h>
+#include <apr_global_mutex.h>
 
 #include "svn_pools.h"
 #include "svn_checksum.h"
@@ -106,6 +108,17 @@
  * with new entries. For details on the fine-tuning involved, see the
  * comments in ensure_data_insertable_l2().
  *
+ * However, hit counters only exist for cached items.  A long scan over
+ * many items that are each read only once will therefore still replace
+ * a large part of L2 over time.  The "tinylfu" policy addresses that by
+ * keeping a count-min sketch of recent requests per segment (TinyLFU).
+ * Requests are counted no matter whether the item was in cache or not,
+ * and the counters get halved periodically to forget old history.  L1
+ * then acts as the admission window and all L2 decisions as well as the
+ * victim selection in overflowing groups are based on the sketch's
+ * frequency estimates instead of the hit counters.  Items from a scan
+ * will only be seen once and will hardly ever displace hot items.
+ *
  * Due to the randomized mapping of keys to entry groups, some groups may
  * overflow.  In that case, there are spare groups that can be chained to
  * an already used group to extend it.
@@ -129,6 +142,23 @@
  * to scale well despite that bottleneck, we simply segment the cache into
  * a number of independent caches (segments). Items will be multiplexed based
  * on their hash key.
+ *
+ * Within each segment, the lock is striped: Every entry group is associated
+ * with one of several lock stripes.  Readers only need to acquire the lock
+ * of the stripe that covers the group they access.  Writers may modify any
+ * part of the segment and, therefore, acquire all stripes.  Since cache
+ * hits by far outnumber modifications in a server, concurrent readers will
+ * rarely contend for the same lock.  The hit statistics are kept per stripe
+ * as well and only get summed up when requested.
+ *
+ * A cache may also be "process-shared".  Then all its mutable state,
+ * including the segment headers and the prefix pool contents, lives in an
+ * anonymous shared memory region and is protected by process-shared
+ * locks.  Because child processes inherit that region at the same address,
+ * all pointers remain valid and every process forked after the creation
+ * of the cache will see the same contents.  Process-local data, such as
+ * the prefix lookup hash, is kept in the creating process' memory and
+ * gets duplicated (copy-on-write) by fork().
  */
 
 /* APR's read-write lock implementation on Windows is horribly inefficient.
@@ -146,6 +176,25 @@
 #  define USE_SIMPLE_MUTEX 0
 #endif
 
+/* Process-shared caches can only be inherited through fork() and require
+ * shared memory support.
+ */
+#if APR_HAS_SHARED_MEMORY && APR_HAS_FORK
+#  define SUPPORT_SHARED_MEMBUFFER 1
+#else
+#  define SUPPORT_SHARED_MEMBUFFER 0
+#endif
+
+/* Lock mechanism to use for process-shared caches.  Prefer ones that
+ * don't need to be re-opened in the child processes and that live in
+ * the shared memory themselves.
+ */
+#if APR_HAS_PROC_PTHREAD_SERIALIZE
+#  define SHARED_LOCK_MECH APR_LOCK_PROC_PTHREAD
+#else
+#  define SHARED_LOCK_MECH APR_LOCK_DEFAULT
+#endif
+
 /* For more efficient copy operations, let's align all data items properly.
  * Since we can't portably align pointers, this is rather the item size
  * granularity which ensures *relative* alignment within the cache - still
@@ -155,6 +204,10 @@
  */
 #define ITEM_ALIGNMENT 16
 
+/* Align integer VALUE to the next ITEM_ALIGNMENT boundary.
+ */
+#define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
+
 /* By default, don't create cache segments smaller than this value unless
  * the total cache size itself is smaller.
  */
@@ -177,6 +230,41 @@
  */
 #define MAX_SEGMENT_SIZE APR_UINT64_C(0xffff0000)
 
+/* Maximum number of lock stripes per cache segment.  Writers have to
+ * acquire all of them, so this should not be too large.  Must be a power
+ * of 2.
+ */
+#define MAX_LOCK_STRIPES 16
+
+/* For thread-safe caches, try to provide at least that many lock stripes
+ * in total, i.e. summed over all segments.  Must be a power of 2.
+ */
+#define MIN_TOTAL_LOCK_STRIPES 64
+
+/* Lock stripes are aligned to this many bytes, i.e. they are placed in
+ * separate CPU cache lines.  Must be a power of 2.
+ */
+#define STRIPE_BLOCK_SIZE 64
+
+/* Number of counters per key in the frequency sketch (policy "tinylfu").
+ */
+#define SKETCH_DEPTH 4
+
+/* Frequency sketch counters saturate at this value.  Keeping it small
+ * allows the sketch to adapt quickly to changing access patterns.
+ */
+#define SKETCH_MAX_COUNT 15
+
+/* Halve all frequency sketch counters after this many requests per
+ * counter.
+ */
+#define SKETCH_SAMPLE_FACTOR 10
+
+/* Upper limit for the number of sketch counters per segment.  Must be a
+ * power of 2 and small enough to not overflow the sample counter.
+ */
+#define MAX_SKETCH_SIZE 0x1000000
+
 /* We don't mark the initialization status for every group but initialize
  * a number of groups at once. That will allow for a very small init flags
  * vector that is likely to fit into the CPU caches even for fairly large
@@ -240,15 +328,157 @@ typedef struct full_key_t
   svn_membuf_t full_key;
 } full_key_t;
 
+/* A region of memory from which we allocate sequentially and that will
+ * never be freed.  Used to carve all data structures of process-shared
+ * caches out of a single shared memory block.
+ */
+typedef struct shared_region_t
+{
+  /* Next unused byte in the region. */
+  char *next;
+
+  /* First byte behind the region. */
+  char *end;
+} shared_region_t;
+
+/* Return SIZE bytes from REGION, rounded up to ITEM_ALIGNMENT.  Shared
+ * memory is always zero-initialized.  If REGION is NULL, allocate from
+ * POOL instead and clear the memory only if CLEAR is set.
+ *
+ * Return NULL if the memory could not be allocated.
+ */
+static void *
+region_alloc(shared_region_t *region,
+             apr_size_t size,
+             svn_boolean_t clear,
+             apr_pool_t *pool)
+{
+  void *result;
+
+  if (region == NULL)
+    return clear ? apr_pcalloc(pool, size) : apr_palloc(pool, size);
+
+  size = ALIGN_VALUE(size);
+  if ((apr_size_t)(region->end - region->next) < size)
+    return NULL;
+
+  result = region->next;
+  region->next += size;
+
+  return result;
+}
+
+#if SUPPORT_SHARED_MEMBUFFER
+
+/* Set *REGION to a new anonymous shared memory block of SIZE bytes.  The
+ * block will be inherited by all processes forked later on and remain
+ * valid until POOL gets cleaned up.
+ */
+static svn_error_t *
+create_shared_region(shared_region_t *region,
+                     apr_size_t size,
+                     apr_pool_t *pool)
+{
+  apr_shm_t *shm;
+  apr_status_t status = apr_shm_create(&shm, size, NULL, pool);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't create shared memory for cache"));
+
+  region->next = apr_shm_baseaddr_get(shm);
+  region->end = region->next + apr_shm_size_get(shm);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MUTEX to a new lock that serializes access across all threads in
+ * all processes forked after this call.  Allocate it in POOL.
+ *
+ * The lock handle itself lives in POOL as well, i.e. in process-local
+ * memory.  Shared data structures only store the address of that handle,
+ * which is valid in every forked child but refers to the child's private
+ * copy of it.  Thus, each child may re-initialize its handle without
+ * affecting the other processes.  See child_init_shared_mutex().
+ */
+static svn_error_t *
+create_shared_mutex(apr_global_mutex_t ***mutex,
+                    apr_pool_t *pool)
+{
+  apr_status_t status;
+
+  *mutex = apr_pcalloc(pool, sizeof(**mutex));
+  status = apr_global_mutex_create(*mutex, NULL, SHARED_LOCK_MECH, pool);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't create process-shared cache lock"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Re-attach the lock handle *MUTEX, created by create_shared_mutex() in
+ * the parent process, to the current child process.  Mechanisms other
+ * than process-shared pthread mutexes may require this before the lock
+ * can be used in the child.  Allocate the new handle in POOL.
+ */
+static svn_error_t *
+child_init_shared_mutex(apr_global_mutex_t **mutex,
+                        apr_pool_t *pool)
+{
+  apr_status_t status
+    = apr_global_mutex_child_init(mutex, apr_global_mutex_lockfile(*mutex),
+                                  pool);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't re-initialize process-shared cache "
+                                "lock"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Acquire the lock referenced by the process-local handle MUTEX. */
+static svn_error_t *
+lock_shared_mutex(apr_global_mutex_t **mutex)
+{
+  apr_status_t status = apr_global_mutex_lock(*mutex);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't lock cache mutex"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Release the lock referenced by the process-local handle MUTEX.
+ * Return ERR upon success. */
+static svn_error_t *
+unlock_shared_mutex(apr_global_mutex_t **mutex,
+                    svn_error_t *err)
+{
+  apr_status_t status = apr_global_mutex_unlock(*mutex);
+  if (status && !err)
+    return svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
+
+  return err;
+}
+
+#endif /* SUPPORT_SHARED_MEMBUFFER */
+
 /* A limited capacity, thread-safe pool of unique C strings.  Operations on
  * this data structure are defined by prefix_pool_* functions.  The only
  * "public" member is VALUES (r/o access only).
+ *
+ * For process-shared caches, this structure itself, VALUES and all the
+ * strings live in shared memory.  MAP and MAPPED are process-local.
  */
 typedef struct prefix_pool_t
 {
-  /* Map C string to a pointer into VALUES with the same contents. */
+  /* Map C string to a pointer into VALUES with the same contents.
+   * Only covers the first *MAPPED entries of VALUES. */
   apr_hash_t *map;
 
+  /* Number of entries in VALUES that have been added to MAP in this
+   * process.  Other processes may have added more entries to a shared
+   * prefix pool, i.e. this may be smaller than VALUES_USED. */
+  apr_uint32_t *mapped;
+
   /* Pointer to an array of strings. These are the contents of this pool
    * and each one of them is referenced by MAP.  Valid indexes are 0 to
    * VALUES_USED - 1.  May be NULL if VALUES_MAX is 0. */
@@ -267,18 +497,31 @@ typedef struct prefix_pool_t
    * the implementation may . */
   apr_size_t bytes_used;
 
+  /* Shared memory to allocate the strings from.  NULL for process-local
+   * pools which allocate from the pool of MAP. */
+  shared_region_t *strings;
+
   /* The serialization object. */
   svn_mutex__t *mutex;
+
+#if SUPPORT_SHARED_MEMBUFFER
+  /* The process-local handle of the serialization object for
+   * process-shared pools.  If not NULL, it is being used instead of MUTEX.
+   */
+  apr_global_mutex_t **shared_mutex;
+#endif
 } prefix_pool_t;
 
 /* Set *PREFIX_POOL to a new instance that tries to limit allocation to
  * BYTES_MAX bytes.  If MUTEX_REQUIRED is set and multi-threading is
- * supported, serialize all access to the new instance.  Allocate the
- * object from *RESULT_POOL. */
+ * supported, serialize all access to the new instance.  If PROCESS_SHARED
+ * is set, place the pool contents in shared memory and serialize access
+ * across processes.  Allocate the object from *RESULT_POOL. */
 static svn_error_t *
 prefix_pool_create(prefix_pool_t **prefix_pool,
                    apr_size_t bytes_max,
                    svn_boolean_t mutex_required,
+                   svn_boolean_t process_shared,
                    apr_pool_t *result_pool)
 {
   enum
@@ -294,13 +537,50 @@ prefix_pool_create(prefix_pool_t **prefix_pool,
   apr_size_t capacity = MIN(APR_UINT32_MAX,
                             bytes_max / ESTIMATED_BYTES_PER_ENTRY);
 
+  prefix_pool_t *result;
+
+  if (process_shared)
+    {
+#if SUPPORT_SHARED_MEMBUFFER
+      /* Put the struct, the VALUES array, the string allocator and the
+       * strings themselves into a single shared memory block. */
+      shared_region_t region;
+      SVN_ERR(create_shared_region(&region,
+                                   ALIGN_VALUE(sizeof(*result))
+                                   + ALIGN_VALUE(capacity * sizeof(char *))
+                                   + ALIGN_VALUE(sizeof(shared_region_t))
+                                   + bytes_max,
+                                   result_pool));
+
+      result = region_alloc(&region, sizeof(*result), TRUE, NULL);
+      result->values = capacity
+                     ? region_alloc(&region, capacity * sizeof(const char *),
+                                    TRUE, NULL)
+                     : NULL;
+      result->strings = region_alloc(&region, sizeof(*result->strings),
+                                     TRUE, NULL);
+      *result->strings = region;
+
+      SVN_ERR(create_shared_mutex(&result->shared_mutex, result_pool));
+#else
+      return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                              _("Process-shared caches are not supported "
+                                "on this platform"));
+#endif
+    }
+  else
+    {
+      result = apr_pcalloc(result_pool, sizeof(*result));
+      result->values = capacity
+                     ? apr_pcalloc(result_pool,
+                                   capacity * sizeof(const char *))
+                     : NULL;
+    }
+
   /* Construct the result struct. */
-  prefix_pool_t *result = apr_pcalloc(result_pool, sizeof(*result));
   result->map = svn_hash__make(result_pool);
+  result->mapped = apr_pcalloc(result_pool, sizeof(*result->mapped));
 
-  result->values = capacity
-                 ? apr_pcalloc(result_pool, capacity * sizeof(const char *))
-                 : NULL;
   result->values_max = (apr_uint32_t)capacity;
   result->values_used = 0;
 
@@ -337,7 +617,15 @@ prefix_pool_get_internal(apr_uint32_t *prefix_idx,
   const char **value;
   apr_size_t prefix_len = strlen(prefix);
   apr_size_t bytes_needed;
-  apr_pool_t *pool;
+  char *copy;
+
+  /* Other processes may have added new entries to a shared pool.
+   * Make them known to our local map. */
+  while (*prefix_pool->mapped < prefix_pool->values_used)
+    {
+      value = &prefix_pool->values[(*prefix_pool->mapped)++];
+      apr_hash_set(prefix_pool->map, *value, strlen(*value), value);
+    }
 
   /* Lookup.  If we already know that prefix, return its index. */
   value = apr_hash_get(prefix_pool->map, prefix, prefix_len);
@@ -365,14 +653,22 @@ prefix_pool_get_internal(apr_uint32_t *prefix_idx,
     }
 
   /* Add new entry. */
-  pool = apr_hash_pool_get(prefix_pool->map);
+  copy = region_alloc(prefix_pool->strings, prefix_len + 1, FALSE,
+                      apr_hash_pool_get(prefix_pool->map));
+  if (copy == NULL)
+    {
+      *prefix_idx = NO_INDEX;
+      return SVN_NO_ERROR;
+    }
 
+  memcpy(copy, prefix, prefix_len + 1);
   value = &prefix_pool->values[prefix_pool->values_used];
-  *value = apr_pstrndup(pool, prefix, prefix_len + 1);
+  *value = copy;
   apr_hash_set(prefix_pool->map, *value, prefix_len, value);
 
   *prefix_idx = prefix_pool->values_used;
   ++prefix_pool->values_used;
+  ++*prefix_pool->mapped;
   prefix_pool->bytes_used += bytes_needed;
 
   return SVN_NO_ERROR;
@@ -384,6 +680,18 @@ prefix_pool_get(apr_uint32_t *prefix_idx,
                 prefix_pool_t *prefix_pool,
                 const char *prefix)
 {
+#if SUPPORT_SHARED_MEMBUFFER
+  if (prefix_pool->shared_mutex)
+    {
+      SVN_ERR(lock_shared_mutex(prefix_pool->shared_mutex));
+      return svn_error_trace(unlock_shared_mutex(
+                               prefix_pool->shared_mutex,
+                               prefix_pool_get_internal(prefix_idx,
+                                                        prefix_pool,
+                                                        prefix)));
+    }
+#endif
+
   SVN_MUTEX__WITH_LOCK(prefix_pool->mutex,
                        prefix_pool_get_internal(prefix_idx, prefix_pool,
                                                 prefix));
@@ -652,6 +960,66 @@ typedef struct entry_group_t
 
 } entry_group_t;
 
+/* Lock and statistics for a subset of the entry groups within a cache
+ * segment.
+ */
+typedef struct stripe_header_t
+{
+#if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
+  /* A lock for intra-process synchronization to the cache, or NULL if
+   * the cache's creator doesn't feel the cache needs to be
+   * thread-safe.
+   */
+  svn_mutex__t *lock;
+#elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+  /* Same for read-write lock. */
+  apr_thread_rwlock_t *lock;
+#endif
+
+#if SUPPORT_SHARED_MEMBUFFER
+  /* For process-shared caches, the lock serializing access across all
+   * processes and threads.  It replaces LOCK.  NULL otherwise.
+   * This points to a process-local handle, see create_shared_mutex().
+   */
+  apr_global_mutex_t **shared_lock;
+#endif
+
+  /* Total number of lookups in groups covered by this stripe.
+   * Purely statistical information that may be used for profiling only.
+   * Updates are not synchronized and values may be nonsensicle on some
+   * platforms.
+   */
+  apr_uint64_t reads;
+
+  /* Total number of hits in groups covered by this stripe.
+   * Purely statistical information that may be used for profiling only.
+   * Updates are not synchronized and values may be nonsensicle on some
+   * platforms.
+   */
+  apr_uint64_t hits;
+
+  /* Number of requests for groups covered by this stripe that have been
+   * recorded in the segment's frequency sketch since it has last been
+   * aged.  Counting them per stripe keeps concurrent readers of different
+   * stripes from contending for a single counter.  Readers may share a
+   * stripe, so use atomic operations for that.
+   */
+  svn_atomic_t sketch_samples;
+} stripe_header_t;
+
+/* A lock stripe padded to STRIPE_BLOCK_SIZE, such that updating the
+ * statistics of one stripe does not invalidate the CPU cache line holding
+ * another one.
+ */
+typedef struct lock_stripe_t
+{
+  /* the actual stripe data */
+  stripe_header_t header;
+
+  /* padding */
+  char padding[STRIPE_BLOCK_SIZE - sizeof(stripe_header_t)];
+} lock_stripe_t;
+
 /* Per-cache level header structure.  Instances of this are members of
  * svn_membuffer_t and will use non-overlapping sections of its DATA buffer.
  * All offset values are global / absolute to that whole buffer.
@@ -775,13 +1143,6 @@ struct svn_membuffer_t
    */
   apr_uint32_t used_entries;
 
-  /* Total number of calls to membuffer_cache_get.
-   * Purely statistical information that may be used for profiling only.
-   * Updates are not synchronized and values may be nonsensicle on some
-   * platforms.
-   */
-  apr_uint64_t total_reads;
-
   /* Total number of calls to membuffer_cache_set.
    * Purely statistical information that may be used for profiling only.
    * Updates are not synchronized and values may be nonsensicle on some
@@ -789,26 +1150,36 @@ struct svn_membuffer_t
    */
   apr_uint64_t total_writes;
 
-  /* Total number of hits since the cache's creation.
-   * Purely statistical information that may be used for profiling only.
-   * Updates are not synchronized and values may be nonsensicle on some
-   * platforms.
+  /* Number of elements in STRIPES.  Must be a power of 2.
    */
-  apr_uint64_t total_hits;
+  apr_uint32_t stripe_count;
 
-#if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
-  /* A lock for intra-process synchronization to the cache, or NULL if
-   * the cache's creator doesn't feel the cache needs to be
-   * thread-safe.
+  /* Locks and read statistics.  Group I is covered by stripe
+   * I & (STRIPE_COUNT - 1).  Never NULL.
    */
-  svn_mutex__t *lock;
-#elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  /* Same for read-write lock. */
-  apr_thread_rwlock_t *lock;
+  lock_stripe_t *stripes;
+
+  /* If set, this segment lives in shared memory and must be accessed
+   * through the SHARED_LOCK of the STRIPES only.
+   */
+  svn_boolean_t process_shared;
+
+  /* Frequency sketch used by the "tinylfu" policy, SKETCH_MASK + 1
+   * counters.  NULL for all other policies.  Counters are incremented
+   * under the read lock, so use atomic operations for that.
+   */
+  svn_atomic_t *sketch;
+
+  /* Number of elements in SKETCH minus one.  SKETCH's size is a power
+   * of 2.  The number of requests recorded in it is being kept in the
+   * STRIPES.
+   */
+  apr_uint32_t sketch_mask;
 
+#if (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
   /* If set, write access will wait until they get exclusive access.
    * Otherwise, they will become no-ops if the segment is currently
-   * read-locked.  Only used when LOCK is an r/w lock.
+   * read-locked.  Only used when the stripe locks are r/w locks.
    */
   svn_boolean_t allow_blocking_writes;
 #endif
@@ -819,21 +1190,34 @@ struct svn_membuffer_t
   svn_atomic_t write_lock_count;
 };
 
-/* Align integer VALUE to the next ITEM_ALIGNMENT boundary.
+/* Return the lock stripe in CACHE that covers the group GROUP_INDEX.
  */
-#define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
+static APR_INLINE stripe_header_t *
+get_stripe(svn_membuffer_t *cache, apr_uint32_t group_index)
+{
+  return &cache->stripes[group_index & (cache->stripe_count - 1)].header;
+}
 
-/* If locking is supported for CACHE, acquire a read lock for it.
+/* If locking is supported for CACHE, acquire a read lock for the group
+ * GROUP_INDEX.  Since writers always lock all stripes, this is also
+ * sufficient to read any other segment-global data.
  */
 static svn_error_t *
-read_lock_cache(svn_membuffer_t *cache)
+read_lock_cache(svn_membuffer_t *cache, apr_uint32_t group_index)
 {
+#if SUPPORT_SHARED_MEMBUFFER
+  if (cache->process_shared)
+    return svn_error_trace(
+             lock_shared_mutex(get_stripe(cache, group_index)->shared_lock));
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
-  return svn_mutex__lock(cache->lock);
+  return svn_mutex__lock(get_stripe(cache, group_index)->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  if (cache->lock)
+  apr_thread_rwlock_t *lock = get_stripe(cache, group_index)->lock;
+  if (lock)
   {
-    apr_status_t status = apr_thread_rwlock_rdlock(cache->lock);
+    apr_status_t status = apr_thread_rwlock_rdlock(lock);
     if (status)
       return svn_error_wrap_apr(status, _("Can't lock cache mutex"));
   }
@@ -844,36 +1228,148 @@ read_lock_cache(svn_membuffer_t *cache)
 #endif
 }
 
+/* If locking is supported for CACHE, release the read lock acquired for
+ * group GROUP_INDEX.  Return ERR upon success.
+ */
+static svn_error_t *
+read_unlock_cache(svn_membuffer_t *cache,
+                  apr_uint32_t group_index,
+                  svn_error_t *err)
+{
+#if SUPPORT_SHARED_MEMBUFFER
+  if (cache->process_shared)
+    return unlock_shared_mutex(get_stripe(cache, group_index)->shared_lock,
+                               err);
+#endif
+
+#if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
+  return svn_mutex__unlock(get_stripe(cache, group_index)->lock, err);
+#elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+  apr_thread_rwlock_t *lock = get_stripe(cache, group_index)->lock;
+  if (lock)
+  {
+    apr_status_t status = apr_thread_rwlock_unlock(lock);
+    if (err)
+      return err;
+
+    if (status)
+      return svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
+  }
+
+  return err;
+#else
+  return err;
+#endif
+}
+
+/* If locking is supported for CACHE, release the locks of the first COUNT
+ * stripes in reverse order.  Return ERR upon success.
+ */
+static svn_error_t *
+unlock_stripes(svn_membuffer_t *cache,
+               apr_uint32_t count,
+               svn_error_t *err)
+{
+#if SUPPORT_SHARED_MEMBUFFER
+  if (cache->process_shared)
+    {
+      while (count > 0)
+        err = unlock_shared_mutex(cache->stripes[--count].header.shared_lock,
+                                  err);
+
+      return err;
+    }
+#endif
+
+#if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
+  while (count > 0)
+    err = svn_mutex__unlock(cache->stripes[--count].header.lock, err);
+
+  return err;
+#elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+  while (count > 0)
+    {
+      apr_thread_rwlock_t *lock = cache->stripes[--count].header.lock;
+      if (lock)
+        {
+          apr_status_t status = apr_thread_rwlock_unlock(lock);
+          if (status && !err)
+            err = svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
+        }
+    }
+
+  return err;
+#else
+  return err;
+#endif
+}
+
 /* If locking is supported for CACHE, acquire a write lock for it.
  * Set *SUCCESS to FALSE, if we couldn't acquire the write lock;
  * leave it untouched otherwise.
+ *
+ * Process-shared caches use plain mutexes.  Like with USE_SIMPLE_MUTEX,
+ * writers will always wait for them.
  */
 static svn_error_t *
 write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 {
+#if SUPPORT_SHARED_MEMBUFFER
+  if (cache->process_shared)
+    {
+      apr_uint32_t i;
+      for (i = 0; i < cache->stripe_count; ++i)
+        {
+          svn_error_t *err
+            = lock_shared_mutex(cache->stripes[i].header.shared_lock);
+          if (err)
+            return svn_error_trace(unlock_stripes(cache, i, err));
+        }
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
-  return svn_mutex__lock(cache->lock);
+  apr_uint32_t i;
+  for (i = 0; i < cache->stripe_count; ++i)
+    {
+      svn_error_t *err = svn_mutex__lock(cache->stripes[i].header.lock);
+      if (err)
+        return svn_error_trace(unlock_stripes(cache, i, err));
+    }
+
+  return SVN_NO_ERROR;
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  if (cache->lock)
+  apr_uint32_t i;
+  for (i = 0; i < cache->stripe_count; ++i)
     {
+      apr_thread_rwlock_t *lock = cache->stripes[i].header.lock;
       apr_status_t status;
+
+      if (lock == NULL)
+        break;
+
       if (cache->allow_blocking_writes)
         {
-          status = apr_thread_rwlock_wrlock(cache->lock);
+          status = apr_thread_rwlock_wrlock(lock);
         }
       else
         {
-          status = apr_thread_rwlock_trywrlock(cache->lock);
+          status = apr_thread_rwlock_trywrlock(lock);
           if (SVN_LOCK_IS_BUSY(status))
             {
+              /* Don't keep the stripes that we already got. */
               *success = FALSE;
-              status = APR_SUCCESS;
+              return svn_error_trace(unlock_stripes(cache, i, SVN_NO_ERROR));
             }
         }
 
       if (status)
-        return svn_error_wrap_apr(status,
-                                  _("Can't write-lock cache mutex"));
+        return svn_error_trace(
+                 unlock_stripes(cache, i,
+                                svn_error_wrap_apr(status,
+                                             _("Can't write-lock cache mutex"))));
     }
 
   return SVN_NO_ERROR;
@@ -888,13 +1384,30 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 static svn_error_t *
 force_write_lock_cache(svn_membuffer_t *cache)
 {
+#if SUPPORT_SHARED_MEMBUFFER
+  if (cache->process_shared)
+    return svn_error_trace(write_lock_cache(cache, NULL));
+#endif
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
-  return svn_mutex__lock(cache->lock);
+  return svn_error_trace(write_lock_cache(cache, NULL));
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  apr_status_t status = apr_thread_rwlock_wrlock(cache->lock);
-  if (status)
-    return svn_error_wrap_apr(status,
-                              _("Can't write-lock cache mutex"));
+  apr_uint32_t i;
+  for (i = 0; i < cache->stripe_count; ++i)
+    {
+      apr_thread_rwlock_t *lock = cache->stripes[i].header.lock;
+      apr_status_t status;
+
+      if (lock == NULL)
+        break;
+
+      status = apr_thread_rwlock_wrlock(lock);
+      if (status)
+        return svn_error_trace(
+                 unlock_stripes(cache, i,
+                                svn_error_wrap_apr(status,
+                                             _("Can't write-lock cache mutex"))));
+    }
 
   return SVN_NO_ERROR;
 #else
@@ -902,38 +1415,23 @@ force_write_lock_cache(svn_membuffer_t *cache)
 #endif
 }
 
-/* If locking is supported for CACHE, release the current lock
- * (read or write).  Return ERR upon success.
+/* If locking is supported for CACHE, release the current write lock.
+ * Return ERR upon success.
  */
 static svn_error_t *
 unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 {
-#if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
-  return svn_mutex__unlock(cache->lock, err);
-#elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  if (cache->lock)
-  {
-    apr_status_t status = apr_thread_rwlock_unlock(cache->lock);
-    if (err)
-      return err;
-
-    if (status)
-      return svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
-  }
-
-  return err;
-#else
-  return err;
-#endif
+  return unlock_stripes(cache, cache->stripe_count, err);
 }
 
-/* If supported, guard the execution of EXPR with a read lock to CACHE.
+/* If supported, guard the execution of EXPR with a read lock to the
+ * group GROUP_INDEX in CACHE.
  * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
  */
-#define WITH_READ_LOCK(cache, expr)         \
-do {                                        \
-  SVN_ERR(read_lock_cache(cache));          \
-  SVN_ERR(unlock_cache(cache, (expr)));     \
+#define WITH_READ_LOCK(cache, group_index, expr)                \
+do {                                                            \
+  SVN_ERR(read_lock_cache(cache, group_index));                 \
+  SVN_ERR(read_unlock_cache(cache, group_index, (expr)));       \
 } while (0)
 
 /* If supported, guard the execution of EXPR with a write lock to CACHE.
@@ -1347,6 +1845,104 @@ get_group_index(svn_membuffer_t **cache,
   return (key0 % APR_UINT64_C(5030895599)) % segment0->group_count;
 }
 
+/* Return the position of the I-th counter for KEY in the frequency
+ * sketch of CACHE.
+ */
+static APR_INLINE apr_uint32_t
+get_sketch_index(svn_membuffer_t *cache,
+                 const entry_key_t *key,
+                 int i)
+{
+  /* Double hashing.  Multiply to spread the bits such that the counters
+   * are not correlated with the group index. */
+  apr_uint64_t hash = (key->fingerprint[0]
+                       + i * (key->fingerprint[1] | 1))
+                    * APR_UINT64_C(0x9e3779b97f4a7c15);
+
+  return (apr_uint32_t)(hash >> 32) & cache->sketch_mask;
+}
+
+/* Count a request for KEY, which maps to group GROUP_INDEX, in the
+ * frequency sketch of CACHE, if there is one.  This requires at least the
+ * read lock for GROUP_INDEX.
+ */
+static void
+record_access(svn_membuffer_t *cache,
+              apr_uint32_t group_index,
+              const entry_key_t *key)
+{
+  int i;
+
+  if (cache->sketch == NULL)
+    return;
+
+  for (i = 0; i < SKETCH_DEPTH; ++i)
+    {
+      svn_atomic_t *counter = &cache->sketch[get_sketch_index(cache, key, i)];
+      if (svn_atomic_read(counter) < SKETCH_MAX_COUNT)
+        svn_atomic_inc(counter);
+    }
+
+  svn_atomic_inc(&get_stripe(cache, group_index)->sketch_samples);
+}
+
+/* Return the estimated number of recent requests for KEY in CACHE.
+ * This requires at least the read lock on CACHE.
+ */
+static apr_uint32_t
+estimate_frequency(svn_membuffer_t *cache,
+                   const entry_key_t *key)
+{
+  apr_uint32_t result = SKETCH_MAX_COUNT;
+  int i;
+
+  for (i = 0; i < SKETCH_DEPTH; ++i)
+    result = MIN(result,
+                 svn_atomic_read(&cache->sketch[get_sketch_index(cache, key,
+                                                                 i)]));
+
+  return result;
+}
+
+/* If enough requests have been recorded in the frequency sketch of CACHE,
+ * halve all counters such that old history fades away.  This requires
+ * the write lock on CACHE.
+ */
+static void
+age_sketch(svn_membuffer_t *cache)
+{
+  apr_uint64_t samples = 0;
+  apr_uint32_t i;
+
+  if (cache->sketch == NULL)
+    return;
+
+  for (i = 0; i < cache->stripe_count; ++i)
+    samples += cache->stripes[i].header.sketch_samples;
+
+  if (samples < (apr_uint64_t)(cache->sketch_mask + 1) * SKETCH_SAMPLE_FACTOR)
+    return;
+
+  for (i = 0; i <= cache->sketch_mask; ++i)
+    cache->sketch[i] /= 2;
+
+  for (i = 0; i < cache->stripe_count; ++i)
+    cache->stripes[i].header.sketch_samples /= 2;
+}
+
+/* Return the "worth" of ENTRY in CACHE that we use to decide which
+ * items to evict.  Depending on the policy, this is either the number of
+ * hits or the estimated number of recent requests.
+ */
+static APR_INLINE apr_uint32_t
+get_entry_worth(svn_membuffer_t *cache,
+                entry_t *entry)
+{
+  return cache->sketch
+       ? estimate_frequency(cache, &entry->key)
+       : entry->hit_count;
+}
+
 /* Reduce the hit count of ENTRY and update the accumulated hit info
  * in CACHE accordingly.
  */
@@ -1510,22 +2106,27 @@ find_entry(svn_membuffer_t *cache,
            * groups in the chain.
            */
           cache_level_t *entry_level;
+          apr_uint32_t entry_worth;
           int to_remove = rand() % (GROUP_SIZE * group->header.chain_length);
           entry_group_t *to_shrink
             = get_group(cache, group_index, to_remove / GROUP_SIZE);
 
           entry = &to_shrink->entries[to_remove % GROUP_SIZE];
           entry_level = get_cache_level(cache, entry);
+          entry_worth = get_entry_worth(cache, entry);
           for (i = 0; i < GROUP_SIZE; ++i)
             {
               /* keep L1 entries whenever possible */
 
               cache_level_t *level
                 = get_cache_level(cache, &to_shrink->entries[i]);
+              apr_uint32_t worth
+                = get_entry_worth(cache, &to_shrink->entries[i]);
               if (   (level != entry_level && entry_level == &cache->l1)
-                  || (entry->hit_count > to_shrink->entries[i].hit_count))
+                  || (entry_worth > worth))
                 {
                   entry_level = level;
+                  entry_worth = worth;
                   entry = &to_shrink->entries[i];
                 }
             }
@@ -1647,7 +2248,8 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
   apr_uint64_t drop_hits = 0;
 
   /* estimated "worth" of the new entry */
-  apr_uint64_t drop_hits_limit = (to_fit_in->hit_count + 1)
+  apr_uint32_t to_fit_in_worth = get_entry_worth(cache, to_fit_in);
+  apr_uint64_t drop_hits_limit = (to_fit_in_worth + 1)
                                * (apr_uint64_t)to_fit_in->priority;
 
   /* This loop will eventually terminate because every cache entry
@@ -1702,7 +2304,9 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
       else
         {
           svn_boolean_t keep;
+          apr_uint32_t entry_worth;
           entry = get_entry(cache, cache->l2.next);
+          entry_worth = get_entry_worth(cache, entry);
 
           if (to_fit_in->priority < SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY)
             {
@@ -1710,7 +2314,7 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                * entry is of even lower prio and has fewer hits.
                */
               if (   entry->priority > to_fit_in->priority
-                  || entry->hit_count > to_fit_in->hit_count)
+                  || entry_worth > to_fit_in_worth)
                 return FALSE;
             }
 
@@ -1731,7 +2335,7 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                * The new entry may still find room by ousting other entries.
                */
               keep = to_fit_in->priority == entry->priority
-                   ? entry->hit_count >= to_fit_in->hit_count
+                   ? entry_worth >= to_fit_in_worth
                    : entry->priority > to_fit_in->priority;
             }
 
@@ -1753,7 +2357,7 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
                * provide the same data but in a further stage of processing.
                */
               if (entry->priority > SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
-                drop_hits += entry->hit_count * (apr_uint64_t)entry->priority;
+                drop_hits += entry_worth * (apr_uint64_t)entry->priority;
 
               drop_entry(cache, entry);
             }
@@ -1837,25 +2441,42 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t total_size,
                                   apr_size_t directory_size,
                                   apr_size_t segment_count,
+                                  svn_cache__membuffer_policy_t policy,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t allow_blocking_writes,
+                                  svn_boolean_t process_shared,
                                   apr_pool_t *pool)
 {
   svn_membuffer_t *c;
   prefix_pool_t *prefix_pool;
+#if SUPPORT_SHARED_MEMBUFFER
+  shared_region_t shared_region;
+#endif
+  shared_region_t *region = NULL;
 
   apr_uint32_t seg;
   apr_uint32_t group_count;
   apr_uint32_t main_group_count;
   apr_uint32_t spare_group_count;
   apr_uint32_t group_init_size;
+  apr_uint32_t stripe_count;
+  apr_uint32_t sketch_size = 0;
+  apr_uint32_t i;
+  lock_stripe_t *stripes;
   apr_uint64_t data_size;
   apr_uint64_t max_entry_size;
 
+#if !SUPPORT_SHARED_MEMBUFFER
+  if (process_shared)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Process-shared caches are not supported "
+                              "on this platform"));
+#endif
+
   /* Allocate 1% of the cache capacity to the prefix string pool.
    */
   SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
-                             pool));
+                             process_shared, pool));
   total_size -= total_size / 100;
 
   /* Limit the total size (only relevant if we can address > 4GB)
@@ -1910,9 +2531,6 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
          && segment_count < MAX_SEGMENT_COUNT)
     segment_count *= 2;
 
-  /* allocate cache as an array of segments / cache objects */
-  c = apr_palloc(pool, segment_count * sizeof(*c));
-
   /* Split total cache size into segments of equal size
    */
   total_size /= segment_count;
@@ -1938,14 +2556,6 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
    */
   data_size = ALIGN_VALUE(total_size - directory_size + 1) - ITEM_ALIGNMENT;
 
-  /* For cache sizes > 16TB, individual cache segments will be larger
-   * than 32GB allowing for >4GB entries.  But caching chunks larger
-   * than 4GB are simply not supported.
-   */
-  max_entry_size = data_size / 8 > MAX_ITEM_SIZE
-                 ? MAX_ITEM_SIZE
-                 : data_size / 8;
-
   /* to keep the entries small, we use 32 bit indexes only
    * -> we need to ensure that no more than 4G entries exist.
    *
@@ -1963,6 +2573,65 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   assert(spare_group_count > 0 && main_group_count > 0);
 
   group_init_size = 1 + group_count / (8 * GROUP_INIT_GRANULARITY);
+
+  /* Without concurrent access, a single (possibly NULL) lock per segment
+   * is all we need.  Otherwise, spread the readers across several locks.
+   * There is no point in having more stripes than groups, though.
+   */
+  stripe_count = 1;
+  if (thread_safe || process_shared)
+    while (   stripe_count < MAX_LOCK_STRIPES
+           && stripe_count * segment_count < MIN_TOTAL_LOCK_STRIPES
+           && stripe_count * 2 <= main_group_count)
+      stripe_count *= 2;
+
+  /* The frequency sketch should have about one counter per index entry.
+   * Its memory is taken from the data buffer, such that the cache stays
+   * within its configured size.  Very small caches get a smaller sketch.
+   */
+  if (policy == svn_cache__membuffer_policy_tinylfu)
+    {
+      sketch_size = 1;
+      while (   sketch_size < (apr_uint64_t)group_count * GROUP_SIZE
+             && sketch_size < MAX_SKETCH_SIZE
+             && sketch_size * 2 * sizeof(svn_atomic_t) <= data_size / 8)
+        sketch_size *= 2;
+
+      data_size -= ALIGN_VALUE(sketch_size * sizeof(svn_atomic_t));
+    }
+
+  /* For cache sizes > 16TB, individual cache segments will be larger
+   * than 32GB allowing for >4GB entries.  But caching chunks larger
+   * than 4GB are simply not supported.
+   */
+  max_entry_size = data_size / 8 > MAX_ITEM_SIZE
+                 ? MAX_ITEM_SIZE
+                 : data_size / 8;
+
+#if SUPPORT_SHARED_MEMBUFFER
+  /* Process-shared caches keep everything that may be modified in a
+   * single shared memory block.  Reserve enough room for all segments.
+   */
+  if (process_shared)
+    {
+      apr_size_t segment_size
+        = ALIGN_VALUE(group_count * sizeof(entry_group_t))
+        + ALIGN_VALUE(group_init_size)
+        + (apr_size_t)ALIGN_VALUE(data_size)
+        + ALIGN_VALUE((stripe_count + 1) * sizeof(lock_stripe_t))
+        + ALIGN_VALUE(sketch_size * sizeof(svn_atomic_t));
+
+      SVN_ERR(create_shared_region(&shared_region,
+                                   ALIGN_VALUE(segment_count * sizeof(*c))
+                                   + segment_count * segment_size,
+                                   pool));
+      region = &shared_region;
+    }
+#endif
+
+  /* allocate cache as an array of segments / cache objects */
+  c = region_alloc(region, segment_count * sizeof(*c), FALSE, pool);
+
   for (seg = 0; seg < segment_count; ++seg)
     {
       /* allocate buffers and initialize cache members
@@ -1978,12 +2647,14 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* Allocate but don't clear / zero the directory because it would add
          significantly to the server start-up time if the caches are large.
          Group initialization will take care of that in stead. */
-      c[seg].directory = apr_palloc(pool,
-                                    group_count * sizeof(entry_group_t));
+      c[seg].directory = region_alloc(region,
+                                      group_count * sizeof(entry_group_t),
+                                      FALSE, pool);
 
       /* Allocate and initialize directory entries as "not initialized",
          hence "unused" */
-      c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+      c[seg].group_initialized = region_alloc(region, group_init_size,
+                                              TRUE, pool);
 
       /* Allocate 1/4th of the data buffer to L1
        */
@@ -2004,42 +2675,77 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].l2.current_data = c[seg].l2.start_offset;
 
       /* This cast is safe because DATA_SIZE <= MAX_SEGMENT_SIZE. */
-      c[seg].data = apr_palloc(pool, (apr_size_t)ALIGN_VALUE(data_size));
+      c[seg].data = region_alloc(region, (apr_size_t)ALIGN_VALUE(data_size),
+                                 FALSE, pool);
       c[seg].data_used = 0;
       c[seg].max_entry_size = max_entry_size;
 
       c[seg].used_entries = 0;
-      c[seg].total_reads = 0;
       c[seg].total_writes = 0;
-      c[seg].total_hits = 0;
+
+      c[seg].sketch = sketch_size
+                    ? region_alloc(region, sketch_size * sizeof(svn_atomic_t),
+                                   TRUE, pool)
+                    : NULL;
+      c[seg].sketch_mask = sketch_size - 1;
 
       /* were allocations successful?
        * If not, initialize a minimal cache structure.
        */
-      if (c[seg].data == NULL || c[seg].directory == NULL)
+      if (   c[seg].data == NULL || c[seg].directory == NULL
+          || (sketch_size && c[seg].sketch == NULL))
         {
           /* We are OOM. There is no need to proceed with "half a cache".
            */
           return svn_error_wrap_apr(APR_ENOMEM, "OOM");
         }
 
-#if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
-      /* A lock for intra-process synchronization to the cache, or NULL if
-       * the cache's creator doesn't feel the cache needs to be
-       * thread-safe.
+      /* Allocate the lock stripes with zero-initialized statistics and
+       * align them to STRIPE_BLOCK_SIZE.
        */
-      SVN_ERR(svn_mutex__init(&c[seg].lock, thread_safe, pool));
-#elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-      /* Same for read-write lock. */
-      c[seg].lock = NULL;
-      if (thread_safe)
+      stripes = region_alloc(region, (stripe_count + 1) * sizeof(*stripes),
+                             TRUE, pool);
+      if (stripes == NULL)
+        return svn_error_wrap_apr(APR_ENOMEM, "OOM");
+
+      c[seg].stripe_count = stripe_count;
+      c[seg].stripes = (lock_stripe_t *)APR_ALIGN((apr_uintptr_t)stripes,
+                                                  STRIPE_BLOCK_SIZE);
+      c[seg].process_shared = process_shared;
+
+      for (i = 0; i < stripe_count; ++i)
         {
-          apr_status_t status =
-              apr_thread_rwlock_create(&(c[seg].lock), pool);
-          if (status)
-            return svn_error_wrap_apr(status, _("Can't create cache mutex"));
+#if SUPPORT_SHARED_MEMBUFFER
+          if (process_shared)
+            {
+              SVN_ERR(create_shared_mutex(
+                        &c[seg].stripes[i].header.shared_lock, pool));
+              continue;
+            }
+#endif
+
+#if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
+          /* A lock for intra-process synchronization to the cache, or NULL
+           * if the cache's creator doesn't feel the cache needs to be
+           * thread-safe.
+           */
+          SVN_ERR(svn_mutex__init(&c[seg].stripes[i].header.lock,
+                                  thread_safe, pool));
+#elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+          /* Same for read-write lock. */
+          if (thread_safe)
+            {
+              apr_status_t status =
+                  apr_thread_rwlock_create(&(c[seg].stripes[i].header.lock),
+                                           pool);
+              if (status)
+                return svn_error_wrap_apr(status,
+                                          _("Can't create cache mutex"));
+            }
+#endif
         }
 
+#if (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
       /* Select the behavior of write operations.
        */
       c[seg].allow_blocking_writes = allow_blocking_writes;
@@ -2054,10 +2760,34 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_child_init(svn_membuffer_t *cache,
+                                apr_pool_t *pool)
+{
+#if SUPPORT_SHARED_MEMBUFFER
+  apr_uint32_t seg;
+  apr_uint32_t i;
+
+  if (!cache->process_shared)
+    return SVN_NO_ERROR;
+
+  /* All segments share the same prefix pool. */
+  SVN_ERR(child_init_shared_mutex(cache->prefix_pool->shared_mutex, pool));
+
+  for (seg = 0; seg < cache->segment_count; ++seg)
+    for (i = 0; i < cache[seg].stripe_count; ++i)
+      SVN_ERR(child_init_shared_mutex(cache[seg].stripes[i].header.shared_lock,
+                                      pool));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache)
 {
   apr_size_t seg;
+  apr_uint32_t i;
   apr_size_t segment_count = cache->segment_count;
 
   /* Length of the group_initialized array in bytes.
@@ -2101,6 +2831,13 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
       cache[seg].data_used = 0;
       cache[seg].used_entries = 0;
 
+      /* Forget the access history. */
+      if (cache[seg].sketch)
+        memset(cache[seg].sketch, 0,
+               (cache[seg].sketch_mask + 1) * sizeof(svn_atomic_t));
+      for (i = 0; i < cache[seg].stripe_count; ++i)
+        cache[seg].stripes[i].header.sketch_samples = 0;
+
       /* Segment may be used again. */
       SVN_ERR(unlock_cache(&cache[seg], SVN_NO_ERROR));
     }
@@ -2134,7 +2871,7 @@ entry_exists(svn_membuffer_t *cache,
              const full_key_t *to_find,
              svn_boolean_t *found)
 {
-  WITH_READ_LOCK(cache,
+  WITH_READ_LOCK(cache, group_index,
                  entry_exists_internal(cache,
                                        group_index,
                                        to_find,
@@ -2209,6 +2946,9 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
    * membuffer in single-threaded mode. */
   assert(0 == svn_atomic_inc(&cache->write_lock_count));
 
+  /* Let old access history fade before we use it for eviction decisions. */
+  age_sketch(cache);
+
   /* Quick check make sure arithmetics will work further down the road. */
   size = item_size + to_find->entry_key.key_len;
   if (size < item_size)
@@ -2355,10 +3095,12 @@ membuffer_cache_set(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
-/* Count a hit in ENTRY within CACHE.
+/* Count a hit in ENTRY within group GROUP_INDEX of CACHE.
  */
 static void
-increment_hit_counters(svn_membuffer_t *cache, entry_t *entry)
+increment_hit_counters(svn_membuffer_t *cache,
+                       apr_uint32_t group_index,
+                       entry_t *entry)
 {
   /* To minimize the memory footprint of the cache index, we limit local
    * hit counters to 32 bits.  These may overflow but we don't really
@@ -2366,8 +3108,9 @@ increment_hit_counters(svn_membuffer_t *cache, entry_t *entry)
    * few billion hits. */
   svn_atomic_inc(&entry->hit_count);
 
-  /* That one is for stats only. */
-  cache->total_hits++;
+  /* That one is for stats only.  Since there are many stripes, it is
+   * unlikely for concurrent readers to touch the same counter. */
+  get_stripe(cache, group_index)->hits++;
 }
 
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
@@ -2393,8 +3136,9 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
 
   /* The actual cache data access needs to sync'ed
    */
+  record_access(cache, group_index, &to_find->entry_key);
   entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  get_stripe(cache, group_index)->reads++;
   if (entry == NULL)
     {
       /* no such entry found.
@@ -2427,7 +3171,7 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
 
   /* update hit statistics
    */
-  increment_hit_counters(cache, entry);
+  increment_hit_counters(cache, group_index, entry);
   *item_size = entry->size - entry->key.key_len;
 
   return SVN_NO_ERROR;
@@ -2453,7 +3197,7 @@ membuffer_cache_get(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   group_index = get_group_index(&cache, &key->entry_key);
-  WITH_READ_LOCK(cache,
+  WITH_READ_LOCK(cache, group_index,
                  membuffer_cache_get_internal(cache,
                                               group_index,
                                               key,
@@ -2483,7 +3227,10 @@ membuffer_cache_has_key_internal(svn_membuffer_t *cache,
                                  const full_key_t *to_find,
                                  svn_boolean_t *found)
 {
-  entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
+  entry_t *entry;
+
+  record_access(cache, group_index, &to_find->entry_key);
+  entry = find_entry(cache, group_index, to_find, FALSE);
   if (entry)
     {
       /* This often be called by "block read" when most data is already
@@ -2491,7 +3238,7 @@ membuffer_cache_has_key_internal(svn_membuffer_t *cache,
          again.  While items in L1 are well protected for a while, L2
          items may get evicted soon.  Thus, mark all them as "hit" to give
          them a higher chance of survival. */
-      increment_hit_counters(cache, entry);
+      increment_hit_counters(cache, group_index, entry);
       *found = TRUE;
     }
   else
@@ -2515,9 +3262,9 @@ membuffer_cache_has_key(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
-  cache->total_reads++;
+  get_stripe(cache, group_index)->reads++;
 
-  WITH_READ_LOCK(cache,
+  WITH_READ_LOCK(cache, group_index,
                  membuffer_cache_has_key_internal(cache,
                                                   group_index,
                                                   key,
@@ -2548,8 +3295,11 @@ membuffer_cache_get_partial_internal(svn_membuffer_t *cache,
                                      DEBUG_CACHE_MEMBUFFER_TAG_ARG
                                      apr_pool_t *result_pool)
 {
-  entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  entry_t *entry;
+
+  record_access(cache, group_index, &to_find->entry_key);
+  entry = find_entry(cache, group_index, to_find, FALSE);
+  get_stripe(cache, group_index)->reads++;
   if (entry == NULL)
     {
       *item = NULL;
@@ -2562,7 +3312,7 @@ membuffer_cache_get_partial_internal(svn_membuffer_t *cache,
       const void *item_data = cache->data + entry->offset + entry->key.key_len;
       apr_size_t item_size = entry->size - entry->key.key_len;
       *found = TRUE;
-      increment_hit_counters(cache, entry);
+      increment_hit_counters(cache, group_index, entry);
 
 #ifdef SVN_DEBUG_CACHE_MEMBUFFER
 
@@ -2601,7 +3351,7 @@ membuffer_cache_get_partial(svn_membuffer_t *cache,
 {
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
 
-  WITH_READ_LOCK(cache,
+  WITH_READ_LOCK(cache, group_index,
                  membuffer_cache_get_partial_internal
                      (cache, group_index, key, item, found,
                       deserializer, baton, DEBUG_CACHE_MEMBUFFER_TAG
@@ -2632,7 +3382,7 @@ membuffer_cache_set_partial_internal(svn_membuffer_t *cache,
   /* cache item lookup
    */
   entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  get_stripe(cache, group_index)->reads++;
 
   /* this function is a no-op if the item is not in cache
    */
@@ -2646,7 +3396,7 @@ membuffer_cache_set_partial_internal(svn_membuffer_t *cache,
       void *orig_data = item_data;
       apr_size_t item_size = entry->size - key_len;
 
-      increment_hit_counters(cache, entry);
+      increment_hit_counters(cache, group_index, entry);
       cache->total_writes++;
 
 #ifdef SVN_DEBUG_CACHE_MEMBUFFER
@@ -3168,7 +3918,7 @@ svn_membuffer_cache_get_info(void *cache_void,
   for (i = 0; i < cache->membuffer->segment_count; ++i)
     {
       svn_membuffer_t *segment = cache->membuffer + i;
-      WITH_READ_LOCK(segment,
+      WITH_READ_LOCK(segment, 0,
                      svn_membuffer_get_segment_info(segment, info, FALSE));
     }
 
@@ -3448,11 +4198,18 @@ static svn_error_t *
 svn_membuffer_get_global_segment_info(svn_membuffer_t *segment,
                                       svn_cache__info_t *info)
 {
-  info->gets += segment->total_reads;
+  apr_uint32_t i;
+
+  /* Merge the per-stripe statistics. */
+  for (i = 0; i < segment->stripe_count; ++i)
+    {
+      info->gets += segment->stripes[i].header.reads;
+      info->hits += segment->stripes[i].header.hits;
+    }
+
   info->sets += segment->total_writes;
-  info->hits += segment->total_hits;
 
-  WITH_READ_LOCK(segment,
+  WITH_READ_LOCK(segment, 0,
                   svn_membuffer_get_segment_info(segment, info, TRUE));
 
   return SVN_NO_ERROR;
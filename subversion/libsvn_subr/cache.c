@@ -21,6 +21,8 @@
  * ====================================================================
  */
 
+#include <apr_strings.h>
+
 #include "cache.h"
 
 svn_error_t *
@@ -257,7 +259,23 @@ svn_cache__format_info(const svn_cache__info_t *info,
   double data_entry_rate = (100.0 * (double)info->used_entries)
                  / (double)(info->total_entries ? info->total_entries : 1);
 
+  const char *l2_info = "";
   const char *histogram = "";
+
+  if (info->l2_gets || info->l2_total_size)
+    {
+      double l2_hit_rate = (100.0 * (double)info->l2_hits)
+                         / (double)(info->l2_gets ? info->l2_gets : 1);
+      l2_info = apr_psprintf(result_pool,
+                             "disk    : %" APR_UINT64_T_FMT
+                             " gets, %" APR_UINT64_T_FMT " hits (%5.2f%%)"
+                             ", used %" APR_UINT64_T_FMT " MB"
+                             " of %" APR_UINT64_T_FMT " MB\n",
+                             info->l2_gets, info->l2_hits, l2_hit_rate,
+                             info->l2_used_size / _1MB,
+                             info->l2_total_size / _1MB);
+    }
+
   if (!access_only)
     {
       svn_stringbuf_t *text = svn_stringbuf_create_empty(result_pool);
@@ -283,11 +301,13 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             "gets    : %" APR_UINT64_T_FMT
                             ", %" APR_UINT64_T_FMT " hits (%5.2f%%)\n"
                             "sets    : %" APR_UINT64_T_FMT
-                            " (%5.2f%% of misses)\n",
+                            " (%5.2f%% of misses)\n"
+                            "%s",
                             info->id,
                             info->gets,
                             info->hits, hit_rate,
-                            info->sets, write_rate)
+                            info->sets, write_rate,
+                            l2_info)
        : svn_string_createf(result_pool,
 
                             "%s\n"
@@ -295,6 +315,7 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             ", %" APR_UINT64_T_FMT " hits (%5.2f%%)\n"
                             "sets    : %" APR_UINT64_T_FMT
                             " (%5.2f%% of misses)\n"
+                            "%s"
                             "failures: %" APR_UINT64_T_FMT "\n"
                             "used    : %" APR_UINT64_T_FMT " MB (%5.2f%%)"
                             " of %" APR_UINT64_T_FMT " MB data cache"
@@ -307,6 +328,7 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             info->gets,
                             info->hits, hit_rate,
                             info->sets, write_rate,
+                            l2_info,
                             info->failures,
 
                             info->used_size / _1MB, data_usage_rate,
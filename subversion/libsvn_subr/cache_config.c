@@ -20,6 +20,7 @@
  * ====================================================================
  */
 
+#include <string.h>
 #include <apr_atomic.h>
 
 #include "svn_cache_config.h"
@@ -29,6 +30,8 @@
 #include "svn_pools.h"
 #include "svn_sorts.h"
 
+#include "svn_private_config.h"
+
 /* The cache settings as a process-wide singleton.
  */
 static svn_cache_config_t cache_settings =
@@ -64,6 +67,21 @@ static svn_cache_config_t cache_settings =
 #endif
 };
 
+/* The process-global (singleton) membuffer cache and its initialization
+ * state as used by svn_atomic__init_once.
+ */
+static svn_membuffer_t *global_cache = NULL;
+static svn_atomic_t global_cache_initialized = 0;
+
+/* If set, initialize_cache() will place the cache in shared memory.
+ */
+static svn_boolean_t create_shared_cache = FALSE;
+
+/* Replacement policy that initialize_cache() will use.
+ */
+static svn_cache__membuffer_policy_t membuffer_policy
+  = svn_cache__membuffer_policy_lfu;
+
 /* Get the current FSFS cache configuration. */
 const svn_cache_config_t *
 svn_cache_config_get(void)
@@ -125,8 +143,10 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
           (apr_size_t)cache_size,
           (apr_size_t)(cache_size / 5),
           0,
+          membuffer_policy,
           ! svn_cache_config_get()->single_threaded,
           FALSE,
+          create_shared_cache,
           pool);
 
       /* Some error occurred. Most likely it's an OOM error but we don't
@@ -158,11 +178,9 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
 svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void)
 {
-  static svn_membuffer_t *cache = NULL;
-  static svn_atomic_t initialized = 0;
-
   svn_error_t *err
-    = svn_atomic__init_once(&initialized, initialize_cache, &cache, NULL);
+    = svn_atomic__init_once(&global_cache_initialized, initialize_cache,
+                            &global_cache, NULL);
   if (err)
     {
       /* no caches today ... */
@@ -170,7 +188,7 @@ svn_cache__get_global_membuffer_cache(void)
       return NULL;
     }
 
-  return cache;
+  return global_cache;
 }
 
 void
@@ -179,3 +197,40 @@ svn_cache_config_set(const svn_cache_config_t *settings)
   cache_settings = *settings;
 }
 
+svn_error_t *
+svn_cache_config_set_replacement_policy(const char *policy)
+{
+  if (strcmp(policy, "lfu") == 0)
+    membuffer_policy = svn_cache__membuffer_policy_lfu;
+  else if (strcmp(policy, "tinylfu") == 0)
+    membuffer_policy = svn_cache__membuffer_policy_tinylfu;
+  else
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("'%s' is not a valid cache replacement "
+                               "policy"), policy);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache_config_create_shared_cache(void)
+{
+  /* If the cache already exists, it is too late to share it. */
+  if (svn_atomic_read(&global_cache_initialized))
+    return SVN_NO_ERROR;
+
+  create_shared_cache = TRUE;
+  return svn_error_trace(svn_atomic__init_once(&global_cache_initialized,
+                                               initialize_cache,
+                                               &global_cache, NULL));
+}
+
+svn_error_t *
+svn_cache_config_child_init(apr_pool_t *pool)
+{
+  /* Nothing to do without a shared cache. */
+  if (!create_shared_cache || global_cache == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_cache__membuffer_child_init(global_cache, pool));
+}
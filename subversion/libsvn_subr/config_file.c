@@ -1168,6 +1168,9 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###   http-bulk-updates          Whether to request bulk update"    NL
         "###                              responses or to fetch each file"   NL
         "###                              in an individual request. "        NL
+        "###   svn-compressed-transport   Whether to compress the whole"     NL
+        "###                              svn:// connection instead of only" NL
+        "###                              the deltas (yes/no)."              NL
         "###   store-passwords            Specifies whether passwords used"  NL
         "###                              to authenticate against a"         NL
         "###                              Subversion server may be cached"   NL
@@ -1310,6 +1313,7 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "# http-proxy-username = defaultusername"                            NL
         "# http-proxy-password = defaultpassword"                            NL
         "# http-compression = auto"                                          NL
+        "# svn-compressed-transport = no"                                    NL
         "# No http-timeout, so just use the builtin default."                NL
         "# ssl-authority-files = /path/to/CAcert.pem;/path/to/CAcert2.pem"   NL
         "#"                                                                  NL
@@ -1554,6 +1558,37 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set the number of threads used to read working copy"           NL
+        "### directories and their metadata ahead of time while walking"    NL
+        "### the working copy for 'svn status'.  The output order does not" NL
+        "### depend on this setting.  The default is 1, i.e. no additional"  NL
+        "### threads.  This option has no effect together with exclusive"   NL
+        "### locking."                                                       NL
+        "# status-threads = 1"                                               NL
+        "### Set the number of threads used to write working files during"   NL
+        "### checkout, update, switch and similar operations.  The working"  NL
+        "### copy database is still updated by a single thread.  The"        NL
+        "### default is 1, i.e. all files are written one after another."    NL
+        "# install-threads = 1"                                              NL
+        "### Set the path to a directory that all working copies of this"    NL
+        "### user share as an additional pristine store.  Pristine texts"    NL
+        "### are hard-linked between that directory and the working copies," NL
+        "### so identical contents are stored only once per file system and" NL
+        "### need not be downloaded again over http(s).  The directory must" NL
+        "### be on the same file system as the working copies.  Only"        NL
+        "### read-only texts owned by the current user are used, and their"  NL
+        "### SHA-1 checksum is verified before they are read or linked into" NL
+        "### a working copy."                                                NL
+        "### 'svn cleanup --vacuum-pristines' removes texts no longer used"  NL
+        "### by any working copy.  No directory is shared by default."       NL
+        "# shared-pristine-store = /var/cache/svn-pristines"                 NL
+        "### Set to true to let long-running clients such as IDE"            NL
+        "### integrations watch the directories of working copies for"       NL
+        "### changes, so that repeated status requests only need to read"    NL
+        "### the directories that changed since.  This uses the file system" NL
+        "### notifications of the operating system and is currently only"    NL
+        "### supported on Linux.  The default is false."                     NL
+        "# status-monitor = false"                                           NL
         ;
 
       err = svn_io_file_open(&f, path,
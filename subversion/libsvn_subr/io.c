@@ -69,6 +69,15 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_dep_compat.h"
 
+#ifdef HAVE_LINUX_FS_H
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+#include <errno.h>
+#endif
+
 #define SVN_SLEEP_ENV_VAR "SVN_I_LOVE_CORRUPTED_WORKING_COPIES_SO_DISABLE_SLEEP_FOR_TIMESTAMPS"
 
 /*
@@ -869,6 +878,91 @@ copy_contents(apr_file_t *from_file,
   /* NOTREACHED */
 }
 
+#ifdef HAVE_COPY_FILE_RANGE
+/* Maximum number of bytes to let a single copy_file_range() call copy. */
+#define COPY_FILE_RANGE_CHUNK_SIZE 0x40000000
+#endif
+
+svn_error_t *
+svn_io__file_copy_in_kernel(svn_boolean_t *copied,
+                            apr_file_t *from_file,
+                            apr_file_t *to_file,
+                            apr_pool_t *scratch_pool)
+{
+  *copied = FALSE;
+
+#if defined(FICLONE) || defined(HAVE_COPY_FILE_RANGE)
+  {
+    apr_os_file_t from_fd;
+    apr_os_file_t to_fd;
+    apr_status_t status;
+
+    status = apr_os_file_get(&from_fd, from_file);
+    if (!status)
+      status = apr_os_file_get(&to_fd, to_file);
+    if (status)
+      return svn_error_wrap_apr(status, _("Can't get file descriptor"));
+
+#ifdef FICLONE
+    /* On copy-on-write file systems such as Btrfs and XFS, simply share
+       all data blocks.  This fails for e.g. different file systems. */
+    if (ioctl(to_fd, FICLONE, from_fd) == 0)
+      {
+        *copied = TRUE;
+        return SVN_NO_ERROR;
+      }
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+    {
+      /* Use explicit offsets to keep the APR file positions valid. */
+      loff_t from_offset = 0;
+      loff_t to_offset = 0;
+
+      while (TRUE)
+        {
+          ssize_t bytes_copied = copy_file_range(from_fd, &from_offset,
+                                                 to_fd, &to_offset,
+                                                 COPY_FILE_RANGE_CHUNK_SIZE,
+                                                 0);
+          if (bytes_copied == 0)
+            {
+              *copied = TRUE;
+              return SVN_NO_ERROR;
+            }
+
+          if (bytes_copied < 0)
+            {
+              int os_err = errno;
+              const char *from_name;
+              const char *to_name;
+
+              if (os_err == EINTR)
+                continue;
+
+              /* Not supported by the kernel or for these files?
+                 Let the caller fall back to a userspace copy. */
+              if (to_offset == 0)
+                return SVN_NO_ERROR;
+
+              SVN_ERR(svn_io_file_name_get(&from_name, from_file,
+                                           scratch_pool));
+              SVN_ERR(svn_io_file_name_get(&to_name, to_file, scratch_pool));
+              return svn_error_wrap_apr(APR_FROM_OS_ERROR(os_err),
+                                        _("Can't copy '%s' to '%s'"),
+                                        svn_dirent_local_style(from_name,
+                                                               scratch_pool),
+                                        svn_dirent_local_style(to_name,
+                                                               scratch_pool));
+            }
+        }
+    }
+#endif
+  }
+#endif
+
+  return SVN_NO_ERROR;
+}
 
 svn_error_t *
 svn_io_copy_file(const char *src,
@@ -879,6 +973,7 @@ svn_io_copy_file(const char *src,
   apr_file_t *from_file, *to_file;
   apr_status_t apr_err;
   const char *dst_tmp;
+  svn_boolean_t copied;
   svn_error_t *err;
 
   /* ### NOTE: sometimes src == dst. In this case, because we copy to a
@@ -909,16 +1004,16 @@ svn_io_copy_file(const char *src,
                                    svn_dirent_dirname(dst, pool),
                                    svn_io_file_del_none, pool, pool));
 
-  apr_err = copy_contents(from_file, to_file, pool);
-
-  if (apr_err)
+  err = svn_io__file_copy_in_kernel(&copied, from_file, to_file, pool);
+  if (!err && !copied)
     {
-      err = svn_error_wrap_apr(apr_err, _("Can't copy '%s' to '%s'"),
-                               svn_dirent_local_style(src, pool),
-                               svn_dirent_local_style(dst_tmp, pool));
+      apr_err = copy_contents(from_file, to_file, pool);
+
+      if (apr_err)
+        err = svn_error_wrap_apr(apr_err, _("Can't copy '%s' to '%s'"),
+                                 svn_dirent_local_style(src, pool),
+                                 svn_dirent_local_style(dst_tmp, pool));
     }
-   else
-     err = NULL;
 
   err = svn_error_compose_create(err,
                                  svn_io_file_close(from_file, pool));
@@ -4318,6 +4413,51 @@ svn_io_file_rename2(const char *from_path, const char *to_path,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_io__file_link(const char *existing_path,
+                  const char *new_path,
+                  apr_pool_t *scratch_pool)
+{
+  apr_status_t status;
+  const char *existing_path_apr, *new_path_apr;
+
+  SVN_ERR(cstring_from_utf8(&existing_path_apr, existing_path, scratch_pool));
+  SVN_ERR(cstring_from_utf8(&new_path_apr, new_path, scratch_pool));
+
+#if defined(WIN32)
+  {
+    const WCHAR *existing_path_w;
+    const WCHAR *new_path_w;
+
+    SVN_ERR(svn_io__utf8_to_unicode_longpath(&existing_path_w,
+                                             existing_path_apr,
+                                             scratch_pool));
+    SVN_ERR(svn_io__utf8_to_unicode_longpath(&new_path_w, new_path_apr,
+                                             scratch_pool));
+
+    if (CreateHardLinkW(new_path_w, existing_path_w, NULL))
+      status = APR_SUCCESS;
+    else
+      status = apr_get_os_error();
+  }
+#elif defined(__OS2__)
+  status = APR_ENOTIMPL;
+#else
+  if (link(existing_path_apr, new_path_apr) == 0)
+    status = APR_SUCCESS;
+  else
+    status = apr_get_os_error();
+#endif
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create link '%s' to '%s'"),
+                              svn_dirent_local_style(new_path, scratch_pool),
+                              svn_dirent_local_style(existing_path,
+                                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_io_file_move(const char *from_path, const char *to_path,
@@ -427,3 +427,11 @@ svn_log__list(const char *path, svn_revnum_t revision,
   return apr_psprintf(pool, "list %s r%ld%s%s", log_path, revision,
                       log_depth(depth, pool), pattern_text->data);
 }
+
+const char *
+svn_log__blame(const char *path, svn_revnum_t start, svn_revnum_t end,
+               apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "blame %s r%ld:%ld",
+                      svn_path_uri_encode(path, pool), start, end);
+}
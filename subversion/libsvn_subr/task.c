@@ -0,0 +1,467 @@
+/* task.c : ordered execution of independent tasks on worker threads
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_thread_pool.h>
+#include <apr_thread_cond.h>
+
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_private_config.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_dep_compat.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
+
+/* Handy macro to check APR function results and turning them into
+ * svn_error_t upon failure. */
+#define WRAP_APR_ERR(x,msg)                     \
+  {                                             \
+    apr_status_t status_ = (x);                 \
+    if (status_)                                \
+      return svn_error_wrap_apr(status_, msg);  \
+  }
+
+/* Number of microseconds that an unused thread remains in the pool before
+ * being terminated. */
+#define THREADPOOL_THREAD_IDLE_LIMIT 1000000
+
+/* Maximum number of worker threads shared by all task queues in this
+ * process. */
+#define MAX_THREADS 16
+
+/* Concurrency to use if we can't determine the number of CPU cores. */
+#define FALLBACK_CONCURRENCY 4
+
+/* One task within a queue. */
+typedef struct task_t
+{
+  /* The queue that this task belongs to. */
+  svn_task__queue_t *queue;
+
+  /* Callbacks and their batons as passed to svn_task__queue_push(). */
+  svn_task__process_func_t process;
+  void *process_baton;
+  svn_task__output_func_t output;
+  void *output_baton;
+
+  /* Root pool owned by this task, containing RESULT.  Being a root pool,
+   * it can be used by the worker thread without further synchronization. */
+  apr_pool_t *pool;
+
+  /* Result and error returned by PROCESS. */
+  void *result;
+  svn_error_t *error;
+
+  /* Set once PROCESS has returned.  Guarded by QUEUE->MUTEX. */
+  svn_boolean_t done;
+} task_t;
+
+struct svn_task__queue_t
+{
+  /* Ring buffer of MAX_PENDING tasks in push order.  The oldest one is at
+   * FIRST, COUNT entries are in use. */
+  task_t **pending;
+  int max_pending;
+  int first;
+  int count;
+
+  /* If set, run tasks on the shared thread pool. */
+  svn_boolean_t concurrent;
+
+  /* First error returned by any task or output.  Once set, no further
+   * outputs will be delivered. */
+  svn_error_t *error;
+
+#if APR_HAS_THREADS
+  /* Signaled whenever a task completes.  Used with MUTEX. */
+  apr_thread_cond_t *cond;
+#endif
+  svn_mutex__t *mutex;
+};
+
+#if APR_HAS_THREADS
+
+/* Thread pool shared by all task queues. */
+static apr_thread_pool_t *thread_pool = NULL;
+
+/* Destructor function that implicitly cleans up any running threads
+   in the THREAD_POOL *once*.
+
+   Must be run as a pre-cleanup hook.
+ */
+static apr_status_t
+thread_pool_pre_cleanup(void *data)
+{
+  apr_thread_pool_t *tp = thread_pool;
+  if (!thread_pool)
+    return APR_SUCCESS;
+
+  thread_pool = NULL;
+
+  return apr_thread_pool_destroy(tp);
+}
+
+#endif
+
+/* Keep track on whether we already created the THREAD_POOL. */
+static volatile svn_atomic_t thread_pool_initialized = FALSE;
+
+/* Core implementation of svn_task__queue_create, creating THREAD_POOL. */
+static svn_error_t *
+create_thread_pool(void *baton,
+                   apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  /* The thread-pool must be allocated from a thread-safe pool.
+     It lives until the global APR pool gets cleaned up. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  WRAP_APR_ERR(apr_thread_pool_create(&thread_pool, 0, MAX_THREADS, pool),
+               _("Can't create task thread pool"));
+
+  /* Work around an APR bug:  The cleanup must happen in the pre-cleanup
+     hook instead of the normal cleanup hook.  Otherwise, the sub-pools
+     containing the thread objects would already be invalid. */
+  apr_pool_pre_cleanup_register(pool, NULL, thread_pool_pre_cleanup);
+
+  /* let idle threads linger for a while in case more requests are
+     coming in */
+  apr_thread_pool_idle_wait_set(thread_pool, THREADPOOL_THREAD_IDLE_LIMIT);
+
+  /* don't queue requests unless we reached the worker thread limit */
+  apr_thread_pool_threshold_set(thread_pool, 0);
+
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Execute TASK's process function and store its result in TASK. */
+static void
+run_task(task_t *task)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(task->pool);
+
+  task->error = svn_error_trace(task->process(&task->result,
+                                              task->process_baton,
+                                              task->pool, scratch_pool));
+  svn_pool_destroy(scratch_pool);
+}
+
+/* Mark TASK as done and wake up the queue owner. */
+static svn_error_t *
+signal_done(task_t *task)
+{
+  svn_task__queue_t *queue = task->queue;
+
+  SVN_ERR(svn_mutex__lock(queue->mutex));
+  task->done = TRUE;
+
+#if APR_HAS_THREADS
+  if (queue->cond)
+    {
+      apr_status_t status = apr_thread_cond_broadcast(queue->cond);
+      if (status)
+        return svn_mutex__unlock(queue->mutex,
+                                 svn_error_wrap_apr(status,
+                                   _("Can't broadcast condition variable")));
+    }
+#endif
+
+  return svn_error_trace(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+}
+
+#if APR_HAS_THREADS
+
+/* Thread-pool callback executing the task_t given by DATA. */
+static void * APR_THREAD_FUNC
+task_thread(apr_thread_t *tid,
+            void *data)
+{
+  task_t *task = data;
+  run_task(task);
+
+  /* As soon as this returns, TASK may be invalid.  If signaling fails,
+     there is no way to tell the queue owner. */
+  svn_error_clear(signal_done(task));
+
+  return NULL;
+}
+
+#endif
+
+/* Block until TASK has been marked as done. */
+static svn_error_t *
+wait_for(task_t *task)
+{
+  svn_task__queue_t *queue = task->queue;
+  svn_boolean_t done = FALSE;
+
+  /* This loop implicitly handles spurious wake-ups. */
+  do
+    {
+      SVN_ERR(svn_mutex__lock(queue->mutex));
+
+      if (task->done)
+        {
+          done = TRUE;
+        }
+#if APR_HAS_THREADS
+      else
+        {
+          apr_status_t status
+            = apr_thread_cond_wait(queue->cond, svn_mutex__get(queue->mutex));
+          if (status)
+            return svn_mutex__unlock(queue->mutex,
+                                     svn_error_wrap_apr(status,
+                                       _("Can't wait for condition variable")));
+        }
+#endif
+
+      SVN_ERR(svn_mutex__unlock(queue->mutex, SVN_NO_ERROR));
+    }
+  while (!done);
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the oldest task in QUEUE to complete, remove it from QUEUE and
+ * deliver its output unless DELIVER is FALSE or QUEUE had an error.
+ * Errors are being recorded in QUEUE.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+retire_oldest(svn_task__queue_t *queue,
+              svn_boolean_t deliver,
+              apr_pool_t *scratch_pool)
+{
+  task_t *task = queue->pending[queue->first];
+
+  SVN_ERR(wait_for(task));
+
+  queue->pending[queue->first] = NULL;
+  queue->first = (queue->first + 1) % queue->max_pending;
+  queue->count--;
+
+  if (task->error)
+    {
+      if (queue->error)
+        svn_error_clear(task->error);
+      else
+        queue->error = task->error;
+    }
+  else if (deliver && !queue->error && task->output)
+    {
+      queue->error = svn_error_trace(task->output(task->result,
+                                                  task->output_baton,
+                                                  scratch_pool));
+    }
+
+  svn_pool_destroy(task->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the first error recorded in QUEUE and reset it.  If there was an
+ * error, discard all tasks still pending in QUEUE. */
+static svn_error_t *
+take_error(svn_task__queue_t *queue)
+{
+  svn_error_t *err = queue->error;
+  if (!err)
+    return SVN_NO_ERROR;
+
+  while (queue->count)
+    {
+      svn_error_t *wait_err = retire_oldest(queue, FALSE, NULL);
+      if (wait_err)
+        {
+          err = svn_error_compose_create(err, wait_err);
+          break;
+        }
+    }
+
+  queue->error = SVN_NO_ERROR;
+
+  return svn_error_trace(err);
+}
+
+/* Pool cleanup function waiting for all tasks in the queue given by DATA
+ * to complete before the queue data structures become invalid. */
+static apr_status_t
+queue_pre_cleanup(void *data)
+{
+  svn_task__queue_t *queue = data;
+
+  while (queue->count)
+    {
+      svn_error_t *err = retire_oldest(queue, FALSE, NULL);
+      if (err)
+        {
+          /* We can't wait for the remaining tasks.  Leak them. */
+          svn_error_clear(err);
+          break;
+        }
+    }
+
+  svn_error_clear(queue->error);
+  queue->error = SVN_NO_ERROR;
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_task__queue_create(svn_task__queue_t **queue,
+                       int max_pending,
+                       apr_pool_t *result_pool)
+{
+  svn_task__queue_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  result->max_pending = MAX(max_pending, 1);
+  result->pending = apr_pcalloc(result_pool,
+                                result->max_pending
+                                  * sizeof(*result->pending));
+
+#if APR_HAS_THREADS
+  result->concurrent = result->max_pending > 1;
+  if (result->concurrent)
+    {
+      SVN_ERR(svn_atomic__init_once(&thread_pool_initialized,
+                                    create_thread_pool, NULL, result_pool));
+      WRAP_APR_ERR(apr_thread_cond_create(&result->cond, result_pool),
+                   _("Can't create condition variable"));
+    }
+#endif
+
+  SVN_ERR(svn_mutex__init(&result->mutex, result->concurrent, result_pool));
+
+  /* Make sure no worker thread touches this queue after it is gone. */
+  apr_pool_pre_cleanup_register(result_pool, result, queue_pre_cleanup);
+
+  *queue = result;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_task__queue_push(svn_task__queue_t *queue,
+                     svn_task__process_func_t process,
+                     void *process_baton,
+                     svn_task__output_func_t output,
+                     void *output_baton,
+                     apr_pool_t *scratch_pool)
+{
+  task_t *task;
+  apr_pool_t *pool;
+
+  /* Make room for the new task. */
+  while (queue->count == queue->max_pending)
+    SVN_ERR(retire_oldest(queue, TRUE, scratch_pool));
+
+  /* Don't start new work after a failure. */
+  if (queue->error)
+    return take_error(queue);
+
+  /* Tasks may run in separate threads and must therefore use separate,
+   * thread-safe pools.  Allocating a root pool achieves exactly that. */
+  pool = svn_pool_create(NULL);
+  task = apr_pcalloc(pool, sizeof(*task));
+  task->queue = queue;
+  task->process = process;
+  task->process_baton = process_baton;
+  task->output = output;
+  task->output_baton = output_baton;
+  task->pool = pool;
+
+  queue->pending[(queue->first + queue->count) % queue->max_pending] = task;
+  queue->count++;
+
+#if APR_HAS_THREADS
+  if (queue->concurrent && thread_pool)
+    {
+      apr_status_t status = apr_thread_pool_push(thread_pool, task_thread,
+                                                 task, 0, NULL);
+      if (status == APR_SUCCESS)
+        return SVN_NO_ERROR;
+
+      /* Fall back to synchronous execution. */
+    }
+#endif
+
+  run_task(task);
+  SVN_ERR(signal_done(task));
+
+  /* Without concurrency, deliver the output right away such that the
+   * sequence of callbacks is the same as a simple loop would produce. */
+  if (!queue->concurrent)
+    {
+      SVN_ERR(retire_oldest(queue, TRUE, scratch_pool));
+      return take_error(queue);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_task__queue_deliver_next(svn_task__queue_t *queue,
+                             apr_pool_t *scratch_pool)
+{
+  if (queue->count)
+    SVN_ERR(retire_oldest(queue, TRUE, scratch_pool));
+
+  return take_error(queue);
+}
+
+svn_error_t *
+svn_task__queue_finish(svn_task__queue_t *queue,
+                       apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (queue->count)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(retire_oldest(queue, TRUE, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return take_error(queue);
+}
+
+int
+svn_task__default_concurrency(void)
+{
+#if APR_HAS_THREADS
+  long cores = FALLBACK_CONCURRENCY;
+
+#if defined(SVN_ON_POSIX) && defined(_SC_NPROCESSORS_ONLN)
+  cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cores < 1)
+    cores = FALLBACK_CONCURRENCY;
+#endif
+
+  return (int)MIN(cores, MAX_THREADS);
+#else
+  return 1;
+#endif
+}
@@ -863,6 +863,11 @@ svn_wc__get_pristine_contents_by_checksum(svn_stream_t **contents,
   SVN_ERR(svn_wc__db_pristine_check(&present, wc_ctx->db, wri_abspath,
                                     checksum, scratch_pool));
 
+  /* Another working copy may have it. */
+  if (! present)
+    SVN_ERR(svn_wc__db_pristine_check_shared(&present, wc_ctx->db,
+                                             checksum, scratch_pool));
+
   if (present)
     {
       get_pristine_lazyopen_baton_t *gpl_baton;
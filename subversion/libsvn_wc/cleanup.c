@@ -129,6 +129,9 @@ cleanup_internal(svn_wc__db_t *db,
 
       /* Remove unreferenced pristine texts */
       SVN_ERR(svn_wc__db_pristine_cleanup(db, dir_abspath, scratch_pool));
+
+      /* And those no other working copy uses either */
+      SVN_ERR(svn_wc__db_pristine_cleanup_shared(db, scratch_pool));
     }
 
   if (fix_recorded_timestamps)
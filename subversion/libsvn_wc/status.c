@@ -51,6 +51,8 @@
 #include "private/svn_wc_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_editor.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
 
 
 /* The file internal variant of svn_wc_status3_t, with slightly more
@@ -100,6 +102,10 @@ struct walk_status_baton
 
   /* Repository locks, if set. */
   apr_hash_t *repos_locks;
+
+  /*** Concurrency ***/
+  /* Directory data being read ahead of time, NULL for sequential walks. */
+  struct status_prefetch_t *prefetch;
 };
 
 /*** Editor batons ***/
@@ -1188,6 +1194,381 @@ one_child_status(const struct walk_status_baton *wb,
   return SVN_NO_ERROR;
 }
 
+/*** Reading directories ahead of time ***/
+
+/* Read the children of the directory LOCAL_ABSPATH as needed by
+   get_dir_status() using DB.
+
+   Set *DIRENTS to the on-disk children, or to an empty hash if
+   CHECK_WORKING_COPY is FALSE or LOCAL_ABSPATH does not exist on disk.
+   Set *NODES and *CONFLICTS as svn_wc__db_read_children_info() does.
+   IGNORE_TEXT_MODS has the same meaning as in walk_status_baton.
+
+   Allocate the results in RESULT_POOL and use SCRATCH_POOL for
+   temporaries. */
+static svn_error_t *
+read_dir_children(apr_hash_t **dirents,
+                  apr_hash_t **nodes,
+                  apr_hash_t **conflicts,
+                  svn_wc__db_t *db,
+                  const char *local_abspath,
+                  svn_boolean_t check_working_copy,
+                  svn_boolean_t ignore_text_mods,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  if (check_working_copy)
+    {
+      svn_wc__status_monitor_t *monitor = svn_wc__db_get_status_monitor(db);
+      svn_error_t *err;
+
+      if (monitor)
+        err = svn_wc__status_monitor_get_dirents(dirents, monitor,
+                                                 local_abspath,
+                                                 result_pool, scratch_pool);
+      else
+        err = svn_io_get_dirents3(dirents, local_abspath,
+                                  ignore_text_mods /* only_check_type*/,
+                                  result_pool, scratch_pool);
+      if (err
+          && (APR_STATUS_IS_ENOENT(err->apr_err)
+              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+        {
+          svn_error_clear(err);
+          *dirents = apr_hash_make(result_pool);
+        }
+      else
+        SVN_ERR(err);
+    }
+  else
+    *dirents = apr_hash_make(result_pool);
+
+  SVN_ERR(svn_wc__db_read_children_info(nodes, conflicts,
+                                        db, local_abspath,
+                                        !check_working_copy,
+                                        result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of children of a directory, in walk order, to look ahead of the
+   one being reported when scheduling reads for sub-directories.  This
+   is multiplied by the number of worker threads. */
+#define PREFETCH_WINDOW 8
+
+/* Data of a single directory, read by a worker thread. */
+typedef struct prefetch_dir_t
+{
+  /* Root pool owned by this structure.  It contains this structure and
+     all of the data below. */
+  apr_pool_t *pool;
+
+  /* The directory being read and the shared state of the walk. */
+  const char *local_abspath;
+  struct status_prefetch_t *prefetch;
+
+  /* The results of read_dir_children(). */
+  apr_hash_t *dirents;
+  apr_hash_t *nodes;
+  apr_hash_t *conflicts;
+
+  /* Error returned by read_dir_children().  It is not fatal, the walk
+     will simply read the directory itself. */
+  svn_error_t *error;
+
+  /* Set once the output of the respective task has been delivered,
+     i.e. once the data above may be used by the walking thread. */
+  svn_boolean_t ready;
+} prefetch_dir_t;
+
+/* A database context to be used by one worker thread at a time. */
+typedef struct prefetch_reader_t
+{
+  /* Root pool containing DB and all of its state. */
+  apr_pool_t *pool;
+  svn_wc__db_t *db;
+} prefetch_reader_t;
+
+/* State shared by all directory reads of a status walk. */
+typedef struct status_prefetch_t
+{
+  /* Runs the directory reads, at most one per reader at any time. */
+  svn_task__queue_t *queue;
+
+  /* Options of the walk, as in walk_status_baton. */
+  svn_boolean_t check_working_copy;
+  svn_boolean_t ignore_text_mods;
+
+  /* Number of children ahead of the current one to schedule for reading,
+     see PREFETCH_WINDOW. */
+  int window;
+
+  /* Directories scheduled for reading but not yet taken by the walk.
+     Maps const char *local_abspath to prefetch_dir_t *.  This is only
+     ever accessed by the walking thread. */
+  apr_hash_t *dirs;
+
+  /* All READER_COUNT readers, with the first IDLE_COUNT entries in IDLE
+     being currently unused.  IDLE is guarded by MUTEX. */
+  prefetch_reader_t *readers;
+  int reader_count;
+  prefetch_reader_t **idle;
+  int idle_count;
+  svn_mutex__t *mutex;
+} status_prefetch_t;
+
+/* Pool cleanup function destroying the root pool DATA. */
+static apr_status_t
+destroy_root_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
+/* Pool cleanup function releasing all data held by the status_prefetch_t
+   given by DATA.  Must only run after all tasks have finished, i.e. after
+   the pre-cleanup of the task queue. */
+static apr_status_t
+cleanup_prefetch(void *data)
+{
+  status_prefetch_t *prefetch = data;
+  apr_hash_index_t *hi;
+  int i;
+
+  for (hi = apr_hash_first(NULL, prefetch->dirs); hi; hi = apr_hash_next(hi))
+    {
+      prefetch_dir_t *dir = apr_hash_this_val(hi);
+
+      svn_error_clear(dir->error);
+      svn_pool_destroy(dir->pool);
+    }
+
+  for (i = 0; i < prefetch->reader_count; ++i)
+    svn_pool_destroy(prefetch->readers[i].pool);
+
+  return APR_SUCCESS;
+}
+
+/* Create the state for reading directories of a walk over DB with THREADS
+   worker threads in *PREFETCH.  CHECK_WORKING_COPY and IGNORE_TEXT_MODS
+   are the options of the walk.  Allocate *PREFETCH in RESULT_POOL; all
+   outstanding reads will be waited for when RESULT_POOL gets cleaned up.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+create_prefetch(status_prefetch_t **prefetch,
+                svn_wc__db_t *db,
+                int threads,
+                svn_boolean_t check_working_copy,
+                svn_boolean_t ignore_text_mods,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  status_prefetch_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  int i;
+
+  result->check_working_copy = check_working_copy;
+  result->ignore_text_mods = ignore_text_mods;
+  result->window = threads * PREFETCH_WINDOW;
+  result->dirs = apr_hash_make(result_pool);
+  result->readers = apr_pcalloc(result_pool,
+                                threads * sizeof(*result->readers));
+  result->idle = apr_pcalloc(result_pool, threads * sizeof(*result->idle));
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, result_pool));
+
+  /* The queue's pre-cleanup will wait for all tasks to finish before
+   * this releases their data. */
+  apr_pool_cleanup_register(result_pool, result, cleanup_prefetch,
+                            apr_pool_cleanup_null);
+
+  /* The readers are only being created here, in the thread that owns DB.
+   * They will open their SQLite connections lazily upon first use. */
+  for (i = 0; i < threads; ++i)
+    {
+      prefetch_reader_t *reader = &result->readers[i];
+
+      reader->pool = svn_pool_create(NULL);
+      result->reader_count++;
+      SVN_ERR(svn_wc__db_open_reader(&reader->db, db, reader->pool,
+                                     scratch_pool));
+      result->idle[result->idle_count++] = reader;
+    }
+
+  SVN_ERR(svn_task__queue_create(&result->queue, threads, result_pool));
+
+  *prefetch = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove an unused reader from PREFETCH and return it in *READER.
+   To be called while holding PREFETCH->MUTEX. */
+static svn_error_t *
+take_reader(prefetch_reader_t **reader,
+            status_prefetch_t *prefetch)
+{
+  /* There are as many readers as tasks may be running. */
+  SVN_ERR_ASSERT(prefetch->idle_count > 0);
+  *reader = prefetch->idle[--prefetch->idle_count];
+
+  return SVN_NO_ERROR;
+}
+
+/* Return READER to the unused readers of PREFETCH.
+   To be called while holding PREFETCH->MUTEX. */
+static svn_error_t *
+release_reader(status_prefetch_t *prefetch,
+               prefetch_reader_t *reader)
+{
+  prefetch->idle[prefetch->idle_count++] = reader;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Fill the prefetch_dir_t given as
+   PROCESS_BATON using one of the readers. */
+static svn_error_t *
+prefetch_dir_process(void **result,
+                     void *process_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  prefetch_dir_t *dir = process_baton;
+  status_prefetch_t *prefetch = dir->prefetch;
+  prefetch_reader_t *reader;
+
+  SVN_MUTEX__WITH_LOCK(prefetch->mutex, take_reader(&reader, prefetch));
+
+  dir->error = read_dir_children(&dir->dirents, &dir->nodes,
+                                 &dir->conflicts, reader->db,
+                                 dir->local_abspath,
+                                 prefetch->check_working_copy,
+                                 prefetch->ignore_text_mods,
+                                 dir->pool, scratch_pool);
+
+  SVN_MUTEX__WITH_LOCK(prefetch->mutex, release_reader(prefetch, reader));
+
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Mark the prefetch_dir_t given as
+   OUTPUT_BATON as ready to be used. */
+static svn_error_t *
+prefetch_dir_output(void *result,
+                    void *output_baton,
+                    apr_pool_t *scratch_pool)
+{
+  prefetch_dir_t *dir = output_baton;
+  dir->ready = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE, if a status walk with DEPTH will call get_dir_status() for
+   a child with the given INFO. This mirrors the conditions in
+   one_child_status(). */
+static svn_boolean_t
+will_descend(const struct svn_wc__db_info_t *info,
+             svn_depth_t depth)
+{
+  return depth == svn_depth_infinity
+      && info
+      && info->has_descendants
+      && info->status != svn_wc__db_status_not_present
+      && info->status != svn_wc__db_status_excluded
+      && info->status != svn_wc__db_status_server_excluded
+      && !(info->kind == svn_node_unknown
+           && info->status == svn_wc__db_status_normal);
+}
+
+/* Schedule reading those children of the directory DIR_ABSPATH that the
+   walk will descend into, as given by SORTED_CHILDREN and NODES, up to
+   PREFETCH->WINDOW entries ahead of the child at index CURRENT.  *NEXT
+   is the index of the first child not considered yet; update it
+   accordingly.  DEPTH is the depth of the walk below DIR_ABSPATH.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+prefetch_children(status_prefetch_t *prefetch,
+                  const char *dir_abspath,
+                  const apr_array_header_t *sorted_children,
+                  apr_hash_t *nodes,
+                  svn_depth_t depth,
+                  int current,
+                  int *next,
+                  apr_pool_t *scratch_pool)
+{
+  for (; *next < sorted_children->nelts
+         && *next < current + prefetch->window;
+       ++*next)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_children, *next,
+                                              svn_sort__item_t);
+      apr_pool_t *pool;
+      prefetch_dir_t *dir;
+
+      if (!will_descend(apr_hash_get(nodes, item->key, item->klen), depth))
+        continue;
+
+      /* The directory data will be written by some worker thread and
+       * must therefore live in a separate root pool. */
+      pool = svn_pool_create(NULL);
+      dir = apr_pcalloc(pool, sizeof(*dir));
+      dir->pool = pool;
+      dir->local_abspath = svn_dirent_join(dir_abspath, item->key, pool);
+      dir->prefetch = prefetch;
+
+      svn_hash_sets(prefetch->dirs, dir->local_abspath, dir);
+      SVN_ERR(svn_task__queue_push(prefetch->queue,
+                                   prefetch_dir_process, dir,
+                                   prefetch_dir_output, dir,
+                                   scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* If LOCAL_ABSPATH has been scheduled for reading in PREFETCH, wait for
+   the read to complete and set *DIR to the result.  Otherwise, or if
+   reading failed, set *DIR to NULL.  The result will be released when
+   RESULT_POOL gets cleaned up.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+take_prefetched_dir(prefetch_dir_t **dir,
+                    status_prefetch_t *prefetch,
+                    const char *local_abspath,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  prefetch_dir_t *result = svn_hash_gets(prefetch->dirs, local_abspath);
+
+  *dir = NULL;
+  if (!result)
+    return SVN_NO_ERROR;
+
+  /* Outputs are delivered in scheduling order, so this will also make
+   * all directories scheduled before RESULT ready. */
+  while (!result->ready)
+    SVN_ERR(svn_task__queue_deliver_next(prefetch->queue, scratch_pool));
+
+  /* RESULT is no longer accessed by any worker.  Pass ownership on. */
+  svn_hash_sets(prefetch->dirs, local_abspath, NULL);
+  apr_pool_cleanup_register(result_pool, result->pool, destroy_root_pool,
+                            apr_pool_cleanup_null);
+
+  if (result->error)
+    {
+      /* E.g. the database could not be opened a second time.  Let the
+       * caller try again without any concurrency. */
+      svn_error_clear(result->error);
+      result->error = SVN_NO_ERROR;
+    }
+  else
+    {
+      *dir = result;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Send svn_wc_status3_t * structures for the directory LOCAL_ABSPATH and
    for all its child nodes (according to DEPTH) through STATUS_FUNC /
    STATUS_BATON.
@@ -1233,8 +1614,9 @@ get_dir_status(const struct walk_status_baton *wb,
   apr_hash_t *dirents, *nodes, *conflicts, *all_children;
   apr_array_header_t *sorted_children;
   apr_array_header_t *collected_ignore_patterns = NULL;
+  prefetch_dir_t *prefetched = NULL;
   apr_pool_t *iterpool;
-  svn_error_t *err;
+  int prefetch_next = 0;
   int i;
 
   if (cancel_func)
@@ -1245,23 +1627,24 @@ get_dir_status(const struct walk_status_baton *wb,
 
   iterpool = svn_pool_create(scratch_pool);
 
-  if (wb->check_working_copy)
+  if (wb->prefetch)
+    SVN_ERR(take_prefetched_dir(&prefetched, wb->prefetch, local_abspath,
+                                scratch_pool, iterpool));
+
+  if (prefetched)
     {
-      err = svn_io_get_dirents3(&dirents, local_abspath,
-                                wb->ignore_text_mods /* only_check_type*/,
-                                scratch_pool, iterpool);
-      if (err
-          && (APR_STATUS_IS_ENOENT(err->apr_err)
-              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
-        {
-          svn_error_clear(err);
-          dirents = apr_hash_make(scratch_pool);
-        }
-      else
-        SVN_ERR(err);
+      dirents = prefetched->dirents;
+      nodes = prefetched->nodes;
+      conflicts = prefetched->conflicts;
     }
   else
-    dirents = apr_hash_make(scratch_pool);
+    {
+      SVN_ERR(read_dir_children(&dirents, &nodes, &conflicts,
+                                wb->db, local_abspath,
+                                wb->check_working_copy,
+                                wb->ignore_text_mods,
+                                scratch_pool, iterpool));
+    }
 
   if (!dir_info)
     SVN_ERR(svn_wc__db_read_single_info(&dir_info, wb->db, local_abspath,
@@ -1278,11 +1661,6 @@ get_dir_status(const struct walk_status_baton *wb,
   /* Create a hash containing all children.  The source hashes
      don't all map the same types, but only the keys of the result
      hash are subsequently used. */
-  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts,
-                                        wb->db, local_abspath,
-                                        !wb->check_working_copy,
-                                        scratch_pool, iterpool));
-
   all_children = apr_hash_overlay(scratch_pool, nodes, dirents);
   if (apr_hash_count(conflicts) > 0)
     all_children = apr_hash_overlay(scratch_pool, conflicts, all_children);
@@ -1355,6 +1733,12 @@ get_dir_status(const struct walk_status_baton *wb,
       key = item.key;
       klen = item.klen;
 
+      /* Keep the worker threads busy with the sub-directories ahead. */
+      if (wb->prefetch)
+        SVN_ERR(prefetch_children(wb->prefetch, local_abspath,
+                                  sorted_children, nodes, depth,
+                                  i, &prefetch_next, iterpool));
+
       child_abspath = svn_dirent_join(local_abspath, key, iterpool);
       child_dirent = apr_hash_get(dirents, key, klen);
       child_info = apr_hash_get(nodes, key, klen);
@@ -2513,6 +2897,7 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
   eb->wb.check_working_copy = check_working_copy;
   eb->wb.repos_locks      = NULL;
   eb->wb.repos_root       = NULL;
+  eb->wb.prefetch         = NULL;
 
   SVN_ERR(svn_wc__db_externals_defined_below(&eb->wb.externals,
                                              wc_ctx->db, eb->target_abspath,
@@ -2619,19 +3004,23 @@ stat_wc_dirent_case_sensitive(const svn_io_dirent2_t **dirent,
                                 result_pool, scratch_pool));
 }
 
-svn_error_t *
-svn_wc__internal_walk_status(svn_wc__db_t *db,
-                             const char *local_abspath,
-                             svn_depth_t depth,
-                             svn_boolean_t get_all,
-                             svn_boolean_t no_ignore,
-                             svn_boolean_t ignore_text_mods,
-                             const apr_array_header_t *ignore_patterns,
-                             svn_wc_status_func4_t status_func,
-                             void *status_baton,
-                             svn_cancel_func_t cancel_func,
-                             void *cancel_baton,
-                             apr_pool_t *scratch_pool)
+/* Implement svn_wc__internal_walk_status(), reading the directories of
+   the tree ahead of time in up to THREADS worker threads.  The sequence of
+   STATUS_FUNC calls does not depend on THREADS. */
+static svn_error_t *
+walk_status(svn_wc__db_t *db,
+            int threads,
+            const char *local_abspath,
+            svn_depth_t depth,
+            svn_boolean_t get_all,
+            svn_boolean_t no_ignore,
+            svn_boolean_t ignore_text_mods,
+            const apr_array_header_t *ignore_patterns,
+            svn_wc_status_func4_t status_func,
+            void *status_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *scratch_pool)
 {
   struct walk_status_baton wb;
   const svn_io_dirent2_t *dirent;
@@ -2644,6 +3033,7 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   wb.check_working_copy = TRUE;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.prefetch = NULL;
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2690,6 +3080,18 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
       && info->status != svn_wc__db_status_excluded
       && info->status != svn_wc__db_status_server_excluded)
     {
+      apr_pool_t *prefetch_pool = NULL;
+
+      /* Only deep walks have enough directories to read concurrently. */
+      if (threads > 1
+          && (depth == svn_depth_infinity || depth == svn_depth_unknown))
+        {
+          prefetch_pool = svn_pool_create(scratch_pool);
+          SVN_ERR(create_prefetch(&wb.prefetch, db, threads,
+                                  wb.check_working_copy, ignore_text_mods,
+                                  prefetch_pool, scratch_pool));
+        }
+
       SVN_ERR(get_dir_status(&wb,
                              local_abspath,
                              FALSE /* skip_root */,
@@ -2703,6 +3105,10 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
                              status_func, status_baton,
                              cancel_func, cancel_baton,
                              scratch_pool));
+
+      /* Wait for the remaining reads, if any, and release all readers. */
+      if (prefetch_pool)
+        svn_pool_destroy(prefetch_pool);
     }
   else
     {
@@ -2735,6 +3141,30 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__internal_walk_status(svn_wc__db_t *db,
+                             const char *local_abspath,
+                             svn_depth_t depth,
+                             svn_boolean_t get_all,
+                             svn_boolean_t no_ignore,
+                             svn_boolean_t ignore_text_mods,
+                             const apr_array_header_t *ignore_patterns,
+                             svn_wc_status_func4_t status_func,
+                             void *status_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  /* Our callers may have uncommitted changes in DB that other connections
+   * would not see.  Stay sequential. */
+  return svn_error_trace(walk_status(db, 1, local_abspath, depth, get_all,
+                                     no_ignore, ignore_text_mods,
+                                     ignore_patterns,
+                                     status_func, status_baton,
+                                     cancel_func, cancel_baton,
+                                     scratch_pool));
+}
+
 svn_error_t *
 svn_wc_walk_status(svn_wc_context_t *wc_ctx,
                    const char *local_abspath,
@@ -2748,20 +3178,52 @@ svn_wc_walk_status(svn_wc_context_t *wc_ctx,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *scratch_pool)
+{
+  /* STATUS_FUNC may change the working copy, which would make directories
+   * read ahead of time stale.  Stay sequential. */
+  return svn_error_trace(
+           walk_status(wc_ctx->db, 1,
+                       local_abspath,
+                       depth,
+                       get_all,
+                       no_ignore,
+                       ignore_text_mods,
+                       ignore_patterns,
+                       status_func,
+                       status_baton,
+                       cancel_func,
+                       cancel_baton,
+                       scratch_pool));
+}
+
+svn_error_t *
+svn_wc__walk_status_read_only(svn_wc_context_t *wc_ctx,
+                              const char *local_abspath,
+                              svn_depth_t depth,
+                              svn_boolean_t get_all,
+                              svn_boolean_t no_ignore,
+                              svn_boolean_t ignore_text_mods,
+                              const apr_array_header_t *ignore_patterns,
+                              svn_wc_status_func4_t status_func,
+                              void *status_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool)
 {
   return svn_error_trace(
-           svn_wc__internal_walk_status(wc_ctx->db,
-                                        local_abspath,
-                                        depth,
-                                        get_all,
-                                        no_ignore,
-                                        ignore_text_mods,
-                                        ignore_patterns,
-                                        status_func,
-                                        status_baton,
-                                        cancel_func,
-                                        cancel_baton,
-                                        scratch_pool));
+           walk_status(wc_ctx->db,
+                       svn_wc__db_get_status_threads(wc_ctx->db),
+                       local_abspath,
+                       depth,
+                       get_all,
+                       no_ignore,
+                       ignore_text_mods,
+                       ignore_patterns,
+                       status_func,
+                       status_baton,
+                       cancel_func,
+                       cancel_baton,
+                       scratch_pool));
 }
 
 
@@ -0,0 +1,450 @@
+/*
+ * status_monitor.c:  reuse directory contents across status walks
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+#include <apr_hash.h>
+
+#include "svn_types.h"
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_utf.h"
+
+#include "wc.h"
+#include "wc_db.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_wc_private.h"
+
+#include "svn_private_config.h"
+
+#ifdef HAVE_SYS_INOTIFY_H
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+
+/* A status walk has to readdir() every directory and lstat() every node
+ * in it, only to find out that nothing changed in most of them.  The
+ * monitor keeps the result of reading a directory, i.e. its dirents, and
+ * asks the kernel to tell whenever that directory's contents or the
+ * metadata of any of its children change.  Until then, the next walk can
+ * simply use the kept dirents.
+ *
+ * Changes are being queued by the kernel as they happen.  We only look
+ * at that queue when asked for the contents of a directory, so there is
+ * no need for a separate thread.
+ */
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+/* Events that invalidate the dirents of a watched directory. */
+#define WATCH_MASK (IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MODIFY \
+                    | IN_MOVED_FROM | IN_MOVED_TO                  \
+                    | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+/* A watched directory.  Entries of directories no longer watched get
+   reused for other directories, so the memory used by the monitor is
+   bounded by the number of directories being watched at the same time. */
+typedef struct watched_dir_t
+{
+  /* Absolute path of the directory.  Points into PATH_BUF. */
+  const char *local_abspath;
+  svn_stringbuf_t *path_buf;
+
+  /* Watch descriptor as returned by inotify_add_watch(). */
+  int wd;
+
+  /* Incremented whenever the directory changes.  Used to detect changes
+     while the directory is being read without holding the lock. */
+  apr_uint64_t generation;
+
+  /* The valid dirents of the directory and the pool they are allocated
+     in.  Both are NULL if the directory has not been read since its last
+     change. */
+  apr_hash_t *dirents;
+  apr_pool_t *pool;
+
+  /* Next entry in the monitor's list of unused entries. */
+  struct watched_dir_t *next_free;
+} watched_dir_t;
+
+struct svn_wc__status_monitor_t
+{
+  /* The inotify instance. */
+  int fd;
+
+  /* The DB that uses this monitor. */
+  svn_wc__db_t *db;
+
+  /* Serializes access to all members below, since status walks read
+     directories on multiple threads. */
+  svn_mutex__t *mutex;
+
+  /* Maps const char *local_abspath -> watched_dir_t *. */
+  apr_hash_t *dirs_by_path;
+
+  /* Maps int wd -> watched_dir_t *. */
+  apr_hash_t *dirs_by_wd;
+
+  /* Entries of directories that are no longer being watched. */
+  watched_dir_t *free_dirs;
+
+  /* Number of directories whose kept dirents have been used. */
+  apr_uint64_t hits;
+
+  /* For all of the above. */
+  apr_pool_t *pool;
+};
+
+/* Forget the dirents of DIR. */
+static void
+invalidate_dir(watched_dir_t *dir)
+{
+  dir->generation++;
+  dir->dirents = NULL;
+  if (dir->pool)
+    {
+      svn_pool_destroy(dir->pool);
+      dir->pool = NULL;
+    }
+}
+
+/* Stop tracking DIR in MONITOR and put its entry up for reuse.  If
+   REMOVE_WATCH is TRUE, also tell the kernel to stop watching it. */
+static void
+forget_dir(svn_wc__status_monitor_t *monitor,
+           watched_dir_t *dir,
+           svn_boolean_t remove_watch)
+{
+  invalidate_dir(dir);
+  if (remove_watch)
+    inotify_rm_watch(monitor->fd, dir->wd);
+
+  apr_hash_set(monitor->dirs_by_wd, &dir->wd, sizeof(dir->wd), NULL);
+  apr_hash_set(monitor->dirs_by_path, dir->local_abspath,
+               APR_HASH_KEY_STRING, NULL);
+
+  dir->wd = -1;
+  dir->next_free = monitor->free_dirs;
+  monitor->free_dirs = dir;
+}
+
+/* Process all pending events of MONITOR.  The caller must hold the
+   monitor's lock. */
+static svn_error_t *
+process_events(svn_wc__status_monitor_t *monitor)
+{
+  /* Large enough for at least one event with the longest name and
+     properly aligned for the events. */
+  union
+  {
+    struct inotify_event event;
+    char data[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+  } buffer;
+
+  while (TRUE)
+    {
+      ssize_t len = read(monitor->fd, buffer.data, sizeof(buffer.data));
+      char *p;
+
+      if (len < 0)
+        {
+          if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return SVN_NO_ERROR;
+          if (errno == EINTR)
+            continue;
+
+          return svn_error_wrap_apr(apr_get_os_error(),
+                                    _("Can't read file system events"));
+        }
+
+      for (p = buffer.data; p < buffer.data + len; )
+        {
+          const struct inotify_event *event = (const void *)p;
+          watched_dir_t *dir;
+
+          p += sizeof(*event) + event->len;
+
+          /* The kernel dropped events.  Trust nothing. */
+          if (event->mask & IN_Q_OVERFLOW)
+            {
+              apr_hash_index_t *hi;
+
+              for (hi = apr_hash_first(NULL, monitor->dirs_by_path);
+                   hi;
+                   hi = apr_hash_next(hi))
+                invalidate_dir(apr_hash_this_val(hi));
+
+              continue;
+            }
+
+          dir = apr_hash_get(monitor->dirs_by_wd, &event->wd,
+                             sizeof(event->wd));
+          if (!dir)
+            continue;
+
+          if (event->mask & IN_IGNORED)
+            forget_dir(monitor, dir, FALSE);
+          else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+            forget_dir(monitor, dir, TRUE);
+          else
+            invalidate_dir(dir);
+        }
+    }
+}
+
+/* Set *DIR to the entry for LOCAL_ABSPATH in MONITOR, starting to watch
+   it if necessary.  Set *DIR to NULL if it cannot be watched.  The caller
+   must hold the monitor's lock. */
+static svn_error_t *
+watch_dir(watched_dir_t **dir,
+          svn_wc__status_monitor_t *monitor,
+          const char *local_abspath,
+          apr_pool_t *scratch_pool)
+{
+  const char *local_abspath_native;
+  watched_dir_t *other;
+  int wd;
+
+  *dir = svn_hash_gets(monitor->dirs_by_path, local_abspath);
+  if (*dir)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_utf_cstring_from_utf8(&local_abspath_native,
+                                    svn_dirent_local_style(local_abspath,
+                                                           scratch_pool),
+                                    scratch_pool));
+
+  /* Running out of watches is not an error; just don't cache. */
+  wd = inotify_add_watch(monitor->fd, local_abspath_native, WATCH_MASK);
+  if (wd < 0)
+    return SVN_NO_ERROR;
+
+  /* The same directory may be known under some other name, e.g. if it
+     has been moved.  Keep just the most recent one. */
+  other = apr_hash_get(monitor->dirs_by_wd, &wd, sizeof(wd));
+  if (other)
+    forget_dir(monitor, other, FALSE);
+
+  /* Reused entries keep their generation counter, so that store_dirents()
+     won't mistake them for the directory they used to be. */
+  if (monitor->free_dirs)
+    {
+      *dir = monitor->free_dirs;
+      monitor->free_dirs = (*dir)->next_free;
+      (*dir)->next_free = NULL;
+      svn_stringbuf_set((*dir)->path_buf, local_abspath);
+    }
+  else
+    {
+      *dir = apr_pcalloc(monitor->pool, sizeof(**dir));
+      (*dir)->path_buf = svn_stringbuf_create(local_abspath, monitor->pool);
+    }
+
+  (*dir)->local_abspath = (*dir)->path_buf->data;
+  (*dir)->wd = wd;
+
+  apr_hash_set(monitor->dirs_by_wd, &(*dir)->wd, sizeof((*dir)->wd), *dir);
+  svn_hash_sets(monitor->dirs_by_path, (*dir)->local_abspath, *dir);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a deep copy of the svn_io_dirent2_t hash DIRENTS, allocated in
+   RESULT_POOL. */
+static apr_hash_t *
+dup_dirents(apr_hash_t *dirents,
+            apr_pool_t *result_pool)
+{
+  apr_hash_t *result = apr_hash_make(result_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(NULL, dirents); hi; hi = apr_hash_next(hi))
+    svn_hash_sets(result,
+                  apr_pstrdup(result_pool, apr_hash_this_key(hi)),
+                  svn_io_dirent2_dup(apr_hash_this_val(hi), result_pool));
+
+  return result;
+}
+
+/* Part of svn_wc__status_monitor_get_dirents() to be called with the
+   monitor's lock held.  Set *DIRENTS to a copy of the kept dirents of
+   LOCAL_ABSPATH if there are any, otherwise set *DIRENTS to NULL and
+   *DIR and *GENERATION to what to pass to store_dirents() later. */
+static svn_error_t *
+lookup_dirents(apr_hash_t **dirents,
+               watched_dir_t **dir,
+               apr_uint64_t *generation,
+               svn_wc__status_monitor_t *monitor,
+               const char *local_abspath,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  *dirents = NULL;
+
+  SVN_ERR(process_events(monitor));
+  SVN_ERR(watch_dir(dir, monitor, local_abspath, scratch_pool));
+
+  if (*dir && (*dir)->dirents)
+    {
+      *dirents = dup_dirents((*dir)->dirents, result_pool);
+      monitor->hits++;
+    }
+  else if (*dir)
+    *generation = (*dir)->generation;
+
+  return SVN_NO_ERROR;
+}
+
+/* Part of svn_wc__status_monitor_get_dirents() to be called with the
+   monitor's lock held.  Keep DIRENTS, which have been read for DIR while
+   it was at GENERATION, unless DIR has changed since. */
+static svn_error_t *
+store_dirents(svn_wc__status_monitor_t *monitor,
+              watched_dir_t *dir,
+              apr_uint64_t generation,
+              apr_hash_t *dirents)
+{
+  SVN_ERR(process_events(monitor));
+
+  /* DIR may have been forgotten or even reused in the meantime but then,
+     it has been invalidated before as well. */
+  if (dir->generation != generation || dir->dirents)
+    return SVN_NO_ERROR;
+
+  dir->pool = svn_pool_create(monitor->pool);
+  dir->dirents = dup_dirents(dirents, dir->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* APR pool cleanup handler detaching and closing the monitor BATON. */
+static apr_status_t
+close_monitor(void *baton)
+{
+  svn_wc__status_monitor_t *monitor = baton;
+
+  if (svn_wc__db_get_status_monitor(monitor->db) == monitor)
+    svn_wc__db_set_status_monitor(monitor->db, NULL);
+
+  close(monitor->fd);
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_wc__status_monitor_start(svn_wc_context_t *wc_ctx,
+                             apr_pool_t *result_pool)
+{
+  svn_wc__status_monitor_t *monitor;
+
+  monitor = apr_pcalloc(result_pool, sizeof(*monitor));
+  monitor->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (monitor->fd < 0)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't monitor the file system"));
+
+  monitor->db = wc_ctx->db;
+  monitor->dirs_by_path = apr_hash_make(result_pool);
+  monitor->dirs_by_wd = apr_hash_make(result_pool);
+  monitor->pool = result_pool;
+
+  apr_pool_cleanup_register(result_pool, monitor, close_monitor,
+                            apr_pool_cleanup_null);
+  SVN_ERR(svn_mutex__init(&monitor->mutex, TRUE, result_pool));
+
+  svn_wc__db_set_status_monitor(wc_ctx->db, monitor);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__status_monitor_get_dirents(apr_hash_t **dirents,
+                                   svn_wc__status_monitor_t *monitor,
+                                   const char *local_abspath,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool)
+{
+  watched_dir_t *dir;
+  apr_uint64_t generation = 0;
+
+  SVN_MUTEX__WITH_LOCK(monitor->mutex,
+                       lookup_dirents(dirents, &dir, &generation, monitor,
+                                      local_abspath,
+                                      result_pool, scratch_pool));
+  if (*dirents)
+    return SVN_NO_ERROR;
+
+  /* Read the directory without blocking other threads.  Since we started
+     watching it before, any change from now on will be noticed. */
+  SVN_ERR(svn_io_get_dirents3(dirents, local_abspath,
+                              FALSE /* only_check_type */,
+                              result_pool, scratch_pool));
+
+  if (dir)
+    SVN_MUTEX__WITH_LOCK(monitor->mutex,
+                         store_dirents(monitor, dir, generation, *dirents));
+
+  return SVN_NO_ERROR;
+}
+
+apr_uint64_t
+svn_wc__status_monitor_get_hits(svn_wc__status_monitor_t *monitor)
+{
+  return monitor->hits;
+}
+
+#else /* !HAVE_SYS_INOTIFY_H */
+
+svn_error_t *
+svn_wc__status_monitor_start(svn_wc_context_t *wc_ctx,
+                             apr_pool_t *result_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Monitoring working copies for changes is "
+                            "not supported on this platform"));
+}
+
+svn_error_t *
+svn_wc__status_monitor_get_dirents(apr_hash_t **dirents,
+                                   svn_wc__status_monitor_t *monitor,
+                                   const char *local_abspath,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool)
+{
+  /* No monitor can exist on this platform. */
+  SVN_ERR_MALFUNCTION();
+}
+
+apr_uint64_t
+svn_wc__status_monitor_get_hits(svn_wc__status_monitor_t *monitor)
+{
+  /* No monitor can exist on this platform. */
+  SVN_ERR_MALFUNCTION_NO_RETURN();
+}
+
+#endif /* HAVE_SYS_INOTIFY_H */
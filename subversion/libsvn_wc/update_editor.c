@@ -261,6 +261,10 @@ struct edit_baton
   /* After closing the root directory a copy of its edited value */
   svn_boolean_t edited;
 
+  /* Number of nodes recorded in the currently open wc_db batch or 0 if
+     there is no such batch.  See batch_node(). */
+  int batched_nodes;
+
   apr_pool_t *pool;
 };
 
@@ -468,6 +472,52 @@ get_empty_tmp_file(const char **tmp_filename,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of nodes to record in a single wc_db batch. */
+#define UPDATE_BATCH_SIZE 1000
+
+/* Prepare for recording a node in the BASE tree of EB's working copy.
+
+   Recording every node in its own SQLite transaction makes checkouts of
+   wide directories spend most of their time committing, so collect the
+   nodes in a batch that gets committed at least once per directory by
+   flush_batch(), or after UPDATE_BATCH_SIZE nodes. */
+static svn_error_t *
+batch_node(struct edit_baton *eb,
+           apr_pool_t *scratch_pool)
+{
+  if (eb->batched_nodes >= UPDATE_BATCH_SIZE)
+    {
+      SVN_ERR(svn_wc__db_end_batch(eb->db, eb->wcroot_abspath,
+                                   scratch_pool));
+      eb->batched_nodes = 0;
+    }
+
+  if (eb->batched_nodes == 0)
+    SVN_ERR(svn_wc__db_begin_batch(eb->db, eb->wcroot_abspath,
+                                   scratch_pool));
+
+  eb->batched_nodes++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Commit the nodes recorded in EB's current wc_db batch, if any.  This
+   must happen before running the work queue, so the work items are
+   committed before they get executed, and before invoking the conflict
+   resolver, which may keep the user busy for a while. */
+static svn_error_t *
+flush_batch(struct edit_baton *eb,
+            apr_pool_t *scratch_pool)
+{
+  if (eb->batched_nodes == 0)
+    return SVN_NO_ERROR;
+
+  eb->batched_nodes = 0;
+
+  return svn_error_trace(svn_wc__db_end_batch(eb->db, eb->wcroot_abspath,
+                                              scratch_pool));
+}
+
 /* An APR pool cleanup handler.  This runs the working queue for an
    editor baton. */
 static apr_status_t
@@ -477,9 +527,11 @@ cleanup_edit_baton(void *edit_baton)
   svn_error_t *err;
   apr_pool_t *pool = apr_pool_parent_get(eb->pool);
 
-  err = svn_wc__wq_run(eb->db, eb->wcroot_abspath,
-                       NULL /* cancel_func */, NULL /* cancel_baton */,
-                       pool);
+  err = flush_batch(eb, pool);
+  if (!err)
+    err = svn_wc__wq_run(eb->db, eb->wcroot_abspath,
+                         NULL /* cancel_func */, NULL /* cancel_baton */,
+                         pool);
 
   if (err)
     {
@@ -1808,6 +1860,7 @@ delete_entry(const char *path,
         }
     }
 
+  SVN_ERR(flush_batch(eb, scratch_pool));
   SVN_ERR(svn_wc__wq_run(eb->db, pb->local_abspath,
                          eb->cancel_func, eb->cancel_baton,
                          scratch_pool));
@@ -2173,6 +2226,7 @@ add_directory(const char *path,
                                 : NULL,
                               db->pool, scratch_pool));
 
+  SVN_ERR(batch_node(eb, scratch_pool));
   SVN_ERR(svn_wc__db_base_add_incomplete_directory(
                                      eb->db, db->local_abspath,
                                      db->new_repos_relpath,
@@ -2796,6 +2850,7 @@ close_directory(void *dir_baton,
 
       /* Update the BASE data for the directory and mark the directory
          complete */
+      SVN_ERR(batch_node(eb, scratch_pool));
       SVN_ERR(svn_wc__db_base_add_directory(
                 eb->db, db->local_abspath,
                 eb->wcroot_abspath,
@@ -2816,6 +2871,7 @@ close_directory(void *dir_baton,
     }
 
   /* Process all of the queued work items for this directory.  */
+  SVN_ERR(flush_batch(eb, scratch_pool));
   SVN_ERR(svn_wc__wq_run(eb->db, db->local_abspath,
                          eb->cancel_func, eb->cancel_baton,
                          scratch_pool));
@@ -3032,6 +3088,7 @@ absent_node(const char *path,
 
     if (tree_conflict)
       {
+        SVN_ERR(flush_batch(eb, scratch_pool));
         if (eb->conflict_func)
           SVN_ERR(svn_wc__conflict_invoke_resolver(eb->db, local_abspath,
                                                    kind,
@@ -4558,6 +4615,7 @@ close_file(void *file_baton,
         svn_hash_sets(eb->wcroot_iprops, fb->local_abspath, NULL);
     }
 
+  SVN_ERR(batch_node(eb, scratch_pool));
   SVN_ERR(svn_wc__db_base_add_file(eb->db, fb->local_abspath,
                                    eb->wcroot_abspath,
                                    fb->new_repos_relpath,
@@ -4584,15 +4642,18 @@ close_file(void *file_baton,
                                    scratch_pool));
 
   if (conflict_skel && eb->conflict_func)
-    SVN_ERR(svn_wc__conflict_invoke_resolver(eb->db, fb->local_abspath,
-                                             svn_node_file,
-                                             conflict_skel,
-                                             NULL /* merge_options */,
-                                             eb->conflict_func,
-                                             eb->conflict_baton,
-                                             eb->cancel_func,
-                                             eb->cancel_baton,
-                                             scratch_pool));
+    {
+      SVN_ERR(flush_batch(eb, scratch_pool));
+      SVN_ERR(svn_wc__conflict_invoke_resolver(eb->db, fb->local_abspath,
+                                               svn_node_file,
+                                               conflict_skel,
+                                               NULL /* merge_options */,
+                                               eb->conflict_func,
+                                               eb->conflict_baton,
+                                               eb->cancel_func,
+                                               eb->cancel_baton,
+                                               scratch_pool));
+    }
 
   /* Deal with the WORKING tree, based on updates to the BASE tree.  */
 
@@ -4735,6 +4796,8 @@ close_edit(void *edit_baton,
   struct edit_baton *eb = edit_baton;
   apr_pool_t *scratch_pool = eb->pool;
 
+  SVN_ERR(flush_batch(eb, scratch_pool));
+
   /* The editor didn't even open the root; we have to take care of
      some cleanup stuffs. */
   if (! eb->root_opened
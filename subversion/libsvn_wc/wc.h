@@ -519,6 +519,27 @@ svn_wc__internal_changelist_match(svn_wc__db_t *db,
                                   const apr_hash_t *clhash,
                                   apr_pool_t *scratch_pool);
 
+/* Set *DIRENTS to the on-disk children of the directory LOCAL_ABSPATH,
+   as svn_io_get_dirents3() does with ONLY_CHECK_TYPE set to FALSE, but
+   avoid reading the directory if MONITOR knows that it has not changed.
+   See svn_wc__status_monitor_start().
+
+   Allocate *DIRENTS in RESULT_POOL and use SCRATCH_POOL for temporaries.
+   This function may be called by multiple threads concurrently. */
+svn_error_t *
+svn_wc__status_monitor_get_dirents(apr_hash_t **dirents,
+                                   svn_wc__status_monitor_t *monitor,
+                                   const char *local_abspath,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool);
+
+/* Return how many times svn_wc__status_monitor_get_dirents() has provided
+   the dirents of a directory through MONITOR without reading it.  The
+   caller must make sure that no status walk uses MONITOR at the same
+   time.  For testing. */
+apr_uint64_t
+svn_wc__status_monitor_get_hits(svn_wc__status_monitor_t *monitor);
+
 /* Library-internal version of svn_wc_walk_status(), which see. */
 svn_error_t *
 svn_wc__internal_walk_status(svn_wc__db_t *db,
@@ -264,6 +264,45 @@ svn_wc__db_open(svn_wc__db_t **db,
                 apr_pool_t *scratch_pool);
 
 
+/* Open a new, independent administrative database context in *READER
+   that uses the same settings as DB.  READER shares no state with DB, not
+   even the configuration object, and may therefore be used by a different
+   thread than DB, provided that RESULT_POOL is not used concurrently with
+   DB's pool.  It will open its own SQLite connections and is meant for
+   read-only access.
+
+   Allocate *READER in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_wc__db_open_reader(svn_wc__db_t **reader,
+                       svn_wc__db_t *db,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
+/* Return the number of threads that read-only status walks over DB may
+   use (see svn_wc__walk_status_read_only()), as set by the
+   SVN_CONFIG_OPTION_STATUS_THREADS option.  This will be 1 if DB uses
+   exclusive SQLite locking. */
+int
+svn_wc__db_get_status_threads(svn_wc__db_t *db);
+
+/* Return the number of threads that may write working files while running
+   the work queue of DB, as set by the SVN_CONFIG_OPTION_INSTALL_THREADS
+   option.  All wc.db access still happens on the calling thread. */
+int
+svn_wc__db_get_install_threads(svn_wc__db_t *db);
+
+/* Make status walks over DB and any readers opened for it later use
+   MONITOR, which may be NULL.  See svn_wc__status_monitor_start(). */
+void
+svn_wc__db_set_status_monitor(svn_wc__db_t *db,
+                              svn_wc__status_monitor_t *monitor);
+
+/* Return the monitor set for DB by svn_wc__db_set_status_monitor() or
+   NULL if there is none. */
+svn_wc__status_monitor_t *
+svn_wc__db_get_status_monitor(svn_wc__db_t *db);
+
+
 /* Close DB.  */
 svn_error_t *
 svn_wc__db_close(svn_wc__db_t *db);
@@ -935,6 +974,10 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
    Even if the pristine text is removed from the store while it is being
    read, the stream will remain valid and readable until it is closed.
 
+   If the text is not present in the WC but in the pristine store shared
+   between working copies, as configured for DB, read it from there.  Texts
+   in that store that can be modified by group or others are ignored.
+
    Allocate the stream in RESULT_POOL. */
 svn_error_t *
 svn_wc__db_pristine_read(svn_stream_t **contents,
@@ -1046,6 +1089,13 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             const char *wri_abspath,
                             apr_pool_t *scratch_pool);
 
+/* Remove all pristine texts from the pristine store shared between working
+   copies, as configured for DB, that are no longer used by any working
+   copy.  Do nothing if no such store has been configured. */
+svn_error_t *
+svn_wc__db_pristine_cleanup_shared(svn_wc__db_t *db,
+                                   apr_pool_t *scratch_pool);
+
 
 /* Set *PRESENT to true if the pristine store for WRI_ABSPATH in DB contains
    a pristine text with SHA-1 checksum SHA1_CHECKSUM, and to false otherwise.
@@ -1057,6 +1107,19 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
                           const svn_checksum_t *sha1_checksum,
                           apr_pool_t *scratch_pool);
 
+/* Set *PRESENT to true if the pristine store shared between working copies,
+   as configured for DB, contains a pristine text with SHA-1 checksum
+   SHA1_CHECKSUM, and to false otherwise.  svn_wc__db_pristine_read() will
+   fall back to that store for texts not present in a working copy.
+
+   Only texts owned by the current user, which nobody may write to and
+   whose contents actually match SHA1_CHECKSUM count as present. */
+svn_error_t *
+svn_wc__db_pristine_check_shared(svn_boolean_t *present,
+                                 svn_wc__db_t *db,
+                                 const svn_checksum_t *sha1_checksum,
+                                 apr_pool_t *scratch_pool);
+
 /* @defgroup svn_wc__db_external  External management
    @{ */
 
@@ -3028,6 +3091,30 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* Variant of svn_wc__db_wq_record_and_fetch_next() for running several
+   work items at once.  In one transaction, mark all work items whose ids
+   are listed in COMPLETED_IDS (an array of apr_uint64_t) as completed,
+   record the timestamps and sizes in RECORD_MAP (which may be NULL) and
+   fetch up to MAX_ITEMS of the remaining work items.
+
+   Set *IDS to an array of apr_uint64_t holding the identifiers of the
+   fetched work items and *WORK_ITEMS to an array of svn_skel_t * holding
+   the corresponding data, both in queue order.  Both arrays will be empty
+   if there are no more work items or MAX_ITEMS is 0.
+
+   RESULT_POOL will be used to allocate *IDS and *WORK_ITEMS, and
+   SCRATCH_POOL will be used for all temporary allocations.  */
+svn_error_t *
+svn_wc__db_wq_record_and_fetch_batch(apr_array_header_t **ids,
+                                     apr_array_header_t **work_items,
+                                     svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     const apr_array_header_t *completed_ids,
+                                     apr_hash_t *record_map,
+                                     int max_items,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
 
 /* @} */
 
@@ -3203,6 +3290,29 @@ svn_wc__db_temp_op_end_directory_update(svn_wc__db_t *db,
                                         const char *local_dir_abspath,
                                         apr_pool_t *scratch_pool);
 
+/* Begin collecting all changes to the working copy containing WRI_ABSPATH
+   in a single SQLite transaction, until the matching call to
+   svn_wc__db_end_batch().  This saves the cost of committing every
+   operation on its own when recording many nodes in a row.
+
+   Each operation within the batch still succeeds or fails as a whole.
+   Calls may be nested; only the outermost svn_wc__db_end_batch() commits.
+
+   The database stays write-locked for the duration of the batch, so
+   don't keep it open while waiting for user interaction and end it before
+   running the work queue. */
+svn_error_t *
+svn_wc__db_begin_batch(svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_pool_t *scratch_pool);
+
+/* End a batch started by svn_wc__db_begin_batch() for the working copy
+   containing WRI_ABSPATH and commit all changes made within it. */
+svn_error_t *
+svn_wc__db_end_batch(svn_wc__db_t *db,
+                     const char *wri_abspath,
+                     apr_pool_t *scratch_pool);
+
 
 /* When local_abspath has no WORKING layer, copy the base tree at
    LOCAL_ABSPATH into the working tree as copy, leaving any subtree
@@ -25,6 +25,8 @@
 
 #define SVN_WC__I_AM_WC_DB
 
+#include <apr_user.h>
+
 #include "svn_pools.h"
 #include "svn_io.h"
 #include "svn_dirent_uri.h"
@@ -42,6 +44,43 @@
 
 
 
+/* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
+   holding the local absolute path to the file location within the
+   pristine store directory BASE_DIR_ABSPATH that is dedicated to hold
+   CHECKSUM's pristine file.  The returned path does not necessarily
+   currently exist.
+
+   Any other allocations are made in SCRATCH_POOL. */
+static svn_error_t *
+get_fname_in_store(const char **pristine_abspath,
+                   const char *base_dir_abspath,
+                   const svn_checksum_t *sha1_checksum,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, scratch_pool);
+  char subdir[3];
+
+  /* We should have a valid checksum and (thus) a valid digest. */
+  SVN_ERR_ASSERT(hexdigest != NULL);
+
+  /* Get the first two characters of the digest, for the subdir. */
+  subdir[0] = hexdigest[0];
+  subdir[1] = hexdigest[1];
+  subdir[2] = '\0';
+
+  hexdigest = apr_pstrcat(scratch_pool, hexdigest, PRISTINE_STORAGE_EXT,
+                          SVN_VA_NULL);
+
+  /* The file is located at BASE_DIR/XX/XXYYZZ...svn-base */
+  *pristine_abspath = svn_dirent_join_many(result_pool,
+                                           base_dir_abspath,
+                                           subdir,
+                                           hexdigest,
+                                           SVN_VA_NULL);
+  return SVN_NO_ERROR;
+}
+
 /* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
    holding the local absolute path to the file location that is dedicated
    to hold CHECKSUM's pristine file, relating to the pristine store
@@ -57,8 +96,6 @@ get_pristine_fname(const char **pristine_abspath,
                    apr_pool_t *scratch_pool)
 {
   const char *base_dir_abspath;
-  const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, scratch_pool);
-  char subdir[3];
 
   /* ### code is in transition. make sure we have the proper data.  */
   SVN_ERR_ASSERT(pristine_abspath != NULL);
@@ -72,23 +109,174 @@ get_pristine_fname(const char **pristine_abspath,
                                           PRISTINE_STORAGE_RELPATH,
                                           SVN_VA_NULL);
 
-  /* We should have a valid checksum and (thus) a valid digest. */
-  SVN_ERR_ASSERT(hexdigest != NULL);
+  /* The file is located at DIR/.svn/pristine/XX/XXYYZZ...svn-base */
+  return svn_error_trace(get_fname_in_store(pristine_abspath,
+                                            base_dir_abspath,
+                                            sha1_checksum,
+                                            result_pool, scratch_pool));
+}
 
-  /* Get the first two characters of the digest, for the subdir. */
-  subdir[0] = hexdigest[0];
-  subdir[1] = hexdigest[1];
-  subdir[2] = '\0';
+/* Set *SHARED_ABSPATH to the location of CHECKSUM's pristine file in the
+   pristine store shared between working copies, as configured for DB.
+   Set it to NULL if there is no such store.
 
-  hexdigest = apr_pstrcat(scratch_pool, hexdigest, PRISTINE_STORAGE_EXT,
-                          SVN_VA_NULL);
+   The shared store uses the same layout as the working copy stores.
+   Its files are hard links to pristine files of working copies, so the
+   number of links tells how many working copies use a pristine text;
+   see svn_wc__db_pristine_cleanup_shared().  Since files get only ever
+   created and removed as a whole by link() and unlink(), concurrent
+   access to the shared store by multiple processes is safe.
+
+   Allocate *SHARED_ABSPATH in RESULT_POOL and use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+get_shared_pristine_fname(const char **shared_abspath,
+                          svn_wc__db_t *db,
+                          const svn_checksum_t *sha1_checksum,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  if (! db->shared_pristine_abspath)
+    {
+      *shared_abspath = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(get_fname_in_store(shared_abspath,
+                                            db->shared_pristine_abspath,
+                                            sha1_checksum,
+                                            result_pool, scratch_pool));
+}
+
+/* Create a hard link NEW_ABSPATH to EXISTING_ABSPATH, creating the parent
+   directory of NEW_ABSPATH if necessary.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+link_pristine(const char *existing_abspath,
+              const char *new_abspath,
+              apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  err = svn_io__file_link(existing_abspath, new_abspath, scratch_pool);
+
+  /* Maybe the directory doesn't exist yet? */
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(new_abspath,
+                                                             scratch_pool),
+                                          scratch_pool));
+      err = svn_io__file_link(existing_abspath, new_abspath, scratch_pool);
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Other users may be able to write to the shared pristine store, so we
+   can't trust just any file in there.  Set *TRUSTED to TRUE if FINFO,
+   obtained with at least APR_FINFO_TYPE, APR_FINFO_OWNER and
+   APR_FINFO_PROT, describes a regular file that belongs to the current
+   user and is read-only even for its owner.  Set it to FALSE otherwise.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+is_trusted_shared_file(svn_boolean_t *trusted,
+                       const apr_finfo_t *finfo,
+                       apr_pool_t *scratch_pool)
+{
+#if defined(APR_HAS_USER) && !defined(WIN32) && !defined(__OS2__)
+  apr_status_t apr_err;
+  apr_uid_t uid;
+  apr_gid_t gid;
+
+  apr_err = apr_uid_current(&uid, &gid, scratch_pool);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Error getting UID of process"));
+
+  *trusted = (finfo->filetype == APR_REG
+              && apr_uid_compare(uid, finfo->user) == APR_SUCCESS
+              && !(finfo->protection
+                   & (APR_UWRITE | APR_GWRITE | APR_WWRITE)));
+#else  /* WIN32 || __OS2__ || !APR_HAS_USER */
+  *trusted = (finfo->filetype == APR_REG
+              && (finfo->protection & APR_FREADONLY));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the pristine text with SHA1_CHECKSUM in the pristine store shared
+   between working copies, as configured for DB, for reading and return
+   it in *FILE, allocated in RESULT_POOL.  Set *SIZE to the size of that
+   text in bytes.
+
+   Set *FILE to NULL if that text is not present, if is_trusted_shared_file()
+   rejects it or if its contents don't match SHA1_CHECKSUM.  Since all
+   checks use the open file, they cover the very file that the caller
+   will read, even if the shared store gets modified concurrently.
+
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+open_shared_pristine(apr_file_t **file,
+                     svn_filesize_t *size,
+                     svn_wc__db_t *db,
+                     const svn_checksum_t *sha1_checksum,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const char *shared_abspath;
+  apr_finfo_t finfo;
+  apr_off_t offset;
+  svn_boolean_t trusted;
+  svn_error_t *err;
+
+  *file = NULL;
+
+  SVN_ERR(get_shared_pristine_fname(&shared_abspath, db, sha1_checksum,
+                                    scratch_pool, scratch_pool));
+  if (! shared_abspath)
+    return SVN_NO_ERROR;
+
+  err = svn_io_file_open(file, shared_abspath, APR_READ, APR_OS_DEFAULT,
+                         result_pool);
+  if (err && (APR_STATUS_IS_ENOENT(err->apr_err)
+              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+    {
+      svn_error_clear(err);
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_io_file_info_get(&finfo,
+                               APR_FINFO_SIZE | APR_FINFO_TYPE
+                                 | APR_FINFO_OWNER | APR_FINFO_PROT,
+                               *file, scratch_pool));
+  SVN_ERR(is_trusted_shared_file(&trusted, &finfo, scratch_pool));
+
+  if (trusted)
+    {
+      svn_checksum_t *actual_checksum;
+      svn_stream_t *stream = svn_stream_from_aprfile2(*file, TRUE,
+                                                      scratch_pool);
+
+      SVN_ERR(svn_stream_contents_checksum(&actual_checksum, stream,
+                                           svn_checksum_sha1,
+                                           scratch_pool, scratch_pool));
+      trusted = svn_checksum_match(actual_checksum, sha1_checksum);
+    }
+
+  if (! trusted)
+    {
+      SVN_ERR(svn_io_file_close(*file, scratch_pool));
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  offset = 0;
+  SVN_ERR(svn_io_file_seek(*file, APR_SET, &offset, scratch_pool));
+  *size = finfo.size;
 
-  /* The file is located at DIR/.svn/pristine/XX/XXYYZZ...svn-base */
-  *pristine_abspath = svn_dirent_join_many(result_pool,
-                                           base_dir_abspath,
-                                           subdir,
-                                           hexdigest,
-                                           SVN_VA_NULL);
   return SVN_NO_ERROR;
 }
 
@@ -214,6 +402,86 @@ pristine_read_txn(svn_stream_t **contents,
   return SVN_NO_ERROR;
 }
 
+/* Like pristine_read_txn() but for the pristine text with SHA1_CHECKSUM
+ * in the pristine store shared between working copies, as configured
+ * for DB.  Return SVN_ERR_WC_PATH_NOT_FOUND if open_shared_pristine()
+ * does not provide that text.
+ */
+static svn_error_t *
+shared_pristine_read(svn_stream_t **contents,
+                     svn_filesize_t *size,
+                     svn_wc__db_t *db,
+                     const svn_checksum_t *sha1_checksum,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_filesize_t file_size;
+
+  SVN_ERR(open_shared_pristine(&file, &file_size, db, sha1_checksum,
+                               result_pool, scratch_pool));
+  if (! file)
+    return svn_error_createf(SVN_ERR_WC_PATH_NOT_FOUND, NULL,
+                             _("Pristine text '%s' not present"),
+                             svn_checksum_to_cstring_display(
+                               sha1_checksum, scratch_pool));
+
+  if (size)
+    *size = file_size;
+
+  if (contents)
+    *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
+  else
+    SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_wc__db_pristine_read() for the pristine store of WCROOT,
+ * falling back to the pristine store shared between working copies, as
+ * configured for DB, if WCROOT does not have the text. */
+static svn_error_t *
+pristine_read(svn_stream_t **contents,
+              svn_filesize_t *size,
+              svn_wc__db_t *db,
+              svn_wc__db_wcroot_t *wcroot,
+              const svn_checksum_t *sha1_checksum,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  const char *pristine_abspath;
+  svn_error_t *err;
+
+  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                             sha1_checksum,
+                             scratch_pool, scratch_pool));
+
+  /* Like SVN_WC__DB_WITH_TXN() but keep the error for inspection. */
+  SVN_ERR(svn_sqlite__begin_savepoint(wcroot->sdb));
+  err = pristine_read_txn(contents, size,
+                          wcroot, sha1_checksum, pristine_abspath,
+                          result_pool, scratch_pool);
+  err = svn_sqlite__finish_savepoint(wcroot->sdb, err);
+
+  /* Not in this working copy but maybe some other one has it? */
+  if (err && err->apr_err == SVN_ERR_WC_PATH_NOT_FOUND
+      && db->shared_pristine_abspath)
+    {
+      svn_error_t *err2 = shared_pristine_read(contents, size, db,
+                                               sha1_checksum,
+                                               result_pool, scratch_pool);
+      if (! err2)
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+
+      svn_error_clear(err2);
+    }
+
+  return svn_error_trace(err);
+}
+
 svn_error_t *
 svn_wc__db_pristine_read(svn_stream_t **contents,
                          svn_filesize_t *size,
@@ -225,7 +493,6 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
-  const char *pristine_abspath;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
 
@@ -243,16 +510,9 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
                               wri_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
-  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
-                             sha1_checksum,
-                             scratch_pool, scratch_pool));
-  SVN_WC__DB_WITH_TXN(
-    pristine_read_txn(contents, size,
-                      wcroot, sha1_checksum, pristine_abspath,
-                      result_pool, scratch_pool),
-    wcroot);
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(pristine_read(contents, size, db, wcroot,
+                                       sha1_checksum,
+                                       result_pool, scratch_pool));
 }
 
 
@@ -268,10 +528,80 @@ pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
                               PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
 }
 
+/* Try to make PRISTINE_ABSPATH a hard link to SHARED_ABSPATH, the same
+ * pristine text in the pristine store shared between working copies.
+ * SIZE and SHA1_CHECKSUM describe that text.  Set *LINKED to TRUE on
+ * success and to FALSE if the shared store does not (fully) provide the
+ * text or a link cannot be created, e.g. because the stores are on
+ * different file systems.
+ *
+ * Other users may be able to write to the shared store, so don't trust
+ * its contents: only keep the link if is_trusted_shared_file() accepts
+ * the linked file and its contents match SHA1_CHECKSUM.  Checking the
+ * link rather than SHARED_ABSPATH makes sure that we verify the very
+ * file we keep, even if SHARED_ABSPATH gets replaced concurrently.
+ */
+static svn_error_t *
+link_from_shared_store(svn_boolean_t *linked,
+                       const char *shared_abspath,
+                       const char *pristine_abspath,
+                       apr_off_t size,
+                       const svn_checksum_t *sha1_checksum,
+                       apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  svn_boolean_t trusted;
+  svn_checksum_t *actual_checksum;
+  svn_error_t *err;
+
+  *linked = FALSE;
+
+  err = svn_io_stat(&finfo, shared_abspath, APR_FINFO_SIZE | APR_FINFO_TYPE,
+                    scratch_pool);
+  if (err || finfo.filetype != APR_REG || finfo.size != size)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* Any file already at PRISTINE_ABSPATH is an orphan. */
+  SVN_ERR(svn_io_remove_file2(pristine_abspath, TRUE, scratch_pool));
+
+  err = link_pristine(shared_abspath, pristine_abspath, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_stat(&finfo, pristine_abspath,
+                      APR_FINFO_SIZE | APR_FINFO_TYPE | APR_FINFO_OWNER
+                        | APR_FINFO_PROT,
+                      scratch_pool));
+  SVN_ERR(is_trusted_shared_file(&trusted, &finfo, scratch_pool));
+  if (trusted && finfo.size == size)
+    {
+      SVN_ERR(svn_io_file_checksum2(&actual_checksum, pristine_abspath,
+                                    svn_checksum_sha1, scratch_pool));
+      *linked = svn_checksum_match(actual_checksum, sha1_checksum);
+    }
+
+  /* Don't let a corrupt or planted text into our store. */
+  if (! *linked)
+    SVN_ERR(svn_io_remove_file2(pristine_abspath, TRUE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Install the pristine text described by BATON into the pristine store of
  * SDB.  If it is already stored then just delete the new file
  * BATON->tempfile_abspath.
  *
+ * If SHARED_ABSPATH is not NULL, it is the location of the text in the
+ * pristine store shared between working copies.  Link to the text found
+ * there instead of installing the new file, or publish the new file
+ * there if it is not present yet.
+ *
  * This function expects to be executed inside a SQLite txn that has already
  * acquired a 'RESERVED' lock.
  *
@@ -287,6 +617,8 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
                      const svn_checksum_t *sha1_checksum,
                      /* The pristine text's MD-5 checksum. */
                      const svn_checksum_t *md5_checksum,
+                     /* The location in the shared pristine store or NULL. */
+                     const char *shared_abspath,
                      apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
@@ -333,18 +665,40 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
    * an orphan file and it doesn't matter if we overwrite it.) */
   {
     apr_finfo_t finfo;
+    svn_boolean_t linked = FALSE;
+
     SVN_ERR(svn_stream__install_get_info(&finfo, install_stream,
                                          APR_FINFO_SIZE, scratch_pool));
-    SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
-                                       TRUE, scratch_pool));
+
+    /* Share the text with other working copies if possible. */
+    if (shared_abspath)
+      SVN_ERR(link_from_shared_store(&linked, shared_abspath,
+                                     pristine_abspath, finfo.size,
+                                     sha1_checksum, scratch_pool));
+
+    if (linked)
+      {
+        SVN_ERR(svn_stream__install_delete(install_stream, scratch_pool));
+      }
+    else
+      {
+        SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
+                                           TRUE, scratch_pool));
+        SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE,
+                                          scratch_pool));
+
+        /* Publish the new text.  If some other process has been faster or
+         * the shared store is not usable for us, just keep our own copy. */
+        if (shared_abspath)
+          svn_error_clear(link_pristine(pristine_abspath, shared_abspath,
+                                        scratch_pool));
+      }
 
     SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
     SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
     SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, scratch_pool));
     SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
     SVN_ERR(svn_sqlite__insert(NULL, stmt));
-
-    SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
   }
 
   return SVN_NO_ERROR;
@@ -354,6 +708,7 @@ struct svn_wc__db_install_data_t
 {
   svn_wc__db_wcroot_t *wcroot;
   svn_stream_t *inner_stream;
+  svn_wc__db_t *db;
 };
 
 svn_error_t *
@@ -380,6 +735,7 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   *install_data = apr_pcalloc(result_pool, sizeof(**install_data));
   (*install_data)->wcroot = wcroot;
+  (*install_data)->db = db;
 
   SVN_ERR_W(svn_stream__create_for_install(stream,
                                            temp_dir_abspath,
@@ -406,6 +762,7 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
 {
   svn_wc__db_wcroot_t *wcroot = install_data->wcroot;
   const char *pristine_abspath;
+  const char *shared_abspath;
 
   SVN_ERR_ASSERT(sha1_checksum != NULL);
   SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
@@ -415,15 +772,18 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
   SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
                              sha1_checksum,
                              scratch_pool, scratch_pool));
+  SVN_ERR(get_shared_pristine_fname(&shared_abspath, install_data->db,
+                                    sha1_checksum,
+                                    scratch_pool, scratch_pool));
 
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
    * at the disk, to ensure no concurrent pristine install/delete txn. */
-  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+  SVN_WC__DB_WITH_IMMEDIATE_TXN(
     pristine_install_txn(wcroot->sdb,
                          install_data->inner_stream, pristine_abspath,
-                         sha1_checksum, md5_checksum,
+                         sha1_checksum, md5_checksum, shared_abspath,
                          scratch_pool),
-    wcroot->sdb);
+    wcroot);
 
   return SVN_NO_ERROR;
 }
@@ -532,6 +892,7 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
   const char *tmp_abspath;
   const char *src_abspath;
   int affected_rows;
+  svn_boolean_t copied;
   svn_error_t *err;
 
   SVN_ERR(svn_sqlite__get_statement(&stmt, dst_wcroot->sdb,
@@ -558,10 +919,23 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
   SVN_ERR(svn_stream_open_readonly(&src_stream, src_abspath,
                                    scratch_pool, scratch_pool));
 
+  /* Pristines are never modified in place, so let them share their data
+     blocks if the file system supports it.  */
+  SVN_ERR(svn_io__file_copy_in_kernel(&copied,
+                                      svn_stream__aprfile(src_stream),
+                                      svn_stream__aprfile(dst_stream),
+                                      scratch_pool));
+
   /* ### Should we verify the SHA1 or MD5 here, or is that too expensive? */
-  SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
-                           cancel_func, cancel_baton,
-                           scratch_pool));
+  if (copied)
+    {
+      SVN_ERR(svn_stream_close(src_stream));
+      SVN_ERR(svn_stream_close(dst_stream));
+    }
+  else
+    SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
+                             cancel_func, cancel_baton,
+                             scratch_pool));
 
   SVN_ERR(get_pristine_fname(&pristine_abspath, dst_wcroot->abspath, checksum,
                              scratch_pool, scratch_pool));
@@ -746,10 +1120,10 @@ pristine_remove_if_unreferenced(svn_wc__db_wcroot_t *wcroot,
 
   /* Ensure the SQL txn has at least a 'RESERVED' lock before we start looking
    * at the disk, to ensure no concurrent pristine install/delete txn. */
-  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+  SVN_WC__DB_WITH_IMMEDIATE_TXN(
     pristine_remove_if_unreferenced_txn(
       wcroot->sdb, wcroot, sha1_checksum, pristine_abspath, scratch_pool),
-    wcroot->sdb);
+    wcroot);
 
   return SVN_NO_ERROR;
 }
@@ -882,6 +1256,55 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_io_walk_func_t for svn_wc__db_pristine_cleanup_shared().
+ *
+ * Every working copy that uses a text in the shared store holds a hard
+ * link to it, so a file that has just a single link left is not used by
+ * any working copy.  Remove it.  If some working copy links to the file
+ * concurrently, that link keeps the text alive.
+ */
+static svn_error_t *
+cleanup_shared_pristine(void *baton,
+                        const char *path,
+                        const apr_finfo_t *finfo,
+                        apr_pool_t *pool)
+{
+  const char *name = svn_dirent_basename(path, NULL);
+  apr_size_t len = strlen(name);
+  apr_size_t ext_len = sizeof(PRISTINE_STORAGE_EXT) - 1;
+
+  if (finfo->filetype != APR_REG
+      || !(finfo->valid & APR_FINFO_NLINK)
+      || finfo->nlink != 1)
+    return SVN_NO_ERROR;
+
+  /* Leave anything alone that is not a pristine text. */
+  if (len <= ext_len || strcmp(name + len - ext_len, PRISTINE_STORAGE_EXT))
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_io_remove_file2(path, TRUE, pool));
+}
+
+svn_error_t *
+svn_wc__db_pristine_cleanup_shared(svn_wc__db_t *db,
+                                   apr_pool_t *scratch_pool)
+{
+  svn_node_kind_t kind;
+
+  if (! db->shared_pristine_abspath)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_check_path(db->shared_pristine_abspath, &kind,
+                            scratch_pool));
+  if (kind != svn_node_dir)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_io_dir_walk2(db->shared_pristine_abspath,
+                                          APR_FINFO_TYPE | APR_FINFO_NLINK,
+                                          cleanup_shared_pristine, NULL,
+                                          scratch_pool));
+}
+
 
 svn_error_t *
 svn_wc__db_pristine_check(svn_boolean_t *present,
@@ -951,3 +1374,28 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
   *present = have_row;
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_wc__db_pristine_check_shared(svn_boolean_t *present,
+                                 svn_wc__db_t *db,
+                                 const svn_checksum_t *sha1_checksum,
+                                 apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_filesize_t size;
+
+  if (sha1_checksum->kind != svn_checksum_sha1)
+    {
+      *present = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Accept exactly the texts that shared_pristine_read() will provide. */
+  SVN_ERR(open_shared_pristine(&file, &size, db, sha1_checksum,
+                               scratch_pool, scratch_pool));
+  *present = (file != NULL);
+  if (file)
+    SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
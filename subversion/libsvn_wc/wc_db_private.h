@@ -32,6 +32,11 @@
 
 #include "wc_db.h"
 
+/* Upper limit for the SVN_CONFIG_OPTION_STATUS_THREADS setting. */
+#define SVN_WC__DB_MAX_STATUS_THREADS 32
+
+/* Upper limit for the SVN_CONFIG_OPTION_INSTALL_THREADS setting. */
+#define SVN_WC__DB_MAX_INSTALL_THREADS 32
 
 struct svn_wc__db_t {
   /* We need the config whenever we run into a new WC directory, in order
@@ -52,6 +57,20 @@ struct svn_wc__db_t {
   /* Busy timeout in ms., 0 for the libsvn_subr default. */
   apr_int32_t timeout;
 
+  /* Number of threads that status walks may use to prefetch data. */
+  int status_threads;
+
+  /* Number of threads that may write working files while running the
+     work queue. */
+  int install_threads;
+
+  /* Absolute path of the pristine store shared between working copies,
+     NULL if none has been configured. */
+  const char *shared_pristine_abspath;
+
+  /* Keeps directory contents across status walks, NULL if not active. */
+  svn_wc__status_monitor_t *status_monitor;
+
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
   apr_hash_t *dir_data;
@@ -107,6 +126,10 @@ typedef struct svn_wc__db_wcroot_t {
      const char *local_abspath -> svn_wc_adm_access_t *adm_access */
   apr_hash_t *access_cache;
 
+  /* Nesting level of svn_wc__db_begin_batch() calls for this wcroot.  While
+     it is not 0, an immediate transaction is open on SDB. */
+  int batch_depth;
+
 } svn_wc__db_wcroot_t;
 
 
@@ -394,6 +417,21 @@ svn_wc__db_mark_conflict_internal(svn_wc__db_wcroot_t *wcroot,
 #define SVN_WC__DB_WITH_TXN4(expr1, expr2, expr3, expr4, wcroot) \
   SVN_SQLITE__WITH_LOCK4(expr1, expr2, expr3, expr4, (wcroot)->sdb)
 
+
+/* Like SVN_WC__DB_WITH_TXN() but make sure that the transaction has a
+ * 'RESERVED' lock before EXPR gets evaluated.
+ *
+ * Within a batch (see svn_wc__db_begin_batch()), that lock is held already
+ * and a new transaction cannot be started, so just use a savepoint then.
+ */
+#define SVN_WC__DB_WITH_IMMEDIATE_TXN(expr, wcroot)                          \
+  do {                                                                        \
+    if ((wcroot)->batch_depth)                                                \
+      SVN_SQLITE__WITH_LOCK(expr, (wcroot)->sdb);                             \
+    else                                                                      \
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(expr, (wcroot)->sdb);                    \
+  } while (0)
+
 /* Update the single op-depth layer in the move destination subtree
    rooted at DST_RELPATH to make it match the move source subtree
    rooted at SRC_RELPATH. */
@@ -194,6 +194,14 @@ close_wcroot(void *data)
 
   SVN_ERR_ASSERT_NO_RETURN(wcroot->sdb != NULL);
 
+  /* Don't lose the changes of an unfinished batch. */
+  if (wcroot->batch_depth)
+    {
+      wcroot->batch_depth = 0;
+      svn_error_clear(svn_sqlite__finish_transaction(wcroot->sdb,
+                                                     SVN_NO_ERROR));
+    }
+
 #if defined(VERIFY_ON_CLOSE) && defined(SVN_DEBUG)
   if (getenv("SVN_CMDLINE_VERIFY_SQL_AT_CLOSE"))
     {
@@ -233,6 +241,8 @@ svn_wc__db_open(svn_wc__db_t **db,
   (*db)->enforce_empty_wq = enforce_empty_wq;
   (*db)->dir_data = apr_hash_make(result_pool);
 
+  (*db)->status_threads = 1;
+  (*db)->install_threads = 1;
   (*db)->state_pool = result_pool;
 
   /* Don't need to initialize (*db)->parse_cache, due to the calloc above */
@@ -241,6 +251,8 @@ svn_wc__db_open(svn_wc__db_t **db,
       svn_error_t *err;
       svn_boolean_t sqlite_exclusive = FALSE;
       apr_int64_t timeout;
+      apr_int64_t threads;
+      const char *shared_pristine_store;
 
       err = svn_config_get_bool(config, &sqlite_exclusive,
                                 SVN_CONFIG_SECTION_WORKING_COPY,
@@ -261,12 +273,96 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      err = svn_config_get_int64(config, &threads,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_STATUS_THREADS,
+                                 1);
+      if (err || threads < 1)
+        svn_error_clear(err);
+      else if (threads > SVN_WC__DB_MAX_STATUS_THREADS)
+        (*db)->status_threads = SVN_WC__DB_MAX_STATUS_THREADS;
+      else
+        (*db)->status_threads = (int)threads;
+
+      err = svn_config_get_int64(config, &threads,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_INSTALL_THREADS,
+                                 1);
+      if (err || threads < 1)
+        svn_error_clear(err);
+      else if (threads > SVN_WC__DB_MAX_INSTALL_THREADS)
+        (*db)->install_threads = SVN_WC__DB_MAX_INSTALL_THREADS;
+      else
+        (*db)->install_threads = (int)threads;
+
+      svn_config_get(config, &shared_pristine_store,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE, NULL);
+      if (shared_pristine_store && *shared_pristine_store)
+        {
+          err = svn_dirent_get_absolute(&(*db)->shared_pristine_abspath,
+                                        svn_dirent_internal_style(
+                                          shared_pristine_store,
+                                          scratch_pool),
+                                        result_pool);
+          if (err)
+            {
+              svn_error_clear(err);
+              (*db)->shared_pristine_abspath = NULL;
+            }
+        }
     }
 
   return SVN_NO_ERROR;
 }
 
 
+svn_error_t *
+svn_wc__db_open_reader(svn_wc__db_t **reader,
+                       svn_wc__db_t *db,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  /* Don't share the configuration object; it may cache values upon
+   * lookup.  The reader only needs the settings parsed from it. */
+  SVN_ERR(svn_wc__db_open(reader, NULL, !db->verify_format,
+                          db->enforce_empty_wq, result_pool, scratch_pool));
+  (*reader)->exclusive = db->exclusive;
+  (*reader)->timeout = db->timeout;
+  (*reader)->shared_pristine_abspath = db->shared_pristine_abspath;
+  (*reader)->status_monitor = db->status_monitor;
+
+  return SVN_NO_ERROR;
+}
+
+
+int
+svn_wc__db_get_status_threads(svn_wc__db_t *db)
+{
+  return db->exclusive ? 1 : db->status_threads;
+}
+
+int
+svn_wc__db_get_install_threads(svn_wc__db_t *db)
+{
+  return db->install_threads;
+}
+
+void
+svn_wc__db_set_status_monitor(svn_wc__db_t *db,
+                              svn_wc__status_monitor_t *monitor)
+{
+  db->status_monitor = monitor;
+}
+
+svn_wc__status_monitor_t *
+svn_wc__db_get_status_monitor(svn_wc__db_t *db)
+{
+  return db->status_monitor;
+}
+
+
 svn_error_t *
 svn_wc__db_close(svn_wc__db_t *db)
 {
@@ -377,6 +473,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
   (*wcroot)->owned_locks = apr_array_make(result_pool, 8,
                                           sizeof(svn_wc__db_wclock_t));
   (*wcroot)->access_cache = apr_hash_make(result_pool);
+  (*wcroot)->batch_depth = 0;
 
   /* SDB will be NULL for pre-NG working copies. We only need to run a
      cleanup when the SDB is present.  */
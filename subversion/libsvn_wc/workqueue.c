@@ -40,6 +40,7 @@
 
 #include "private/svn_io_private.h"
 #include "private/svn_skel.h"
+#include "private/svn_task.h"
 
 
 /* Workqueue operation names.  */
@@ -77,7 +78,12 @@ struct work_item_dispatch {
                        apr_pool_t *scratch_pool);
 };
 
-/* Forward definition */
+/* Forward definitions */
+static void
+record_dirent(work_item_baton_t *wqb,
+              const char *local_abspath,
+              const svn_io_dirent2_t *dirent);
+
 static svn_error_t *
 get_and_record_fileinfo(work_item_baton_t *wqb,
                         const char *local_abspath,
@@ -445,60 +451,80 @@ svn_wc__wq_build_postupgrade(svn_skel_t **work_item,
 
 /* OP_FILE_INSTALL */
 
-/* Process the OP_FILE_INSTALL work item WORK_ITEM.
- * See svn_wc__wq_build_file_install() which generates this work item.
- * Implements (struct work_item_dispatch).func. */
+/* Everything needed to install a working file, as determined by
+   prepare_file_install().  Executing it via perform_file_install() does
+   not need to access the wc.db and may therefore happen in a different
+   thread than the one owning the DB. */
+typedef struct file_install_t
+{
+  /* The working file to write and the file to read its contents from. */
+  const char *local_abspath;
+  const char *source_abspath;
+
+  /* Where to create temporary files. */
+  const char *temp_dir_abspath;
+
+  /* How to translate the contents of SOURCE_ABSPATH. */
+  svn_subst_eol_style_t style;
+  const char *eol;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+
+  /* How to tweak the working file after installing it.  SET_TIME is 0
+     if the timestamp shall not be changed. */
+  svn_boolean_t set_executable;
+  svn_boolean_t set_read_only;
+  apr_time_t set_time;
+
+  /* Whether to return the file's size and timestamp for recording. */
+  svn_boolean_t record_fileinfo;
+} file_install_t;
+
+/* Read all information required to process the OP_FILE_INSTALL work item
+   WORK_ITEM from DB and return it in *INSTALL, allocated in RESULT_POOL.
+   Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-run_file_install(work_item_baton_t *wqb,
-                 svn_wc__db_t *db,
-                 const svn_skel_t *work_item,
-                 const char *wri_abspath,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 apr_pool_t *scratch_pool)
+prepare_file_install(file_install_t **install,
+                     svn_wc__db_t *db,
+                     const svn_skel_t *work_item,
+                     const char *wri_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
 {
   const svn_skel_t *arg1 = work_item->children->next;
   const svn_skel_t *arg4 = arg1->next->next->next;
+  file_install_t *result = apr_pcalloc(result_pool, sizeof(*result));
   const char *local_relpath;
-  const char *local_abspath;
   svn_boolean_t use_commit_times;
-  svn_boolean_t record_fileinfo;
-  svn_boolean_t special;
-  svn_stream_t *src_stream;
-  svn_subst_eol_style_t style;
-  const char *eol;
-  apr_hash_t *keywords;
-  const char *temp_dir_abspath;
-  svn_stream_t *dst_stream;
   apr_int64_t val;
   const char *wcroot_abspath;
-  const char *source_abspath;
   const svn_checksum_t *checksum;
   apr_hash_t *props;
   apr_time_t changed_date;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
-  SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+  SVN_ERR(svn_wc__db_from_relpath(&result->local_abspath, db, wri_abspath,
+                                  local_relpath, result_pool, scratch_pool));
 
   SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
   use_commit_times = (val != 0);
   SVN_ERR(svn_skel__parse_int(&val, arg1->next->next, scratch_pool));
-  record_fileinfo = (val != 0);
+  result->record_fileinfo = (val != 0);
 
   SVN_ERR(svn_wc__db_read_node_install_info(&wcroot_abspath,
                                             &checksum, &props,
                                             &changed_date,
-                                            db, local_abspath, wri_abspath,
+                                            db, result->local_abspath,
+                                            wri_abspath,
                                             scratch_pool, scratch_pool));
 
   if (arg4 != NULL)
     {
       /* Use the provided path for the source.  */
       local_relpath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
-      SVN_ERR(svn_wc__db_from_relpath(&source_abspath, db, wri_abspath,
-                                      local_relpath,
-                                      scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__db_from_relpath(&result->source_abspath, db,
+                                      wri_abspath, local_relpath,
+                                      result_pool, scratch_pool));
     }
   else if (! checksum)
     {
@@ -513,31 +539,97 @@ run_file_install(work_item_baton_t *wqb,
                                _("Can't install '%s' from pristine store, "
                                  "because no checksum is recorded for this "
                                  "file"),
-                               svn_dirent_local_style(local_abspath,
+                               svn_dirent_local_style(result->local_abspath,
                                                       scratch_pool));
     }
   else
     {
-      SVN_ERR(svn_wc__db_pristine_get_future_path(&source_abspath,
+      SVN_ERR(svn_wc__db_pristine_get_future_path(&result->source_abspath,
                                                   wcroot_abspath,
                                                   checksum,
-                                                  scratch_pool, scratch_pool));
+                                                  result_pool,
+                                                  scratch_pool));
     }
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
-                                   scratch_pool, scratch_pool));
-
   /* Fetch all the translation bits.  */
-  SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                     &keywords,
-                                     &special, db, local_abspath,
+  SVN_ERR(svn_wc__get_translate_info(&result->style, &result->eol,
+                                     &result->keywords,
+                                     &result->special,
+                                     db, result->local_abspath,
                                      props, FALSE,
-                                     scratch_pool, scratch_pool));
-  if (special)
+                                     result_pool, scratch_pool));
+
+  /* No need to set exec or read-only flags on special files.  */
+  if (result->special)
+    {
+      *install = result;
+      return SVN_NO_ERROR;
+    }
+
+  /* Where is the Right Place to put a temp file in this working copy?  */
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&result->temp_dir_abspath,
+                                         db, wcroot_abspath,
+                                         result_pool, scratch_pool));
+
+#ifndef WIN32
+  result->set_executable = (props
+                            && svn_hash_gets(props, SVN_PROP_EXECUTABLE));
+#endif
+
+  /* Note that this explicitly checks the pristine properties, to make sure
+     that when the lock is locally set (=modification) it is not read only */
+  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
+    {
+      svn_wc__db_status_t status;
+      svn_wc__db_lock_t *lock;
+      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   db, result->local_abspath,
+                                   scratch_pool, scratch_pool));
+
+      result->set_read_only = (!lock && status != svn_wc__db_status_added);
+    }
+
+  if (use_commit_times)
+    result->set_time = changed_date;
+
+  *install = result;
+  return SVN_NO_ERROR;
+}
+
+/* Write the working file described by INSTALL.  If INSTALL requests its
+   fileinfo to be recorded, set *DIRENT to the stat of the new file,
+   allocated in RESULT_POOL.  Otherwise, set it to NULL.  Use SCRATCH_POOL
+   for temporary allocations.
+
+   This does not access the wc.db and may be called from any thread as
+   long as CANCEL_FUNC can be called from there. */
+static svn_error_t *
+perform_file_install(const svn_io_dirent2_t **dirent,
+                     const file_install_t *install,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+  svn_boolean_t translate;
+  svn_boolean_t copied = FALSE;
+
+  *dirent = NULL;
+
+  SVN_ERR(svn_stream_open_readonly(&src_stream, install->source_abspath,
+                                   scratch_pool, scratch_pool));
+
+  if (install->special)
     {
       /* When this stream is closed, the resulting special file will
          atomically be created/moved into place at LOCAL_ABSPATH.  */
-      SVN_ERR(svn_subst_create_specialfile(&dst_stream, local_abspath,
+      SVN_ERR(svn_subst_create_specialfile(&dst_stream,
+                                           install->local_abspath,
                                            scratch_pool, scratch_pool));
 
       /* Copy the "repository normal" form of the special file into the
@@ -546,91 +638,114 @@ run_file_install(work_item_baton_t *wqb,
                                cancel_func, cancel_baton,
                                scratch_pool));
 
-      /* No need to set exec or read-only flags on special files.  */
-
       /* ### Shouldn't this record a timestamp and size, etc.? */
       return SVN_NO_ERROR;
     }
 
-  if (svn_subst_translation_required(style, eol, keywords,
-                                     FALSE /* special */,
-                                     TRUE /* force_eol_check */))
+  translate = svn_subst_translation_required(install->style, install->eol,
+                                             install->keywords,
+                                             FALSE /* special */,
+                                             TRUE /* force_eol_check */);
+  if (translate)
     {
       /* Wrap it in a translating (expanding) stream.  */
-      src_stream = svn_subst_stream_translated(src_stream, eol,
+      src_stream = svn_subst_stream_translated(src_stream, install->eol,
                                                TRUE /* repair */,
-                                               keywords,
+                                               install->keywords,
                                                TRUE /* expand */,
                                                scratch_pool);
     }
 
-  /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
-                                         db, wcroot_abspath,
-                                         scratch_pool, scratch_pool));
-
   /* Translate to a temporary file. We don't want the user seeing a partial
      file, nor let them muck with it while we translate. We may also need to
      get its TRANSLATED_SIZE before the user can monkey it.  */
-  SVN_ERR(svn_stream__create_for_install(&dst_stream, temp_dir_abspath,
+  SVN_ERR(svn_stream__create_for_install(&dst_stream,
+                                         install->temp_dir_abspath,
                                          scratch_pool, scratch_pool));
 
-  /* Copy from the source to the dest, translating as we go. This will also
-     close both streams.  */
-  SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
-                           cancel_func, cancel_baton,
-                           scratch_pool));
+  /* Without translation, the kernel may be able to copy the data for us
+     or even let the working file share its blocks with the pristine. */
+  if (!translate)
+    SVN_ERR(svn_io__file_copy_in_kernel(&copied,
+                                        svn_stream__aprfile(src_stream),
+                                        svn_stream__aprfile(dst_stream),
+                                        scratch_pool));
+
+  if (copied)
+    {
+      SVN_ERR(svn_stream_close(src_stream));
+      SVN_ERR(svn_stream_close(dst_stream));
+    }
+  else
+    {
+      /* Copy from the source to the dest, translating as we go. This will
+         also close both streams.  */
+      SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
+                               cancel_func, cancel_baton,
+                               scratch_pool));
+    }
 
   /* All done. Move the file into place.  */
   /* With a single db we might want to install files in a missing directory.
      Simply trying this scenario on error won't do any harm and at least
      one user reported this problem on IRC. */
-  SVN_ERR(svn_stream__install_stream(dst_stream, local_abspath,
+  SVN_ERR(svn_stream__install_stream(dst_stream, install->local_abspath,
                                      TRUE /* make_parents*/, scratch_pool));
 
   /* Tweak the on-disk file according to its properties.  */
-#ifndef WIN32
-  if (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE))
-    SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
+  if (install->set_executable)
+    SVN_ERR(svn_io_set_file_executable(install->local_abspath, TRUE, FALSE,
                                        scratch_pool));
-#endif
 
-  /* Note that this explicitly checks the pristine properties, to make sure
-     that when the lock is locally set (=modification) it is not read only */
-  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
-    {
-      svn_wc__db_status_t status;
-      svn_wc__db_lock_t *lock;
-      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL,
-                                   db, local_abspath,
-                                   scratch_pool, scratch_pool));
-
-      if (!lock && status != svn_wc__db_status_added)
-        SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
-    }
+  if (install->set_read_only)
+    SVN_ERR(svn_io_set_file_read_only(install->local_abspath, FALSE,
+                                      scratch_pool));
 
-  if (use_commit_times)
-    {
-      if (changed_date)
-        SVN_ERR(svn_io_set_file_affected_time(changed_date,
-                                              local_abspath,
-                                              scratch_pool));
-    }
+  if (install->set_time)
+    SVN_ERR(svn_io_set_file_affected_time(install->set_time,
+                                          install->local_abspath,
+                                          scratch_pool));
 
   /* ### this should happen before we rename the file into place.  */
-  if (record_fileinfo)
+  if (install->record_fileinfo)
     {
-      SVN_ERR(get_and_record_fileinfo(wqb, local_abspath,
-                                      FALSE /* ignore_enoent */,
-                                      scratch_pool));
+      const svn_io_dirent2_t *stat;
+
+      SVN_ERR(svn_io_stat_dirent2(&stat, install->local_abspath, FALSE,
+                                  FALSE /* ignore_enoent */,
+                                  result_pool, scratch_pool));
+      if (stat->kind == svn_node_file)
+        *dirent = stat;
     }
 
   return SVN_NO_ERROR;
 }
 
+/* Process the OP_FILE_INSTALL work item WORK_ITEM.
+ * See svn_wc__wq_build_file_install() which generates this work item.
+ * Implements (struct work_item_dispatch).func. */
+static svn_error_t *
+run_file_install(work_item_baton_t *wqb,
+                 svn_wc__db_t *db,
+                 const svn_skel_t *work_item,
+                 const char *wri_abspath,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_install_t *install;
+  const svn_io_dirent2_t *dirent;
+
+  SVN_ERR(prepare_file_install(&install, db, work_item, wri_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(perform_file_install(&dirent, install, cancel_func, cancel_baton,
+                               wqb->result_pool, scratch_pool));
+
+  if (dirent)
+    record_dirent(wqb, install->local_abspath, dirent);
+
+  return SVN_NO_ERROR;
+}
 
 svn_error_t *
 svn_wc__wq_build_file_install(svn_skel_t **work_item,
@@ -1474,6 +1589,285 @@ dispatch_work_item(work_item_baton_t *wqb,
 }
 
 
+/* Return ERR, which occurred while running the work item WORK_ITEM with
+   the identifier ID in the work queue of WRI_ABSPATH, wrapped in an error
+   that identifies that work item.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+wrap_work_item_error(svn_error_t *err,
+                     const char *wri_abspath,
+                     apr_uint64_t id,
+                     const svn_skel_t *work_item,
+                     apr_pool_t *scratch_pool)
+{
+  const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
+
+  return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                           _("Failed to run the WC DB work queue "
+                             "associated with '%s', work item %d %s"),
+                           svn_dirent_local_style(wri_abspath,
+                                                  scratch_pool),
+                           (int)id, skel);
+}
+
+/* Number of work items that svn_wc__wq_run() fetches from the wc.db at
+   once when installing files concurrently. */
+#define WQ_BATCH_SIZE 256
+
+/* Values in concurrent_run_t.in_flight. */
+static const char INSTALL_WRITES[] = "w";
+static const char INSTALL_READS[] = "r";
+
+/* State of a concurrent run of the work queue.  Only ever accessed by the
+   thread owning the wc.db. */
+typedef struct concurrent_run_t
+{
+  /* Executes the file system part of OP_FILE_INSTALL work items. */
+  svn_task__queue_t *queue;
+
+  /* The working files and sources of all installs currently in QUEUE.
+     Maps const char * to INSTALL_WRITES or INSTALL_READS. */
+  apr_hash_t *in_flight;
+
+  /* Work items completed but not yet removed from the wc.db.
+     Array of apr_uint64_t. */
+  apr_array_header_t *completed_ids;
+
+  /* Fileinfo to record together with removing COMPLETED_IDS. */
+  work_item_baton_t wib;
+} concurrent_run_t;
+
+/* An OP_FILE_INSTALL work item being processed by a concurrent run. */
+typedef struct install_task_t
+{
+  /* The run that this item is part of. */
+  concurrent_run_t *run;
+
+  /* The work item, as fetched from the queue of WRI_ABSPATH. */
+  apr_uint64_t id;
+  const svn_skel_t *work_item;
+  const char *wri_abspath;
+
+  /* What to do, as determined by prepare_file_install(). */
+  const file_install_t *install;
+} install_task_t;
+
+/* Implements svn_task__process_func_t.  Execute the install_task_t given
+   as BATON and return the svn_io_dirent2_t * to record, if any. */
+static svn_error_t *
+install_task_process(void **result,
+                     void *baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  install_task_t *task = baton;
+  const svn_io_dirent2_t *dirent;
+  svn_error_t *err;
+
+  /* The caller's cancel function is not guaranteed to be thread-safe.
+     Cancellation is being checked before each push instead. */
+  err = perform_file_install(&dirent, task->install, NULL, NULL,
+                             result_pool, scratch_pool);
+  if (err)
+    return svn_error_trace(wrap_work_item_error(err, task->wri_abspath,
+                                                task->id, task->work_item,
+                                                scratch_pool));
+
+  *result = (void *)dirent;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Queue the install_task_t given as
+   BATON and the svn_io_dirent2_t * RESULT for being written to the wc.db. */
+static svn_error_t *
+install_task_output(void *result,
+                    void *baton,
+                    apr_pool_t *scratch_pool)
+{
+  install_task_t *task = baton;
+  concurrent_run_t *run = task->run;
+  const svn_io_dirent2_t *dirent = result;
+
+  if (dirent)
+    record_dirent(&run->wib, task->install->local_abspath,
+                  svn_io_dirent2_dup(dirent, run->wib.result_pool));
+
+  APR_ARRAY_PUSH(run->completed_ids, apr_uint64_t) = task->id;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for all installs of RUN to finish. */
+static svn_error_t *
+finish_installs(concurrent_run_t *run,
+                apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_task__queue_finish(run->queue, scratch_pool));
+  apr_hash_clear(run->in_flight);
+
+  return SVN_NO_ERROR;
+}
+
+/* In a single wc.db transaction, remove all completed work items of RUN
+   from the queue of WRI_ABSPATH in DB, record their fileinfo and fetch up
+   to MAX_ITEMS new items into *IDS and *WORK_ITEMS, allocated in
+   RESULT_POOL.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+complete_and_fetch(apr_array_header_t **ids,
+                   apr_array_header_t **work_items,
+                   concurrent_run_t *run,
+                   svn_wc__db_t *db,
+                   const char *wri_abspath,
+                   int max_items,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_wc__db_wq_record_and_fetch_batch(ids, work_items,
+                                               db, wri_abspath,
+                                               run->completed_ids,
+                                               run->wib.record_map,
+                                               max_items,
+                                               result_pool, scratch_pool));
+
+  apr_array_clear(run->completed_ids);
+  svn_pool_clear(run->wib.result_pool);
+  run->wib.record_map = NULL;
+  run->wib.used = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_wc__wq_run() for up to THREADS concurrent file installs.
+
+   The wc.db is only accessed from the calling thread: it fetches the work
+   items in batches, reads everything required for OP_FILE_INSTALL items
+   and hands their file system part to worker threads.  All other work
+   items are executed in the calling thread after all earlier items have
+   been completed and recorded, just like svn_wc__wq_run() would do.
+   Installs to the same path are serialized as well.
+
+   A work item is only removed from the queue after it has been completed,
+   so an interrupted run can always be continued by the next one.
+ */
+static svn_error_t *
+run_concurrently(svn_wc__db_t *db,
+                 const char *wri_abspath,
+                 int threads,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *batch_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  concurrent_run_t run = { 0 };
+
+  run.in_flight = apr_hash_make(scratch_pool);
+  run.completed_ids = apr_array_make(scratch_pool, WQ_BATCH_SIZE,
+                                     sizeof(apr_uint64_t));
+  run.wib.result_pool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_task__queue_create(&run.queue, threads, scratch_pool));
+
+  while (TRUE)
+    {
+      apr_array_header_t *ids;
+      apr_array_header_t *work_items;
+      int i;
+
+      /* All items of the previous batch have been completed by now. */
+      svn_pool_clear(batch_pool);
+      SVN_ERR(complete_and_fetch(&ids, &work_items, &run, db, wri_abspath,
+                                 WQ_BATCH_SIZE, batch_pool, iterpool));
+
+      /* Stop work queue processing, if requested. A future 'svn cleanup'
+         should be able to continue the processing.  */
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      if (ids->nelts == 0)
+        break;
+
+      for (i = 0; i < ids->nelts; i++)
+        {
+          apr_uint64_t id = APR_ARRAY_IDX(ids, i, apr_uint64_t);
+          const svn_skel_t *work_item = APR_ARRAY_IDX(work_items, i,
+                                                      svn_skel_t *);
+          svn_error_t *err;
+
+          svn_pool_clear(iterpool);
+
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          if (svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL))
+            {
+              install_task_t *task = apr_pcalloc(batch_pool, sizeof(*task));
+              file_install_t *install;
+
+              err = prepare_file_install(&install, db, work_item,
+                                         wri_abspath, batch_pool, iterpool);
+              if (err)
+                return svn_error_trace(wrap_work_item_error(err, wri_abspath,
+                                                            id, work_item,
+                                                            iterpool));
+
+              /* Later items must not overtake earlier ones that read or
+                 write the same file or write the file they read from.
+                 Installs sharing the same source don't conflict. */
+              if (svn_hash_gets(run.in_flight, install->local_abspath)
+                  || svn_hash_gets(run.in_flight, install->source_abspath)
+                       == INSTALL_WRITES)
+                SVN_ERR(finish_installs(&run, iterpool));
+
+              svn_hash_sets(run.in_flight, install->local_abspath,
+                            INSTALL_WRITES);
+              if (!svn_hash_gets(run.in_flight, install->source_abspath))
+                svn_hash_sets(run.in_flight, install->source_abspath,
+                              INSTALL_READS);
+
+              task->run = &run;
+              task->id = id;
+              task->work_item = work_item;
+              task->wri_abspath = wri_abspath;
+              task->install = install;
+
+              SVN_ERR(svn_task__queue_push(run.queue,
+                                           install_task_process, task,
+                                           install_task_output, task,
+                                           iterpool));
+            }
+          else
+            {
+              /* Other work items may depend on the on-disk and wc.db
+                 results of all earlier ones. */
+              SVN_ERR(finish_installs(&run, iterpool));
+              if (run.completed_ids->nelts)
+                {
+                  apr_array_header_t *no_ids;
+                  apr_array_header_t *no_items;
+
+                  SVN_ERR(complete_and_fetch(&no_ids, &no_items, &run,
+                                             db, wri_abspath, 0,
+                                             iterpool, iterpool));
+                }
+
+              err = dispatch_work_item(&run.wib, db, wri_abspath, work_item,
+                                       cancel_func, cancel_baton, iterpool);
+              if (err)
+                return svn_error_trace(wrap_work_item_error(err, wri_abspath,
+                                                            id, work_item,
+                                                            iterpool));
+
+              APR_ARRAY_PUSH(run.completed_ids, apr_uint64_t) = id;
+            }
+        }
+
+      SVN_ERR(finish_installs(&run, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(batch_pool);
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__wq_run(svn_wc__db_t *db,
                const char *wri_abspath,
@@ -1481,10 +1875,10 @@ svn_wc__wq_run(svn_wc__db_t *db,
                void *cancel_baton,
                apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool;
   apr_uint64_t last_id = 0;
   work_item_baton_t wib = { 0 };
-  wib.result_pool = svn_pool_create(scratch_pool);
+  int threads = svn_wc__db_get_install_threads(db);
 
 #ifdef SVN_DEBUG_WORK_QUEUE
   SVN_DBG(("wq_run: wri='%s'\n", wri_abspath));
@@ -1500,6 +1894,14 @@ svn_wc__wq_run(svn_wc__db_t *db,
   }
 #endif
 
+  if (threads > 1)
+    return svn_error_trace(run_concurrently(db, wri_abspath, threads,
+                                            cancel_func, cancel_baton,
+                                            scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  wib.result_pool = svn_pool_create(scratch_pool);
+
   while (TRUE)
     {
       apr_uint64_t id;
@@ -1546,16 +1948,8 @@ svn_wc__wq_run(svn_wc__db_t *db,
       err = dispatch_work_item(&wib, db, wri_abspath, work_item,
                                cancel_func, cancel_baton, iterpool);
       if (err)
-        {
-          const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
-
-          return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
-                                   _("Failed to run the WC DB work queue "
-                                     "associated with '%s', work item %d %s"),
-                                   svn_dirent_local_style(wri_abspath,
-                                                          scratch_pool),
-                                   (int)id, skel);
-        }
+        return svn_error_trace(wrap_work_item_error(err, wri_abspath, id,
+                                                    work_item, scratch_pool));
 
       /* The work item finished without error. Mark it completed
          in the next loop.  */
@@ -1626,9 +2020,19 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
   SVN_ERR(svn_io_stat_dirent2(&dirent, local_abspath, FALSE, ignore_enoent,
                               wqb->result_pool, scratch_pool));
 
-  if (dirent->kind != svn_node_file)
-    return SVN_NO_ERROR;
+  if (dirent->kind == svn_node_file)
+    record_dirent(wqb, local_abspath, dirent);
+
+  return SVN_NO_ERROR;
+}
 
+/* Remember DIRENT, allocated in WQB->RESULT_POOL, as the fileinfo to record
+   for LOCAL_ABSPATH once the current work item has been completed. */
+static void
+record_dirent(work_item_baton_t *wqb,
+              const char *local_abspath,
+              const svn_io_dirent2_t *dirent)
+{
   wqb->used = TRUE;
 
   if (! wqb->record_map)
@@ -1636,6 +2040,4 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
 
   svn_hash_sets(wqb->record_map, apr_pstrdup(wqb->result_pool, local_abspath),
                 dirent);
-
-  return SVN_NO_ERROR;
 }
@@ -120,6 +120,10 @@ extern module AP_MODULE_DECLARE_DATA dav_svn_module;
 /* The authz_svn provider for bypassing path authz. */
 static authz_svn__subreq_bypass_func_t pathauthz_bypass_func = NULL;
 
+/* Whether to share the in-memory cache between all httpd child processes.
+   Like the cache size, this is a process-wide setting. */
+static svn_boolean_t use_shared_cache = FALSE;
+
 static int
 init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
 {
@@ -150,9 +154,55 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
+  /* The shared cache must exist before httpd forks its children.
+     Since httpd runs the post-config hooks twice during startup, skip
+     the first pass to not allocate the cache memory twice. */
+  if (use_shared_cache)
+    {
+      const char *userdata_key = "mod_dav_svn_shared_cache";
+      void *data = NULL;
+
+      apr_pool_userdata_get(&data, userdata_key, s->process->pool);
+      if (data == NULL)
+        {
+          apr_pool_userdata_set((const void *)1, userdata_key,
+                                apr_pool_cleanup_null, s->process->pool);
+        }
+      else
+        {
+          serr = svn_cache_config_create_shared_cache();
+          if (serr)
+            {
+              ap_log_perror(APLOG_MARK, APLOG_ERR, serr->apr_err, p,
+                            "mod_dav_svn: error creating the shared "
+                            "in-memory cache: '%s'",
+                            serr->message ? serr->message
+                                          : "(no more info)");
+              svn_error_clear(serr);
+              return HTTP_INTERNAL_SERVER_ERROR;
+            }
+        }
+    }
+
   return OK;
 }
 
+/* Re-attach the shared cache created in init() to each forked child. */
+static void
+init_child(apr_pool_t *p, server_rec *s)
+{
+  svn_error_t *serr = svn_cache_config_child_init(p);
+
+  if (serr)
+    {
+      ap_log_error(APLOG_MARK, APLOG_ERR, serr->apr_err, s,
+                   "mod_dav_svn: error attaching to the shared "
+                   "in-memory cache: '%s'",
+                   serr->message ? serr->message : "(no more info)");
+      svn_error_clear(serr);
+    }
+}
+
 static svn_error_t *
 malfunction_handler(svn_boolean_t can_return,
                     const char *file, int line,
@@ -624,6 +674,31 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNInMemoryCacheShared_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  use_shared_cache = arg;
+
+  return NULL;
+}
+
+static const char *
+SVNInMemoryCacheReplacementPolicy_cmd(cmd_parms *cmd, void *config,
+                                      const char *arg1)
+{
+  svn_error_t *err = svn_cache_config_set_replacement_policy(arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return apr_psprintf(cmd->pool,
+                          "'%s' is not a valid cache replacement policy. "
+                          "Valid values are 'lfu' and 'tinylfu'.",
+                          arg1);
+    }
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -1388,6 +1463,23 @@ static const command_rec cmds[] =
                 "specifies the maximum size in kB per process of Subversion's "
                 "in-memory object cache (default value is 16384; 0 switches "
                 "to dynamically sized caches)."),
+
+  /* per server */
+  AP_INIT_FLAG("SVNInMemoryCacheShared", SVNInMemoryCacheShared_cmd, NULL,
+               RSRC_CONF,
+               "shares Subversion's in-memory object cache between all "
+               "httpd child processes.  SVNInMemoryCacheSize then limits "
+               "the total size of the cache (default is Off)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNInMemoryCacheReplacementPolicy",
+                SVNInMemoryCacheReplacementPolicy_cmd, NULL,
+                RSRC_CONF,
+                "specifies how Subversion's in-memory object cache selects "
+                "the data to evict: 'lfu' evicts the least frequently used "
+                "data, 'tinylfu' additionally keeps one-off reads of many "
+                "items from pushing out frequently used data, at the "
+                "expense of about 2 percent of the cache memory (default is "
+                "lfu)."),
   /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
@@ -1429,6 +1521,7 @@ register_hooks(apr_pool_t *pconf)
 {
   ap_hook_pre_config(init_dso, NULL, NULL, APR_HOOK_REALLY_FIRST);
   ap_hook_post_config(init, NULL, NULL, APR_HOOK_MIDDLE);
+  ap_hook_child_init(init_child, NULL, NULL, APR_HOOK_MIDDLE);
 
   /* our provider */
   dav_register_provider(pconf, "svn", &provider);
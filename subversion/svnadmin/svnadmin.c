@@ -95,6 +95,8 @@ check_lib_versions(void)
 /** Subcommands. **/
 
 static svn_opt_subcommand_t
+  subcommand_build_changes_index,
+  subcommand_build_mergeinfo_index,
   subcommand_crashtest,
   subcommand_create,
   subcommand_delrevprop,
@@ -155,7 +157,8 @@ enum svnadmin__cmdline_options_t
     svnadmin__normalize_props,
     svnadmin__exclude,
     svnadmin__include,
-    svnadmin__glob
+    svnadmin__glob,
+    svnadmin__jobs
   };
 
 /* Option codes and descriptions.
@@ -294,6 +297,11 @@ static const apr_getopt_option_t options_table[] =
         "                             Character '/' is not treated specially, so\n"
         "                             pattern /*/foo matches paths /a/foo and /a/b/foo.") },
 
+    {"jobs", svnadmin__jobs, 1,
+     N_("process up to ARG revision ranges concurrently.\n"
+        "                             Default: 1.\n"
+        "                             [ignored with --metadata-only]")},
+
     {NULL}
   };
 
@@ -303,6 +311,27 @@ static const apr_getopt_option_t options_table[] =
  */
 static const svn_opt_subcommand_desc3_t cmd_table[] =
 {
+  {"build-changes-index", subcommand_build_changes_index, {0}, {N_(
+    "usage: svnadmin build-changes-index REPOS_PATH\n"
+    "\n"), N_(
+    "Create the changed-paths index of the repository, if necessary, and\n"
+    "add all revisions to it that it does not cover yet.  Once created, the\n"
+    "index is kept up-to-date at commit time and speeds up 'svn log' on\n"
+    "paths that change rarely.\n"
+    "To remove the index, delete the file 'db/changes-index.db'.\n"
+   )},
+   {'q'} },
+
+  {"build-mergeinfo-index", subcommand_build_mergeinfo_index, {0}, {N_(
+    "usage: svnadmin build-mergeinfo-index REPOS_PATH\n"
+    "\n"), N_(
+    "Create the mergeinfo index of the repository, if necessary, and add\n"
+    "all revisions to it that it does not cover yet.  Once created, the\n"
+    "index is kept up-to-date at commit time and speeds up 'svn log -g'.\n"
+    "To remove the index, delete the file 'db/mergeinfo-index.db'.\n"
+   )},
+   {'q'} },
+
   {"crashtest", subcommand_crashtest, {0}, {N_(
     "usage: svnadmin crashtest REPOS_PATH\n"
     "\n"), N_(
@@ -605,7 +634,8 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "Verify the data stored in the repository.\n"
    )},
    {'t', 'r', 'q', svnadmin__keep_going, 'M',
-    svnadmin__check_normalization, svnadmin__metadata_only} },
+    svnadmin__check_normalization, svnadmin__metadata_only,
+    svnadmin__jobs} },
 
   { NULL, NULL, {0}, {NULL}, {0} }
 };
@@ -648,6 +678,7 @@ struct svnadmin_opt_state
   apr_array_header_t *exclude;                      /* --exclude */
   apr_array_header_t *include;                      /* --include */
   svn_boolean_t glob;                               /* --pattern */
+  int jobs;                                         /* --jobs */
 
   const char *config_dir;    /* Overriding Configuration Directory */
 };
@@ -796,6 +827,58 @@ crashtest_malfunction_handler(svn_boolean_t can_return,
   return SVN_NO_ERROR; /* Not reached. */
 }
 
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_build_changes_index(apr_getopt_t *os, void *baton,
+                               apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+  svn_stream_t *feedback_stream = NULL;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+
+  /* Progress feedback goes to STDOUT, unless they asked to suppress it. */
+  if (! opt_state->quiet)
+    feedback_stream = recode_stream_create(stdout, pool);
+
+  return svn_error_trace(
+    svn_repos_build_changes_index(repos,
+                                  !opt_state->quiet ? repos_notify_handler
+                                                    : NULL,
+                                  feedback_stream, check_cancel, NULL,
+                                  pool));
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_build_mergeinfo_index(apr_getopt_t *os, void *baton,
+                                 apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+  svn_stream_t *feedback_stream = NULL;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+
+  /* Progress feedback goes to STDOUT, unless they asked to suppress it. */
+  if (! opt_state->quiet)
+    feedback_stream = recode_stream_create(stdout, pool);
+
+  return svn_error_trace(
+    svn_repos_build_mergeinfo_index(repos,
+                                    !opt_state->quiet ? repos_notify_handler
+                                                      : NULL,
+                                    feedback_stream, check_cancel, NULL,
+                                    pool));
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_crashtest(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -1239,6 +1322,19 @@ repos_notify_handler(void *baton,
         }
       return;
 
+    case svn_repos_notify_mergeinfo_indexed:
+      svn_error_clear(svn_stream_printf(feedback_stream, scratch_pool,
+                                        _("* Indexed mergeinfo of revision "
+                                          "%ld.\n"), notify->revision));
+      return;
+
+    case svn_repos_notify_changes_indexed:
+      svn_error_clear(svn_stream_printf(feedback_stream, scratch_pool,
+                                        _("* Indexed changed paths of "
+                                          "revision %ld.\n"),
+                                        notify->revision));
+      return;
+
     case svn_repos_notify_pack_noop:
       /* For best backward compatibility, we keep silent if there were just
          no more shards to pack. */
@@ -2247,9 +2343,11 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     apr_array_make(pool, 0, sizeof(struct verification_error *));
   verify_baton.result_pool = pool;
 
-  SVN_ERR(svn_repos_verify_fs3(repos, lower, upper,
+  SVN_ERR(svn_repos_verify_fs4(repos, lower, upper,
                                opt_state->check_normalization,
                                opt_state->metadata_only,
+                               opt_state->jobs,
+                               opt_state->keep_going,
                                !opt_state->quiet
                                  ? repos_notify_handler : NULL,
                                feedback_stream,
@@ -2887,6 +2985,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -3031,6 +3130,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__metadata_only:
         opt_state.metadata_only = TRUE;
         break;
+      case svnadmin__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid number of jobs '%s'"),
+                                   opt_arg);
+        break;
       case svnadmin__fs_type:
         SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.fs_type, opt_arg, pool));
         break;
@@ -3228,7 +3334,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+    /* 'pack' may process shards concurrently, see fsfs.conf. */
+    settings.single_threaded = opt_state.jobs <= 1
+                            && subcommand->cmd_func != subcommand_pack;
 
     svn_cache_config_set(&settings);
   }
@@ -54,6 +54,7 @@
 #include "private/svn_log.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_fspath.h"
 
 #ifdef HAVE_UNISTD_H
@@ -3686,6 +3687,83 @@ list(svn_ra_svn_conn_t *conn,
   return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
 }
 
+static svn_error_t *
+blame(svn_ra_svn_conn_t *conn,
+      apr_pool_t *pool,
+      svn_ra_svn__list_t *params,
+      void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *full_path;
+  svn_revnum_t start_rev, end_rev;
+  const char *ignore_space;
+  svn_boolean_t ignore_eol_style;
+  svn_diff_file_options_t *diff_options;
+  apr_array_header_t *chunks;
+  apr_hash_t *rev_props;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  int i;
+  authz_baton_t ab;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  /* Parse arguments. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "crrwb", &path, &start_rev,
+                                  &end_rev, &ignore_space,
+                                  &ignore_eol_style));
+  full_path = svn_fspath__join(b->repository->fs_path->data,
+                               svn_relpath_canonicalize(path, pool), pool);
+
+  diff_options = svn_diff_file_options_create(pool);
+  if (strcmp(ignore_space, "change") == 0)
+    diff_options->ignore_space = svn_diff_file_ignore_space_change;
+  else if (strcmp(ignore_space, "all") == 0)
+    diff_options->ignore_space = svn_diff_file_ignore_space_all;
+  diff_options->ignore_eol_style = ignore_eol_style;
+
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__blame(full_path, start_rev, end_rev, pool)));
+
+  SVN_CMD_ERR(svn_repos__blame(&chunks, &rev_props, b->repository->repos,
+                               full_path, start_rev, end_rev, diff_options,
+                               authz_check_access_cb_func(b), &ab,
+                               NULL, NULL, pool, pool));
+
+  /* Send the line chunks first, then the revisions they refer to. */
+  iterpool = svn_pool_create(pool);
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((!", "success"));
+  for (i = 0; i < chunks->nelts; ++i)
+    {
+      const svn_repos__blame_chunk_t *chunk
+        = &APR_ARRAY_IDX(chunks, i, svn_repos__blame_chunk_t);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "n(?r)",
+                                      (apr_uint64_t)chunk->start,
+                                      chunk->revision));
+    }
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)(!"));
+  for (hi = apr_hash_first(pool, rev_props); hi; hi = apr_hash_next(hi))
+    {
+      const svn_revnum_t *revision = apr_hash_this_key(hi);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "r(!", *revision));
+      SVN_ERR(svn_ra_svn__write_proplist(conn, iterpool,
+                                         apr_hash_this_val(hi)));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!)"));
+    }
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "reparent",        reparent },
   { "get-latest-rev",  get_latest_rev },
@@ -3719,6 +3797,7 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-deleted-rev", get_deleted_rev },
   { "get-iprops",      get_inherited_props },
   { "list",            list },
+  { "blame",           blame },
   { NULL }
 };
 
@@ -4127,13 +4206,14 @@ construct_server_baton(server_baton_t **baton,
 
   /* Send greeting.  We don't support version 1 any more, so we can
    * send an empty mechlist. */
-  if (params->compression_level > 0)
+  if (params->compression_level > 0 && params->compressed_transport)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
                                            SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED,
+                                           SVN_RA_SVN_CAP_COMPRESSED_TRANSPORT,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
                                            SVN_RA_SVN_CAP_COMMIT_REVPROPS,
                                            SVN_RA_SVN_CAP_DEPTH,
@@ -4143,11 +4223,31 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME
+                                           ));
+  else if (params->compression_level > 0)
+    SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
+                                           "nn()(wwwwwwwwwwwwww)",
+                                           (apr_uint64_t) 2, (apr_uint64_t) 2,
+                                           SVN_RA_SVN_CAP_EDIT_PIPELINE,
+                                           SVN_RA_SVN_CAP_SVNDIFF1,
+                                           SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED,
+                                           SVN_RA_SVN_CAP_ABSENT_ENTRIES,
+                                           SVN_RA_SVN_CAP_COMMIT_REVPROPS,
+                                           SVN_RA_SVN_CAP_DEPTH,
+                                           SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                           SVN_RA_SVN_CAP_ATOMIC_REVPROPS,
+                                           SVN_RA_SVN_CAP_PARTIAL_REPLAY,
+                                           SVN_RA_SVN_CAP_INHERITED_PROPS,
+                                           SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
+                                           SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4159,7 +4259,8 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
@@ -4175,6 +4276,14 @@ construct_server_baton(server_baton_t **baton,
   client_url = svn_uri_canonicalize(client_url, conn_pool);
   SVN_ERR(svn_ra_svn__set_capabilities(conn, caplist));
 
+  /* Everything after the client's reply to our greeting will be
+   * compressed if we both asked for it. */
+  if (params->compression_level > 0
+      && params->compressed_transport
+      && svn_ra_svn_has_capability(conn,
+                                   SVN_RA_SVN_CAP_COMPRESSED_TRANSPORT))
+    SVN_ERR(svn_ra_svn__enable_compression(conn, scratch_pool));
+
   /* All released versions of Subversion support edit-pipeline,
    * so we do not accept connections from clients that do not. */
   if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_EDIT_PIPELINE))
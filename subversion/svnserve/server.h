@@ -143,6 +143,11 @@ typedef struct serve_params_t {
      Defaults to SVN_DELTA_COMPRESSION_LEVEL_DEFAULT. */
   int compression_level;
 
+  /* Whether to offer the compressed-transport capability to clients.
+     Only used if COMPRESSION_LEVEL is not 0.  Defaults to FALSE, i.e.
+     only the deltas get compressed. */
+  svn_boolean_t compressed_transport;
+
   /* Item size up to which we use the zero-copy code path to transmit
      them over the network.  0 disables that code path. */
   apr_size_t zero_copy_limit;
@@ -49,6 +49,7 @@
 #include "svn_version.h"
 #include "svn_io.h"
 #include "svn_hash.h"
+#include "svn_sorts.h"
 
 #include "svn_private_config.h"
 
@@ -57,9 +58,11 @@
 #include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_ra_svn_private.h"
 
 #if APR_HAS_THREADS
 #    include <apr_thread_pool.h>
+#    include <apr_poll.h>
 #endif
 
 #include "winservice.h"
@@ -145,6 +148,26 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Number of threads that wait for idle connections to become readable.
+ *
+ * Between two commands, connections don't occupy a worker thread but get
+ * parked in one of these threads' pollsets instead.  A single poller can
+ * easily watch many thousand connections; multiple pollers merely spread
+ * the wake-up load.
+ */
+#define POLLER_COUNT 2
+
+/* Maximum number of ready connections that a poller thread will pick up
+ * in a single poll call.
+ */
+#define POLLER_BATCH_SIZE 256
+
+/* Maximum time in usec that a poller thread waits before retrying after
+ * its pollset failed.  The delay starts small and doubles with every
+ * consecutive failure.
+ */
+#define POLLER_MAX_BACKOFF apr_time_from_sec(1)
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -222,6 +245,9 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_SHARED_CACHE    277
+#define SVNSERVE_OPT_COMPRESSED_TRANSPORT 278
+#define SVNSERVE_OPT_CACHE_POLICY    279
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -287,6 +313,12 @@ static const apr_getopt_option_t svnserve__options[] =
         "[0 .. no compression, 5 .. default, \n"
         "                             "
         " 9 .. maximum compression]")},
+    {"compressed-transport", SVNSERVE_OPT_COMPRESSED_TRANSPORT, 0,
+     N_("offer clients to compress the whole connection\n"
+        "                             "
+        "instead of only the deltas.  Has no effect with\n"
+        "                             "
+        "compression level 0.")},
     {"memory-cache-size", 'M', 1,
      N_("size of the extra in-memory cache in MB used to\n"
         "                             "
@@ -297,6 +329,28 @@ static const apr_getopt_option_t svnserve__options[] =
         "0 switches to dynamically sized caches.\n"
         "                             "
         "[used for FSFS and FSX repositories only]")},
+    {"shared-memory-cache", SVNSERVE_OPT_SHARED_CACHE, 0,
+     N_("share the in-memory cache between all server\n"
+        "                             "
+        "processes instead of giving each connection a\n"
+        "                             "
+        "copy of its own.  The size given by -M then\n"
+        "                             "
+        "applies to all processes combined.\n"
+        "                             "
+        "[used only in the default (fork) mode]")},
+    {"cache-replacement-policy", SVNSERVE_OPT_CACHE_POLICY, 1,
+     N_("'lfu' (default) evicts the least frequently used\n"
+        "                             "
+        "data from the in-memory cache.  'tinylfu' also\n"
+        "                             "
+        "keeps one-off reads of many items, e.g. exports\n"
+        "                             "
+        "of large trees, from pushing out frequently used\n"
+        "                             "
+        "data, at the expense of 2 percent of the cache.\n"
+        "                             "
+        "[used for FSFS and FSX repositories only]")},
     {"cache-txdeltas", SVNSERVE_OPT_CACHE_TXDELTAS, 1,
      N_("enable or disable caching of deltas between older\n"
         "                             "
@@ -614,22 +668,179 @@ static svn_root_pools__t *connection_pools;
 /* The global thread pool serving all connections. */
 static apr_thread_pool_t *threads;
 
+/* A thread waiting for any of the idle connections in POLLSET to send
+   their next command. */
+typedef struct poller_t
+{
+  /* Idle connections.  The client_data of each entry is the respective
+     connection_t. */
+  apr_pollset_t *pollset;
+
+  /* The thread servicing POLLSET. */
+  apr_thread_t *thread;
+} poller_t;
+
+/* The POLLER_COUNT pollers used in threaded mode.  NULL, if the platform
+   does not support thread-safe pollsets.  In that case, idle connections
+   will be polled round-robin by the worker threads. */
+static poller_t *pollers = NULL;
+
+/* Round-robin counter used to distribute idle connections over POLLERS. */
+static volatile svn_atomic_t next_poller = 0;
+
+/* Set when the pollers shall terminate. */
+static volatile svn_atomic_t pollers_stopped = FALSE;
+
 /* Very simple load determination callback for serve_interruptable:
    With less than half the threads in THREADS in use, we can afford to
-   wait in the socket read() function.  Otherwise, poll them round-robin. */
+   wait in the socket read() function.  Otherwise, poll them round-robin.
+
+   If we have POLLERS, never wait for the next command in a worker thread
+   but hand the connection over to the pollers instead. */
 static svn_boolean_t
 is_busy(connection_t *connection)
 {
+  if (pollers)
+    return TRUE;
+
   return apr_thread_pool_threads_count(threads) * 2
        > apr_thread_pool_thread_max_get(threads);
 }
 
+static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data);
+
+/* Have one of the POLLERS wait for the next command to arrive on
+   CONNECTION and then push it back into THREAD's task pool.  Fall back
+   to re-scheduling the connection immediately if that fails. */
+static void
+park_connection(connection_t *connection)
+{
+  apr_status_t status;
+  apr_pollfd_t pfd = { 0 };
+  poller_t *poller = &pollers[svn_atomic_inc(&next_poller) % POLLER_COUNT];
+
+  pfd.p = connection->pool;
+  pfd.desc_type = APR_POLL_SOCKET;
+  pfd.reqevents = APR_POLLIN;
+  pfd.desc.s = connection->usock;
+  pfd.client_data = connection;
+
+  status = apr_pollset_add(poller->pollset, &pfd);
+  if (status)
+    apr_thread_pool_push(threads, serve_thread, connection, 0, NULL);
+}
+
+/* Wait for the connections parked in the poller_t given by DATA to become
+   readable, i.e. for a client to send its next command, and dispatch them
+   to the worker threads. */
+static void * APR_THREAD_FUNC poller_thread(apr_thread_t *tid, void *data)
+{
+  poller_t *poller = data;
+  apr_interval_time_t backoff = 0;
+
+  while (!svn_atomic_read(&pollers_stopped))
+    {
+      const apr_pollfd_t *ready;
+      apr_int32_t count, i;
+      apr_status_t status = apr_pollset_poll(poller->pollset, -1, &count,
+                                             &ready);
+
+      /* Interrupted or woken up for shutdown. */
+      if (APR_STATUS_IS_EINTR(status))
+        continue;
+
+      /* Parked connections must not get lost, so keep trying.  But don't
+         spin on a pollset that fails persistently. */
+      if (status)
+        {
+          backoff = backoff ? MIN(2 * backoff, POLLER_MAX_BACKOFF)
+                            : apr_time_from_msec(1);
+          apr_sleep(backoff);
+          continue;
+        }
+
+      backoff = 0;
+
+      for (i = 0; i < count; ++i)
+        {
+          connection_t *connection = ready[i].client_data;
+
+          /* Don't report the same connection again while it is being
+             served.  The worker will park it again when it becomes idle. */
+          apr_pollset_remove(poller->pollset, &ready[i]);
+          apr_thread_pool_push(threads, serve_thread, connection, 0, NULL);
+        }
+    }
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Create and start the POLLERS, allocated in POOL.  If the platform does
+   not support thread-safe pollsets, leave POLLERS as NULL. */
+static svn_error_t *
+start_pollers(apr_pool_t *pool)
+{
+  poller_t *new_pollers = apr_pcalloc(pool,
+                                      POLLER_COUNT * sizeof(*new_pollers));
+  int i;
+
+  for (i = 0; i < POLLER_COUNT; ++i)
+    {
+      apr_status_t status
+        = apr_pollset_create(&new_pollers[i].pollset, POLLER_BATCH_SIZE,
+                             pool,
+                             APR_POLLSET_THREADSAFE | APR_POLLSET_WAKEABLE);
+
+      /* Not supported by the default pollset implementation? */
+      if (APR_STATUS_IS_ENOTIMPL(status))
+        return SVN_NO_ERROR;
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create pollset"));
+    }
+
+  pollers = new_pollers;
+  for (i = 0; i < POLLER_COUNT; ++i)
+    {
+      apr_status_t status = apr_thread_create(&pollers[i].thread, NULL,
+                                              poller_thread, &pollers[i],
+                                              pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create thread"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Terminate the POLLERS started by start_pollers(), if any.  Connections
+   still parked in them will not be served anymore. */
+static void
+stop_pollers(void)
+{
+  int i;
+  if (!pollers)
+    return;
+
+  svn_atomic_set(&pollers_stopped, TRUE);
+  for (i = 0; i < POLLER_COUNT; ++i)
+    if (pollers[i].thread)
+      {
+        apr_status_t retval;
+
+        apr_pollset_wakeup(pollers[i].pollset);
+        apr_thread_join(&retval, pollers[i].thread);
+      }
+}
+
 /* Serve the connection given by DATA.  Under high load, serve only
    the current command (if any) and then put the connection back into
-   THREAD's task pool. */
+   THREAD's task pool.  If we have POLLERS, serve only the commands that
+   have already arrived and then park the connection in a poller until
+   the next one comes in. */
 static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 {
   svn_boolean_t done;
+  svn_boolean_t has_command = TRUE;
   connection_t *connection = data;
   svn_error_t *err;
 
@@ -637,6 +848,13 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 
   /* process the actual request and log errors */
   err = serve_interruptable(&done, connection, is_busy, pool);
+
+  /* Data already buffered by CONN will not be signaled by the pollset.
+     So, we may only park connections that have nothing left to read. */
+  if (!err && !done && pollers)
+    err = svn_ra_svn__has_command(&has_command, &done, connection->conn,
+                                  pool);
+
   if (err)
     {
       logger__log_error(connection->params->logger, err, NULL,
@@ -647,9 +865,11 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
     }
   svn_root_pools__release_pool(pool, connection_pools);
 
-  /* Close or re-schedule connection. */
+  /* Close, park or re-schedule connection. */
   if (done)
     close_connection(connection);
+  else if (pollers && !has_command)
+    park_connection(connection);
   else
     apr_thread_pool_push(threads, serve_thread, connection, 0, NULL);
 
@@ -725,6 +945,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
   svn_boolean_t use_block_read = FALSE;
+  svn_boolean_t use_shared_cache = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
   int family = APR_INET;
@@ -764,6 +985,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.base = NULL;
   params.cfg = NULL;
   params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
+  params.compressed_transport = FALSE;
   params.logger = NULL;
   params.config_pool = NULL;
   params.fs_config = NULL;
@@ -900,6 +1122,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
             params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_MAX;
           break;
 
+        case SVNSERVE_OPT_COMPRESSED_TRANSPORT:
+          params.compressed_transport = TRUE;
+          break;
+
         case 'M':
           {
             apr_uint64_t sz_val;
@@ -929,6 +1155,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_SHARED_CACHE:
+          use_shared_cache = TRUE;
+          break;
+
+        case SVNSERVE_OPT_CACHE_POLICY:
+          SVN_ERR(svn_cache_config_set_replacement_policy(arg));
+          break;
+
         case SVNSERVE_OPT_CLIENT_SPEED:
           {
             apr_size_t bandwidth = (apr_size_t)apr_strtoi64(arg, NULL, 0);
@@ -1295,6 +1529,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       }
 
     svn_cache_config_set(&settings);
+
+    /* Create the cache before forking the per-connection processes such
+     * that all of them inherit the same one. */
+    if (use_shared_cache && handling_mode == connection_mode_fork)
+      SVN_ERR(svn_cache_config_create_shared_cache());
   }
 
 #if APR_HAS_THREADS
@@ -1323,6 +1562,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
       /* don't queue requests unless we reached the worker thread limit */
       apr_thread_pool_threshold_set(threads, 0);
+
+      /* idle connections shall not occupy worker threads */
+      SVN_ERR(start_pollers(pool));
     }
   else
     {
@@ -1352,8 +1594,22 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
               /* the child would't listen to the main server's socket */
               apr_socket_close(sock);
 
-              /* serve_socket() logs any error it returns, so ignore it. */
-              svn_error_clear(serve_socket(connection, connection->pool));
+              /* The locks of a shared cache must be re-attached to
+                 this process before the cache gets used. */
+              err = svn_cache_config_child_init(connection->pool);
+              if (err)
+                {
+                  logger__log_error(params.logger, err, NULL, NULL);
+                  svn_error_clear(err);
+                }
+              else
+                {
+                  /* serve_socket() logs any error it returns,
+                     so ignore it. */
+                  svn_error_clear(serve_socket(connection,
+                                               connection->pool));
+                }
+
               close_connection(connection);
               return SVN_NO_ERROR;
             }
@@ -1424,6 +1680,7 @@ main(int argc, const char *argv[])
   /* Explicitly wait for all threads to exit.  As we found out with similar
      code in our C test framework, the memory pool cleanup below cannot be
      trusted to do the right thing. */
+  stop_pollers();
   if (threads)
     apr_thread_pool_destroy(threads);
 #endif
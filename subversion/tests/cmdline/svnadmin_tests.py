@@ -3824,6 +3824,33 @@ def load_issue4725(sbox):
   sbox2.build(create_wc=False, empty=True)
   load_and_verify_dumpstream(sbox2, None, [], None, False, dump, '-M100')
 
+def verify_jobs(sbox):
+  "verify with concurrent jobs"
+
+  sbox.build(create_wc=False)
+
+  # Create enough revisions to have them verified by several tasks.
+  for i in range(40):
+    svntest.actions.run_and_verify_svnmucc(None, [],
+                                           '-U', sbox.repo_url,
+                                           '-m', 'r%d' % (i + 2),
+                                           'mkdir', 'dir%d' % i,
+                                           'propset', 'foo', str(i), 'iota')
+
+  _, expected_output, _ = svntest.actions.run_and_verify_svnadmin(
+                                   None, [], 'verify', sbox.repo_dir)
+
+  # Output must be identical, no matter how many jobs we use.
+  for jobs in ['1', '2', '7']:
+    svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                            'verify', '--jobs', jobs,
+                                            sbox.repo_dir)
+
+  # Invalid job counts shall be rejected.
+  svntest.actions.run_and_verify_svnadmin(None, '.*Invalid number of jobs.*',
+                                          'verify', '--jobs', '0',
+                                          sbox.repo_dir)
+
 ########################################################################
 # Run the tests
 
@@ -3898,6 +3925,7 @@ test_list = [ None,
               dump_exclude_all_rev_changes,
               dump_invalid_filtering_option,
               load_issue4725,
+              verify_jobs,
              ]
 
 if __name__ == '__main__':
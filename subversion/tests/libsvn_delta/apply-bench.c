@@ -0,0 +1,204 @@
+/* apply-bench.c -- measure the throughput of applying delta windows
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* The input is a series of files, usually consecutive versions of the
+ * same node, e.g. as extracted from a packed FSFS repository with
+ *
+ *   for r in `svn log -q URL | grep ^r | cut -c2- | cut -d' ' -f1`;
+ *     do svn cat -r $r URL > v$r; done
+ *
+ * Every version gets deltified against its predecessor, just like FSFS
+ * does when building delta chains.  The windows of all deltas are then
+ * applied repeatedly with svn_txdelta_apply_instructions(), which is what
+ * fulltext reconstruction spends its time on once the data is cached.
+ */
+
+#define APR_WANT_STDIO
+#define APR_WANT_STRFUNC
+#include <apr_want.h>
+
+#include <apr_general.h>
+#include <apr_time.h>
+
+#include "svn_delta.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+/* A delta window together with its source and expected target view. */
+typedef struct bench_window_t
+{
+  svn_txdelta_window_t *window;
+  const char *sbuf;
+  const char *expected;
+} bench_window_t;
+
+/* Deltify TARGET against SOURCE and append the windows to WINDOWS.
+ * Allocate them in POOL. */
+static svn_error_t *
+add_windows(apr_array_header_t *windows,
+            const svn_stringbuf_t *source,
+            const svn_stringbuf_t *target,
+            apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *stream;
+  svn_txdelta_window_t *window;
+  apr_size_t tpos = 0;
+
+  svn_txdelta2(&stream,
+               svn_stream_from_string(svn_string_create_from_buf(source,
+                                                                 pool),
+                                      pool),
+               svn_stream_from_string(svn_string_create_from_buf(target,
+                                                                 pool),
+                                      pool),
+               FALSE, pool);
+
+  while (TRUE)
+    {
+      bench_window_t *entry;
+
+      SVN_ERR(svn_txdelta_next_window(&window, stream, pool));
+      if (window == NULL)
+        break;
+
+      entry = apr_array_push(windows);
+      entry->window = window;
+      entry->sbuf = source->data + window->sview_offset;
+      entry->expected = target->data + tpos;
+      tpos += window->tview_len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Apply all WINDOWS ITERATIONS times and print the throughput.
+ * Use POOL for allocations. */
+static svn_error_t *
+run_bench(const apr_array_header_t *windows,
+          int iterations,
+          apr_pool_t *pool)
+{
+  char *tbuf = apr_palloc(pool, SVN_DELTA_WINDOW_SIZE);
+  apr_uint64_t total = 0;
+  apr_uint64_t ops = 0;
+  apr_time_t start;
+  apr_time_t elapsed;
+  int i, k;
+
+  /* Check that the deltas reproduce the input. */
+  for (k = 0; k < windows->nelts; ++k)
+    {
+      const bench_window_t *entry = &APR_ARRAY_IDX(windows, k,
+                                                   bench_window_t);
+      apr_size_t tlen = entry->window->tview_len;
+
+      SVN_ERR_ASSERT(tlen <= SVN_DELTA_WINDOW_SIZE);
+      svn_txdelta_apply_instructions(entry->window, entry->sbuf, tbuf, &tlen);
+      if (memcmp(tbuf, entry->expected, tlen))
+        return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                                "Delta does not reproduce the target");
+
+      total += tlen;
+      ops += entry->window->num_ops;
+    }
+
+  start = apr_time_now();
+  for (i = 0; i < iterations; ++i)
+    for (k = 0; k < windows->nelts; ++k)
+      {
+        const bench_window_t *entry = &APR_ARRAY_IDX(windows, k,
+                                                     bench_window_t);
+        apr_size_t tlen = entry->window->tview_len;
+
+        svn_txdelta_apply_instructions(entry->window, entry->sbuf, tbuf,
+                                       &tlen);
+      }
+  elapsed = apr_time_now() - start;
+
+  printf("%d windows, %" APR_UINT64_T_FMT " ops, %" APR_UINT64_T_FMT
+         " bytes per iteration\n", windows->nelts, ops, total);
+  printf("%.1f MB/s (%.3f ms per iteration)\n",
+         elapsed ? (double)total * iterations / elapsed : 0.0,
+         (double)elapsed / 1000.0 / iterations);
+
+  return SVN_NO_ERROR;
+}
+
+int
+main(int argc, char **argv)
+{
+  apr_pool_t *pool;
+  apr_array_header_t *windows;
+  svn_stringbuf_t *previous = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+  int iterations = 100;
+  int i;
+
+  if (argc > 2 && strcmp(argv[1], "-n") == 0)
+    {
+      iterations = atoi(argv[2]);
+      argc -= 2;
+      argv += 2;
+    }
+
+  if (argc < 3 || iterations < 1)
+    {
+      fprintf(stderr,
+              "Usage: apply-bench [-n <iterations>] <file1> <file2> ...\n"
+              "\n"
+              "Deltify each file against its predecessor and measure the\n"
+              "throughput of applying the resulting delta windows.\n");
+      exit(1);
+    }
+
+  apr_initialize();
+  pool = svn_pool_create(NULL);
+  windows = apr_array_make(pool, 16, sizeof(bench_window_t));
+
+  for (i = 1; !err && i < argc; ++i)
+    {
+      svn_stringbuf_t *contents;
+
+      err = svn_stringbuf_from_file2(&contents, argv[i], pool);
+      if (!err && previous)
+        err = add_windows(windows, previous, contents, pool);
+
+      previous = contents;
+    }
+
+  if (!err)
+    err = run_bench(windows, iterations, pool);
+
+  if (err)
+    {
+      svn_handle_error2(err, stderr, FALSE, "apply-bench: ");
+      svn_error_clear(err);
+      exit(1);
+    }
+
+  svn_pool_destroy(pool);
+  apr_terminate();
+
+  return 0;
+}
@@ -36,6 +36,7 @@
 #include "svn_delta.h"
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "private/svn_delta_private.h"
 
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
@@ -605,6 +606,365 @@ random_txdelta_to_svndiff_stream_test(apr_pool_t *pool)
   return err;
 }
 
+/* Read the contents of FP into a new stringbuf allocated in POOL,
+   truncated to at most SVN_DELTA_WINDOW_SIZE bytes. */
+static svn_stringbuf_t *
+read_window_data(apr_file_t *fp, apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(SVN_DELTA_WINDOW_SIZE,
+                                                        pool);
+  apr_size_t len;
+
+  rewind_file(fp);
+  apr_file_read_full(fp, result->data, SVN_DELTA_WINDOW_SIZE, &len);
+  result->len = len;
+  result->data[len] = '\0';
+
+  return result;
+}
+
+/* Run the xdelta engine on SOURCE and TARGET after copying them to
+   a buffer with the given ALIGNMENT offset.  Return the window in
+   *WINDOW, allocated in POOL. */
+static void
+xdelta_at_alignment(svn_txdelta_window_t **window,
+                    const svn_stringbuf_t *source,
+                    const svn_stringbuf_t *target,
+                    apr_size_t alignment,
+                    apr_pool_t *pool)
+{
+  svn_txdelta__ops_baton_t build_baton = { 0 };
+  char *data = apr_palloc(pool, alignment + source->len + target->len);
+
+  memcpy(data + alignment, source->data, source->len);
+  memcpy(data + alignment + source->len, target->data, target->len);
+
+  build_baton.new_data = svn_stringbuf_create_empty(pool);
+  svn_txdelta__xdelta(&build_baton, data + alignment, source->len,
+                      target->len, pool);
+
+  *window = svn_txdelta__make_window(&build_baton, pool);
+  (*window)->sview_len = source->len;
+  (*window)->tview_len = target->len;
+}
+
+/* (Note: *LAST_SEED is an output parameter.) */
+static svn_error_t *
+do_random_xdelta_alignment_test(apr_pool_t *pool,
+                                apr_uint32_t *last_seed)
+{
+  apr_uint32_t seed, maxlen;
+  apr_size_t bytes_range;
+  int i, iterations, dump_files, print_windows;
+  const char *random_bytes;
+  apr_pool_t *iterpool;
+
+  /* Initialize parameters and print out the seed in case we dump core
+     or something. */
+  init_params(&seed, &maxlen, &iterations, &dump_files, &print_windows,
+              &random_bytes, &bytes_range, pool);
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < iterations; i++)
+    {
+      apr_uint32_t subseed_base;
+      apr_file_t *source_file, *target_file;
+      svn_stringbuf_t *source, *target;
+      svn_txdelta_window_t *reference;
+      apr_size_t alignment;
+      char *tbuf;
+      apr_size_t tlen;
+
+      svn_pool_clear(iterpool);
+
+      *last_seed = seed;
+      subseed_base = svn_test_rand(&seed);
+      source_file = generate_random_file(maxlen, subseed_base, &seed,
+                                         random_bytes, bytes_range,
+                                         dump_files, iterpool);
+      target_file = generate_random_file(maxlen, subseed_base, &seed,
+                                         random_bytes, bytes_range,
+                                         dump_files, iterpool);
+      source = read_window_data(source_file, iterpool);
+      target = read_window_data(target_file, iterpool);
+      apr_file_close(source_file);
+      apr_file_close(target_file);
+
+      /* The xdelta engine requires a non-empty source. */
+      if (source->len == 0)
+        continue;
+
+      xdelta_at_alignment(&reference, source, target, 0, iterpool);
+
+      /* The delta must reproduce the target. */
+      tbuf = apr_palloc(iterpool, target->len + 1);
+      tlen = target->len;
+      svn_txdelta_apply_instructions(reference, source->data, tbuf, &tlen);
+      SVN_TEST_ASSERT(tlen == target->len);
+      SVN_TEST_ASSERT(memcmp(tbuf, target->data, tlen) == 0);
+
+      /* The chunked / vectorized comparisons must not make the result
+         depend on the buffer alignment. */
+      for (alignment = 1; alignment < 32; ++alignment)
+        {
+          svn_txdelta_window_t *window;
+          int k;
+
+          xdelta_at_alignment(&window, source, target, alignment, iterpool);
+
+          SVN_TEST_ASSERT(window->num_ops == reference->num_ops);
+          SVN_TEST_ASSERT(window->src_ops == reference->src_ops);
+          for (k = 0; k < window->num_ops; ++k)
+            {
+              SVN_TEST_ASSERT(window->ops[k].action_code
+                              == reference->ops[k].action_code);
+              SVN_TEST_ASSERT(window->ops[k].offset
+                              == reference->ops[k].offset);
+              SVN_TEST_ASSERT(window->ops[k].length
+                              == reference->ops[k].length);
+            }
+
+          SVN_TEST_ASSERT(svn_string_compare(window->new_data,
+                                             reference->new_data));
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_xdelta_alignment_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed;
+  svn_error_t *err = do_random_xdelta_alignment_test(pool, &seed);
+  if (err)
+    fprintf(stderr, "SEED: %lu\n", (unsigned long)seed);
+  return err;
+}
+
+/* (Note: *LAST_SEED is an output parameter.) */
+static svn_error_t *
+do_random_pipelined_svndiff_test(apr_pool_t *pool,
+                                 apr_uint32_t *last_seed)
+{
+  apr_uint32_t seed, maxlen;
+  apr_size_t bytes_range;
+  int i, iterations, dump_files, print_windows;
+  const char *random_bytes;
+  apr_pool_t *iterpool;
+
+  /* Initialize parameters and print out the seed in case we dump core
+     or something. */
+  init_params(&seed, &maxlen, &iterations, &dump_files, &print_windows,
+              &random_bytes, &bytes_range, pool);
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < iterations; i++)
+    {
+      apr_uint32_t subseed_base;
+      apr_file_t *source_file, *target_file;
+      svn_stringbuf_t *source, *target;
+      svn_stringbuf_t *expected, *actual;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_stream_t *stream;
+      apr_size_t len;
+
+      svn_pool_clear(iterpool);
+
+      /* Make sure we get several windows per delta. */
+      *last_seed = seed;
+      subseed_base = svn_test_rand(&seed);
+      source_file = generate_random_file(8 * maxlen, subseed_base, &seed,
+                                         random_bytes, bytes_range,
+                                         dump_files, iterpool);
+      target_file = generate_random_file(8 * maxlen, subseed_base, &seed,
+                                         random_bytes, bytes_range,
+                                         dump_files, iterpool);
+      SVN_ERR(svn_stringbuf_from_aprfile(&source, source_file, iterpool));
+      SVN_ERR(svn_stringbuf_from_aprfile(&target, target_file, iterpool));
+      apr_file_close(source_file);
+      apr_file_close(target_file);
+
+      /* Sequential reference. */
+      expected = svn_stringbuf_create_empty(iterpool);
+      svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                              svn_stream_from_stringbuf(expected, iterpool),
+                              i % 3, i % 10, iterpool);
+      stream = svn_txdelta_target_push(handler, handler_baton,
+                                       svn_stream_from_stringbuf(source,
+                                                                 iterpool),
+                                       iterpool);
+      len = target->len;
+      SVN_ERR(svn_stream_write(stream, target->data, &len));
+      SVN_ERR(svn_stream_close(stream));
+
+      /* Concurrent window processing must produce the very same data. */
+      actual = svn_stringbuf_create_empty(iterpool);
+      SVN_ERR(svn_txdelta__target_push_svndiff(&stream,
+                                    svn_stream_from_stringbuf(actual,
+                                                              iterpool),
+                                    i % 3, i % 10,
+                                    svn_stream_from_stringbuf(source,
+                                                              iterpool),
+                                    1 + i % 8, iterpool));
+      len = target->len;
+      SVN_ERR(svn_stream_write(stream, target->data, &len));
+      SVN_ERR(svn_stream_close(stream));
+
+      SVN_TEST_ASSERT(svn_stringbuf_compare(expected, actual));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_pipelined_svndiff_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed;
+  svn_error_t *err = do_random_pipelined_svndiff_test(pool, &seed);
+  if (err)
+    fprintf(stderr, "SEED: %lu\n", (unsigned long)seed);
+  return err;
+}
+
+/* Apply the ops of WINDOW to SBUF byte by byte, writing the result to
+   TBUF.  This is the reference for svn_txdelta_apply_instructions(). */
+static void
+apply_bytewise(const svn_txdelta_window_t *window,
+               const char *sbuf,
+               char *tbuf)
+{
+  apr_size_t tpos = 0;
+  int i;
+
+  for (i = 0; i < window->num_ops; ++i)
+    {
+      const svn_txdelta_op_t *op = &window->ops[i];
+      apr_size_t k;
+
+      for (k = 0; k < op->length; ++k)
+        switch (op->action_code)
+          {
+          case svn_txdelta_source:
+            tbuf[tpos + k] = sbuf[op->offset + k];
+            break;
+          case svn_txdelta_target:
+            tbuf[tpos + k] = tbuf[op->offset + k];
+            break;
+          default:
+            tbuf[tpos + k] = window->new_data->data[op->offset + k];
+          }
+
+      tpos += op->length;
+    }
+}
+
+/* (Note: *LAST_SEED is an output parameter.) */
+static svn_error_t *
+do_random_apply_instructions_test(apr_pool_t *pool,
+                                  apr_uint32_t *last_seed)
+{
+  apr_uint32_t seed, maxlen;
+  apr_size_t bytes_range;
+  int i, iterations, dump_files, print_windows;
+  const char *random_bytes;
+  apr_pool_t *iterpool;
+  apr_size_t j;
+  char sbuf[256];
+  char new_data[256];
+  svn_string_t new_string;
+
+  init_params(&seed, &maxlen, &iterations, &dump_files, &print_windows,
+              &random_bytes, &bytes_range, pool);
+
+  for (j = 0; j < sizeof(sbuf); ++j)
+    {
+      sbuf[j] = (char)svn_test_rand(&seed);
+      new_data[j] = (char)svn_test_rand(&seed);
+    }
+
+  new_string.data = new_data;
+  new_string.len = sizeof(new_data);
+
+  /* Short ops with short pattern lengths close to the buffer ends are
+     the interesting cases, so run many small windows. */
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < iterations * 1000; i++)
+    {
+      svn_txdelta_window_t window = { 0 };
+      svn_txdelta_op_t *ops;
+      char *expected, *actual;
+      apr_size_t tlen;
+      int k;
+
+      svn_pool_clear(iterpool);
+      *last_seed = seed;
+
+      window.num_ops = 1 + svn_test_rand(&seed) % 20;
+      window.sview_len = sizeof(sbuf);
+      window.new_data = &new_string;
+      window.ops = ops = apr_palloc(iterpool,
+                                    window.num_ops * sizeof(*ops));
+      for (k = 0; k < window.num_ops; ++k)
+        {
+          ops[k].action_code = svn_test_rand(&seed) % 3;
+          ops[k].length = 1 + svn_test_rand(&seed)
+                              % (svn_test_rand(&seed) % 2 ? 20 : 100);
+          if (window.tview_len == 0
+              && ops[k].action_code == svn_txdelta_target)
+            ops[k].action_code = svn_txdelta_source;
+
+          /* Target copies may overlap with the target range by up to
+             40 bytes, producing repeating patterns. */
+          if (ops[k].action_code == svn_txdelta_target)
+            ops[k].offset = window.tview_len - 1
+                          - svn_test_rand(&seed)
+                            % (window.tview_len < 40 ? window.tview_len : 40);
+          else
+            ops[k].offset = svn_test_rand(&seed)
+                            % (sizeof(sbuf) - ops[k].length + 1);
+
+          window.tview_len += ops[k].length;
+        }
+
+      /* Allocate exactly the required size, so out-of-bounds writes
+         get caught by memory checkers. */
+      expected = apr_palloc(iterpool, window.tview_len);
+      actual = apr_palloc(iterpool, window.tview_len);
+      apply_bytewise(&window, sbuf, expected);
+
+      tlen = window.tview_len;
+      svn_txdelta_apply_instructions(&window, sbuf, actual, &tlen);
+      SVN_TEST_ASSERT(tlen == window.tview_len);
+      SVN_TEST_ASSERT(memcmp(actual, expected, tlen) == 0);
+
+      /* Partial application must produce a prefix of the target. */
+      tlen = 1 + svn_test_rand(&seed) % window.tview_len;
+      memset(actual, 0, window.tview_len);
+      svn_txdelta_apply_instructions(&window, sbuf, actual, &tlen);
+      SVN_TEST_ASSERT(memcmp(actual, expected, tlen) == 0);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_apply_instructions_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed;
+  svn_error_t *err = do_random_apply_instructions_test(pool, &seed);
+  if (err)
+    fprintf(stderr, "SEED: %lu\n", (unsigned long)seed);
+  return err;
+}
+
 /* Change to 1 to enable the unit test for the delta combiner's range index: */
 #if 0
 #include "range-index-test.h"
@@ -625,6 +985,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "random combine delta test"),
     SVN_TEST_PASS2(random_txdelta_to_svndiff_stream_test,
                    "random txdelta to svndiff stream test"),
+    SVN_TEST_PASS2(random_xdelta_alignment_test,
+                   "xdelta output independent of buffer alignment"),
+    SVN_TEST_PASS2(random_pipelined_svndiff_test,
+                   "concurrent svndiff generation"),
+    SVN_TEST_PASS2(random_apply_instructions_test,
+                   "apply random delta instructions"),
 #ifdef SVN_RANGE_INDEX_TEST_H
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
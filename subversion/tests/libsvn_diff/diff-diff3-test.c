@@ -3065,6 +3065,175 @@ three_way_double_add(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Baton for check_histogram_range(). */
+typedef struct histogram_check_baton_t
+{
+  /* The line numbers making up both sources. */
+  const int *lines[2];
+
+  /* The first line in either source not yet covered by any range. */
+  apr_off_t next[2];
+} histogram_check_baton_t;
+
+/* Check that the range reported by svn_diff_output2() follows directly
+   after the previous one and, if COMMON, that the lines are the same in
+   both sources.  Implements the common parts of svn_diff_output_fns_t. */
+static svn_error_t *
+check_histogram_range(histogram_check_baton_t *b,
+                      svn_boolean_t common,
+                      apr_off_t original_start,
+                      apr_off_t original_length,
+                      apr_off_t modified_start,
+                      apr_off_t modified_length)
+{
+  apr_off_t i;
+
+  SVN_TEST_ASSERT(original_start == b->next[0]);
+  SVN_TEST_ASSERT(modified_start == b->next[1]);
+
+  if (common)
+    {
+      SVN_TEST_ASSERT(original_length == modified_length);
+      for (i = 0; i < original_length; i++)
+        SVN_TEST_ASSERT(b->lines[0][original_start + i]
+                        == b->lines[1][modified_start + i]);
+    }
+
+  b->next[0] += original_length;
+  b->next[1] += modified_length;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+histogram_output_common(void *output_baton,
+                        apr_off_t original_start,
+                        apr_off_t original_length,
+                        apr_off_t modified_start,
+                        apr_off_t modified_length,
+                        apr_off_t latest_start,
+                        apr_off_t latest_length)
+{
+  return check_histogram_range(output_baton, TRUE,
+                               original_start, original_length,
+                               modified_start, modified_length);
+}
+
+static svn_error_t *
+histogram_output_diff_modified(void *output_baton,
+                               apr_off_t original_start,
+                               apr_off_t original_length,
+                               apr_off_t modified_start,
+                               apr_off_t modified_length,
+                               apr_off_t latest_start,
+                               apr_off_t latest_length)
+{
+  return check_histogram_range(output_baton, FALSE,
+                               original_start, original_length,
+                               modified_start, modified_length);
+}
+
+static const svn_diff_output_fns_t histogram_check_fns =
+{
+  histogram_output_common,
+  histogram_output_diff_modified
+};
+
+/* Diff random files made of few distinct lines with the histogram
+   algorithm and verify that the result is consistent. */
+static svn_error_t *
+test_histogram_diff(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  diff_opts->algorithm = svn_diff_file_algorithm_histogram;
+
+  SVN_ERR(two_way_diff("histogram1", "histogram2",
+                       "x\n"
+                       "}\n"
+                       "y\n"
+                       "}\n",
+
+                       "y\n"
+                       "}\n",
+
+                       "--- histogram1"  NL
+                       "+++ histogram2"  NL
+                       "@@ -1,4 +1,2 @@" NL
+                       "-x\n"
+                       "-}\n"
+                       " y\n"
+                       " }\n",
+                       diff_opts, pool));
+
+  seed_val();
+  for (i = 0; i < 100; i++)
+    {
+      int *lines[2];
+      svn_stringbuf_t *contents[2];
+      histogram_check_baton_t baton = { { NULL } };
+      int count[2], distinct, j, k;
+      svn_diff_t *diff;
+
+      svn_pool_clear(iterpool);
+
+      /* Make the second source an edited version of the first one. */
+      count[0] = range_rand(0, 500);
+      distinct = range_rand(1, i % 2 ? 5 : 200);
+      lines[0] = apr_palloc(iterpool, count[0] * sizeof(int));
+      lines[1] = apr_palloc(iterpool, 2 * count[0] * sizeof(int));
+      count[1] = 0;
+      for (j = 0; j < count[0]; j++)
+        {
+          lines[0][j] = range_rand(0, distinct);
+          switch (range_rand(0, 9))
+            {
+              case 0:
+                break;
+              case 1:
+                lines[1][count[1]++] = range_rand(0, distinct);
+                break;
+              case 2:
+                lines[1][count[1]++] = range_rand(0, distinct);
+                /* Fall through. */
+              default:
+                lines[1][count[1]++] = lines[0][j];
+            }
+        }
+
+      for (k = 0; k < 2; k++)
+        {
+          contents[k] = svn_stringbuf_create_empty(iterpool);
+          for (j = 0; j < count[k]; j++)
+            svn_stringbuf_appendcstr(contents[k],
+                                     apr_psprintf(iterpool, "line %d\n",
+                                                  lines[k][j]));
+          baton.lines[k] = lines[k];
+        }
+
+      SVN_ERR(svn_diff_mem_string_diff(&diff,
+                                       svn_string_create_from_buf(contents[0],
+                                                                  iterpool),
+                                       svn_string_create_from_buf(contents[1],
+                                                                  iterpool),
+                                       diff_opts, iterpool));
+      SVN_ERR(svn_diff_output2(diff, &baton, &histogram_check_fns,
+                               NULL, NULL));
+      if (baton.next[0] != count[0] || baton.next[1] != count[1])
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Histogram diff covers %d:%d lines "
+                                 "instead of %d:%d (seed %u)",
+                                 (int)baton.next[0], (int)baton.next[1],
+                                 count[0], count[1], seed_val());
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -3107,6 +3276,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "2-way issue #3362 test v1"),
     SVN_TEST_PASS2(two_way_issue_3362_v2,
                    "2-way issue #3362 test v2"),
+    SVN_TEST_PASS2(test_histogram_diff,
+                   "2-way diff with the histogram algorithm"),
     SVN_TEST_XFAIL2(three_way_double_add,
                    "3-way merge, double add"),
     SVN_TEST_NULL
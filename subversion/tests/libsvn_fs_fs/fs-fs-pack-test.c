@@ -30,6 +30,7 @@
 #include "../../libsvn_fs_fs/fs_fs.h"
 #include "../../libsvn_fs_fs/low_level.h"
 #include "../../libsvn_fs_fs/pack.h"
+#include "../../libsvn_fs_fs/rev_file.h"
 #include "../../libsvn_fs_fs/util.h"
 
 #include "svn_hash.h"
@@ -100,6 +101,23 @@ pack_notify(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Append CONFIG to the fsfs.conf file of the repository in DIR.
+   Use POOL for allocations. */
+static svn_error_t *
+append_to_fsfs_conf(const char *dir,
+                    const char *config,
+                    apr_pool_t *pool)
+{
+  apr_file_t *file;
+
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(dir, PATH_CONFIG, pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  return SVN_NO_ERROR;
+}
+
 #define R1_LOG_MSG "Let's serf"
 
 /* Create a filesystem in DIR.  Set the shard size to SHARD_SIZE and create
@@ -416,6 +434,83 @@ read_packed_fs(const svn_test_opts_t *opts,
 #undef SHARD_SIZE
 #undef MAX_REV
 
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-read-mapped-packed-fs"
+#define SHARD_SIZE 5
+#define MAX_REV 23
+static svn_error_t *
+read_mapped_packed_fs(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_stream_t *rstream;
+  svn_stringbuf_t *rstring;
+  svn_fs_fs__revision_file_t *rev_file;
+  const char *first_mapping = NULL;
+  svn_revnum_t i;
+  int pass;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (opts->server_minor_version && (opts->server_minor_version < 11))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't support mapped pack files");
+#if !APR_HAS_MMAP
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "mmap() not supported");
+#endif
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, pool));
+  SVN_ERR(append_to_fsfs_conf(REPO_NAME,
+                              "[" CONFIG_SECTION_IO "]\n"
+                              CONFIG_OPTION_MMAP_PACKED_FILES " = true\n",
+                              pool));
+
+  /* The second pass uses a new filesystem object that shall reuse the
+     existing mappings. */
+  for (pass = 0; pass < 2; ++pass)
+    {
+      SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+      for (i = 1; i < (MAX_REV + 1); i++)
+        {
+          svn_fs_root_t *rev_root;
+          svn_stringbuf_t *sb;
+
+          SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+          SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", pool));
+          SVN_ERR(svn_test__stream_to_string(&rstring, rstream, pool));
+
+          if (i == 1)
+            sb = svn_stringbuf_create("This is the file 'iota'.\n", pool);
+          else
+            sb = svn_stringbuf_create(get_rev_contents(i, pool), pool);
+
+          if (! svn_stringbuf_compare(rstring, sb))
+            return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                     "Bad data in revision %ld.", i);
+        }
+
+      /* The data must actually have come from a mapped pack file and the
+         second pass must have reused the mapping of the first one. */
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 1, pool, pool));
+      SVN_TEST_ASSERT(rev_file->is_packed);
+      SVN_TEST_ASSERT(rev_file->mapped_data != NULL);
+      if (pass == 0)
+        first_mapping = rev_file->mapped_data;
+      else
+        SVN_TEST_ASSERT(rev_file->mapped_data == first_mapping);
+
+      SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+    }
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
 /* ------------------------------------------------------------------------ */
 #define REPO_NAME "test-repo-commit-packed-fs"
 #define SHARD_SIZE 5
@@ -1562,6 +1657,84 @@ rep_sharing_effectiveness(const svn_test_opts_t *opts,
 
 /* ------------------------------------------------------------------------ */
 
+#define REPO_NAME "test-repo-rep_sharing_across_handles"
+
+static svn_error_t *
+rep_sharing_across_handles(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  int count;
+  int i;
+  const char *hello_str = multiply_string("Hello, ", pool);
+  const char *world_str = multiply_string("World!", pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Create a repo and open it a second time.  Explicitly enable rep
+     sharing for both. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  ffd->rep_sharing_allowed = TRUE;
+
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  ffd = fs2->fsap_data;
+  ffd->rep_sharing_allowed = TRUE;
+
+  /* Revision 1: Let the second handle look up enough reps for the
+     rep-cache filter to get built. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs2, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", hello_str, pool));
+  for (i = 0; i < 200; ++i)
+    {
+      const char *name = apr_psprintf(pool, "file%d", i);
+
+      SVN_ERR(svn_fs_make_file(root, name, pool));
+      SVN_ERR(svn_test__set_file_contents(root, name,
+                                          apr_psprintf(pool, "%d", i),
+                                          pool));
+    }
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Revision 2: Add new contents through the first handle. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "bar", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "bar", world_str, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Revision 3: The second handle must find both contents in the
+     rep-cache, although the filter has been built before r2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs2, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "baz", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "baz", world_str, pool));
+  SVN_ERR(svn_fs_make_file(root, "qux", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "qux", hello_str, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Only the root directory has been written in r3. */
+  SVN_ERR(count_representations(&count, fs2, rev, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
 #define REPO_NAME "test-repo-delta_chain_with_plain"
 
 static svn_error_t *
@@ -1813,6 +1986,53 @@ pack_with_limited_memory(const svn_test_opts_t *opts,
 
 /* ------------------------------------------------------------------------ */
 
+#define REPO_NAME "test-repo-pack_concurrently"
+#define SHARD_SIZE 4
+#define MAX_REV 33
+static svn_error_t *
+pack_concurrently(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  struct pack_notify_baton pnb;
+  svn_revnum_t min_unpacked;
+  svn_fs_t *fs;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (opts->server_minor_version && (opts->server_minor_version < 11))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.11 SVN doesn't support concurrent packs");
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  /* Enable concurrent packing. */
+  SVN_ERR(append_to_fsfs_conf(REPO_NAME,
+                              "[" CONFIG_SECTION_PACK "]\n"
+                              CONFIG_OPTION_PACK_THREADS " = 4\n",
+                              pool));
+
+  /* Notifications must still arrive in shard order. */
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_pack(REPO_NAME, pack_notify, &pnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(pnb.expected_shard == (MAX_REV + 1) / SHARD_SIZE);
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__min_unpacked_rev(&min_unpacked, fs, pool));
+  SVN_TEST_INT_ASSERT(min_unpacked,
+                      (MAX_REV + 1) / SHARD_SIZE * SHARD_SIZE);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
 #define REPO_NAME "test-repo-large_delta_against_plain"
 
 static svn_error_t *
@@ -1934,6 +2154,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "file with 0 expanded-length, issue #4554"),
     SVN_TEST_OPTS_PASS(rep_sharing_effectiveness,
                        "rep-sharing effectiveness"),
+    SVN_TEST_OPTS_PASS(rep_sharing_across_handles,
+                       "rep-sharing between concurrent fs handles"),
     SVN_TEST_OPTS_PASS(delta_chain_with_plain,
                        "delta chains starting with PLAIN, issue #4577"),
     SVN_TEST_OPTS_PASS(compare_0_length_rep,
@@ -1942,6 +2164,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(pack_concurrently,
+                       "pack multiple shards concurrently"),
+    SVN_TEST_OPTS_PASS(read_mapped_packed_fs,
+                       "read from memory mapped pack files"),
     SVN_TEST_NULL
   };
 
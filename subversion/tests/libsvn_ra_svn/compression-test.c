@@ -0,0 +1,251 @@
+/*
+ * compression-test.c:  tests the compressed-transport codec of ra_svn.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_ra_svn.h"
+#include "svn_delta.h"
+
+#include "private/svn_ra_svn_private.h"
+
+#include "../svn_test.h"
+
+/* Number of tuples sent in the round-trip tests. */
+#define ITEM_COUNT 1000
+
+/* Return a connection that reads from IN and writes to OUT, compressing
+   at LEVEL.  Allocate it in POOL. */
+static svn_ra_svn_conn_t *
+create_conn(svn_stringbuf_t *in,
+            svn_stringbuf_t *out,
+            int level,
+            apr_pool_t *pool)
+{
+  return svn_ra_svn_create_conn5(NULL,
+                                 in ? svn_stream_from_stringbuf(in, pool)
+                                    : svn_stream_empty(pool),
+                                 out ? svn_stream_from_stringbuf(out, pool)
+                                     : svn_stream_empty(pool),
+                                 level, 0, 0, 0, 0, pool);
+}
+
+/* Write the ITEM_NO'th tuple of the round-trip tests to CONN. */
+static svn_error_t *
+write_item(svn_ra_svn_conn_t *conn,
+           int item_no,
+           apr_pool_t *pool)
+{
+  svn_string_t *str = svn_string_createf(pool, "/trunk/file-%d.c",
+                                         item_no % 37);
+
+  return svn_error_trace(svn_ra_svn__write_tuple(conn, pool, "(nwcs)",
+                                                 (apr_uint64_t)item_no,
+                                                 "change", "jrandom", str));
+}
+
+/* Read the ITEM_NO'th tuple of the round-trip tests from CONN and
+   verify its contents. */
+static svn_error_t *
+read_item(svn_ra_svn_conn_t *conn,
+          int item_no,
+          apr_pool_t *pool)
+{
+  apr_uint64_t number;
+  const char *word, *author;
+  svn_string_t *str;
+
+  SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "nwcs",
+                                 &number, &word, &author, &str));
+  SVN_TEST_ASSERT(number == (apr_uint64_t)item_no);
+  SVN_TEST_STRING_ASSERT(word, "change");
+  SVN_TEST_STRING_ASSERT(author, "jrandom");
+  SVN_TEST_STRING_ASSERT(str->data,
+                         apr_psprintf(pool, "/trunk/file-%d.c",
+                                      item_no % 37));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_round_trip(apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *plain = svn_stringbuf_create_empty(pool);
+  int level;
+  int i;
+
+  /* The uncompressed size of the data, for reference. */
+  {
+    svn_ra_svn_conn_t *conn = create_conn(NULL, plain, 0, pool);
+
+    for (i = 0; i < ITEM_COUNT; ++i)
+      {
+        svn_pool_clear(iterpool);
+        SVN_ERR(write_item(conn, i, iterpool));
+      }
+
+    SVN_ERR(svn_ra_svn__flush(conn, iterpool));
+  }
+
+  for (level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
+       level <= SVN_DELTA_COMPRESSION_LEVEL_MAX;
+       ++level)
+    {
+      svn_stringbuf_t *wire = svn_stringbuf_create_empty(pool);
+      svn_ra_svn_conn_t *writer = create_conn(NULL, wire, level, pool);
+      svn_ra_svn_conn_t *reader = create_conn(wire, NULL, level, pool);
+
+      SVN_ERR(svn_ra_svn__enable_compression(writer, pool));
+      for (i = 0; i < ITEM_COUNT; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(write_item(writer, i, iterpool));
+        }
+
+      SVN_ERR(svn_ra_svn__flush(writer, iterpool));
+
+      /* Repetitive command tuples must shrink considerably. */
+      SVN_TEST_ASSERT(wire->len < plain->len / 2);
+
+      SVN_ERR(svn_ra_svn__enable_compression(reader, pool));
+      for (i = 0; i < ITEM_COUNT; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(read_item(reader, i, iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_incompressible_data(apr_pool_t *pool)
+{
+  /* Several times the codec's buffer size, so that neither side can
+     process it in a single chunk. */
+  apr_size_t len = 4 * SVN_STREAM_CHUNK_SIZE + 17;
+  svn_stringbuf_t *data = svn_stringbuf_create_ensure(len, pool);
+  svn_stringbuf_t *wire = svn_stringbuf_create_empty(pool);
+  svn_ra_svn_conn_t *writer = create_conn(NULL, wire, 5, pool);
+  svn_ra_svn_conn_t *reader = create_conn(wire, NULL, 5, pool);
+  apr_uint32_t seed = 0;
+  svn_string_t *result;
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    svn_stringbuf_appendbyte(data, (char)svn_test_rand(&seed));
+
+  SVN_ERR(svn_ra_svn__enable_compression(writer, pool));
+  SVN_ERR(svn_ra_svn__write_tuple(writer, pool, "(s)",
+                                  svn_string_ncreate(data->data,
+                                                    data->len, pool)));
+  SVN_ERR(svn_ra_svn__flush(writer, pool));
+
+  SVN_ERR(svn_ra_svn__enable_compression(reader, pool));
+  SVN_ERR(svn_ra_svn__read_tuple(reader, pool, "s", &result));
+  SVN_TEST_ASSERT(result->len == len);
+  SVN_TEST_ASSERT(memcmp(result->data, data->data, len) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_switch_mid_stream(apr_pool_t *pool)
+{
+  svn_stringbuf_t *wire = svn_stringbuf_create_empty(pool);
+  svn_ra_svn_conn_t *writer = create_conn(NULL, wire, 5, pool);
+  svn_ra_svn_conn_t *reader = create_conn(wire, NULL, 5, pool);
+  const char *word;
+  apr_uint64_t number;
+
+  /* Uncompressed greeting, then compressed commands.  Enabling the
+     compression twice must not wrap the stream twice. */
+  SVN_ERR(svn_ra_svn__write_tuple(writer, pool, "(w)", "greeting"));
+  SVN_ERR(svn_ra_svn__enable_compression(writer, pool));
+  SVN_ERR(svn_ra_svn__enable_compression(writer, pool));
+  SVN_ERR(svn_ra_svn__write_tuple(writer, pool, "(n)", (apr_uint64_t)42));
+  SVN_ERR(svn_ra_svn__flush(writer, pool));
+
+  /* The reader will have buffered compressed data along with the
+     greeting.  It must not get lost when switching. */
+  SVN_ERR(svn_ra_svn__read_tuple(reader, pool, "w", &word));
+  SVN_TEST_STRING_ASSERT(word, "greeting");
+  SVN_ERR(svn_ra_svn__enable_compression(reader, pool));
+  SVN_ERR(svn_ra_svn__enable_compression(reader, pool));
+  SVN_ERR(svn_ra_svn__read_tuple(reader, pool, "n", &number));
+  SVN_TEST_ASSERT(number == 42);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_svndiff_version(apr_pool_t *pool)
+{
+  svn_stringbuf_t *caps = svn_stringbuf_create_empty(pool);
+  svn_ra_svn_conn_t *conn = create_conn(NULL, caps, 0, pool);
+  svn_ra_svn__list_t *list;
+
+  /* Get ourselves a capability list as the other side would send it. */
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "((ww))",
+                                  SVN_RA_SVN_CAP_SVNDIFF1,
+                                  SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED));
+  SVN_ERR(svn_ra_svn__flush(conn, pool));
+  conn = create_conn(caps, NULL, 5, pool);
+  SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "l", &list));
+
+  /* Without compressed transport, the deltas get compressed. */
+  conn = create_conn(NULL, NULL, 5, pool);
+  SVN_ERR(svn_ra_svn__set_capabilities(conn, list));
+  SVN_TEST_INT_ASSERT(svn_ra_svn__svndiff_version(conn), 2);
+
+  /* With it, they don't. */
+  SVN_ERR(svn_ra_svn__enable_compression(conn, pool));
+  SVN_TEST_INT_ASSERT(svn_ra_svn__svndiff_version(conn), 0);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+static int max_threads = -1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_round_trip,
+                   "round-trip tuples at all compression levels"),
+    SVN_TEST_PASS2(test_incompressible_data,
+                   "round-trip large incompressible data"),
+    SVN_TEST_PASS2(test_switch_mid_stream,
+                   "enable compression after the greeting"),
+    SVN_TEST_PASS2(test_svndiff_version,
+                   "no svndiff compression on compressed connections"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
@@ -1725,6 +1725,77 @@ test_authz_recursive_override(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_authz_tree_walk(apr_pool_t *pool)
+{
+  svn_authz_t *authz_cfg;
+  int count, i;
+  struct check_access_tests *reverse_set;
+
+  const char *contents =
+    "[/]"                                                                   NL
+    "plato = r"                                                             NL
+    ""                                                                      NL
+    "[/trunk/secret]"                                                       NL
+    "plato ="                                                               NL
+    ""                                                                      NL
+    "[/trunk/src/lib]"                                                      NL
+    "plato = rw"                                                            NL
+    ""                                                                      NL
+    "[:glob:/branches/*/private]"                                           NL
+    "plato ="                                                               NL;
+
+  /* Paths in the order of a depth-first tree walk, including jumps back
+   * to siblings of ancestors.  Lookups may continue from any previously
+   * visited parent directory and repeated checks may be answered from
+   * the cache of recent results. */
+  struct check_access_tests test_set[] = {
+    { "/", NULL, "plato", svn_authz_read, TRUE },
+    { "/trunk", NULL, "plato", svn_authz_read, TRUE },
+    { "/trunk/secret", NULL, "plato", svn_authz_read, FALSE },
+    { "/trunk/secret/x", NULL, "plato", svn_authz_read, FALSE },
+    { "/trunk/src", NULL, "plato", svn_authz_read, TRUE },
+    { "/trunk/src", NULL, "plato", svn_authz_write, FALSE },
+    { "/trunk/src/lib", NULL, "plato", svn_authz_write, TRUE },
+    { "/trunk/src/lib/a/b.c", NULL, "plato", svn_authz_write, TRUE },
+    { "/trunk/src/lib/a/b.c", NULL, "plato", svn_authz_read, TRUE },
+    { "/trunk/src/main.c", NULL, "plato", svn_authz_write, FALSE },
+    { "/trunk/secret/y", NULL, "plato", svn_authz_read, FALSE },
+    { "/trunk/README", NULL, "plato", svn_authz_read, TRUE },
+    { "/branches/1.x/private", NULL, "plato", svn_authz_read, FALSE },
+    { "/branches/1.x/private/z", NULL, "plato", svn_authz_read, FALSE },
+    { "/branches/1.x/public", NULL, "plato", svn_authz_read, TRUE },
+    { "/branches/2.x/private/z", NULL, "plato", svn_authz_read, FALSE },
+    { "/trunk", NULL, "plato", svn_authz_read | svn_authz_recursive, FALSE },
+    { "/trunk/src/lib", NULL, "plato",
+      svn_authz_write | svn_authz_recursive, TRUE },
+    { "/tags", NULL, "plato", svn_authz_read | svn_authz_recursive, TRUE },
+    { "/", NULL, "plato", svn_authz_read | svn_authz_recursive, FALSE },
+    { "/trunk/secret/x", NULL, "plato", svn_authz_read, FALSE },
+    { "/trunk/src/lib/a", NULL, "plato", svn_authz_write, TRUE },
+    /* Sentinel */
+    { NULL, NULL, NULL, svn_authz_none, FALSE }
+  };
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+
+  /* Walk the tree twice, the second time with all results cached. */
+  SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+  SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+
+  /* The same checks in reverse order must yield the same results with
+   * a fresh configuration as well. */
+  count = sizeof(test_set) / sizeof(test_set[0]) - 1;
+  reverse_set = apr_pcalloc(pool, (count + 1) * sizeof(*reverse_set));
+  for (i = 0; i < count; ++i)
+    memcpy(&reverse_set[i], &test_set[count - 1 - i], sizeof(*reverse_set));
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+  SVN_ERR(authz_check_access(authz_cfg, reverse_set, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_authz_pattern_tests(apr_pool_t *pool)
 {
@@ -3512,6 +3583,467 @@ get_logs(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Set the contents of the file PATH to CONTENTS in a new revision and, if
+   MERGEINFO is not NULL, set it as svn:mergeinfo on /branch. */
+static svn_error_t *
+commit_mergeinfo_rev(svn_repos_t *repos,
+                     svn_revnum_t *youngest_rev,
+                     const char *path,
+                     const char *contents,
+                     const char *mergeinfo,
+                     apr_pool_t *pool)
+{
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+
+  SVN_ERR(svn_fs_begin_txn(&txn, svn_repos_fs(repos), *youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, path, contents, pool));
+  if (mergeinfo)
+    SVN_ERR(svn_fs_change_node_prop(txn_root, "/branch", SVN_PROP_MERGEINFO,
+                                    svn_string_create(mergeinfo, pool),
+                                    pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(*youngest_rev));
+
+  return SVN_NO_ERROR;
+}
+
+/* Count the log entries of /branch in YOUNGEST_REV:1 in *COUNT. */
+static svn_error_t *
+count_branch_logs(svn_revnum_t *count,
+                  svn_repos_t *repos,
+                  svn_revnum_t youngest_rev,
+                  svn_boolean_t include_merged_revisions,
+                  apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "/branch";
+
+  *count = 0;
+  SVN_ERR(svn_repos_get_logs4(repos, paths, youngest_rev, 1, 0, FALSE,
+                              FALSE, include_merged_revisions, NULL,
+                              NULL, NULL, log_receiver, count, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+mergeinfo_index(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_revnum_t plain_count, indexed_count, live_count;
+  const char *index_path;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-mergeinfo-index",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add /trunk/f. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "/trunk", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/trunk/f", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/trunk/f", "1\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* Index the empty history.  All further revisions will be added to the
+     index as they get committed. */
+  SVN_ERR(svn_repos_build_mergeinfo_index(repos, NULL, NULL, NULL, NULL,
+                                          pool));
+
+  /* Revision 2:  Branch /trunk to /branch. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "/trunk", txn_root, "/branch",
+                      pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* Revisions 3 to 6:  Change /trunk and merge it into /branch twice. */
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/trunk/f", "3\n",
+                               NULL, pool));
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/branch/f", "3\n",
+                               "/trunk:3", pool));
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/trunk/f", "5\n",
+                               NULL, pool));
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/branch/f", "5\n",
+                               "/trunk:3,5", pool));
+
+  SVN_ERR(count_branch_logs(&plain_count, repos, youngest_rev, FALSE, pool));
+  SVN_ERR(count_branch_logs(&indexed_count, repos, youngest_rev, TRUE,
+                            pool));
+
+  /* Without the index, the same result must be produced. */
+  index_path = svn_dirent_join(svn_fs_path(fs, pool), "mergeinfo-index.db",
+                               pool);
+  SVN_ERR(svn_io_remove_file2(index_path, FALSE, pool));
+  SVN_ERR(count_branch_logs(&live_count, repos, youngest_rev, TRUE, pool));
+
+  /* r6, r4, r2 and r1 (through the copy) touched /branch.  With -g, r6 and
+     r4 report the merged r5 and r3 plus an end-of-children marker each. */
+  SVN_TEST_ASSERT(plain_count == 4);
+  SVN_TEST_ASSERT(live_count == plain_count + 4);
+  SVN_TEST_ASSERT(indexed_count == live_count);
+
+  /* Rebuilding from scratch gives the same result as well. */
+  SVN_ERR(svn_repos_build_mergeinfo_index(repos, NULL, NULL, NULL, NULL,
+                                          pool));
+  SVN_ERR(count_branch_logs(&indexed_count, repos, youngest_rev, TRUE,
+                            pool));
+  SVN_TEST_ASSERT(indexed_count == live_count);
+
+  /* A broken index must neither fail commits nor log. */
+  SVN_ERR(svn_io_write_atomic2(index_path, "not a database", 14, NULL,
+                               FALSE, pool));
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/trunk/f", "7\n",
+                               NULL, pool));
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/branch/f", "7\n",
+                               "/trunk:3,5,7", pool));
+  SVN_ERR(count_branch_logs(&indexed_count, repos, youngest_rev, TRUE,
+                            pool));
+  SVN_ERR(svn_io_remove_file2(index_path, FALSE, pool));
+  SVN_ERR(count_branch_logs(&live_count, repos, youngest_rev, TRUE, pool));
+  SVN_TEST_ASSERT(live_count == plain_count + 7);
+  SVN_TEST_ASSERT(indexed_count == live_count);
+
+  return SVN_NO_ERROR;
+}
+
+/* Log receiver appending the revision number to the svn_stringbuf_t
+   given as BATON. */
+static svn_error_t *
+log_revs_receiver(void *baton,
+                  svn_log_entry_t *log_entry,
+                  apr_pool_t *pool)
+{
+  svn_stringbuf_t *revs = baton;
+  svn_stringbuf_appendcstr(revs, apr_psprintf(pool, " r%ld",
+                                              log_entry->revision));
+  return SVN_NO_ERROR;
+}
+
+/* Return the revisions reported by the logs for all of PATHS in REPOS
+   from YOUNGEST_REV to 0, for either setting of STRICT_NODE_HISTORY,
+   as a single string allocated in POOL. */
+static svn_error_t *
+get_logs_string(const char **result,
+                svn_repos_t *repos,
+                const char *paths[],
+                svn_revnum_t youngest_rev,
+                apr_pool_t *pool)
+{
+  svn_stringbuf_t *revs = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; paths[i]; ++i)
+    {
+      apr_array_header_t *targets = apr_array_make(pool, 1,
+                                                   sizeof(const char *));
+      int strict;
+
+      APR_ARRAY_PUSH(targets, const char *) = paths[i];
+      for (strict = 0; strict < 2; ++strict)
+        {
+          svn_stringbuf_appendcstr(revs, apr_psprintf(pool, "\n%s%s:",
+                                                      paths[i],
+                                                      strict ? " (strict)"
+                                                             : ""));
+          SVN_ERR(svn_repos_get_logs4(repos, targets, youngest_rev, 0, 0,
+                                      FALSE, strict, FALSE, NULL,
+                                      NULL, NULL, log_revs_receiver, revs,
+                                      pool));
+        }
+    }
+
+  *result = revs->data;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+changes_index(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  const char *expected, *actual, *index_path;
+  const char *paths[] = { "/trunk/f", "/trunk/d/g", "/branch", "/branch/f",
+                          "/branch/d", "/branch/d/g", NULL };
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-changes-index",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add /trunk/f and /trunk/d/g. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "/trunk", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/trunk/f", pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "/trunk/d", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/trunk/d/g", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Revision 2:  Modify /trunk/f. */
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/trunk/f", "2\n",
+                               NULL, pool));
+
+  /* Revision 3:  Branch /trunk@1 to /branch. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 1, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "/trunk", txn_root, "/branch", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Revisions 4 and 5:  Modify /trunk/d/g and /branch/f. */
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/trunk/d/g", "4\n",
+                               NULL, pool));
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/branch/f", "5\n",
+                               NULL, pool));
+
+  /* Revision 6:  Replace /branch/d with a new directory. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "/branch/d", pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "/branch/d", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/branch/d/g", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Revision 7:  Replace /branch/f with a copy of /trunk/f@2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 2, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "/branch/f", pool));
+  SVN_ERR(svn_fs_copy(rev_root, "/trunk/f", txn_root, "/branch/f", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Revision 8:  Modify /branch/d/g. */
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/branch/d/g", "8\n",
+                               NULL, pool));
+
+  /* The index must not change the result. */
+  SVN_ERR(get_logs_string(&expected, repos, paths, youngest_rev, pool));
+
+  SVN_ERR(svn_repos_build_changes_index(repos, NULL, NULL, NULL, NULL,
+                                        pool));
+  SVN_ERR(get_logs_string(&actual, repos, paths, youngest_rev, pool));
+  SVN_TEST_STRING_ASSERT(actual, expected);
+
+  /* Revision 9:  Modify /branch/d/g again.  The commit extends the
+     index. */
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/branch/d/g", "9\n",
+                               NULL, pool));
+  SVN_ERR(get_logs_string(&actual, repos, paths, youngest_rev, pool));
+  index_path = svn_dirent_join(svn_fs_path(fs, pool), "changes-index.db",
+                               pool);
+  SVN_ERR(svn_io_remove_file2(index_path, FALSE, pool));
+  SVN_ERR(get_logs_string(&expected, repos, paths, youngest_rev, pool));
+  SVN_TEST_STRING_ASSERT(actual, expected);
+
+  /* Revision 10:  A broken index must neither fail commits nor log. */
+  SVN_ERR(svn_io_write_atomic2(index_path, "not a database", 14, NULL,
+                               FALSE, pool));
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/trunk/f", "10\n",
+                               NULL, pool));
+  SVN_ERR(get_logs_string(&actual, repos, paths, youngest_rev, pool));
+  SVN_ERR(svn_io_remove_file2(index_path, FALSE, pool));
+  SVN_ERR(get_logs_string(&expected, repos, paths, youngest_rev, pool));
+  SVN_TEST_STRING_ASSERT(actual, expected);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Implements svn_repos_authz_func_t.  Deny access to the path given
+   as BATON and allow everything else. */
+static svn_error_t *
+deny_path_authz(svn_boolean_t *allowed,
+                svn_fs_root_t *root,
+                const char *path,
+                void *baton,
+                apr_pool_t *pool)
+{
+  *allowed = strcmp(path, baton) != 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the line-origin map of PATH@END in REPOS as a string like
+   "0:r1 3:r2", with "-" standing for unattributed lines.  If DENIED_PATH
+   is not NULL, the caller may not read that path. */
+static svn_error_t *
+get_blame_string(const char **result,
+                 svn_repos_t *repos,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 const char *denied_path,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *chunks;
+  apr_hash_t *rev_props;
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+  int i;
+
+  SVN_ERR(svn_repos__blame(&chunks, &rev_props, repos, path, start, end,
+                           NULL,
+                           denied_path ? deny_path_authz : NULL,
+                           (void *)denied_path,
+                           NULL, NULL, pool, pool));
+
+  for (i = 0; i < chunks->nelts; ++i)
+    {
+      const svn_repos__blame_chunk_t *chunk
+        = &APR_ARRAY_IDX(chunks, i, svn_repos__blame_chunk_t);
+
+      if (i)
+        svn_stringbuf_appendbyte(buf, ' ');
+
+      if (SVN_IS_VALID_REVNUM(chunk->revision))
+        {
+          svn_stringbuf_appendcstr(buf,
+                                   apr_psprintf(pool, "%d:r%ld",
+                                                (int)chunk->start,
+                                                chunk->revision));
+          SVN_TEST_ASSERT(apr_hash_get(rev_props, &chunk->revision,
+                                       sizeof(chunk->revision)));
+        }
+      else
+        svn_stringbuf_appendcstr(buf, apr_psprintf(pool, "%d:-",
+                                                   (int)chunk->start));
+    }
+
+  *result = buf->data;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+server_side_blame(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  const char *actual;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-server-side-blame",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revision 1:  Add /f and /g. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/f", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/f", "a\nb\nc\n", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/g", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+
+  /* Revisions 2 and 3:  Change one line and append another. */
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/f", "a\nB\nc\n",
+                               NULL, pool));
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/f", "a\nB\nc\nd\n",
+                               NULL, pool));
+
+  SVN_ERR(get_blame_string(&actual, repos, "/f", 1, 3, NULL, pool));
+  SVN_TEST_STRING_ASSERT(actual, "0:r1 1:r2 2:r1 3:r3");
+  SVN_ERR(get_blame_string(&actual, repos, "/f", 2, 3, NULL, pool));
+  SVN_TEST_STRING_ASSERT(actual, "0:- 1:r2 2:- 3:r3");
+
+  /* Revision 4:  Change /g only.  /f@4 is the same node as /f@3. */
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/g", "4\n",
+                               NULL, pool));
+  SVN_ERR(get_blame_string(&actual, repos, "/f", 1, 4, NULL, pool));
+  SVN_TEST_STRING_ASSERT(actual, "0:r1 1:r2 2:r1 3:r3");
+
+  /* Revision 5:  Prepend a line.  This extends the map of /f@3. */
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/f",
+                               "x\na\nB\nc\nd\n", NULL, pool));
+  SVN_ERR(get_blame_string(&actual, repos, "/f", 1, 5, NULL, pool));
+  SVN_TEST_STRING_ASSERT(actual, "0:r5 1:r1 2:r2 3:r1 4:r3");
+  SVN_ERR(get_blame_string(&actual, repos, "/f", 4, 5, NULL, pool));
+  SVN_TEST_STRING_ASSERT(actual, "0:r5 1:-");
+
+  /* Older maps are still correct. */
+  SVN_ERR(get_blame_string(&actual, repos, "/f", 1, 2, NULL, pool));
+  SVN_TEST_STRING_ASSERT(actual, "0:r1 1:r2 2:r1");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+server_side_blame_authz(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  const char *actual;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-server-side-blame-authz",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* Revisions 1 and 2:  Create and change /f. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/f", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/f", "a\nb\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/f", "a\nB\n",
+                               NULL, pool));
+
+  /* Revision 3:  Copy /f to /h.  Revision 4:  Append to /h. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "/f", txn_root, "/h", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+  SVN_ERR(commit_mergeinfo_rev(repos, &youngest_rev, "/h", "a\nB\nc\n",
+                               NULL, pool));
+
+  /* If /f is unreadable, the history of /h starts with the copy.  The
+     second run takes the map from the cache, which must not have been
+     affected by the authz restrictions. */
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(get_blame_string(&actual, repos, "/h", 1, 4, "/f", pool));
+      SVN_TEST_STRING_ASSERT(actual, "0:r3 2:r4");
+    }
+
+  SVN_ERR(get_blame_string(&actual, repos, "/h", 1, 4, NULL, pool));
+  SVN_TEST_STRING_ASSERT(actual, "0:r1 1:r2 2:r4");
+  SVN_ERR(get_blame_string(&actual, repos, "/h", 4, 4, "/f", pool));
+  SVN_TEST_STRING_ASSERT(actual, "0:- 2:r4");
+
+  /* Unreadable paths must not reveal whether they exist. */
+  SVN_TEST_ASSERT_ERROR(get_blame_string(&actual, repos, "/h", 1, 4, "/h",
+                                         pool),
+                        SVN_ERR_AUTHZ_UNREADABLE);
+  SVN_TEST_ASSERT_ERROR(get_blame_string(&actual, repos, "/x", 1, 4, "/x",
+                                         pool),
+                        SVN_ERR_AUTHZ_UNREADABLE);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Tests for svn_repos_get_file_revsN() */
 
@@ -4505,6 +5037,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test if revprops are validated by repos"),
     SVN_TEST_OPTS_PASS(get_logs,
                        "test svn_repos_get_logs ranges and limits"),
+    SVN_TEST_OPTS_PASS(mergeinfo_index,
+                       "test log -g with the mergeinfo index"),
+    SVN_TEST_OPTS_PASS(changes_index,
+                       "test log with the changed-paths index"),
+    SVN_TEST_OPTS_PASS(server_side_blame,
+                       "test svn_repos__blame"),
+    SVN_TEST_OPTS_PASS(server_side_blame_authz,
+                       "test svn_repos__blame with authz"),
     SVN_TEST_OPTS_PASS(test_get_file_revs,
                        "test svn_repos_get_file_revsN"),
     SVN_TEST_OPTS_PASS(issue_4060,
@@ -4529,6 +5069,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test authz prefixes"),
     SVN_TEST_PASS2(test_authz_recursive_override,
                    "test recursively authz rule override"),
+    SVN_TEST_PASS2(test_authz_tree_walk,
+                   "test authz lookups along a tree walk"),
     SVN_TEST_PASS2(test_authz_pattern_tests,
                    "test various basic authz pattern combinations"),
     SVN_TEST_PASS2(test_authz_wildcards,
@@ -26,8 +26,15 @@
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_time.h>
+#include <apr_thread_proc.h>
+
+#if APR_HAS_FORK
+#include <unistd.h>   /* for _exit() */
+#endif
 
 #include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_dirent_uri.h"
 
 #include "private/svn_cache.h"
 #include "svn_private_config.h"
@@ -210,7 +217,8 @@ test_membuffer_cache_basic(apr_pool_t *pool)
   svn_membuffer_t *membuffer;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            svn_cache__membuffer_policy_lfu,
+                                            TRUE, TRUE, FALSE, pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
@@ -268,7 +276,8 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
   void *val;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            svn_cache__membuffer_policy_lfu,
+                                            TRUE, TRUE, FALSE, pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
@@ -300,7 +309,8 @@ test_membuffer_serializer_error_handling(apr_pool_t *pool)
 
   /* Create a new cache. */
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            svn_cache__membuffer_policy_lfu,
+                                            TRUE, TRUE, FALSE, pool));
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
                                             membuffer,
                                             serialize_revnum,
@@ -387,7 +397,8 @@ test_membuffer_cache_clearing(apr_pool_t *pool)
 
   /* Create a simple cache for strings, keyed by strings. */
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            svn_cache__membuffer_policy_lfu,
+                                            TRUE, TRUE, FALSE, pool));
   SVN_ERR(svn_cache__create_membuffer_cache(&cache,
                                             membuffer,
                                             serialize_revnum,
@@ -505,7 +516,8 @@ test_membuffer_unaligned_string_keys(apr_pool_t *pool)
   const char *unaligned_prefix = apr_pstrdup(pool, "_cache:") + 1;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            svn_cache__membuffer_policy_lfu,
+                                            TRUE, TRUE, FALSE, pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(
@@ -555,7 +567,8 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   const char *unaligned_prefix = apr_pstrdup(pool, "_cache:") + 1;
 
   SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
-                                            TRUE, TRUE, pool));
+                                            svn_cache__membuffer_policy_lfu,
+                                            TRUE, TRUE, FALSE, pool));
 
   /* Create a cache with just one entry. */
   SVN_ERR(svn_cache__create_membuffer_cache(
@@ -591,6 +604,492 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
 }
 
 
+/* Number of distinct keys used by test_membuffer_concurrent_hits. */
+#define BENCH_KEY_COUNT 1000
+
+/* Number of lookups per thread in test_membuffer_concurrent_hits. */
+#define BENCH_LOOKUP_COUNT 200000
+
+/* Maximum number of threads used by test_membuffer_concurrent_hits. */
+#define BENCH_MAX_THREADS 16
+
+/* Per-thread data for test_membuffer_concurrent_hits. */
+typedef struct lookup_baton_t
+{
+  /* Thread-private cache front-end for the shared membuffer. */
+  svn_cache__t *cache;
+
+  /* Thread-private root pool. */
+  apr_pool_t *pool;
+
+  /* Seed for the key sequence to look up. */
+  apr_uint32_t seed;
+
+  /* Outcome of the lookup sequence. */
+  svn_error_t *err;
+} lookup_baton_t;
+
+/* Look up BENCH_LOOKUP_COUNT random keys in BATON->CACHE and verify that
+ * each of them maps to its own value. */
+static svn_error_t *
+lookup_revnums(lookup_baton_t *baton)
+{
+  apr_pool_t *iterpool = svn_pool_create(baton->pool);
+  int i;
+
+  for (i = 0; i < BENCH_LOOKUP_COUNT; ++i)
+    {
+      svn_revnum_t key = svn_test_rand(&baton->seed) % BENCH_KEY_COUNT;
+      svn_revnum_t *value;
+      svn_boolean_t found;
+
+      if (i % 1000 == 0)
+        svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_cache__get((void **)&value, &found, baton->cache, &key,
+                             iterpool));
+      if (!found || *value != key)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "cache lookup failed for key %ld", key);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+static void *
+APR_THREAD_FUNC lookup_thread(apr_thread_t *tid, void *data)
+{
+  lookup_baton_t *baton = data;
+
+  baton->err = lookup_revnums(baton);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+#endif
+
+/* Look up keys in MEMBUFFER from THREAD_COUNT threads concurrently and
+ * return the total number of hits per second in *RATE. */
+static svn_error_t *
+run_concurrent_lookups(double *rate,
+                       svn_membuffer_t *membuffer,
+                       int thread_count,
+                       apr_pool_t *pool)
+{
+  lookup_baton_t batons[BENCH_MAX_THREADS];
+#if APR_HAS_THREADS
+  apr_thread_t *threads[BENCH_MAX_THREADS];
+#endif
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_time_t start;
+  apr_time_t duration;
+  int i;
+
+  /* Each thread gets its own front-end, i.e. the only shared resource
+   * is the membuffer itself - just like in a multi-threaded server. */
+  for (i = 0; i < thread_count; ++i)
+    {
+      batons[i].pool = svn_pool_create(NULL);
+      batons[i].seed = (apr_uint32_t)i;
+      batons[i].err = SVN_NO_ERROR;
+      SVN_ERR(svn_cache__create_membuffer_cache(
+                &batons[i].cache, membuffer,
+                serialize_revnum, deserialize_revnum,
+                sizeof(svn_revnum_t), "bench:",
+                SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+                batons[i].pool, pool));
+    }
+
+  start = apr_time_now();
+
+#if APR_HAS_THREADS
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t status = apr_thread_create(&threads[i], NULL,
+                                              lookup_thread, &batons[i],
+                                              pool);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't create thread");
+    }
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, threads[i]);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't join thread");
+    }
+#else
+  for (i = 0; i < thread_count; ++i)
+    batons[i].err = lookup_revnums(&batons[i]);
+#endif
+
+  duration = MAX(apr_time_now() - start, 1);
+  *rate = (double)thread_count * BENCH_LOOKUP_COUNT * APR_USEC_PER_SEC
+        / duration;
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      err = svn_error_compose_create(err, batons[i].err);
+      svn_pool_destroy(batons[i].pool);
+    }
+
+  return svn_error_trace(err);
+}
+
+static svn_error_t *
+test_membuffer_concurrent_hits(const svn_test_opts_t *opts,
+                               apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_revnum_t key;
+  int thread_count;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(
+            &membuffer, 0x1000000, 0x400000, 0,
+            svn_cache__membuffer_policy_tinylfu, TRUE, TRUE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &cache, membuffer, serialize_revnum, deserialize_revnum,
+            sizeof(svn_revnum_t), "bench:",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            pool, pool));
+
+  for (key = 0; key < BENCH_KEY_COUNT; ++key)
+    SVN_ERR(svn_cache__set(cache, &key, &key, pool));
+
+  for (thread_count = 1;
+       thread_count <= BENCH_MAX_THREADS;
+       thread_count *= 2)
+    {
+      double rate;
+      SVN_ERR(run_concurrent_lookups(&rate, membuffer, thread_count, pool));
+
+      if (opts->verbose)
+        printf("%2d thread(s): %.0f hits/sec\n", thread_count, rate);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Parameters of the synthetic access trace used by replay_scan_trace.
+ * The hot set fits easily into the cache while the scan is several times
+ * larger than the whole cache.
+ */
+#define TRACE_ITEM_SIZE 1000
+#define TRACE_HOT_KEYS 200
+#define TRACE_WARMUP_ROUNDS 10
+#define TRACE_SCAN_KEYS 5000
+#define TRACE_SCAN_STRIDE 10
+#define TRACE_HOT_PER_STRIDE 5
+
+/* Request KEY from CACHE as the FSFS code would: look it up and add VALUE
+ * in case of a miss.  Return whether it was a hit in *HIT.  Use POOL for
+ * allocations. */
+static svn_error_t *
+trace_access(svn_boolean_t *hit,
+             svn_cache__t *cache,
+             apr_int64_t key,
+             svn_stringbuf_t *value,
+             apr_pool_t *pool)
+{
+  void *dummy;
+
+  SVN_ERR(svn_cache__get(&dummy, hit, cache, &key, pool));
+  if (!*hit)
+    SVN_ERR(svn_cache__set(cache, &key, value, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Replay a mixed scan / hot-set trace against a new 1MB membuffer cache
+ * using POLICY.  After warming up the cache with TRACE_HOT_KEYS items,
+ * TRACE_SCAN_KEYS items get requested exactly once each while the hot
+ * items continue to be requested in between.  Return the hit ratio for
+ * the hot items during the scan in *HOT_HIT_RATIO and the hit ratio over
+ * the whole trace in *TOTAL_HIT_RATIO.  Use POOL for allocations. */
+static svn_error_t *
+replay_scan_trace(double *hot_hit_ratio,
+                  double *total_hit_ratio,
+                  svn_cache__membuffer_policy_t policy,
+                  apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_stringbuf_t *value;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int hot_requests = 0, hot_hits = 0;
+  int requests = 0, hits = 0;
+  int hot_key = 0;
+  int i, k;
+  svn_boolean_t hit;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 0x100000, 0x20000,
+                                            1, policy, FALSE, TRUE, FALSE,
+                                            pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &cache, membuffer, NULL, NULL, sizeof(apr_int64_t), "trace:",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            pool, pool));
+
+  value = svn_stringbuf_create_ensure(TRACE_ITEM_SIZE, pool);
+  svn_stringbuf_fillchar(value, 'x', TRACE_ITEM_SIZE);
+
+  /* Warm-up: the hot set gets requested repeatedly. */
+  for (i = 0; i < TRACE_WARMUP_ROUNDS; ++i)
+    for (k = 0; k < TRACE_HOT_KEYS; ++k)
+      {
+        svn_pool_clear(iterpool);
+        SVN_ERR(trace_access(&hit, cache, k, value, iterpool));
+        requests++;
+        hits += hit;
+      }
+
+  /* Scan, interleaved with continued hot set requests. */
+  for (i = 0; i < TRACE_SCAN_KEYS; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(trace_access(&hit, cache, TRACE_HOT_KEYS + i, value,
+                           iterpool));
+      requests++;
+      hits += hit;
+
+      if (i % TRACE_SCAN_STRIDE == 0)
+        for (k = 0; k < TRACE_HOT_PER_STRIDE; ++k)
+          {
+            SVN_ERR(trace_access(&hit, cache, hot_key, value, iterpool));
+            hot_key = (hot_key + 1) % TRACE_HOT_KEYS;
+
+            requests++;
+            hits += hit;
+            hot_requests++;
+            hot_hits += hit;
+          }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  *hot_hit_ratio = (double)hot_hits / hot_requests;
+  *total_hit_ratio = (double)hits / requests;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_scan_resistance(const svn_test_opts_t *opts,
+                               apr_pool_t *pool)
+{
+  double lfu_hot, lfu_total;
+  double tinylfu_hot, tinylfu_total;
+
+  SVN_ERR(replay_scan_trace(&lfu_hot, &lfu_total,
+                            svn_cache__membuffer_policy_lfu, pool));
+  SVN_ERR(replay_scan_trace(&tinylfu_hot, &tinylfu_total,
+                            svn_cache__membuffer_policy_tinylfu, pool));
+
+  if (opts->verbose)
+    {
+      printf("lfu    : %5.1f%% hot set hits, %5.1f%% total hits\n",
+             100.0 * lfu_hot, 100.0 * lfu_total);
+      printf("tinylfu: %5.1f%% hot set hits, %5.1f%% total hits\n",
+             100.0 * tinylfu_hot, 100.0 * tinylfu_total);
+    }
+
+  /* The scan must not flush the hot set. */
+  SVN_TEST_ASSERT(tinylfu_hot > 0.8);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_FORK
+/* Store 42 under key "answer" in a new front-end cache for MEMBUFFER
+ * that uses a key prefix not known to the creator of MEMBUFFER.
+ * This is what the child process in test_membuffer_process_shared does.
+ */
+static svn_error_t *
+set_in_child(svn_membuffer_t *membuffer,
+             apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_revnum_t answer = 42;
+
+  SVN_ERR(svn_cache__membuffer_child_init(membuffer, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &cache, membuffer, serialize_revnum, deserialize_revnum,
+            APR_HASH_KEY_STRING, "child:",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            pool, pool));
+
+  return svn_error_trace(svn_cache__set(cache, "answer", &answer, pool));
+}
+#endif
+
+static svn_error_t *
+test_membuffer_process_shared(apr_pool_t *pool)
+{
+#if APR_HAS_FORK
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_revnum_t *answer;
+  svn_boolean_t found;
+  apr_proc_t proc;
+  apr_status_t status;
+  int exitcode;
+  apr_exit_why_e exitwhy;
+
+  svn_error_t *err = svn_cache__membuffer_cache_create(
+                         &membuffer, 0x100000, 0x10000, 0,
+                         svn_cache__membuffer_policy_tinylfu,
+                         FALSE, TRUE, TRUE, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "process-shared caches not supported");
+    }
+  SVN_ERR(err);
+
+  /* A shared cache must behave like any other cache. */
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &cache, membuffer, serialize_revnum, deserialize_revnum,
+            APR_HASH_KEY_STRING, "cache:",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            pool, pool));
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+  /* Data written by a child process must be visible to the parent. */
+  status = apr_proc_fork(&proc, pool);
+  if (status == APR_INCHILD)
+    {
+      /* Don't run any cleanups in the child. */
+      err = set_in_child(membuffer, pool);
+      _exit(err ? 1 : 0);
+    }
+  else if (status != APR_INPARENT)
+    return svn_error_wrap_apr(status, "fork failed");
+
+  status = apr_proc_wait(&proc, &exitcode, &exitwhy, APR_WAIT);
+  if (status != APR_CHILD_DONE)
+    return svn_error_wrap_apr(status, "waiting for child failed");
+  SVN_TEST_ASSERT(APR_PROC_CHECK_EXIT(exitwhy));
+  SVN_TEST_INT_ASSERT(exitcode, 0);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &cache, membuffer, serialize_revnum, deserialize_revnum,
+            APR_HASH_KEY_STRING, "child:",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            pool, pool));
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "answer", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*answer == 42);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "fork() not supported");
+#endif
+}
+
+/* Create a membuffer-based cache with PREFIX in *CACHE_P and put a disk
+ * tier using STORE behind it.  The first level gets its own membuffer
+ * instance, i.e. it will always start empty.  Allocate in POOL. */
+static svn_error_t *
+create_disk_tier(svn_cache__t **cache_p,
+                 svn_cache__disk_t *store,
+                 svn_cache__serialize_func_t serializer,
+                 svn_cache__deserialize_func_t deserializer,
+                 const char *prefix,
+                 apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *memory;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            svn_cache__membuffer_policy_lfu,
+                                            TRUE, TRUE, FALSE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &memory, membuffer, serializer, deserializer,
+            APR_HASH_KEY_STRING, prefix,
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            pool, pool));
+  SVN_ERR(svn_cache__create_disk_tier(cache_p, memory, store,
+                                      serializer, deserializer,
+                                      APR_HASH_KEY_STRING, prefix, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_disk_cache(apr_pool_t *pool)
+{
+  const char *sandbox;
+  svn_cache__disk_t *store;
+  svn_cache__t *cache;
+  svn_cache__info_t info;
+  svn_revnum_t *answer;
+  svn_stringbuf_t *text;
+  svn_boolean_t found;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "cache-test-disk", pool));
+  err = svn_cache__open_disk_store(&store,
+                                   svn_dirent_join(sandbox, "store", pool),
+                                   0x100000, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "disk caches not supported");
+    }
+  SVN_ERR(err);
+  if (store == NULL)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "disk cache is locked by another process");
+
+  /* A disk tier must behave like any other cache. */
+  SVN_ERR(create_disk_tier(&cache, store, serialize_revnum,
+                           deserialize_revnum, "revnum:", pool));
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+  SVN_ERR(create_disk_tier(&cache, store, NULL, NULL, "text:", pool));
+  SVN_ERR(svn_cache__set(cache, "text", svn_stringbuf_create("data", pool),
+                         pool));
+
+  /* With a new, empty first level, all data must come from the disk. */
+  SVN_ERR(create_disk_tier(&cache, store, serialize_revnum,
+                           deserialize_revnum, "revnum:", pool));
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "thirty", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*answer == 30);
+
+  /* That hit will have been promoted to the first level. */
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "thirty", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_ASSERT(*answer == 30);
+
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "forty", pool));
+  SVN_TEST_ASSERT(!found);
+
+  SVN_ERR(svn_cache__get_info(cache, &info, FALSE, pool));
+  SVN_TEST_ASSERT(info.l2_gets == 2);
+  SVN_TEST_ASSERT(info.l2_hits == 1);
+  SVN_TEST_ASSERT(info.l2_used_size > 0);
+  SVN_TEST_ASSERT(info.l2_total_size >= 0x100000);
+
+  SVN_ERR(create_disk_tier(&cache, store, NULL, NULL, "text:", pool));
+  SVN_ERR(svn_cache__get((void **) &text, &found, cache, "text", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_STRING_ASSERT(text->data, "data");
+
+  /* Prefixes separate the key spaces. */
+  SVN_ERR(svn_cache__get((void **) &text, &found, cache, "thirty", pool));
+  SVN_TEST_ASSERT(!found);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -616,6 +1115,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test membuffer cache with unaligned string keys"),
     SVN_TEST_PASS2(test_membuffer_unaligned_fixed_keys,
                    "test membuffer cache with unaligned fixed keys"),
+    SVN_TEST_PASS2(test_membuffer_process_shared,
+                   "membuffer cache shared across processes"),
+    SVN_TEST_OPTS_PASS(test_membuffer_concurrent_hits,
+                       "concurrent membuffer cache hits"),
+    SVN_TEST_PASS2(test_disk_cache,
+                   "membuffer cache with persistent disk tier"),
+    SVN_TEST_OPTS_PASS(test_membuffer_scan_resistance,
+                       "scan-resistant membuffer replacement policy"),
     SVN_TEST_NULL
   };
 
@@ -1147,6 +1147,65 @@ test_apr_trunc_workaround(apr_pool_t *pool)
   return SVN_NO_ERROR;  
 }
 
+static svn_error_t *
+test_file_copy_in_kernel(apr_pool_t *pool)
+{
+  const char *tmp_dir;
+  const char *src_path;
+  const char *dst_path;
+  const char *copy_path;
+  apr_file_t *src_file;
+  apr_file_t *dst_file;
+  svn_stringbuf_t *content;
+  svn_stringbuf_t *actual_content;
+  svn_boolean_t copied;
+  apr_off_t offset;
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "test_file_copy_in_kernel",
+                                    pool));
+
+  /* Large enough to span multiple file system blocks. */
+  content = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < 10000; i++)
+    svn_stringbuf_appendcstr(content, "0123456789abcdef");
+
+  src_path = svn_dirent_join(tmp_dir, "src", pool);
+  dst_path = svn_dirent_join(tmp_dir, "dst", pool);
+  copy_path = svn_dirent_join(tmp_dir, "copy", pool);
+  SVN_ERR(svn_io_file_create_bytes(src_path, content->data, content->len,
+                                   pool));
+
+  SVN_ERR(svn_io_file_open(&src_file, src_path, APR_READ | APR_BUFFERED,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_open(&dst_file, dst_path,
+                           APR_WRITE | APR_CREATE | APR_EXCL | APR_BUFFERED,
+                           APR_OS_DEFAULT, pool));
+
+  SVN_ERR(svn_io__file_copy_in_kernel(&copied, src_file, dst_file, pool));
+
+  /* The file positions must not have been changed. */
+  offset = 0;
+  SVN_ERR(svn_io_file_seek(src_file, APR_CUR, &offset, pool));
+  SVN_TEST_ASSERT(offset == 0);
+
+  SVN_ERR(svn_io_file_close(src_file, pool));
+  SVN_ERR(svn_io_file_close(dst_file, pool));
+
+  /* Whether the platform supports this or not, DST is either a full copy
+     or still empty. */
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, dst_path, pool));
+  SVN_TEST_STRING_ASSERT(actual_content->data,
+                         copied ? content->data : "");
+
+  /* svn_io_copy_file() uses the same mechanism with a fallback. */
+  SVN_ERR(svn_io_copy_file(src_path, copy_path, TRUE, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, copy_path, pool));
+  SVN_TEST_STRING_ASSERT(actual_content->data, content->data);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 3;
@@ -1184,6 +1243,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_io_open_uniquely_named()"),
     SVN_TEST_PASS2(test_apr_trunc_workaround,
                    "test workaround for APR in svn_io_file_trunc"),
+    SVN_TEST_PASS2(test_file_copy_in_kernel,
+                   "test svn_io__file_copy_in_kernel"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,188 @@
+/*
+ * task-test.c:  a collection of svn_task__* tests
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_thread_proc.h>
+
+#include "svn_pools.h"
+#include "private/svn_task.h"
+
+#include "../svn_test.h"
+
+/* Number of tasks to push in each test. */
+#define TASK_COUNT 200
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is an int *.
+ * Return the square of that value. */
+static svn_error_t *
+square_process(void **result,
+               void *process_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  int value = *(int *)process_baton;
+  int *square = apr_palloc(result_pool, sizeof(*square));
+
+#if APR_HAS_THREADS
+  /* Make later tasks tend to complete before earlier ones. */
+  if (value % 7 == 0)
+    apr_thread_yield();
+#endif
+
+  *square = value * value;
+  *result = square;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  Fail for the value 13. */
+static svn_error_t *
+failing_process(void **result,
+                void *process_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  if (*(int *)process_baton == 13)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL, "unlucky");
+
+  return square_process(result, process_baton, result_pool, scratch_pool);
+}
+
+/* Baton for collect_output. */
+typedef struct collector_t
+{
+  /* Number of outputs received so far. */
+  int count;
+
+  /* Set if outputs were not received in push order. */
+  svn_boolean_t out_of_order;
+} collector_t;
+
+/* Implements svn_task__output_func_t.  OUTPUT_BATON is a collector_t. */
+static svn_error_t *
+collect_output(void *result,
+               void *output_baton,
+               apr_pool_t *scratch_pool)
+{
+  collector_t *collector = output_baton;
+
+  if (*(int *)result != collector->count * collector->count)
+    collector->out_of_order = TRUE;
+
+  collector->count++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Push TASK_COUNT tasks with PROCESS to a queue with MAX_PENDING slots and
+ * verify that the outputs arrive in order. */
+static svn_error_t *
+run_ordered_tasks(int max_pending,
+                  apr_pool_t *pool)
+{
+  svn_task__queue_t *queue;
+  collector_t collector = { 0 };
+  int *values = apr_palloc(pool, TASK_COUNT * sizeof(*values));
+  int i;
+
+  SVN_ERR(svn_task__queue_create(&queue, max_pending, pool));
+  for (i = 0; i < TASK_COUNT; ++i)
+    {
+      values[i] = i;
+      SVN_ERR(svn_task__queue_push(queue, square_process, &values[i],
+                                   collect_output, &collector, pool));
+    }
+
+  SVN_ERR(svn_task__queue_finish(queue, pool));
+
+  SVN_TEST_INT_ASSERT(collector.count, TASK_COUNT);
+  SVN_TEST_ASSERT(!collector.out_of_order);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_sequential_tasks(apr_pool_t *pool)
+{
+  return run_ordered_tasks(1, pool);
+}
+
+static svn_error_t *
+test_concurrent_tasks(apr_pool_t *pool)
+{
+  SVN_ERR(run_ordered_tasks(4, pool));
+  SVN_ERR(run_ordered_tasks(svn_task__default_concurrency(), pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_task_errors(apr_pool_t *pool)
+{
+  svn_task__queue_t *queue;
+  collector_t collector = { 0 };
+  int *values = apr_palloc(pool, TASK_COUNT * sizeof(*values));
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_task__queue_create(&queue, 4, pool));
+  for (i = 0; i < TASK_COUNT && !err; ++i)
+    {
+      values[i] = i;
+      err = svn_task__queue_push(queue, failing_process, &values[i],
+                                 collect_output, &collector, pool);
+    }
+
+  if (!err)
+    err = svn_task__queue_finish(queue, pool);
+
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_TEST_FAILED);
+
+  /* Exactly the outputs before the failing task must have been
+   * delivered. */
+  SVN_TEST_INT_ASSERT(collector.count, 13);
+  SVN_TEST_ASSERT(!collector.out_of_order);
+
+  /* The queue can be reused after an error. */
+  SVN_ERR(svn_task__queue_finish(queue, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_sequential_tasks,
+                   "sequential task execution"),
+    SVN_TEST_PASS2(test_concurrent_tasks,
+                   "concurrent tasks with ordered output"),
+    SVN_TEST_PASS2(test_task_errors,
+                   "error handling in task queues"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
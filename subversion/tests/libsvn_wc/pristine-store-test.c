@@ -44,6 +44,7 @@
 
 #include "../../libsvn_wc/wc.h"
 #include "../../libsvn_wc/wc_db.h"
+#include "../../libsvn_wc/wc_db_private.h"
 #include "../../libsvn_wc/wc-queries.h"
 #include "../../libsvn_wc/workqueue.h"
 
@@ -306,6 +307,176 @@ reject_mismatching_text(const svn_test_opts_t *opts,
 #endif
 }
 
+/* Install DATA as a pristine text into the WC at WC_ABSPATH in DB and set
+ * *DATA_SHA1 to its checksum. */
+static svn_error_t *
+install_text(svn_checksum_t **data_sha1,
+             svn_wc__db_t *db,
+             const char *wc_abspath,
+             const char *data,
+             apr_pool_t *pool)
+{
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_checksum_t *data_md5;
+  apr_size_t sz;
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data,
+                                              data_sha1, &data_md5,
+                                              db, wc_abspath,
+                                              pool, pool));
+
+  sz = strlen(data);
+  SVN_ERR(svn_stream_write(pristine_stream, data, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+
+  return svn_error_trace(svn_wc__db_pristine_install(install_data,
+                                                     *data_sha1, data_md5,
+                                                     pool));
+}
+
+/* Share a pristine text between two working copies. */
+static svn_error_t *
+pristine_shared_store(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_wc__db_t *db1, *db2;
+  const char *wc1_abspath, *wc2_abspath;
+  const char *shared_abspath;
+  svn_checksum_t *data_sha1;
+  svn_boolean_t present;
+
+  const char data[] = "Blah";
+
+  SVN_ERR(create_repos_and_wc(&wc1_abspath, &db1,
+                              "pristine_shared_store_1", opts, pool));
+  SVN_ERR(create_repos_and_wc(&wc2_abspath, &db2,
+                              "pristine_shared_store_2", opts, pool));
+
+  shared_abspath = svn_dirent_join(svn_dirent_dirname(wc1_abspath, pool),
+                                   "pristine_shared_store", pool);
+  SVN_ERR(svn_io_remove_dir2(shared_abspath, TRUE, NULL, NULL, pool));
+  db1->shared_pristine_abspath = shared_abspath;
+  db2->shared_pristine_abspath = shared_abspath;
+
+  /* The first WC publishes the text. */
+  SVN_ERR(install_text(&data_sha1, db1, wc1_abspath, data, pool));
+  SVN_ERR(svn_wc__db_pristine_check_shared(&present, db1, data_sha1, pool));
+  SVN_TEST_ASSERT(present);
+
+  /* The second WC can read it without having it. */
+  {
+    svn_stream_t *data_stream = svn_stream_from_string(
+                                  svn_string_create(data, pool), pool);
+    svn_stream_t *data_read_back;
+    svn_filesize_t size;
+    svn_boolean_t same;
+
+    SVN_ERR(svn_wc__db_pristine_check(&present, db2, wc2_abspath, data_sha1,
+                                      pool));
+    SVN_TEST_ASSERT(! present);
+
+    SVN_ERR(svn_wc__db_pristine_read(&data_read_back, &size, db2,
+                                     wc2_abspath, data_sha1, pool, pool));
+    SVN_TEST_ASSERT(size == strlen(data));
+    SVN_ERR(svn_stream_contents_same2(&same, data_read_back, data_stream,
+                                      pool));
+    SVN_TEST_ASSERT(same);
+  }
+
+  /* Installing it into the second WC as well keeps the text in use after
+   * the first WC drops it. */
+  SVN_ERR(install_text(&data_sha1, db2, wc2_abspath, data, pool));
+  SVN_ERR(svn_wc__db_pristine_remove(db1, wc1_abspath, data_sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_cleanup_shared(db1, pool));
+  SVN_ERR(svn_wc__db_pristine_check_shared(&present, db1, data_sha1, pool));
+  SVN_TEST_ASSERT(present);
+
+  /* Once no WC uses it, cleanup removes it from the shared store. */
+  SVN_ERR(svn_wc__db_pristine_remove(db2, wc2_abspath, data_sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_cleanup_shared(db2, pool));
+  SVN_ERR(svn_wc__db_pristine_check_shared(&present, db2, data_sha1, pool));
+  SVN_TEST_ASSERT(! present);
+
+  /* A planted text of the right size doesn't get into a WC. */
+  {
+    const char good_data[] = "Good";
+    const char *hex, *planted_abspath;
+    svn_checksum_t *good_sha1;
+    svn_stream_t *data_read_back;
+    svn_boolean_t same;
+
+    SVN_ERR(svn_checksum(&good_sha1, svn_checksum_sha1, good_data,
+                         strlen(good_data), pool));
+    hex = svn_checksum_to_cstring(good_sha1, pool);
+    planted_abspath = svn_dirent_join_many(pool, shared_abspath,
+                                           apr_pstrmemdup(pool, hex, 2),
+                                           apr_pstrcat(pool, hex, ".svn-base",
+                                                       SVN_VA_NULL),
+                                           SVN_VA_NULL);
+    SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(planted_abspath,
+                                                           pool),
+                                        pool));
+    SVN_ERR(svn_io_file_create(planted_abspath, "Evil", pool));
+    SVN_ERR(svn_io_set_file_read_only(planted_abspath, FALSE, pool));
+
+    SVN_ERR(install_text(&good_sha1, db1, wc1_abspath, good_data, pool));
+    SVN_ERR(svn_wc__db_pristine_read(&data_read_back, NULL, db1,
+                                     wc1_abspath, good_sha1, pool, pool));
+    SVN_ERR(svn_stream_contents_same2(&same, data_read_back,
+                                      svn_stream_from_string(
+                                        svn_string_create(good_data, pool),
+                                        pool),
+                                      pool));
+    SVN_TEST_ASSERT(same);
+  }
+
+  /* Neither planted nor writable texts get read from the shared store. */
+  {
+    const char nice_data[] = "Nice";
+    const char *hex, *planted_abspath;
+    svn_checksum_t *nice_sha1;
+    svn_stream_t *data_read_back;
+
+    SVN_ERR(svn_checksum(&nice_sha1, svn_checksum_sha1, nice_data,
+                         strlen(nice_data), pool));
+    hex = svn_checksum_to_cstring(nice_sha1, pool);
+    planted_abspath = svn_dirent_join_many(pool, shared_abspath,
+                                           apr_pstrmemdup(pool, hex, 2),
+                                           apr_pstrcat(pool, hex, ".svn-base",
+                                                       SVN_VA_NULL),
+                                           SVN_VA_NULL);
+    SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(planted_abspath,
+                                                           pool),
+                                        pool));
+    SVN_ERR(svn_io_file_create(planted_abspath, "Evil", pool));
+    SVN_ERR(svn_io_set_file_read_only(planted_abspath, FALSE, pool));
+
+    SVN_ERR(svn_wc__db_pristine_check_shared(&present, db2, nice_sha1,
+                                             pool));
+    SVN_TEST_ASSERT(! present);
+    SVN_TEST_ASSERT_ERROR(svn_wc__db_pristine_read(&data_read_back, NULL,
+                                                   db2, wc2_abspath,
+                                                   nice_sha1, pool, pool),
+                          SVN_ERR_WC_PATH_NOT_FOUND);
+
+    /* The right contents won't do as long as the file may be modified. */
+    SVN_ERR(svn_io_remove_file2(planted_abspath, FALSE, pool));
+    SVN_ERR(svn_io_file_create(planted_abspath, nice_data, pool));
+    SVN_ERR(svn_wc__db_pristine_check_shared(&present, db2, nice_sha1,
+                                             pool));
+    SVN_TEST_ASSERT(! present);
+
+    SVN_ERR(svn_io_set_file_read_only(planted_abspath, FALSE, pool));
+    SVN_ERR(svn_wc__db_pristine_check_shared(&present, db2, nice_sha1,
+                                             pool));
+    SVN_TEST_ASSERT(present);
+  }
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = -1;
 
@@ -318,6 +489,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pristine_delete_while_open"),
     SVN_TEST_OPTS_PASS(reject_mismatching_text,
                        "reject_mismatching_text"),
+    SVN_TEST_OPTS_PASS(pristine_shared_store,
+                       "pristine_shared_store"),
     SVN_TEST_NULL
   };
 
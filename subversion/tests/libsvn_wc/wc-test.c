@@ -35,11 +35,13 @@
 #include "svn_wc.h"
 #include "svn_client.h"
 #include "svn_hash.h"
+#include "svn_sorts.h"
 
 #include "utils.h"
 
 #include "private/svn_wc_private.h"
 #include "private/svn_sqlite.h"
+#include "private/svn_skel.h"
 #include "private/svn_dep_compat.h"
 #include "../../libsvn_wc/wc.h"
 #include "../../libsvn_wc/wc_db.h"
@@ -493,6 +495,572 @@ test_internal_file_modified(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_wc_status_func4_t.  Append LOCAL_ABSPATH and the node
+ * status of STATUS as a line to the svn_stringbuf_t BATON. */
+static svn_error_t *
+append_status_line(void *baton,
+                   const char *local_abspath,
+                   const svn_wc_status3_t *status,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *lines = baton;
+
+  svn_stringbuf_appendcstr(lines,
+                           apr_psprintf(scratch_pool, "%s %d %d\n",
+                                        local_abspath,
+                                        (int)status->node_status,
+                                        (int)status->text_status));
+
+  return SVN_NO_ERROR;
+}
+
+/* Walk the whole working copy in B with THREADS status threads and return
+ * the reported statuses in *LINES. */
+static svn_error_t *
+walk_with_threads(svn_stringbuf_t **lines,
+                  svn_test__sandbox_t *b,
+                  int threads,
+                  apr_pool_t *pool)
+{
+  *lines = svn_stringbuf_create_empty(pool);
+  b->wc_ctx->db->status_threads = threads;
+
+  SVN_ERR(svn_wc__walk_status_read_only(b->wc_ctx, b->wc_abspath,
+                                        svn_depth_infinity,
+                                        TRUE /* get_all */,
+                                        FALSE /* no_ignore */,
+                                        FALSE /* ignore_text_mods */,
+                                        NULL /* ignore_patterns */,
+                                        append_status_line, *lines,
+                                        NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_concurrent_status_walk(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_stringbuf_t *expected, *actual;
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "concurrent_status_walk",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Add a few more directories, modifications and unversioned nodes to
+   * make the walk a bit more interesting. */
+  for (i = 0; i < 20; ++i)
+    {
+      const char *dir = apr_psprintf(pool, "A/D/G/sub%d", i);
+      SVN_ERR(sbox_wc_mkdir(&b, dir));
+      SVN_ERR(sbox_wc_mkdir(&b, apr_psprintf(pool, "%s/deeper", dir)));
+      SVN_ERR(sbox_file_write(&b, apr_psprintf(pool, "%s/file", dir), "x"));
+    }
+  SVN_ERR(sbox_wc_commit(&b, ""));
+  SVN_ERR(sbox_file_write(&b, "A/B/lambda", "modified"));
+  SVN_ERR(sbox_file_write(&b, "A/C/unversioned", "?"));
+  SVN_ERR(sbox_wc_delete(&b, "A/D/H"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/C/added"));
+
+  SVN_ERR(walk_with_threads(&expected, &b, 1, pool));
+  SVN_ERR(walk_with_threads(&actual, &b, 4, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  SVN_ERR(walk_with_threads(&actual, &b, 32, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for delete_while_walking(). */
+typedef struct delete_while_walking_baton_t
+{
+  svn_wc_context_t *wc_ctx;
+
+  /* Delete DELETE_ABSPATH when the walk reports TRIGGER_ABSPATH. */
+  const char *trigger_abspath;
+  const char *delete_abspath;
+
+  /* The node status reported for CHECK_ABSPATH. */
+  const char *check_abspath;
+  enum svn_wc_status_kind check_status;
+} delete_while_walking_baton_t;
+
+/* Implements svn_wc_status_func4_t.  Delete a node in the working copy
+ * while the walk is in progress, like e.g. the cleanup walker of
+ * libsvn_client does with unversioned nodes. */
+static svn_error_t *
+delete_while_walking(void *baton,
+                     const char *local_abspath,
+                     const svn_wc_status3_t *status,
+                     apr_pool_t *scratch_pool)
+{
+  delete_while_walking_baton_t *b = baton;
+
+  if (strcmp(local_abspath, b->trigger_abspath) == 0)
+    SVN_ERR(svn_wc_delete4(b->wc_ctx, b->delete_abspath,
+                           TRUE /* keep_local */,
+                           FALSE /* delete_unversioned_target */,
+                           NULL, NULL, NULL, NULL, scratch_pool));
+
+  if (strcmp(local_abspath, b->check_abspath) == 0)
+    b->check_status = status->node_status;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_mutating_status_walk(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  delete_while_walking_baton_t baton;
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "mutating_status_walk",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Enough directories to keep the readers busy. */
+  for (i = 0; i < 20; ++i)
+    SVN_ERR(sbox_wc_mkdir(&b, apr_psprintf(pool, "A/D/G/sub%d", i)));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  baton.wc_ctx = b.wc_ctx;
+  baton.trigger_abspath = sbox_wc_path(&b, "A/B");
+  baton.delete_abspath = sbox_wc_path(&b, "A/D");
+  baton.check_abspath = sbox_wc_path(&b, "A/D/G/pi");
+  baton.check_status = svn_wc_status_none;
+
+  /* Status threads are configured but must not be used by a walk that
+   * may modify the working copy: it has to see the deletion. */
+  b.wc_ctx->db->status_threads = 4;
+  SVN_ERR(svn_wc__acquire_write_lock(NULL, b.wc_ctx, b.wc_abspath, FALSE,
+                                     pool, pool));
+  SVN_ERR(svn_wc_walk_status(b.wc_ctx, b.wc_abspath, svn_depth_infinity,
+                             TRUE /* get_all */, FALSE /* no_ignore */,
+                             FALSE /* ignore_text_mods */,
+                             NULL /* ignore_patterns */,
+                             delete_while_walking, &baton,
+                             NULL, NULL, pool));
+  SVN_ERR(svn_wc__release_write_lock(b.wc_ctx, b.wc_abspath, pool));
+
+  SVN_TEST_INT_ASSERT(baton.check_status, svn_wc_status_deleted);
+
+  return SVN_NO_ERROR;
+}
+
+/* Update the working copy in B from r0 to HEAD with THREADS install
+ * threads and return the resulting statuses plus the contents of some
+ * translated files in *LINES. */
+static svn_error_t *
+update_with_threads(svn_stringbuf_t **lines,
+                    svn_test__sandbox_t *b,
+                    int threads,
+                    apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+  int i;
+
+  b->wc_ctx->db->install_threads = 1;
+  SVN_ERR(sbox_wc_update(b, "", 0));
+
+  b->wc_ctx->db->install_threads = threads;
+  SVN_ERR(sbox_wc_update(b, "", SVN_INVALID_REVNUM));
+
+  SVN_ERR(walk_with_threads(lines, b, 1, pool));
+  for (i = 0; i < 40; i += 7)
+    {
+      SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                       sbox_wc_path(b, apr_psprintf(pool,
+                                                      "A/C/file%d", i)),
+                                       pool));
+      svn_stringbuf_appendstr(*lines, contents);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_concurrent_file_install(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_stringbuf_t *expected, *actual;
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "concurrent_file_install",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Add files that need translation, flags or share their pristine. */
+  for (i = 0; i < 40; ++i)
+    {
+      const char *file = apr_psprintf(pool, "A/C/file%d", i);
+
+      SVN_ERR(sbox_file_write(&b, file,
+                              i % 2 ? "same\n"
+                                    : apr_psprintf(pool,
+                                                   "$Revision$ %d\n", i)));
+      SVN_ERR(sbox_wc_add(&b, file));
+      if (i % 2 == 0)
+        SVN_ERR(sbox_wc_propset(&b, SVN_PROP_KEYWORDS, "Revision", file));
+      if (i % 3 == 0)
+        SVN_ERR(sbox_wc_propset(&b, SVN_PROP_EOL_STYLE, "CRLF", file));
+      if (i % 5 == 0)
+        SVN_ERR(sbox_wc_propset(&b, SVN_PROP_EXECUTABLE, "*", file));
+      if (i % 11 == 0)
+        SVN_ERR(sbox_wc_propset(&b, SVN_PROP_NEEDS_LOCK, "*", file));
+    }
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  SVN_ERR(update_with_threads(&expected, &b, 1, pool));
+  SVN_ERR(update_with_threads(&actual, &b, 4, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  SVN_ERR(update_with_threads(&actual, &b, 32, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of nodes recorded by test_batched_node_inserts per run when
+ * measuring the throughput in verbose mode. */
+#define BENCH_NODE_COUNT 2000
+
+/* Record COUNT new files named PREFIX<n> below the root of the working
+ * copy in B, committing every BATCH_SIZE nodes or each node on its own
+ * if BATCH_SIZE is 0.  Set *RATE to the number of nodes per second. */
+static svn_error_t *
+insert_base_files(double *rate,
+                  svn_test__sandbox_t *b,
+                  const char *prefix,
+                  int count,
+                  int batch_size,
+                  apr_pool_t *pool)
+{
+  svn_wc__db_t *db = b->wc_ctx->db;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  const char *repos_root_url, *repos_uuid;
+  svn_checksum_t *checksum;
+  apr_time_t start, duration;
+  int i;
+
+  SVN_ERR(svn_wc__db_base_get_info(NULL, NULL, NULL, NULL,
+                                   &repos_root_url, &repos_uuid,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL,
+                                   db, b->wc_abspath, pool, pool));
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, "", 0, pool));
+
+  start = apr_time_now();
+  for (i = 0; i < count; ++i)
+    {
+      const char *name;
+
+      svn_pool_clear(iterpool);
+      name = apr_psprintf(iterpool, "%s%d", prefix, i);
+
+      if (batch_size && i % batch_size == 0)
+        SVN_ERR(svn_wc__db_begin_batch(db, b->wc_abspath, iterpool));
+
+      SVN_ERR(svn_wc__db_base_add_file(db,
+                                       svn_dirent_join(b->wc_abspath, name,
+                                                       iterpool),
+                                       b->wc_abspath, name,
+                                       repos_root_url, repos_uuid, 1,
+                                       apr_hash_make(iterpool),
+                                       1, 0, "jrandom", checksum,
+                                       NULL, FALSE, FALSE, NULL, NULL,
+                                       FALSE, FALSE, NULL, NULL,
+                                       iterpool));
+
+      if (batch_size
+          && (i % batch_size == batch_size - 1 || i == count - 1))
+        SVN_ERR(svn_wc__db_end_batch(db, b->wc_abspath, iterpool));
+    }
+
+  duration = MAX(apr_time_now() - start, 1);
+  *rate = (double)count * APR_USEC_PER_SEC / duration;
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_batched_node_inserts(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  const apr_array_header_t *children;
+  double unbatched_rate, batched_rate;
+
+  /* Only measure the throughput if someone is going to look at it.
+   * Otherwise, just check that batches of any size get committed. */
+  int count = opts->verbose ? BENCH_NODE_COUNT : 50;
+  int batch_size = opts->verbose ? 1000 : 20;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "batched_node_inserts",
+                                   opts, pool));
+
+  SVN_ERR(insert_base_files(&unbatched_rate, &b, "single", count, 0,
+                            pool));
+  SVN_ERR(insert_base_files(&batched_rate, &b, "batched", count, batch_size,
+                            pool));
+
+  /* All nodes have been committed. */
+  SVN_ERR(svn_wc__db_base_get_children(&children, b.wc_ctx->db,
+                                       b.wc_abspath, pool, pool));
+  SVN_TEST_INT_ASSERT(children->nelts, 2 * count);
+
+  if (opts->verbose)
+    printf("unbatched: %.0f nodes/sec\n"
+           "batched:   %.0f nodes/sec\n",
+           unbatched_rate, batched_rate);
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of files that test_batched_update adds to a single directory.
+ * More than the update editor records in a single batch. */
+#define WIDE_DIR_FILE_COUNT 1010
+
+static svn_error_t *
+test_batched_update(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  const apr_array_header_t *children;
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "batched_update", opts, pool));
+
+  SVN_ERR(sbox_wc_mkdir(&b, "wide"));
+  SVN_ERR(sbox_wc_mkdir(&b, "wide/sub"));
+  SVN_ERR(sbox_file_write(&b, "wide/sub/file", "sub\n"));
+  SVN_ERR(sbox_wc_add(&b, "wide/sub/file"));
+  for (i = 0; i < WIDE_DIR_FILE_COUNT; ++i)
+    {
+      const char *file;
+
+      svn_pool_clear(iterpool);
+      file = apr_psprintf(iterpool, "wide/file%d", i);
+
+      SVN_ERR(sbox_file_write(&b, file,
+                              apr_psprintf(iterpool, "file %d\n", i)));
+      SVN_ERR(sbox_wc_add(&b, file));
+    }
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* Have the update editor add all nodes again. */
+  SVN_ERR(sbox_wc_update(&b, "", 0));
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+
+  SVN_ERR(svn_wc__db_base_get_children(&children, b.wc_ctx->db,
+                                       sbox_wc_path(&b, "wide"),
+                                       pool, pool));
+  SVN_TEST_INT_ASSERT(children->nelts, WIDE_DIR_FILE_COUNT + 1);
+
+  for (i = 0; i < WIDE_DIR_FILE_COUNT; ++i)
+    {
+      const char *file;
+      svn_revnum_t revision;
+      svn_stringbuf_t *contents;
+
+      svn_pool_clear(iterpool);
+      file = apr_psprintf(iterpool, "wide/file%d", i);
+
+      SVN_ERR(svn_wc__db_base_get_info(NULL, NULL, &revision, NULL, NULL,
+                                       NULL, NULL, NULL, NULL, NULL, NULL,
+                                       NULL, NULL, NULL, NULL, NULL,
+                                       b.wc_ctx->db, sbox_wc_path(&b, file),
+                                       iterpool, iterpool));
+      SVN_TEST_INT_ASSERT(revision, 1);
+
+      SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, file),
+                                       iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data,
+                             apr_psprintf(iterpool, "file %d\n", i));
+    }
+
+  /* No batch may be left open after the edit. */
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
+                                                b.wc_ctx->db, b.wc_abspath,
+                                                pool, pool));
+  SVN_TEST_INT_ASSERT(wcroot->batch_depth, 0);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_batch_rollback(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_wc__db_t *db;
+  const char *repos_root_url, *repos_uuid;
+  const apr_array_header_t *children;
+  svn_checksum_t *checksum;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "batch_rollback", opts, pool));
+  db = b.wc_ctx->db;
+
+  SVN_ERR(svn_wc__db_base_get_info(NULL, NULL, NULL, NULL,
+                                   &repos_root_url, &repos_uuid,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL,
+                                   db, b.wc_abspath, pool, pool));
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, "", 0, pool));
+
+  SVN_ERR(svn_wc__db_begin_batch(db, b.wc_abspath, pool));
+
+  SVN_ERR(svn_wc__db_base_add_file(db, sbox_wc_path(&b, "before"),
+                                   b.wc_abspath, "before",
+                                   repos_root_url, repos_uuid, 1,
+                                   apr_hash_make(pool), 1, 0, "jrandom",
+                                   checksum, NULL, FALSE, FALSE, NULL, NULL,
+                                   FALSE, FALSE, NULL, NULL, pool));
+
+  /* An invalid conflict skel makes the operation fail only after it has
+   * inserted the node. */
+  SVN_TEST_ASSERT_ANY_ERROR(svn_wc__db_base_add_file(
+                              db, sbox_wc_path(&b, "failing"),
+                              b.wc_abspath, "failing",
+                              repos_root_url, repos_uuid, 1,
+                              apr_hash_make(pool), 1, 0, "jrandom",
+                              checksum, NULL, FALSE, FALSE, NULL, NULL,
+                              FALSE, FALSE,
+                              svn_skel__make_empty_list(pool), NULL,
+                              pool));
+
+  SVN_ERR(svn_wc__db_base_add_file(db, sbox_wc_path(&b, "after"),
+                                   b.wc_abspath, "after",
+                                   repos_root_url, repos_uuid, 1,
+                                   apr_hash_make(pool), 1, 0, "jrandom",
+                                   checksum, NULL, FALSE, FALSE, NULL, NULL,
+                                   FALSE, FALSE, NULL, NULL, pool));
+
+  SVN_ERR(svn_wc__db_end_batch(db, b.wc_abspath, pool));
+
+  /* Only the failed operation has been rolled back. */
+  SVN_ERR(svn_wc__db_base_get_children(&children, db, b.wc_abspath,
+                                       pool, pool));
+  SVN_TEST_INT_ASSERT(children->nelts, 2);
+  SVN_ERR(svn_wc__db_base_get_info(NULL, &kind, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL,
+                                   db, sbox_wc_path(&b, "before"),
+                                   pool, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_wc__db_base_get_info(NULL, &kind, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL,
+                                   db, sbox_wc_path(&b, "after"),
+                                   pool, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  SVN_TEST_ASSERT_ERROR(svn_wc__db_base_get_info(NULL, NULL, NULL, NULL,
+                                                 NULL, NULL, NULL, NULL,
+                                                 NULL, NULL, NULL, NULL,
+                                                 NULL, NULL, NULL, NULL,
+                                                 db,
+                                                 sbox_wc_path(&b, "failing"),
+                                                 pool, pool),
+                        SVN_ERR_WC_PATH_NOT_FOUND);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like walk_with_threads() but without using the status monitor of the
+ * working copy in B. */
+static svn_error_t *
+walk_unmonitored(svn_stringbuf_t **lines,
+                 svn_test__sandbox_t *b,
+                 apr_pool_t *pool)
+{
+  svn_wc__status_monitor_t *monitor
+    = svn_wc__db_get_status_monitor(b->wc_ctx->db);
+
+  svn_wc__db_set_status_monitor(b->wc_ctx->db, NULL);
+  SVN_ERR(walk_with_threads(lines, b, 1, pool));
+  svn_wc__db_set_status_monitor(b->wc_ctx->db, monitor);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_status_monitor(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_stringbuf_t *expected, *actual;
+  apr_pool_t *monitor_pool = svn_pool_create(pool);
+  svn_wc__status_monitor_t *monitor;
+  apr_uint64_t hits;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "status_monitor", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  err = svn_wc__status_monitor_start(b.wc_ctx, monitor_pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "no file system monitor on this platform");
+    }
+  SVN_ERR(err);
+  monitor = svn_wc__db_get_status_monitor(b.wc_ctx->db);
+  SVN_TEST_ASSERT(monitor != NULL);
+
+  /* Let the monitor learn about all directories. */
+  SVN_ERR(walk_unmonitored(&expected, &b, pool));
+  SVN_ERR(walk_with_threads(&actual, &b, 1, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  /* Nothing changed, so the next walks don't need to read directories. */
+  hits = svn_wc__status_monitor_get_hits(monitor);
+  SVN_ERR(walk_with_threads(&actual, &b, 1, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+  SVN_TEST_ASSERT(svn_wc__status_monitor_get_hits(monitor) > hits);
+
+  SVN_ERR(walk_with_threads(&actual, &b, 4, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  /* Make all kinds of changes behind its back. */
+  SVN_ERR(sbox_file_write(&b, "A/mu", "modified mu\n"));
+  SVN_ERR(sbox_file_write(&b, "A/B/unversioned", "?"));
+  SVN_ERR(svn_io_remove_file2(sbox_wc_path(&b, "A/D/gamma"), FALSE, pool));
+  SVN_ERR(svn_io_remove_dir2(sbox_wc_path(&b, "A/D/H"), FALSE,
+                             NULL, NULL, pool));
+  SVN_ERR(sbox_disk_mkdir(&b, "A/C/new"));
+  SVN_ERR(svn_io_file_rename2(sbox_wc_path(&b, "A/B/E/alpha"),
+                              sbox_wc_path(&b, "A/B/E/moved"), FALSE,
+                              pool));
+
+  /* The monitored walks must see what a regular walk sees. */
+  SVN_ERR(walk_unmonitored(&expected, &b, pool));
+  SVN_ERR(walk_with_threads(&actual, &b, 1, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+  SVN_ERR(walk_with_threads(&actual, &b, 4, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  /* Unchanged directories such as A/B/F still come from the monitor. */
+  hits = svn_wc__status_monitor_get_hits(monitor);
+  SVN_ERR(walk_with_threads(&actual, &b, 1, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+  SVN_TEST_ASSERT(svn_wc__status_monitor_get_hits(monitor) > hits);
+
+  svn_pool_destroy(monitor_pool);
+  SVN_TEST_ASSERT(svn_wc__db_get_status_monitor(b.wc_ctx->db) == NULL);
+
+  SVN_ERR(walk_with_threads(&actual, &b, 1, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  return SVN_NO_ERROR;
+}
+
 /* ---------------------------------------------------------------------- */
 /* The list of test functions */
 
@@ -515,6 +1083,20 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test legacy commit2"),
     SVN_TEST_OPTS_PASS(test_internal_file_modified,
                        "test internal_file_modified"),
+    SVN_TEST_OPTS_PASS(test_concurrent_status_walk,
+                       "status walk with concurrent directory reads"),
+    SVN_TEST_OPTS_PASS(test_mutating_status_walk,
+                       "status walk whose callback modifies the wc"),
+    SVN_TEST_OPTS_PASS(test_concurrent_file_install,
+                       "work queue with concurrent file installs"),
+    SVN_TEST_OPTS_PASS(test_batched_node_inserts,
+                       "batched BASE node inserts"),
+    SVN_TEST_OPTS_PASS(test_batched_update,
+                       "update editor records nodes in batches"),
+    SVN_TEST_OPTS_PASS(test_batch_rollback,
+                       "failing operation within a batch"),
+    SVN_TEST_OPTS_PASS(test_status_monitor,
+                       "status walks with a file system monitor"),
     SVN_TEST_NULL
   };
 
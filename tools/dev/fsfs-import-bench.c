@@ -0,0 +1,212 @@
+/* fsfs-import-bench.c -- measure FSFS commit times for large imports
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <stdlib.h>
+
+#include <apr.h>
+#include <apr_general.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_utf.h"
+#include "svn_dirent_uri.h"
+#include "svn_cmdline.h"
+#include "svn_fs.h"
+
+/* Every DUPLICATE_INTERVAL'th file has the same contents as a file of the
+   previous revision, i.e. can be shared via the rep-cache. */
+#define DUPLICATE_INTERVAL 10
+
+/* Create a new FSFS repository at PATH and set whether it may use
+   rep-sharing according to REP_SHARING.  Return it in *FS_P. */
+static svn_error_t *
+create_fs(svn_fs_t **fs_p,
+          const char *path,
+          svn_boolean_t rep_sharing,
+          apr_pool_t *pool)
+{
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  svn_fs_t *fs;
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FS_TYPE, SVN_FS_TYPE_FSFS);
+  SVN_ERR(svn_fs_create2(&fs, path, fs_config, pool, pool));
+
+  if (!rep_sharing)
+    SVN_ERR(svn_io_file_create(svn_dirent_join(path, "fsfs.conf", pool),
+                               "[rep-sharing]\n"
+                               "enable-rep-sharing = false\n",
+                               pool));
+
+  return svn_error_trace(svn_fs_open2(fs_p, path, fs_config, pool, pool));
+}
+
+/* Commit revision REV to FS, adding FILE_COUNT files to a new directory.
+   Add the time spent on the commit itself to *COMMIT_TIME. */
+static svn_error_t *
+commit_revision(svn_fs_t *fs,
+                svn_revnum_t rev,
+                int file_count,
+                apr_time_t *commit_time,
+                apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *dir = apr_psprintf(pool, "/r%ld", rev);
+  const char *conflict;
+  svn_revnum_t new_rev;
+  apr_time_t start;
+  int i;
+
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, rev - 1, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, dir, pool));
+
+  for (i = 0; i < file_count; ++i)
+    {
+      const char *path;
+      const char *contents;
+      svn_stream_t *stream;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "%s/file%d", dir, i);
+      contents = (i % DUPLICATE_INTERVAL == 0 && rev > 1)
+               ? apr_psprintf(iterpool, "file %d of r%ld\n", i, rev - 1)
+               : apr_psprintf(iterpool, "file %d of r%ld\n", i, rev);
+
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(svn_fs_apply_text(&stream, root, path, NULL, iterpool));
+      SVN_ERR(svn_stream_puts(stream, contents));
+      SVN_ERR(svn_stream_close(stream));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  start = apr_time_now();
+  SVN_ERR(svn_fs_commit_txn(&conflict, &new_rev, txn, pool));
+  *commit_time += apr_time_now() - start;
+
+  return SVN_NO_ERROR;
+}
+
+/* Import REV_COUNT revisions with FILE_COUNT files each into a new
+   repository at PATH and print the time it took.  REP_SHARING controls
+   whether the repository uses its rep-cache. */
+static svn_error_t *
+bench_import(const char *path,
+             svn_boolean_t rep_sharing,
+             int rev_count,
+             int file_count,
+             apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_t *fs;
+  apr_time_t start, commit_time = 0;
+  svn_revnum_t rev;
+
+  SVN_ERR(create_fs(&fs, path, rep_sharing, pool));
+
+  start = apr_time_now();
+  for (rev = 1; rev <= rev_count; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(commit_revision(fs, rev, file_count, &commit_time, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_cmdline_printf(pool,
+                           "%-12s %9d %12.3f ms %12.3f ms %9.3f ms\n",
+                           rep_sharing ? "rep-sharing" : "no sharing",
+                           rev_count * file_count,
+                           (apr_time_now() - start) / 1000.0,
+                           commit_time / 1000.0,
+                           commit_time / 1000.0 / rev_count));
+}
+
+static void
+print_usage(const char *progname,
+            apr_pool_t *pool)
+{
+  svn_error_clear(svn_cmdline_fprintf(stderr, pool,
+     "Usage: %s DIR [REVISIONS [FILES]]\n"
+     "\n"
+     "Create FSFS repositories with and without rep-sharing in the new\n"
+     "directory DIR and commit REVISIONS (default: 10) revisions to them,\n"
+     "each adding FILES (default: 10000) small files.  Every %dth file\n"
+     "duplicates a file of the previous revision.  Print the total time\n"
+     "and the time spent in svn_fs_commit_txn() for each repository.\n",
+     progname, DUPLICATE_INTERVAL));
+}
+
+int main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  svn_error_t *svn_err;
+  const char *dir;
+  int rev_count = 10;
+  int file_count = 10000;
+
+  if (svn_cmdline_init("fsfs-import-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = svn_pool_create(NULL);
+
+  if (argc < 2 || argc > 4
+      || (argc > 2 && (rev_count = atoi(argv[2])) <= 0)
+      || (argc > 3 && (file_count = atoi(argv[3])) <= 0))
+    {
+      print_usage(argv[0], pool);
+      return EXIT_FAILURE;
+    }
+
+  svn_err = svn_utf_cstring_to_utf8(&dir, argv[1], pool);
+  if (!svn_err)
+    svn_err = svn_fs_initialize(pool);
+  if (!svn_err)
+    svn_err = svn_io_dir_make(dir, APR_OS_DEFAULT, pool);
+  if (!svn_err)
+    svn_err = svn_cmdline_printf(pool,
+                                 "repository       files"
+                                 "          total           commit"
+                                 "   per rev\n");
+  if (!svn_err)
+    svn_err = bench_import(svn_dirent_join(dir, "shared", pool), TRUE,
+                           rev_count, file_count, pool);
+  if (!svn_err)
+    svn_err = bench_import(svn_dirent_join(dir, "unshared", pool), FALSE,
+                           rev_count, file_count, pool);
+
+  if (svn_err)
+    {
+      svn_handle_error2(svn_err, stderr, FALSE, "fsfs-import-bench: ");
+      svn_error_clear(svn_err);
+      return EXIT_FAILURE;
+    }
+
+  svn_pool_destroy(pool);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,339 @@
+/* ra-svn-compression-bench.c -- measure ra_svn transport compression
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr.h>
+#include <apr_general.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_cmdline.h"
+#include "svn_ra_svn.h"
+#include "svn_delta.h"
+#include "svn_time.h"
+
+#include "private/svn_ra_svn_private.h"
+
+/* Number of top-level items sent per scenario. */
+#define ITEM_COUNT 20000
+
+/* Write the ITEM_NO'th item of a scenario to CONN. */
+typedef svn_error_t *(*write_item_fn_t)(svn_ra_svn_conn_t *conn,
+                                        int item_no,
+                                        apr_uint32_t *seed,
+                                        apr_pool_t *pool);
+
+/* Return a pseudo-random number and update *SEED. */
+static apr_uint32_t
+next_random(apr_uint32_t *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 8;
+}
+
+static const char *const dirs[] =
+{
+  "trunk/subversion/libsvn_subr",
+  "trunk/subversion/libsvn_ra_svn",
+  "trunk/subversion/libsvn_fs_fs",
+  "trunk/subversion/tests/cmdline",
+  "branches/1.10.x/subversion/libsvn_wc",
+  "tags/1.9.7/tools/dev"
+};
+
+static const char *const authors[] =
+{
+  "alice", "bob", "carol", "dave", "eve"
+};
+
+/* Return a path name as seen in a typical repository. */
+static const char *
+random_path(apr_uint32_t *seed,
+            apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "/%s/file%u.c",
+                      dirs[next_random(seed) % 6],
+                      (unsigned)(next_random(seed) % 500));
+}
+
+/* Return a date string for revision REV. */
+static const char *
+date_of(int rev,
+        apr_pool_t *pool)
+{
+  return svn_time_to_cstring(APR_INT64_C(1500000000000000)
+                             + (apr_time_t)rev * APR_INT64_C(3600000000),
+                             pool);
+}
+
+/* Implements write_item_fn_t, mimicking a log entry with changed paths
+   as sent for "svn log -v". */
+static svn_error_t *
+write_log_entry(svn_ra_svn_conn_t *conn,
+                int item_no,
+                apr_uint32_t *seed,
+                apr_pool_t *pool)
+{
+  int count = 1 + next_random(seed) % 20;
+  int i;
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "((!"));
+  for (i = 0; i < count; ++i)
+    SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "(cw()(cbb))",
+                                    random_path(seed, pool), "M", "file",
+                                    TRUE, FALSE));
+
+  return svn_error_trace(svn_ra_svn__write_tuple(conn, pool,
+                                                 "!)r(c)(c)(c))",
+                                                 (svn_revnum_t)item_no,
+                                                 authors[item_no % 5],
+                                                 date_of(item_no, pool),
+                                                 "Fix a typo in a comment."));
+}
+
+/* Implements write_item_fn_t, mimicking a directory entry as sent for
+   "svn ls -R". */
+static svn_error_t *
+write_dirent(svn_ra_svn_conn_t *conn,
+             int item_no,
+             apr_uint32_t *seed,
+             apr_pool_t *pool)
+{
+  svn_revnum_t rev = next_random(seed) % 100000;
+
+  return svn_error_trace(svn_ra_svn__write_tuple(conn, pool,
+                                                 "(cwnbr(c)(c))",
+                                                 random_path(seed, pool),
+                                                 "file",
+                                                 (apr_uint64_t)
+                                                   (next_random(seed) % 65536),
+                                                 FALSE, rev,
+                                                 date_of(rev, pool),
+                                                 authors[rev % 5]));
+}
+
+/* Implements write_item_fn_t, mimicking a node property list. */
+static svn_error_t *
+write_proplist(svn_ra_svn_conn_t *conn,
+               int item_no,
+               apr_uint32_t *seed,
+               apr_pool_t *pool)
+{
+  return svn_error_trace(svn_ra_svn__write_tuple(conn, pool,
+                                                 "((cc)(cc)(cc))",
+                                                 "svn:eol-style", "native",
+                                                 "svn:keywords",
+                                                 "Author Date Id Revision",
+                                                 "svn:mergeinfo",
+                                                 apr_psprintf(pool,
+                                                   "/branches/1.10.x:%d-%d",
+                                                   item_no, item_no + 10)));
+}
+
+/* Implements write_item_fn_t, sending incompressible data such as
+   svndiff windows that have already been compressed. */
+static svn_error_t *
+write_random_data(svn_ra_svn_conn_t *conn,
+                  int item_no,
+                  apr_uint32_t *seed,
+                  apr_pool_t *pool)
+{
+  char *buffer = apr_palloc(pool, 256);
+  svn_string_t data;
+  int i;
+
+  for (i = 0; i < 256; ++i)
+    buffer[i] = (char)next_random(seed);
+
+  data.data = buffer;
+  data.len = 256;
+
+  return svn_error_trace(svn_ra_svn__write_tuple(conn, pool, "(s)", &data));
+}
+
+/* Send ITEM_COUNT items produced by WRITE_FN through an ra_svn connection
+   and read them back.  Compress the connection if COMPRESSION_LEVEL is
+   not 0.  Print the number of bytes that went over the wire and the time
+   spent on either side. */
+static svn_error_t *
+bench_scenario(const char *name,
+               write_item_fn_t write_fn,
+               int compression_level,
+               apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *wire = svn_stringbuf_create_empty(pool);
+  svn_ra_svn_conn_t *writer, *reader;
+  apr_uint32_t seed = 0;
+  apr_time_t start, write_time, read_time;
+  apr_size_t payload;
+  int i;
+
+  writer = svn_ra_svn_create_conn5(NULL, svn_stream_empty(pool),
+                                   svn_stream_from_stringbuf(wire, pool),
+                                   compression_level, 0, 0, 0, 0, pool);
+  if (compression_level)
+    SVN_ERR(svn_ra_svn__enable_compression(writer, pool));
+
+  /* Determine the uncompressed size of the data. */
+  if (compression_level)
+    {
+      svn_stringbuf_t *plain = svn_stringbuf_create_empty(pool);
+      svn_ra_svn_conn_t *counter
+        = svn_ra_svn_create_conn5(NULL, svn_stream_empty(pool),
+                                  svn_stream_from_stringbuf(plain, pool),
+                                  0, 0, 0, 0, 0, pool);
+      for (i = 0; i < ITEM_COUNT; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(write_fn(counter, i, &seed, iterpool));
+        }
+
+      SVN_ERR(svn_ra_svn__flush(counter, iterpool));
+      payload = plain->len;
+      seed = 0;
+    }
+
+  start = apr_time_now();
+  for (i = 0; i < ITEM_COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(write_fn(writer, i, &seed, iterpool));
+    }
+
+  SVN_ERR(svn_ra_svn__flush(writer, iterpool));
+  write_time = apr_time_now() - start;
+  if (!compression_level)
+    payload = wire->len;
+
+  reader = svn_ra_svn_create_conn5(NULL,
+                                   svn_stream_from_stringbuf(wire, pool),
+                                   svn_stream_empty(pool),
+                                   compression_level, 0, 0, 0, 0, pool);
+  if (compression_level)
+    SVN_ERR(svn_ra_svn__enable_compression(reader, pool));
+
+  start = apr_time_now();
+  for (i = 0; i < ITEM_COUNT; ++i)
+    {
+      svn_ra_svn__item_t *item;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__read_item(reader, iterpool, &item));
+    }
+
+  read_time = apr_time_now() - start;
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_cmdline_printf(pool,
+                           "%-12s %d %10" APR_SIZE_T_FMT
+                           " %10" APR_SIZE_T_FMT " %6.1f%%"
+                           " %9.3f ms %9.3f ms\n",
+                           name, compression_level, payload, wire->len,
+                           100.0 * wire->len / payload,
+                           write_time / 1000.0, read_time / 1000.0));
+}
+
+static void
+print_usage(const char *progname,
+            apr_pool_t *pool)
+{
+  svn_error_clear(svn_cmdline_fprintf(stderr, pool,
+     "Usage: %s [LEVEL ...]\n"
+     "\n"
+     "Marshal typical ra_svn responses (log -v entries, recursive listings,\n"
+     "property lists and incompressible data), send them over a connection\n"
+     "using the transport compression LEVEL (0 = off; default: 0 and %d)\n"
+     "and parse them again.  Print the payload size, the bytes on the wire\n"
+     "and the time spent for sending and receiving.\n",
+     progname, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT));
+}
+
+int main(int argc, const char *argv[])
+{
+  static const struct
+  {
+    const char *name;
+    write_item_fn_t write_fn;
+  } scenarios[] =
+  {
+    { "log -v", write_log_entry },
+    { "ls -R", write_dirent },
+    { "proplist", write_proplist },
+    { "random", write_random_data }
+  };
+
+  apr_pool_t *pool;
+  svn_error_t *svn_err = SVN_NO_ERROR;
+  apr_array_header_t *levels;
+  int i, k;
+
+  if (svn_cmdline_init("ra-svn-compression-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = svn_pool_create(NULL);
+  levels = apr_array_make(pool, 2, sizeof(int));
+
+  for (i = 1; i < argc; ++i)
+    {
+      char *end;
+      long level = strtol(argv[i], &end, 10);
+
+      if (*end || level < 0 || level > 9)
+        {
+          print_usage(argv[0], pool);
+          return EXIT_FAILURE;
+        }
+
+      APR_ARRAY_PUSH(levels, int) = (int)level;
+    }
+
+  if (levels->nelts == 0)
+    {
+      APR_ARRAY_PUSH(levels, int) = 0;
+      APR_ARRAY_PUSH(levels, int) = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
+    }
+
+  svn_err = svn_cmdline_printf(pool,
+                               "scenario     L    payload       wire  ratio"
+                               "     write        read\n");
+  for (i = 0; !svn_err && i < (int)(sizeof(scenarios) / sizeof(scenarios[0]));
+       ++i)
+    for (k = 0; !svn_err && k < levels->nelts; ++k)
+      svn_err = bench_scenario(scenarios[i].name, scenarios[i].write_fn,
+                               APR_ARRAY_IDX(levels, k, int), pool);
+
+  if (svn_err)
+    {
+      svn_handle_error2(svn_err, stderr, FALSE, "ra-svn-compression-bench: ");
+      svn_error_clear(svn_err);
+      return EXIT_FAILURE;
+    }
+
+  svn_pool_destroy(pool);
+  return EXIT_SUCCESS;
+}
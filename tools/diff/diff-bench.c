@@ -0,0 +1,195 @@
+/* diff-bench.c -- time the diff algorithms of libsvn_diff
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr.h>
+#include <apr_general.h>
+#include <apr_time.h>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+#include "svn_pools.h"
+#include "svn_diff.h"
+#include "svn_io.h"
+#include "svn_cmdline.h"
+
+/* Output baton counting the lines reported as changed. */
+typedef struct count_baton_t
+{
+  apr_off_t removed;
+  apr_off_t added;
+} count_baton_t;
+
+/* Implements svn_diff_output_fns_t.output_diff_modified. */
+static svn_error_t *
+count_modified(void *output_baton,
+               apr_off_t original_start,
+               apr_off_t original_length,
+               apr_off_t modified_start,
+               apr_off_t modified_length,
+               apr_off_t latest_start,
+               apr_off_t latest_length)
+{
+  count_baton_t *baton = output_baton;
+
+  baton->removed += original_length;
+  baton->added += modified_length;
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t count_fns =
+{
+  NULL,
+  count_modified
+};
+
+/* Diff ORIGINAL against MODIFIED ITERATIONS times with OPTIONS and print
+ * the average time taken and the size of the result. */
+static svn_error_t *
+bench_pair(const char *original,
+           const char *modified,
+           int iterations,
+           const svn_diff_file_options_t *options,
+           apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  count_baton_t baton = { 0 };
+  apr_time_t start = apr_time_now();
+  apr_time_t elapsed;
+  svn_diff_t *diff;
+  int i;
+
+  for (i = 0; i < iterations; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_diff_file_diff_2(&diff, original, modified, options,
+                                   iterpool));
+    }
+
+  elapsed = apr_time_now() - start;
+  SVN_ERR(svn_diff_output2(diff, &baton, &count_fns, NULL, NULL));
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_cmdline_printf(pool,
+                           "%10.3f ms  -%-8" APR_OFF_T_FMT
+                           " +%-8" APR_OFF_T_FMT "  %s %s\n",
+                           elapsed / 1000.0 / iterations,
+                           baton.removed, baton.added,
+                           original, modified));
+}
+
+/* Print the peak memory usage of this process, if available. */
+static void
+print_peak_memory(apr_pool_t *pool)
+{
+#ifndef WIN32
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    svn_error_clear(svn_cmdline_printf(pool, "peak RSS: %ld kB\n",
+                                       (long)usage.ru_maxrss));
+#endif
+}
+
+static void
+print_usage(const char *progname,
+            apr_pool_t *pool)
+{
+  svn_error_clear(svn_cmdline_fprintf(stderr, pool,
+     "Usage: %s [-n ITERATIONS] [OPTIONS] <file1> <file2> ...\n"
+     "\n"
+     "Diff each pair of files ITERATIONS times (default: 10) and print the\n"
+     "average time taken, the number of removed and added lines and, at\n"
+     "the end, the peak memory usage of the process.  OPTIONS are diff\n"
+     "extensions as described by 'svn help diff'; use --histogram to select\n"
+     "the histogram algorithm.  Since the memory usage is per process,\n"
+     "compare the algorithms in separate runs.\n",
+     progname));
+}
+
+int main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  svn_error_t *svn_err = SVN_NO_ERROR;
+  svn_diff_file_options_t *diff_options;
+  apr_array_header_t *options_array;
+  apr_array_header_t *files;
+  int iterations = 10;
+  int i;
+
+  if (svn_cmdline_init("diff-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = svn_pool_create(NULL);
+
+  options_array = apr_array_make(pool, 0, sizeof(const char *));
+  files = apr_array_make(pool, 0, sizeof(const char *));
+  diff_options = svn_diff_file_options_create(pool);
+
+  for (i = 1 ; i < argc ; i++)
+    {
+      if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+          iterations = atoi(argv[++i]);
+          if (iterations < 1)
+            {
+              print_usage(argv[0], pool);
+              return 2;
+            }
+        }
+      else if (argv[i][0] == '-')
+        APR_ARRAY_PUSH(options_array, const char *) = argv[i];
+      else
+        APR_ARRAY_PUSH(files, const char *) = argv[i];
+    }
+
+  if (files->nelts == 0 || files->nelts % 2)
+    {
+      print_usage(argv[0], pool);
+      return 2;
+    }
+
+  svn_err = svn_diff_file_options_parse(diff_options, options_array, pool);
+
+  for (i = 0; !svn_err && i < files->nelts; i += 2)
+    svn_err = bench_pair(APR_ARRAY_IDX(files, i, const char *),
+                         APR_ARRAY_IDX(files, i + 1, const char *),
+                         iterations, diff_options, pool);
+
+  if (svn_err)
+    {
+      svn_handle_error2(svn_err, stderr, FALSE, "diff-bench: ");
+      svn_error_clear(svn_err);
+      return 2;
+    }
+
+  print_peak_memory(pool);
+  svn_pool_destroy(pool);
+
+  return 0;
+}